@@ -49,6 +49,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <vma/vk_mem_alloc.h>
 #include <memory>
@@ -87,8 +88,36 @@
 // Max object ocurrence
 #define ENGINE_MAX_OBJECTS 100
 #define ENGINE_MAX_LIGHTS 50
+// Shadow cascades of the cascaded directional light. Stored in the shadow map array after the layers of the lights
+#define ENGINE_MAX_CASCADES 4
+#define ENGINE_MAX_SHADOW_LAYERS (ENGINE_MAX_LIGHTS + ENGINE_MAX_CASCADES)
+// Texture slots each material owns in the bindless texture arrays
 #define MAX_TEXTURES_PER_MATERIAL 6
-#define MAX_TEXTURES ENGINE_MAX_OBJECTS * MAX_TEXTURES_PER_MATERIAL
+// Most slots a bindless texture array can grow to, if the device allows as many. Arrays are sized after the material table
+#define ENGINE_MAX_BINDLESS_TEXTURES (64 * 1024)
+// Initial capacity of the per-frame instance and material storage buffers. They grow on demand
+#define ENGINE_INITIAL_INSTANCES ENGINE_MAX_OBJECTS
+// Initial capacity of the geometry arena (shared vertex/index buffers used by GPU-driven drawing). It grows on demand
+#define ENGINE_INITIAL_ARENA_VERTICES (256 * 1024)
+#define ENGINE_INITIAL_ARENA_INDICES (768 * 1024)
+
+// Minimum draws recorded by each worker when a pass splits its draw list across secondary command buffers
+#define ENGINE_MIN_DRAWS_PER_RECORDING_JOB 128
+// Minimum transforms whose world matrices each worker updates. Subtrees of the scene root are grouped up to it
+#define ENGINE_MIN_TRANSFORMS_PER_JOB 1024
+
+// Meshlet bounds. They fit the task/mesh shader workgroups of most vendors
+#define ENGINE_MESHLET_MAX_VERTICES 64
+#define ENGINE_MESHLET_MAX_TRIANGLES 124
+// Triangle count from which the loaders cluster a geometry into meshlets
+#define ENGINE_MESHLET_MIN_TRIANGLES 4096
+// Coarser levels of detail the loaders generate at most, for geometry with at least ENGINE_LOD_MIN_TRIANGLES triangles
+#define ENGINE_MAX_LODS 4
+#define ENGINE_LOD_MIN_TRIANGLES 4096
+
+// Size of the persistent staging ring used for batched transfers
+#define ENGINE_STAGING_BUFFER_SIZE (64 * 1024 * 1024)
+#define ENGINE_STAGING_ALIGNMENT 16
 
 // File terminations
 #define PLY "ply"
@@ -238,6 +267,11 @@ typedef enum VertexAttributeType
     UV_ATTRIBUTE       = 3,
     COLOR_ATTRIBUTE    = 4
 } VertexAttributeType;
+typedef enum VertexLayout
+{
+    STANDARD_VERTEX_LAYOUT = 0, // Single interleaved stream of FP32 Vertex
+    PACKED_VERTEX_LAYOUT   = 1, // FP32 position stream plus a quantized PackedVertex stream
+} VertexLayout;
 typedef enum ShadowType
 {
     BASIC_SHADOW     = 0, // Classic shadow mapping
@@ -266,8 +300,9 @@ enum QueueType
 {
     GRAPHIC_QUEUE = 0,
     PRESENT_QUEUE = 1,
-    COMPUTE_QUEUE = 2,
-    RT_QUEUE      = 3
+    COMPUTE_QUEUE  = 2,
+    RT_QUEUE       = 3,
+    TRANSFER_QUEUE = 4
 };
 enum AttachmentType
 {
@@ -283,6 +318,7 @@ enum UniformDataType
     UNIFORM_COMBINED_IMAGE_SAMPLER = 2,
     UNIFORM_ACCELERATION_STRUCTURE = 3,
     UNIFORM_STORAGE_IMAGE          = 4,
+    UNIFORM_STORAGE_BUFFER         = 5,
 };
 enum BorderColor
 {
@@ -300,6 +336,16 @@ typedef enum DescriptorLayoutType
     OBJECT_TEXTURE_LAYOUT = 2,
     G_BUFFER_LAYOUT       = 3
 } DescriptorLayout;
+/*
+Per-frame buffers stored in Frame::uniformBuffers
+*/
+typedef enum FrameBufferType
+{
+    GLOBAL_BUFFER   = 0, // Camera and scene uniforms
+    INSTANCE_BUFFER = 1, // Storage buffer. One Object3D::GPUPayload per instance ID
+    MATERIAL_BUFFER = 2, // Storage buffer. One IMaterial::GPUPayload per material index
+    DRAW_BUFFER     = 3, // Storage buffer. Draw records of the instances (or of their meshlets), consumed by GPU culling
+} FrameBufferType;
 typedef enum ColorFormatTypeFlagBits
 {
     SR_8      = VK_FORMAT_R8_SRGB,       // Red
@@ -398,6 +444,7 @@ typedef enum PipelineStageFlagsBits
     STAGE_COMPUTE_SHADER          = 0x00000008,
     STAGE_FRAGMENT_SHADER         = 0x00000009,
     STAGE_ALL_COMMANDS            = 0x00000010,
+    STAGE_DRAW_INDIRECT           = 0x00000011,
 } PipelineStage;
 typedef enum AccessFlagsBits
 {
@@ -411,6 +458,8 @@ typedef enum AccessFlagsBits
     ACCESS_SHADER_READ                    = 0x00000007,
     ACCESS_SHADER_WRITE                   = 0x00000008,
     ACCESS_MEMORY_READ                    = 0x00000009,
+    ACCESS_INDIRECT_COMMAND_READ          = 0x0000000A,
+    ACCESS_SHADER_READ_WRITE              = 0x0000000B,
     ACCESS_MAX                            = 0x00000010
 } AccessFlags;
 typedef enum AttachmentStoreOpFlagsBits
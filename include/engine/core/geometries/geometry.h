@@ -11,6 +11,8 @@
 #define GEOMETRY_H
 
 #include <engine/common.h>
+#include <engine/core/geometries/lod.h>
+#include <engine/core/geometries/meshlet.h>
 #include <engine/graphics/accel.h>
 #include <engine/graphics/vao.h>
 
@@ -27,11 +29,22 @@ enum class Topology
     LINES_TO_TRIANGLES = 2,
     OTHER              = 3
 };
+/*
+What happens to the CPU copy of the geometric data once it lives on the GPU
+*/
+enum class CPUResidency
+{
+    KEEP                 = 0, // Kept, so the geometry can be uploaded again after being evicted
+    RELEASE_AFTER_UPLOAD = 1, // Freed after the upload. Bounds and topology are kept, but the geometry can't be uploaded again
+};
 
 struct GeometricData {
     std::vector<uint32_t>         vertexIndex;
     std::vector<Graphics::Vertex> vertexData;
     std::vector<Graphics::Voxel>  voxelData;
+    std::vector<Meshlet>          meshlets; // Kept when the CPU data is released, GPU culling draws from them
+    std::vector<uint32_t>         lodIndex; // Indices of the coarser levels of detail
+    std::vector<GeometryLOD>      lods;     // Kept when the CPU data is released
 
     // Topology
     Topology topology{Topology::TRIANGLES};
@@ -42,6 +55,7 @@ struct GeometricData {
     Vec3 center;
 
     bool loaded{false};
+    bool released{false}; // Arrays freed after the upload
 
     void compute_statistics();
 };
@@ -58,6 +72,7 @@ class Geometry
 
     GeometricData m_properties = {};
     size_t        m_materialID = 0;
+    CPUResidency  m_residency  = CPUResidency::KEEP;
 
     friend Graphics::VertexArrays* const get_VAO(Geometry* g);
     friend Graphics::BLAS* const         get_BLAS(Geometry* g);
@@ -80,8 +95,51 @@ class Geometry
         return m_properties.loaded;
     }
     inline bool indexed() const {
-        return !m_properties.vertexIndex.empty();
+        return m_properties.released ? m_VAO.indexCount > 0 : !m_properties.vertexIndex.empty();
+    }
+    inline VertexLayout get_vertex_layout() const {
+        return m_VAO.layout;
+    }
+    /*
+    Vertex layout the geometry is uploaded with. The packed one halves the vertex bandwidth and gives depth only passes a
+    position stream of their own. Has to be set before the geometry is uploaded
+    */
+    inline void set_vertex_layout(VertexLayout layout) {
+        m_VAO.layout = layout;
     }
+    inline CPUResidency get_CPU_residency() const {
+        return m_residency;
+    }
+    inline void set_CPU_residency(CPUResidency residency) {
+        m_residency = residency;
+    }
+    /*
+    Whether the CPU arrays are still there, so the geometry can be (re)uploaded or read back
+    */
+    inline bool CPU_data_available() const {
+        return m_properties.loaded && !m_properties.released;
+    }
+    inline bool has_meshlets() const {
+        return !m_properties.meshlets.empty();
+    }
+    /*
+    Clusters the triangles into meshlets, reordering the index array. GPU-driven passes then cull and draw every meshlet on its
+    own. Has to be called before the geometry is uploaded. Returns false if the geometry is not an indexed triangle list
+    */
+    bool build_meshlets(uint32_t maxVertices = ENGINE_MESHLET_MAX_VERTICES, uint32_t maxTriangles = ENGINE_MESHLET_MAX_TRIANGLES);
+    inline uint32_t get_LOD_count() const {
+        return static_cast<uint32_t>(m_properties.lods.size());
+    }
+    /*
+    Simplifies the geometry into up to maxLevels coarser levels of detail, drawn by the GPU-driven passes as it gets smaller on
+    screen. Has to be called before the geometry is uploaded. Returns false if the geometry is not an indexed triangle list or
+    can't be simplified
+    */
+    bool build_LODs(uint32_t maxLevels = ENGINE_MAX_LODS, float reduction = 0.5f);
+    /*
+    Frees the vertex, index and voxel arrays. Called by the renderer after the upload if the residency policy says so
+    */
+    void release_CPU_data();
 
     inline const GeometricData& get_properties() const {
         return m_properties;
@@ -112,11 +170,32 @@ class Geometry
         m_BLAS.dynamic = op;
     }
 
+    /*
+    Arrays are taken by value and moved in, so passing them with std::move hands them over without copies
+    */
     void fill(std::vector<Graphics::Vertex> vertexInfo, Topology topology = Topology::TRIANGLES);
     void fill(std::vector<Graphics::Vertex> vertexInfo, std::vector<uint32_t> vertexIndex, Topology topology = Topology::TRIANGLES);
     void fill(Vec3* pos, Vec3* normal, Vec2* uv, Vec3* tangent, uint32_t vertNumber, Topology topology = Topology::TRIANGLES);
+    /*
+    Bulk copy of already processed data, such as a mapped geometry cache. Bounds are taken as given instead of being recomputed
+    */
+    void fill(const Graphics::Vertex* vertices,
+              size_t                  vertexCount,
+              const uint32_t*         indices,
+              size_t                  indexCount,
+              Topology                topology,
+              const Vec3&             minCoords,
+              const Vec3&             maxCoords);
 
     void fill_voxel_array(std::vector<Graphics::Voxel> voxels);
+    /*
+    Already built meshlets, such as the ones of a geometry cache. The index array has to be ordered by them
+    */
+    void fill_meshlet_array(std::vector<Meshlet> meshlets);
+    /*
+    Already built levels of detail, such as the ones of a geometry cache
+    */
+    void fill_LOD_array(std::vector<GeometryLOD> lods, std::vector<uint32_t> lodIndex);
 
     /* Primitive creator helpers */
     static Geometry* create_quad();
@@ -0,0 +1,55 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+
+#ifndef LOD_H
+#define LOD_H
+
+#include <engine/common.h>
+#include <engine/graphics/vao.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+/*
+Coarser level of detail of a geometry. Levels reuse the vertices of the full detail geometry, only their indices are stored. On
+the GPU they follow the full detail indices in the same index buffer.
+*/
+struct GeometryLOD {
+    uint32_t firstIndex = 0;    // From the start of the index buffer (full detail indices first)
+    uint32_t indexCount = 0;
+    float    error      = 0.0f; // Object space deviation from the full detail surface. Grows with every level
+    uint32_t padding    = 0;
+};
+
+/*
+Quadric error metric edge collapse. Vertices collapse onto one of their neighbours, so no vertex is created or moved. Vertices
+on open borders or attribute seams (positions shared by several vertices) never collapse away, which keeps the UV layout and
+the silhouette of open meshes. Stops at targetIndexCount or when nothing can collapse without folding triangles. The error of
+the result is written into resultError
+*/
+std::vector<uint32_t> simplify(const std::vector<Graphics::Vertex>& vertices,
+                               const std::vector<uint32_t>&         indices,
+                               size_t                               targetIndexCount,
+                               float*                               resultError = nullptr);
+/*
+Chain of levels, each one about reduction times the triangles of the previous. Their indices are appended into lodIndices,
+placed after the indices of the full detail geometry. Stops when a level can't get meaningfully simpler
+*/
+std::vector<GeometryLOD> build_LODs(const std::vector<Graphics::Vertex>& vertices,
+                                    const std::vector<uint32_t>&         indices,
+                                    std::vector<uint32_t>&               lodIndices,
+                                    uint32_t                             maxLevels = ENGINE_MAX_LODS,
+                                    float                                reduction = 0.5f);
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
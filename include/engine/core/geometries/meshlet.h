@@ -0,0 +1,56 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <engine/common.h>
+#include <engine/graphics/vao.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+/*
+Cluster of neighbouring triangles with bounded vertex and triangle counts. The index array of the geometry is reordered so
+every meshlet owns a contiguous range of it, which lets meshlets be drawn as regular indexed draws.
+*/
+struct Meshlet {
+    uint32_t firstIndex     = 0; // Into the geometry index array
+    uint32_t indexCount     = 0;
+    uint32_t vertexCount    = 0; // Unique vertices referenced
+    uint32_t padding        = 0;
+    Vec4     boundingSphere = Vec4(0.0f);                   // Object space center and radius
+    Vec4     normalCone     = Vec4(0.0f, 0.0f, 0.0f, 1.0f); // Object space axis and cutoff. A cutoff of 1 means no cone
+
+    inline bool has_cone() const {
+        return normalCone.w < 1.0f;
+    }
+};
+
+/*
+Greedy clustering of an indexed triangle list. Triangles sharing vertices with the last one added are preferred, so meshlets
+grow as compact patches. Indices are reordered in place, triangle winding is kept.
+*/
+std::vector<Meshlet> build_meshlets(const std::vector<Graphics::Vertex>& vertices,
+                                    std::vector<uint32_t>&               indices,
+                                    uint32_t                             maxVertices  = ENGINE_MESHLET_MAX_VERTICES,
+                                    uint32_t                             maxTriangles = ENGINE_MESHLET_MAX_TRIANGLES);
+/*
+CPU version of the meshlet culling done by shaders/culling/instance_culling.glsl. The bounding sphere is tested against the
+frustum planes of viewProj and, with coneCulling, the normal cone against the camera position: meshlets whose triangles are all
+back facing are culled. Cone culling is skipped for models with non uniform scale or mirroring.
+*/
+bool is_meshlet_visible(const Meshlet& meshlet, const Mat4& model, const Mat4& viewProj, const Vec3& cameraPosition, bool coneCulling = true);
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -66,7 +66,7 @@ public:
     virtual std::unordered_map<int, bool>      get_texture_binding_state() const               = 0;
     virtual void                               set_texture_binding_state( int id, bool state ) = 0;
 
-    virtual std::string get_shaderpass_ID() const {
+    virtual const std::string& get_shaderpass_ID() const {
         return m_shaderPassID;
     }
     virtual inline MaterialSettings get_parameters() const {
@@ -98,6 +98,15 @@ public:
     virtual inline Graphics::DescriptorSet& get_texture_descriptor() {
         return m_textureDescriptor;
     }
+    /*
+    Set when a parameter or texture changes. The scene builder clears it once every texture of the material is resident
+    */
+    inline bool is_dirty() const {
+        return m_isDirty;
+    }
+    inline void set_dirty( bool d ) {
+        m_isDirty = d;
+    }
 };
 
 } // namespace Core
@@ -46,6 +46,10 @@ struct Frustum {
     Face farFace;
     Face nearFace;
 };
+/*
+Frustum of a view projection matrix (Vulkan clip space, depth from 0 to 1). For views other than cameras, such as lights
+*/
+Frustum extract_frustum( const Mat4& viewProj );
 
 class Camera : public Object3D
 {
@@ -0,0 +1,89 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <engine/core/scene/camera.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+/*
+One bit per object, set if it passed the culling test
+*/
+struct VisibilityMask {
+    std::vector<uint64_t> words;
+    uint32_t              count = 0;
+
+    inline void resize( uint32_t n ) {
+        count = n;
+        words.assign( ( n + 63 ) / 64, 0 );
+    }
+    inline bool is_visible( uint32_t i ) const {
+        return i < count && ( words[i >> 6] >> ( i & 63 ) ) & 1u;
+    }
+    inline void set_visible( uint32_t i ) {
+        words[i >> 6] |= uint64_t( 1 ) << ( i & 63 );
+    }
+    uint32_t count_visible() const;
+    /*
+    Appends the indices of the visible objects in increasing order
+    */
+    void get_visible( std::vector<uint32_t>& indices ) const;
+};
+
+/*
+World space bounds of a set of objects in structure of arrays form, so the culling kernel reads every component of several
+objects with a single load. Every object has a bounding sphere and an axis aligned box sharing the same center. Arrays are
+padded to the widest SIMD width, padding and disabled objects are never visible.
+*/
+struct CullingBounds {
+    std::vector<float>    centerX;
+    std::vector<float>    centerY;
+    std::vector<float>    centerZ;
+    std::vector<float>    radius;
+    std::vector<float>    extentX;
+    std::vector<float>    extentY;
+    std::vector<float>    extentZ;
+    VisibilityMask        enabled;
+    uint32_t              count = 0;
+
+    /*
+    Keeps the bounds already set. New objects start disabled
+    */
+    void resize( uint32_t n );
+    /*
+    Sets the bounds of an object from its object space box and its model matrix, and enables it
+    */
+    void set( uint32_t i, const Mat4& model, const Vec3& minCoords, const Vec3& maxCoords );
+    inline void disable( uint32_t i ) {
+        enabled.words[i >> 6] &= ~( uint64_t( 1 ) << ( i & 63 ) );
+    }
+};
+
+/*
+Tests every enabled object against the frustum. An object is visible if both its sphere and its box are on the positive side of
+(or cross) every face. Runs 8 objects per iteration with AVX2, 4 with SSE2 or NEON, one at a time otherwise
+*/
+void cull_frustum( const CullingBounds& bounds, const Frustum& frustum, VisibilityMask& visibility );
+/*
+Scalar version of cull_frustum. Reference for the SIMD kernels, and fallback on targets without them
+*/
+void cull_frustum_scalar( const CullingBounds& bounds, const Frustum& frustum, VisibilityMask& visibility );
+/*
+Instruction set the culling kernel was compiled for
+*/
+const char* get_culling_ISA();
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -181,6 +181,15 @@ public:
     virtual Light::GPUPayload get_uniforms( Mat4 cameraView ) const = 0;
 };
 
+/*
+Shadow views of a cascaded directional light, nearest first
+*/
+struct ShadowCascades {
+    uint32_t count = 0;
+    float    splits[ENGINE_MAX_CASCADES]   = {}; // Far distance of each cascade from the camera
+    Mat4     viewProj[ENGINE_MAX_CASCADES] = {};
+};
+
 // POINT LIGHT
 
 class PointLight : public Light
@@ -213,6 +222,9 @@ class DirectionalLight : public Light
     Vec3 m_direction;
     // Only works if using procedural sky as enviroment
     bool m_useAsSun = false;
+    // Cascaded shadows. The camera frustum, up to the shadow far plane, is split among them
+    uint32_t m_cascades      = ENGINE_MAX_CASCADES; // 1 falls back to a single map framed by the shadow fov and target
+    float    m_cascadeLambda = 0.75f;               // Blend between uniform (0) and logarithmic (1) splits
 
     static int m_instanceCount;
 
@@ -240,6 +252,35 @@ public:
         m_useAsSun = op;
     }
 
+    /*
+    Only the first active directional light with shadow maps and more than one cascade is cascaded
+    */
+    inline uint32_t get_cascade_count() const {
+        return m_cascades;
+    }
+    inline void set_cascade_count( uint32_t count ) {
+        m_cascades = std::min( std::max( count, 1u ), (uint32_t)ENGINE_MAX_CASCADES );
+    }
+    inline float get_cascade_lambda() const {
+        return m_cascadeLambda;
+    }
+    inline void set_cascade_lambda( float lambda ) {
+        m_cascadeLambda = std::min( std::max( lambda, 0.0f ), 1.0f );
+    }
+
+    /*
+    Splits the view frustum of a camera, up to the shadow far plane, into the cascades of the light, and fits an orthographic view
+    around each slice. Fits are snapped to the shadow map texels, so they only change when the camera moves more than a texel and
+    shadow edges do not swim. Casters between the light and a slice are kept as long as they are inside the scene bounds
+    */
+    ShadowCascades get_shadow_cascades( const Mat4& cameraView,
+                                        const Mat4& cameraProj,
+                                        float       cameraNear,
+                                        float       cameraFar,
+                                        const Vec3& sceneMin,
+                                        const Vec3& sceneMax,
+                                        uint32_t    resolution ) const;
+
     static Vec3 get_sun_direction( float elevationDeg, float rotationDeg );
 
     virtual Light::GPUPayload get_uniforms( Mat4 cameraView ) const;
@@ -10,6 +10,7 @@
 #define OBJECT3D_H
 
 #include <engine/common.h>
+#include <engine/core/scene/transform_hierarchy.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
@@ -64,6 +65,27 @@ protected:
     bool m_isSelected { false };
     bool isDirty { true };
 
+    // World matrix cache. Objects outside a hierarchy only cache their local matrix
+    TransformHierarchy* m_hierarchy { nullptr };
+    uint32_t            m_hierarchySlot { 0 };
+    bool                m_localDirty { true };
+
+    friend class TransformHierarchy;
+
+    inline Mat4 compute_local_matrix() const {
+        Mat4 local = math::translate( Mat4( 1.0f ), m_transform.position );
+        local      = math::rotate( local, m_transform.rotation.x, Vec3( 1, 0, 0 ) );
+        local      = math::rotate( local, m_transform.rotation.y, Vec3( 0, 1, 0 ) );
+        local      = math::rotate( local, m_transform.rotation.z, Vec3( 0, 0, 1 ) );
+        return math::scale( local, m_transform.scale );
+    }
+    inline void mark_transform_dirty() {
+        isDirty      = true;
+        m_localDirty = true;
+        if ( m_hierarchy )
+            m_hierarchy->mark_dirty( this );
+    }
+
 public:
     Object3D( const std::string na, ObjectType t )
         : TYPE( t )
@@ -117,7 +139,7 @@ public:
     };
     virtual void set_position( const Vec3 p ) {
         m_transform.position = p;
-        isDirty              = true;
+        mark_transform_dirty();
     }
 
     virtual inline Vec3 get_position() {
@@ -141,7 +163,7 @@ public:
         // Update UP
         m_transform.up = math::cross( m_transform.right, m_transform.forward );
 
-        isDirty = true;
+        mark_transform_dirty();
     }
 
     virtual inline Vec3 get_rotation( bool radians = false ) {
@@ -150,18 +172,19 @@ public:
 
     virtual void set_scale( const Vec3 s ) {
         m_transform.scale = s;
-        isDirty           = true;
+        mark_transform_dirty();
     }
 
     virtual inline void look_at( Vec3 pos, Vec3 target, Vec3 up ) {
         m_transform.position = pos;
         m_transform.up       = up;
         m_transform.forward  = math::normalize( target - pos );
+        mark_transform_dirty();
     }
 
     virtual void set_scale( const float s ) {
         m_transform.scale = Vec3( s );
-        isDirty           = true;
+        mark_transform_dirty();
     }
 
     virtual inline Vec3 get_scale() {
@@ -213,30 +236,30 @@ public:
 
     virtual void set_transform( Transform t ) {
         m_transform = t;
-        isDirty     = true;
+        mark_transform_dirty();
     }
 
+    /*
+    World matrix. Objects in a scene read it from the scene transform hierarchy, where it is only recomputed when the object or
+    one of its ancestors moved
+    */
     virtual Mat4 get_model_matrix() {
-        //  Dirty flag
-        if ( isDirty )
-        {
-
-            m_transform.worldMatrix = Mat4( 1.0f );
-            m_transform.worldMatrix = math::translate( m_transform.worldMatrix, m_transform.position );
-            m_transform.worldMatrix = math::rotate( m_transform.worldMatrix, m_transform.rotation.x, Vec3( 1, 0, 0 ) );
-            m_transform.worldMatrix = math::rotate( m_transform.worldMatrix, m_transform.rotation.y, Vec3( 0, 1, 0 ) );
-            m_transform.worldMatrix = math::rotate( m_transform.worldMatrix, m_transform.rotation.z, Vec3( 0, 0, 1 ) );
-            m_transform.worldMatrix = math::scale( m_transform.worldMatrix, m_transform.scale );
+        if ( m_hierarchy )
+            return m_hierarchy->resolve( this );
 
-            isDirty = false;
+        if ( m_localDirty )
+        {
+            m_transform.worldMatrix = compute_local_matrix();
+            m_localDirty            = false;
         }
-
         return m_parent ? m_parent->get_model_matrix() * m_transform.worldMatrix : m_transform.worldMatrix;
     }
 
     virtual void add_child( Object3D* child ) {
         child->m_parent = this;
         m_children.push_back( child );
+        if ( m_hierarchy )
+            m_hierarchy->invalidate_topology();
     }
 
     virtual std::vector<Object3D*> get_children() const {
@@ -263,8 +286,8 @@ public:
 
     struct GPUPayload {
         Mat4 model;
-        Vec4 otherParams1; // x is affected by fog, y is receive shadows, z cast shadows, w is line/point width
-        Vec4 otherParams2; // x is selected // is affected by ambient light
+        Vec4 otherParams1; // x is affected by fog, y is receive shadows, z cast shadows, w is instance ID
+        Vec4 otherParams2; // x is material index, yzw is bounding volume center
     };
 };
 } // namespace Core
@@ -10,8 +10,10 @@
 #define SCENE_H
 
 #include <engine/core/scene/camera.h>
+#include <engine/core/scene/culling.h>
 #include <engine/core/scene/light.h>
 #include <engine/core/scene/mesh.h>
+#include <engine/core/scene/scene_BVH.h>
 #include <engine/core/scene/skybox.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
@@ -41,6 +43,19 @@ private:
     float m_fogExponent      = 1.0f;
     // BVOL
     AABB m_volume = ( this );
+    // SPATIAL HIERARCHY (world space bounds of the active meshes)
+    struct BVHProxy {
+        int32_t  id;
+        uint32_t stamp;
+    };
+    SceneBVH                                  m_BVH;
+    std::unordered_map<const Mesh*, BVHProxy> m_BVHProxies;
+    uint32_t                                  m_BVHStamp = 0;
+    // WORLD MATRICES OF EVERY OBJECT UNDER THE SCENE
+    TransformHierarchy m_transforms;
+    // CULLING (indexed as the mesh list)
+    CullingBounds  m_cullingBounds;
+    VisibilityMask m_cameraVisibility;
 
     inline void classify_object( Object3D* obj ) {
         switch ( obj->get_type() )
@@ -63,6 +78,8 @@ private:
         for ( auto child : obj->get_children() )
             classify_object( child );
     }
+    // Cube around the given box, so voxels stay cubic
+    void fit_volume( const Vec3& minCoords, const Vec3& maxCoords );
 
     friend void            set_meshes( Scene* const scene, std::vector<Mesh*> meshes );
     friend Graphics::TLAS* get_TLAS( Scene* const scene );
@@ -70,10 +87,13 @@ private:
 public:
     Scene( Camera* cam )
         : m_activeCamera( cam ) {
+        m_transforms.set_root( this );
         add_child( cam );
     };
     Scene()
-        : m_activeCamera( nullptr ) {};
+        : m_activeCamera( nullptr ) {
+        m_transforms.set_root( this );
+    };
     ~Scene() {
         delete m_activeCamera;
         delete m_skybox;
@@ -101,13 +121,14 @@ public:
     inline void add_child( Object3D* obj ) {
         classify_object( obj );
         Object3D::add_child( obj );
+        m_transforms.invalidate_topology();
         isDirty = true;
     }
 
     inline Camera* const get_active_camera() const {
         return m_activeCamera;
     }
-    inline const std::vector<Mesh*> get_meshes() const {
+    inline const std::vector<Mesh*>& get_meshes() const {
         return m_meshes;
     }
     inline const std::vector<Camera*> get_cameras() const {
@@ -184,12 +205,38 @@ public:
 
     /*
     Setup axis-aligned bounding volume for the entire scene. This object might be necessary for some functionalities,
-    sush as voxelization of the scene.
+    sush as voxelization of the scene. update_culling_data() already keeps it fitted to the active meshes
     */
     void        update_AABB();
     inline AABB get_AABB() const {
         return m_volume;
     }
+    /*
+    Updates the world matrices of every object that moved, or whose ancestors moved, since the last call. Call it once per
+    frame before anything reads them, so later reads are cache hits
+    */
+    inline void update_transforms( Utils::JobSystem* jobSystem = nullptr ) {
+        m_transforms.update( jobSystem );
+    }
+    /*
+    Refits the spatial hierarchy and the culling bounds to the current transforms of the meshes, and culls them against the
+    active camera. Only meshes whose bounds left their leaves touch the tree. Also fits the scene AABB. Call it once per frame,
+    after the mesh list is final (indices in the results are positions in it), and share the results among every view that needs
+    CPU culling
+    */
+    void                   update_culling_data();
+    inline const SceneBVH& get_BVH() const {
+        return m_BVH;
+    }
+    inline const CullingBounds& get_culling_bounds() const {
+        return m_cullingBounds;
+    }
+    /*
+    Meshes seen by the active camera this frame. Every enabled mesh if the camera does not cull
+    */
+    inline const VisibilityMask& get_camera_visibility() const {
+        return m_cameraVisibility;
+    }
 
     struct GPUPayload {
         Vec4              fogColorAndSSAO; // w is for enabling SSAO
@@ -205,6 +252,12 @@ public:
         float             envRotation;
         float             envColorMultiplier;
         float             time;
+        // Cascaded directional light. Cascade c is drawn into shadow layer ENGINE_MAX_LIGHTS + c
+        int               cascadeLight; // Light slot. Negative if none
+        int               cascadeCount;
+        float             cascadePadding[3];
+        Vec4              cascadeSplits; // Far distance of each cascade from the camera
+        Mat4              cascadeViewProj[ENGINE_MAX_CASCADES];
     };
 };
 
@@ -0,0 +1,131 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include <engine/core/scene/camera.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+// Ahead declare
+class Mesh;
+
+/*
+Dynamic bounding volume hierarchy over the world space bounds of the scene meshes. Leaves store fattened bounds, so objects
+moving inside them do not touch the tree. Objects leaving them are reinserted, and the tree is kept balanced by rotations
+on the way up. Queries test the fattened bounds, so they are conservative, and return the index of the mesh in the scene
+list, the same one used as instance ID on the GPU.
+*/
+class SceneBVH
+{
+public:
+    static constexpr int32_t  NULL_NODE = -1;
+    static constexpr uint32_t MAX_VIEWS = 32; // Views tested at once by a batched frustum query
+
+    struct Node {
+        Vec3     minCoords = Vec3( INFINITY );
+        Vec3     maxCoords = Vec3( -INFINITY );
+        int32_t  parent    = NULL_NODE; // Next free node while in the free list
+        int32_t  left      = NULL_NODE;
+        int32_t  right     = NULL_NODE;
+        int32_t  height    = 0; // Leaves are 0, free nodes -1
+        Mesh*    mesh      = nullptr;
+        uint32_t index     = 0;
+
+        inline bool is_leaf() const {
+            return left == NULL_NODE;
+        }
+    };
+    struct RayHit {
+        uint32_t index;
+        float    distance; // Along the ray to the bounds of the mesh, 0 if it starts inside
+    };
+
+private:
+    std::vector<Node> m_nodes;
+    int32_t           m_root      = NULL_NODE;
+    int32_t           m_freeList  = NULL_NODE;
+    uint32_t          m_leafCount = 0;
+    float             m_margin    = 0.1f;
+
+    int32_t allocate_node();
+    void    free_node( int32_t node );
+    void    insert_leaf( int32_t leaf );
+    void    remove_leaf( int32_t leaf );
+    int32_t balance( int32_t node );
+    void    fit( int32_t node );
+
+public:
+    /*
+    Margin is the fraction of the size of the bounds added on every side of the leaves
+    */
+    SceneBVH( float margin = 0.1f )
+        : m_margin( margin ) {
+    }
+
+    /*
+    Returns the proxy of the mesh, which identifies its leaf until removed
+    */
+    int32_t insert( Mesh* mesh, uint32_t index, const Vec3& minCoords, const Vec3& maxCoords );
+    void    remove( int32_t proxy );
+    /*
+    Updates the bounds of a proxy. Only reinserts it if they left its fattened bounds, returning true then
+    */
+    bool move( int32_t proxy, const Vec3& minCoords, const Vec3& maxCoords );
+    void clear();
+
+    inline void set_index( int32_t proxy, uint32_t index ) {
+        m_nodes[proxy].index = index;
+    }
+    inline const Node& get_node( int32_t proxy ) const {
+        return m_nodes[proxy];
+    }
+    inline uint32_t get_count() const {
+        return m_leafCount;
+    }
+    inline uint32_t get_height() const {
+        return m_root == NULL_NODE ? 0 : m_nodes[m_root].height;
+    }
+    /*
+    Bounds of the whole hierarchy (fattened)
+    */
+    inline void get_bounds( Vec3& minCoords, Vec3& maxCoords ) const {
+        minCoords = m_root == NULL_NODE ? Vec3( 0.0f ) : m_nodes[m_root].minCoords;
+        maxCoords = m_root == NULL_NODE ? Vec3( 0.0f ) : m_nodes[m_root].maxCoords;
+    }
+
+    /*
+    Meshes whose bounds touch the frustum. Planes a node is fully inside of are not tested again for its children
+    */
+    void query_frustum( const Frustum& frustum, std::vector<uint32_t>& results ) const;
+    /*
+    Several frustums in a single traversal (shadow cascades, light faces, stereo...). Results pair every mesh touching at least
+    one frustum with the mask of the frustums it touches. Up to MAX_VIEWS frustums
+    */
+    void query_frustums( const Frustum* frustums, uint32_t count, std::vector<std::pair<uint32_t, uint32_t>>& results ) const;
+    void query_sphere( const Vec3& center, float radius, std::vector<uint32_t>& results ) const;
+    /*
+    Meshes whose bounds the ray crosses before maxDistance, nearest first. Direction does not need to be normalized, distances
+    are then in units of its length
+    */
+    void query_ray( const Vec3& origin, const Vec3& direction, float maxDistance, std::vector<RayHit>& results ) const;
+};
+
+/*
+World space axis aligned bounds of a box transformed by the given matrix
+*/
+void transform_bounds( const Mat4& model, const Vec3& minCoords, const Vec3& maxCoords, Vec3& worldMin, Vec3& worldMax );
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -0,0 +1,91 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <engine/common.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Utils {
+class JobSystem;
+}
+
+namespace Core {
+
+// Ahead declare
+class Object3D;
+
+/*
+Local and world matrices of every object under a root, stored contiguously in depth first order. Parents always come before
+their children and every subtree is a contiguous range, so marking an object dirty flags its whole subtree by walking a single range,
+and a single forward pass updates every world matrix. Objects read their cached world matrix from here.
+*/
+class TransformHierarchy
+{
+public:
+    enum Flags : uint8_t
+    {
+        LOCAL_DIRTY = 1, // Position, rotation or scale changed
+        WORLD_DIRTY = 2, // An ancestor changed
+    };
+
+private:
+    Object3D*              m_root = nullptr;
+    std::vector<Object3D*> m_objects;
+    std::vector<int32_t>   m_parents;     // Slot of the parent, -1 for the root
+    std::vector<uint32_t>  m_subtreeEnds; // One past the last descendant
+    std::vector<Mat4>      m_local;
+    std::vector<Mat4>      m_world;
+    std::vector<uint8_t>   m_flags;
+    // Slot ranges of consecutive subtrees hanging from the root, of at least ENGINE_MIN_TRANSFORMS_PER_JOB transforms (but the
+    // last one). They are independent, so they are updated in parallel
+    std::vector<std::pair<uint32_t, uint32_t>> m_subtrees;
+
+    bool m_topologyDirty = true;
+    bool m_dirty         = true;
+
+    void        rebuild();
+    void        update_range( uint32_t begin, uint32_t end );
+    const Mat4& resolve_slot( uint32_t slot );
+
+public:
+    inline void set_root( Object3D* root ) {
+        m_root          = root;
+        m_topologyDirty = true;
+    }
+    /*
+    Objects were added or reparented. Slots are rebuilt on the next update or read
+    */
+    inline void invalidate_topology() {
+        m_topologyDirty = true;
+    }
+    /*
+    The transform of the object changed. Flags its descendants too
+    */
+    void          mark_dirty( const Object3D* object );
+    inline size_t size() const {
+        return m_objects.size();
+    }
+    /*
+    World matrix of an object of the hierarchy. Only recomputes it, and its dirty ancestors, if they changed since the last
+    update
+    */
+    const Mat4& resolve( const Object3D* object );
+    /*
+    Updates every dirty world matrix. Subtrees of the root are split among the workers of the job system if given
+    */
+    void update( Utils::JobSystem* jobSystem = nullptr );
+};
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
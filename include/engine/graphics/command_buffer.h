@@ -24,14 +24,72 @@ namespace Graphics {
 
 struct CommandPool;
 
+/*
+State last recorded into a command buffer. Pipeline, descriptor set and dynamic state binds equal to it are skipped. Every copy
+of a command buffer records into the same handle, so they share it. Forgotten when recording begins, and wherever the state is
+left undefined (secondary command buffers, GUI drawing)
+*/
+struct CommandState {
+    static constexpr uint32_t BIND_POINTS       = 3; // Graphic, compute and ray tracing
+    static constexpr uint32_t MAX_BOUND_SETS    = 4;
+    static constexpr uint32_t MAX_BOUND_OFFSETS = 4; // Binds with more dynamic offsets are always recorded
+
+    struct BoundSet {
+        VkDescriptorSet  handle                     = VK_NULL_HANDLE;
+        VkPipelineLayout layout                     = VK_NULL_HANDLE;
+        uint32_t         offsetCount                = 0;
+        uint32_t         offsets[MAX_BOUND_OFFSETS] = {};
+    };
+    VkPipeline pipelines[BIND_POINTS]            = {};
+    BoundSet   sets[BIND_POINTS][MAX_BOUND_SETS] = {};
+    // Dynamic state, -1 when unknown
+    int32_t cullMode        = -1;
+    int32_t depthTest       = -1;
+    int32_t depthWrite      = -1;
+    int32_t depthBiasEnable = -1;
+
+    uint32_t skippedBinds = 0; // Since recording began
+
+    /*
+    True if the dynamic state already has the value. Records it otherwise
+    */
+    inline bool is_set(int32_t& current, int32_t value) {
+        if (current == value)
+        {
+            skippedBinds++;
+            return true;
+        }
+        current = value;
+        return false;
+    }
+
+    inline void forget_dynamic_state() {
+        cullMode        = -1;
+        depthTest       = -1;
+        depthWrite      = -1;
+        depthBiasEnable = -1;
+    }
+    inline void forget() {
+        const uint32_t skipped = skippedBinds;
+        *this                  = {};
+        skippedBinds           = skipped;
+    }
+};
+
 struct CommandBuffer {
-    VkCommandBuffer handle      = VK_NULL_HANDLE;
-    VkDevice        device      = VK_NULL_HANDLE;
-    VkCommandPool   pool        = VK_NULL_HANDLE;
-    VkQueue         queue       = VK_NULL_HANDLE;
-    bool            isRecording = false;
+    VkCommandBuffer   handle      = VK_NULL_HANDLE;
+    VkDevice          device      = VK_NULL_HANDLE;
+    VkCommandPool     pool        = VK_NULL_HANDLE;
+    VkQueue           queue       = VK_NULL_HANDLE;
+    bool              isRecording = false;
+    ptr<CommandState> state; // Null for command buffers not allocated from a pool, nothing is skipped then
 
     void begin(VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    /*
+    Begins a secondary command buffer that continues a render pass. The primary has to begin that pass with
+    VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. Dynamic state is not inherited
+    */
+    void begin_secondary(RenderPass& renderpass, Framebuffer& fbo, uint32_t subpass = 0);
     void end();
     void reset();
     void submit(Fence fence = {}, std::vector<Semaphore> waitSemaphores = {}, std::vector<Semaphore> signalSemaphores = {});
@@ -43,14 +101,39 @@ struct CommandBuffer {
 
     void begin_renderpass(RenderPass& renderpass, Framebuffer& fbo, VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE);
     void end_renderpass(RenderPass& renderpass, Framebuffer& fbo);
+    void execute_commands(const std::vector<CommandBuffer>& secondaryBuffers);
     void draw_geometry(const VertexArrays& vao, uint32_t instanceCount = 1, uint32_t firstOcurrence = 0, int32_t offset = 0, uint32_t firstInstance = 0);
+    /*
+    Issues the VkDrawIndexedIndirectCommands written in commands (starting at commandOffset). The amount of draws is read from
+    countBuffer at countOffset and clamped to maxDraws. Every command reads from the vertex and index buffers of the given VAO
+    */
+    void draw_geometry_indirect(
+        const VertexArrays& vao, Buffer& commands, size_t commandOffset, Buffer& countBuffer, size_t countOffset, uint32_t maxDraws);
     void draw_gui_data();
-    void bind_shaderpass(ShaderPass& pass);
-    void bind_descriptor_set(DescriptorSet         descriptor,
-                             uint32_t              ocurrence,
-                             ShaderPass&           pass,
-                             std::vector<uint32_t> offsets = {},
-                             BindingType           binding = BINDING_TYPE_GRAPHIC);
+    void bind_shaderpass(const ShaderPass& pass);
+    /*
+    Binds the descriptor set at index ocurrence. Only the handle is read and the dynamic offsets are a view over the caller's
+    array, so nothing is copied or allocated. Skipped if the same set is already bound there with the same layout and offsets
+    */
+    void bind_descriptor_set(VkDescriptorSet   descriptor,
+                             uint32_t          ocurrence,
+                             const ShaderPass& pass,
+                             const uint32_t*   offsets,
+                             uint32_t          offsetCount,
+                             BindingType       binding = BINDING_TYPE_GRAPHIC);
+    inline void bind_descriptor_set(const DescriptorSet&            descriptor,
+                                    uint32_t                        ocurrence,
+                                    const ShaderPass&               pass,
+                                    std::initializer_list<uint32_t> offsets = {},
+                                    BindingType                     binding = BINDING_TYPE_GRAPHIC) {
+        bind_descriptor_set(descriptor.handle, ocurrence, pass, offsets.begin(), static_cast<uint32_t>(offsets.size()), binding);
+    }
+    /*
+    Pipeline, descriptor set and dynamic state binds skipped since recording began, as they were already bound
+    */
+    inline uint32_t get_skipped_binds() const {
+        return state ? state->skippedBinds : 0;
+    }
     void set_viewport(Extent2D extent, Offset2D scissorOffset = {0, 0});
     void set_cull_mode(CullingMode mode);
     void set_depth_write_enable(bool op);
@@ -75,7 +158,24 @@ struct CommandBuffer {
                           PipelineStage srcStage  = STAGE_COLOR_ATTACHMENT_OUTPUT,
                           PipelineStage dstStage  = STAGE_FRAGMENT_SHADER);
 
+    /*
+    Global memory barrier. Useful for buffers written and read by different stages in the same command buffer
+    */
+    void memory_barrier(AccessFlags   srcMask  = ACCESS_SHADER_WRITE,
+                        AccessFlags   dstMask  = ACCESS_SHADER_READ,
+                        PipelineStage srcStage = STAGE_COMPUTE_SHADER,
+                        PipelineStage dstStage = STAGE_FRAGMENT_SHADER);
+
     void clear_image(Image& img, ImageLayout layout, ImageAspect aspect = ASPECT_COLOR, Vec4 clearColor = Vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    /*
+    Clears a range of layers of an attachment of the current render pass. Layers out of the range keep their content
+    */
+    void clear_attachment(uint32_t    attachment,
+                          ClearValue  clearValue,
+                          Extent2D    extent,
+                          uint32_t    baseLayer  = 0,
+                          uint32_t    layerCount = 1,
+                          ImageAspect aspect     = ASPECT_COLOR);
 
     /*Copy the entire extent of the image*/
     void blit_image(Image&      srcImage,
@@ -101,12 +201,18 @@ struct CommandBuffer {
 
     void dispatch_compute(Extent3D grid);
 
-    void copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size);
+    void copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size, size_t srcOffset = 0, size_t dstOffset = 0);
+
+    void fill_buffer(Buffer& buffer, uint32_t value, size_t size, size_t offset = 0);
 
     /*
     Expected layout is LAYOUT_UNDEFINED
     */
     void copy_buffer_to_image(Image& img, Buffer& buffer);
+    /*
+    Same as above, but reading from a region of a shared buffer. Layers are expected to be tightly packed every layerSize bytes.
+    */
+    void copy_buffer_to_image(Image& img, Buffer& buffer, size_t bufferOffset, size_t layerSize);
     
     void copy_image_to_buffer(Image& img, Buffer& buffer);
 
@@ -87,6 +87,10 @@ struct DescriptorPool {
 
     void allocate_descriptor_set( uint32_t layoutSetIndex, DescriptorSet* descriptor );
     void allocate_variable_descriptor_set( uint32_t layoutSetIndex, DescriptorSet* descriptor, uint32_t count );
+    /*
+    Same as above, with a layout owned by another pool. For sets living in a pool of their own, so it can be recreated bigger
+    */
+    void allocate_variable_descriptor_set( const DescriptorLayout& layout, uint32_t layoutSetIndex, DescriptorSet* descriptor, uint32_t count );
 
     void cleanup();
 };
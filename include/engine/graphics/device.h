@@ -27,6 +27,10 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 
 namespace Graphics {
 /*
+Handle returned by asynchronous uploads. Can be polled with Device::is_upload_complete(). Zero means no upload
+*/
+typedef uint64_t UploadTicket;
+/*
 Vulkan API graphic context related data and functionality
 */
 class Device
@@ -43,6 +47,9 @@ class Device
     VkPhysicalDeviceProperties       m_properties       = {};
     VkPhysicalDeviceFeatures         m_features         = {};
     VkPhysicalDeviceMemoryProperties m_memoryProperties = {};
+    // Driver pipeline cache. Loaded at init and written back at cleanup
+    VkPipelineCache m_pipelineCache     = VK_NULL_HANDLE;
+    std::string     m_pipelineCachePath = ""; // Defaults to resources/shaders/.cache/pipelines.bin
     // Validation
     VkDebugUtilsMessengerEXT       m_debugMessenger   = VK_NULL_HANDLE;
     const std::vector<const char*> m_validationLayers = {"VK_LAYER_KHRONOS_validation"};
@@ -59,11 +66,53 @@ class Device
         Fence         uploadFence;
         CommandPool   commandPool;
         CommandBuffer commandBuffer;
+        /*Persistently mapped staging ring. Recycled after every flush*/
+        Buffer              stagingBuffer;
+        char*               stagingData   = nullptr;
+        size_t              stagingOffset = 0;
+        std::vector<Buffer> overflowBuffers; // Dedicated staging for transfers bigger than the ring
+        /*Batching state*/
+        uint32_t batchDepth    = 0;
+        uint32_t pendingCopies = 0;
 
         void immediate_submit(std::function<void(CommandBuffer cmd)>&& function);
+        /*Submits all recorded transfers and waits once for them*/
+        void submit_pending();
+        /*Same as above, but reopens recording if a batch is still active*/
+        void flush();
+        void release_staging();
         void cleanup();
     };
     UploadContext m_uploadContext = {};
+    /*
+    Asynchronous uploads. Copies run on the transfer queue. A second, graphics-queue submission acquires queue ownership (when families
+    differ) and generates mipmaps. A fence per submission is polled to flag the resources as resident
+    */
+    struct TransferContext {
+        struct Submission {
+            UploadTicket  ticket = 0;
+            CommandBuffer transferCmd;
+            CommandBuffer graphicCmd;
+            Semaphore     ownershipSemaphore;
+            Fence         fence;
+            Buffer        staging;
+            VertexArrays* vao   = nullptr;
+            Image*        image = nullptr;
+        };
+        CommandPool             transferPool;
+        CommandPool             graphicPool;
+        uint32_t                transferFamily = 0;
+        uint32_t                graphicFamily  = 0;
+        UploadTicket            lastTicket     = 0;
+        std::vector<Submission> inFlight;
+        std::vector<Submission> available; // Recycled command buffers and sync objects
+
+        inline bool needs_ownership_transfer() const {
+            return transferFamily != graphicFamily;
+        }
+        void cleanup();
+    };
+    TransferContext m_transferContext = {};
 
 #ifdef NDEBUG
     const bool m_enableValidationLayers{false};
@@ -72,6 +121,16 @@ class Device
 #endif
 
     void create_upload_context();
+    void create_transfer_context();
+    /*Loads the blob on disk if it was written by this same GPU and driver*/
+    void create_pipeline_cache();
+    void save_pipeline_cache();
+    TransferContext::Submission& acquire_transfer_submission();
+    UploadTicket                 submit_transfer(TransferContext::Submission& submission, bool needsGraphicStage);
+    /*Copies data into the staging ring (or a dedicated buffer if it does not fit) and returns the buffer and offset to copy from*/
+    Buffer& stage_data(const void* data, size_t size, size_t& offset);
+    /*Records transfer commands into the open batch or submits them right away when not batching*/
+    void record_upload(std::function<void(CommandBuffer cmd)>&& function);
 
   public:
     /*
@@ -85,6 +144,14 @@ class Device
     inline Swapchain get_swapchain() const {
         return m_swapchain;
     }
+    /*Driver pipeline cache, persisted across runs. Shader passes build their pipelines through it*/
+    inline VkPipelineCache get_pipeline_cache() const {
+        return m_pipelineCache;
+    }
+    /*Most textures a shader stage can sample. Bounds bindless texture arrays*/
+    inline uint32_t get_max_stage_textures() const {
+        return std::min(m_properties.limits.maxPerStageDescriptorSamplers, m_properties.limits.maxPerStageDescriptorSampledImages);
+    }
 
     /*
     INIT AND SHUTDOWN
@@ -98,6 +165,10 @@ class Device
               SyncType        presentMode);
 
     void init_headless();
+    /*Where the pipeline cache is read from and written to. Has to be set before init*/
+    inline void set_pipeline_cache_path(const std::string& path) {
+        m_pipelineCachePath = path;
+    }
 
     void update_swapchain(Extent2D surfaceExtent, uint32_t framesPerFlight, ColorFormatType presentFormat, SyncType presentMode);
     void cleanup();
@@ -111,8 +182,14 @@ class Device
     Buffer create_buffer_VMA(size_t allocSize, BufferUsageFlags usage, VmaMemoryUsage memoryUsage, uint32_t strideSize = 0);
     /*Create Buffer*/
     Buffer create_buffer(size_t allocSize, BufferUsageFlags usage, MemoryPropertyFlags memoryProperties, uint32_t strideSize = 0);
-    /*Create Image*/
-    Image create_image(Extent3D extent, ImageConfig config, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
+    /*Create Image. If aliasedMemory is given, the image is bound to it instead of getting an allocation of its own*/
+    Image create_image(Extent3D       extent,
+                       ImageConfig    config,
+                       VmaMemoryUsage memoryUsage   = VMA_MEMORY_USAGE_GPU_ONLY,
+                       VmaAllocation  aliasedMemory = VK_NULL_HANDLE);
+    /*Allocates device memory every given image can be bound to, so images not alive at the same time can share it*/
+    VmaAllocation allocate_aliasing_memory(const std::vector<Image*>& images, size_t* allocatedSize = nullptr);
+    void          free_aliasing_memory(VmaAllocation memory);
     /*Create Texture*/
     Texture create_texture(const ptr<Image>& img, TextureConfig config);
     /*Create Framebuffer Object*/
@@ -121,8 +198,8 @@ class Device
     Semaphore   create_semaphore();
     Fence       create_fence(bool signaled = true);
     /*Create Frame. A frame is a data structure that contains the objects needed for synchronize each frame rendered and
-     * buffers to contain data needed for the GPU to render*/
-    Frame create_frame(uint16_t id);
+     * buffers to contain data needed for the GPU to render. Each recording worker gets its own pool for secondary command buffers*/
+    Frame create_frame(uint16_t id, uint32_t recordingWorkers = 1);
     /*Create RenderPass*/
     RenderPass create_render_pass(std::vector<AttachmentConfig>& attachments, std::vector<SubPassDependency>& dependencies);
     /*Create Descriptor Pool*/
@@ -163,14 +240,51 @@ class Device
     DATA TRANSFER
     -----------------------------------------------
     */
+    /*
+    Opens a transfer batch. Every upload issued until the matching end_upload_batch() is recorded into a single command buffer and
+    submitted with one fence wait. Batches can be nested; only the outermost end flushes. Uploaded resources are valid after the flush.
+    */
+    void begin_upload_batch();
+    void end_upload_batch();
+    /*Forces the submission of all pending transfers of the current batch*/
+    void flush_uploads();
+    inline bool is_batching_uploads() const {
+        return m_uploadContext.batchDepth > 0;
+    }
+    /*With the packed layout the vbo data holds positions and the attribute data the PackedVertex stream*/
     void upload_vertex_arrays(VertexArrays& vao,
                               size_t        vboSize,
                               const void*   vboData,
                               size_t        iboSize,
                               const void*   iboData,
-                              size_t        voxelSize = 0,
-                              const void*   voxelData = nullptr);
+                              size_t        voxelSize     = 0,
+                              const void*   voxelData     = nullptr,
+                              size_t        attributeSize = 0,
+                              const void*   attributeData = nullptr);
     void upload_texture_image(Image& img, ImageConfig config, SamplerConfig samplerConfig, const void* imgCache, size_t bytesPerPixel);
+    /*Uploads host data into a region of an existing device buffer (needs BUFFER_USAGE_TRANSFER_DST)*/
+    void upload_buffer_data(Buffer& dstBuffer, const void* data, size_t size, size_t dstOffset = 0);
+    /*Device to device copy. Source needs BUFFER_USAGE_TRANSFER_SRC and destination BUFFER_USAGE_TRANSFER_DST*/
+    void copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size, size_t srcOffset = 0, size_t dstOffset = 0);
+    /*
+    Asynchronous counterparts of the uploads above. They return immediately; the resource is flagged as loaded on GPU once
+    poll_uploads() finds its ticket completed. Until then the pendingUpload member of the resource holds the ticket
+    */
+    UploadTicket upload_vertex_arrays_async(VertexArrays& vao,
+                                            size_t        vboSize,
+                                            const void*   vboData,
+                                            size_t        iboSize,
+                                            const void*   iboData,
+                                            size_t        voxelSize     = 0,
+                                            const void*   voxelData     = nullptr,
+                                            size_t        attributeSize = 0,
+                                            const void*   attributeData = nullptr);
+    UploadTicket upload_texture_image_async(Image& img, ImageConfig config, SamplerConfig samplerConfig, const void* imgCache, size_t bytesPerPixel);
+    /*Retires finished asynchronous uploads. Call once per frame*/
+    void poll_uploads();
+    bool is_upload_complete(UploadTicket ticket);
+    void wait_upload(UploadTicket ticket);
+    void wait_all_uploads();
     void upload_BLAS(BLAS& accel, VAO& vao);
     void upload_TLAS(TLAS& accel, std::vector<BLASInstance>& BLASinstances);
     void download_texture_image(Image& img, void*& imgCache, size_t& size, size_t& channels);
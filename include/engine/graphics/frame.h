@@ -18,6 +18,32 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 
 namespace Graphics {
 
+/*
+Range of the GPU-driven indirect command buffers holding the instances that share a render state
+*/
+struct DrawBucket {
+    uint32_t stateKey     = 0;
+    uint32_t firstCommand = 0; // In commands
+    uint32_t maxCommands  = 0; // Instance groups registered in the bucket
+};
+
+/*
+Shadow view of a light slot of the scene uniforms, as the shadow passes see it
+*/
+struct ShadowView {
+    Mat4 viewProj   = Mat4(1.0f);
+    bool rasterized = false; // Shadow mapped. Raytraced lights are not drawn by the shadow passes
+};
+
+/*
+Command pool owned by a recording worker. Secondary command buffers are handed out in order and recycled when the frame starts
+*/
+struct WorkerCommands {
+    CommandPool                pool = {};
+    std::vector<CommandBuffer> secondaryBuffers;
+    uint32_t                   usedBuffers = 0;
+};
+
 struct Frame {
     // Control
     Semaphore presentSemaphore = {};
@@ -28,10 +54,26 @@ struct Frame {
     CommandBuffer commandBuffer        = {};
     CommandPool   computeCommandPool   = {};
     CommandBuffer computeCommandBuffer = {};
+    // One pool per recording worker, so secondary command buffers can be recorded in parallel
+    std::vector<WorkerCommands> workerCommands;
     // Uniforms
     std::vector<Buffer> uniformBuffers;
+    // Render state buckets of the GPU-driven passes. Filled by the scene builder
+    std::vector<DrawBucket> drawBuckets;
+    uint32_t                drawRecordCount = 0; // Records in the DRAW_BUFFER. One per instance, or per meshlet of it
+    // Light slots of the scene uniforms. Filled by the scene builder
+    std::vector<ShadowView> shadowViews;
     uint32_t            index = 0;
 
+    /*
+    Next free secondary command buffer of a worker. Only the thread acting as that worker may call it
+    */
+    CommandBuffer& get_secondary_command_buffer(uint32_t worker);
+    /*Recycles the worker pools. The frame fence has to be waited*/
+    void reset_worker_commands();
+    /*Redundant binds skipped while recording the frame, in the primary and in every secondary command buffer*/
+    uint32_t get_skipped_binds() const;
+
     void cleanup();
 
     static bool guiEnabled;
@@ -48,6 +48,7 @@ struct Image {
     VkDevice        device        = VK_NULL_HANDLE;
     VmaAllocator    memory        = VK_NULL_HANDLE; /*Memory allocation managed by VMA*/
     VmaAllocation   allocation    = VK_NULL_HANDLE;
+    VmaAllocation   aliasedMemory = VK_NULL_HANDLE; /*Shared memory the image is bound to (not owned). Kept across recreations*/
     VkImageView     view          = VK_NULL_HANDLE;
     VkSampler       sampler       = VK_NULL_HANDLE;
     VkDescriptorSet GUIReadHandle = VK_NULL_HANDLE;
@@ -58,8 +59,9 @@ struct Image {
     ImageConfig   config;
     SamplerConfig samplerConfig;
 
-    bool loadedOnCPU{false};
-    bool loadedOnGPU{false};
+    bool     loadedOnCPU{false};
+    bool     loadedOnGPU{false};
+    uint64_t pendingUpload{0}; // Ticket of an in-flight asynchronous upload, if any
 
     void create_view(ImageConfig _config);
 
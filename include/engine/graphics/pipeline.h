@@ -26,6 +26,7 @@ struct PipelineSettings {
 // GRAPHIC PIPELINE SETTINGS
 struct GraphicPipelineSettings {
     std::unordered_map<int, bool>                    attributes;
+    VertexLayout                                     vertexLayout     = STANDARD_VERTEX_LAYOUT;
     VkPrimitiveTopology                              topology         = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     VkPolygonMode                                    poligonMode      = VK_POLYGON_MODE_FILL;
     VkCullModeFlagBits                               cullMode         = VK_CULL_MODE_NONE;
@@ -53,6 +54,7 @@ void build_pipeline_layout(VkPipelineLayout& layout,
 void build_graphic_pipeline(VkPipeline&                                  pipeline,
                             VkPipelineLayout&                            layout,
                             VkDevice                                     device,
+                            VkPipelineCache                              cache,
                             VkRenderPass                                 renderPass,
                             VkExtent2D                                   extent,
                             GraphicPipelineSettings&                     settings,
@@ -61,6 +63,7 @@ void build_graphic_pipeline(VkPipeline&                                  pipelin
 void build_compute_pipeline(VkPipeline&                     pipeline,
                             VkPipelineLayout&               layout,
                             VkDevice                        device,
+                            VkPipelineCache                 cache,
                             VkPipelineShaderStageCreateInfo computeStage);
 }; // namespace PipelineBuilder
 
@@ -42,6 +42,8 @@ struct Fence
    
     void reset();
     void wait(uint64_t timeout = UINT64_MAX);
+    /*Non-blocking status query*/
+    bool is_signaled() const;
     void cleanup();
 };
 
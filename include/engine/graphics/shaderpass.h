@@ -36,12 +36,28 @@ struct ShaderSource {
     std::string tessEvalSource;
     std::string computeSource;
 
+    /*
+    SPIR-V cache. Compiled stages are stored on disk named after a hash of their expanded source and compile options, so an
+    edited shader or include simply misses. Directory defaults to resources/shaders/.cache/
+    */
+    static bool        cacheEnabled;
+    static std::string cacheDirectory;
+
     static ShaderSource read_file(const std::string& filePath);
 
+    /*
+    Looks the stage up in the SPIR-V cache and only compiles it on a miss
+    */
     static std::vector<uint32_t> compile_shader(const std::string          src,
                                                 const std::string          shaderName,
                                                 shaderc_shader_kind        kind,
                                                 shaderc_optimization_level optimization);
+    /*
+    Offline prewarm. Compiles every stage of every .glsl file under the directory into the cache. Returns the amount of stages
+    */
+    static uint32_t prewarm_cache(const std::string&         shaderDirectory,
+                                  shaderc_optimization_level optimization = shaderc_optimization_level_performance);
+    static void     clear_cache();
 
     static ShaderStage
     create_shader_stage(VkDevice device, VkShaderStageFlagBits stageType, const std::vector<uint32_t> code);
@@ -68,7 +84,8 @@ struct BaseShaderPass {
 
     virtual void
     build_shader_stages(shaderc_optimization_level optimization = shaderc_optimization_level_performance) = 0;
-    virtual void build(DescriptorPool& descriptorManager)                                                 = 0;
+    /*Pipelines are created through the given driver cache, if any*/
+    virtual void build(DescriptorPool& descriptorManager, VkPipelineCache pipelineCache)                  = 0;
     virtual void cleanup();
 };
 /*
@@ -93,9 +110,14 @@ struct GraphicShaderPass : public ShaderPass {
 
     void build_shader_stages(shaderc_optimization_level optimization = shaderc_optimization_level_performance);
 
-    void build(DescriptorPool& descriptorManager);
+    void build(DescriptorPool& descriptorManager, VkPipelineCache pipelineCache);
 
     void cleanup();
+    /*
+    Same shader pass fed by the packed vertex layout (see PackedVertex). The vertex stage is compiled with PACKED_VERTEX defined.
+    Stages and pipeline still have to be built
+    */
+    GraphicShaderPass* create_packed_variant() const;
 };
 
 /*
@@ -110,7 +132,7 @@ struct ComputeShaderPass : public ShaderPass {
 
     void build_shader_stages(shaderc_optimization_level optimization = shaderc_optimization_level_performance);
 
-    void build(DescriptorPool& descriptorManager);
+    void build(DescriptorPool& descriptorManager, VkPipelineCache pipelineCache);
 
     void cleanup();
 };
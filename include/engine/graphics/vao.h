@@ -11,6 +11,7 @@
 
 #include <engine/utils.h>
 #include <engine/graphics/buffer.h>
+#include <glm/gtc/packing.hpp>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 
@@ -19,18 +20,37 @@ namespace Graphics {
 Geometric Render Data
 */
 struct VertexArrays {
-    bool loadedOnGPU = false;
+    bool     loadedOnGPU   = false;
+    uint64_t pendingUpload = 0; // Ticket of an in-flight asynchronous upload, if any
 
-    Buffer   vbo         = {};
+    VertexLayout layout = STANDARD_VERTEX_LAYOUT;
+
+    Buffer   vbo         = {}; // Whole vertices, or only positions in the packed layout
     uint32_t vertexCount = 0;
-    Buffer   ibo         = {};
-    uint32_t indexCount  = 0;
+    Buffer   ibo           = {};
+    uint32_t indexCount    = 0; // Full detail indices, drawn by default
+    uint32_t lodIndexCount = 0; // Indices of the coarser levels of detail, stored after the full detail ones
+
+    /*
+    Quantized attribute stream (see PackedVertex). Only used by the packed layout
+    */
+    Buffer attributeBuffer = {};
 
     /*
     Optional, if the geometry need a proxy axis-aligned voxelized volume
     */
     Buffer   voxelBuffer   = {};
     uint32_t voxelCount    = 0;
+
+    /*
+    View into the geometry arena used for GPU-driven drawing (see Render::GeometryArena). Non-indexed geometry gets a sequential
+    index range
+    */
+    bool     inArena           = false;
+    uint32_t arenaVertexOffset = 0;
+    uint32_t arenaVertexCount  = 0;
+    uint32_t arenaFirstIndex   = 0;
+    uint32_t arenaIndexCount   = 0; // Levels of detail included
 };
 typedef VertexArrays VAO;
 /*
@@ -43,67 +63,18 @@ struct Vertex {
     Vec2 texCoord;
     Vec3 color;
 
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding   = 0;
-        bindingDescription.stride    = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return bindingDescription;
-    }
-    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(bool position = true,
-                                                                                   bool normal   = true,
-                                                                                   bool tangent  = true,
-                                                                                   bool texCoord = true,
-                                                                                   bool color    = true) {
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-        if (position)
-        {
-            VkVertexInputAttributeDescription posAtt{};
-            posAtt.binding  = 0;
-            posAtt.location = 0;
-            posAtt.format   = VK_FORMAT_R32G32B32_SFLOAT;
-            posAtt.offset   = offsetof(Vertex, pos);
-            attributeDescriptions.push_back(posAtt);
-        }
-        if (normal)
-        {
-            VkVertexInputAttributeDescription normalAtt{};
-            normalAtt.binding  = 0;
-            normalAtt.location = 1;
-            normalAtt.format   = VK_FORMAT_R32G32B32_SFLOAT;
-            normalAtt.offset   = offsetof(Vertex, normal);
-            attributeDescriptions.push_back(normalAtt);
-        }
-        if (texCoord)
-        {
-            VkVertexInputAttributeDescription texCoordAtt{};
-            texCoordAtt.binding  = 0;
-            texCoordAtt.location = 2;
-            texCoordAtt.format   = VK_FORMAT_R32G32_SFLOAT;
-            texCoordAtt.offset   = offsetof(Vertex, texCoord);
-            attributeDescriptions.push_back(texCoordAtt);
-        }
-        if (tangent)
-        {
-            VkVertexInputAttributeDescription tangentAtt{};
-            tangentAtt.binding  = 0;
-            tangentAtt.location = 3;
-            tangentAtt.format   = VK_FORMAT_R32G32B32_SFLOAT;
-            tangentAtt.offset   = offsetof(Vertex, tangent);
-            attributeDescriptions.push_back(tangentAtt);
-        }
-        if (color)
-        {
-            VkVertexInputAttributeDescription colorAtt{};
-            colorAtt.binding  = 0;
-            colorAtt.location = 4;
-            colorAtt.format   = VK_FORMAT_R32G32B32_SFLOAT;
-            colorAtt.offset   = offsetof(Vertex, color);
-            attributeDescriptions.push_back(colorAtt);
-        }
-
-        return attributeDescriptions;
-    }
+    /*
+    Streams of the layout. Positions always go in binding 0, so position only pipelines fetch 12 bytes per vertex with the packed
+    layout. The attribute stream (binding 1) is left out if no attribute other than the position is used
+    */
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VertexLayout layout = STANDARD_VERTEX_LAYOUT,
+                                                                               bool         positionOnly = false);
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(bool         position = true,
+                                                                                   bool         normal   = true,
+                                                                                   bool         tangent  = true,
+                                                                                   bool         texCoord = true,
+                                                                                   bool         color    = true,
+                                                                                   VertexLayout layout   = STANDARD_VERTEX_LAYOUT);
 
     bool operator==(const Vertex& other) const {
         return pos == other.pos && normal == other.normal && tangent == other.tangent && texCoord == other.texCoord &&
@@ -114,6 +85,21 @@ struct Vertex {
         return !(*this == other);
     }
 };
+/*
+Quantized attributes of the packed layout, the position goes in a stream of its own. Normal and tangent are octahedral encoded
+into snorm16 pairs, the uv is half float and the color unorm8. 16 bytes instead of the 44 these attributes take in Vertex. A zero
+tangent is stored as (-1, -1), which shaders decode back to zero (decode_tangent_oct_snorm)
+*/
+struct PackedVertex {
+    uint32_t normal;
+    uint32_t tangent;
+    uint32_t texCoord;
+    uint32_t color;
+
+    static PackedVertex pack(const Vertex& v);
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must match the vertex input formats");
+
 /*
 Voxel data type configured as an Axis-Aligned-Box
 */
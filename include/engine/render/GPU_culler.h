@@ -0,0 +1,125 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef GPU_CULLER_H
+#define GPU_CULLER_H
+
+#include <engine/common.h>
+#include <engine/core/geometries/geometry.h>
+#include <engine/core/scene/scene.h>
+#include <engine/graphics/device.h>
+#include <engine/graphics/shaderpass.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+// Render state keys are 7 bits wide (topology, culling mode, depth test, depth write and vertex layout)
+#define ENGINE_MAX_DRAW_BUCKETS 128
+
+/*
+Draw record of an instance, or of one of its meshlets when its geometry has them, written by the scene builder into the frame
+DRAW_BUFFER. Records drawing the same index range with the same flags and render state are instances of each other. They form an
+instance group, stored contiguously and drawn with a single instanced command. Mirrors DrawData in
+shaders/culling/instance_culling.glsl
+*/
+struct GPUDrawRecord {
+    uint32_t indexCount     = 0;
+    uint32_t firstIndex     = 0;
+    int32_t  vertexOffset   = 0;
+    uint32_t flags          = 0;
+    uint32_t bucket         = 0; // Index into Frame::drawBuckets
+    uint32_t firstCommand   = 0; // First command slot of the bucket
+    uint32_t instance       = 0; // Instance ID (mesh position in the scene list)
+    uint32_t firstInstance  = 0; // First record of the instance group. Its visible instance IDs are listed from there
+    Vec4     boundingSphere = Vec4( 0.0f );                   // Object space center and radius. Negative radius skips the frustum test
+    Vec4     normalCone     = Vec4( 0.0f, 0.0f, 0.0f, 1.0f ); // Object space axis and cutoff of the meshlet. Cutoff 1 skips the test
+
+    static constexpr uint32_t DRAWABLE_BIT     = 0x1;
+    static constexpr uint32_t CAST_SHADOWS_BIT = 0x2;
+    static constexpr uint32_t SHADOW_ONLY_BIT  = 0x4; // Coarser level drawn only by shadow passes
+};
+
+/*
+GPU-driven drawing helper. A compute pass culls every record of the frame DRAW_BUFFER and lists the instance IDs of the visible
+ones per instance group. A second dispatch appends a single instanced VkDrawIndexedIndirectCommand per group with visible instances
+into the range of its render state bucket, so thousands of copies of a mesh cost one command. Records of meshlets are also culled by
+their normal cone against the camera, so back facing clusters of dense meshes are not drawn. The owner pass then issues one
+indirect-count draw per bucket over the geometry arena, so the CPU cost no longer depends on the amount of meshes. Vertex shaders
+read the instance ID from the list, which the owner pass binds to its per object set.
+*/
+class GPUCuller
+{
+public:
+    enum class Mode
+    {
+        CAMERA = 0, // Against the active camera frustum
+        LIGHTS = 1, // Against the frustums of the shadow layers in the light mask (lights and cascades). Skips instances not casting shadows
+        NONE   = 2, // Every drawable instance. Like CAMERA, skips shadow only records
+    };
+
+private:
+    ptr<Graphics::Device> m_device;
+    Mode                  m_mode = Mode::CAMERA;
+
+    Graphics::DescriptorPool     m_descriptorPool = {};
+    Graphics::ComputeShaderPass* m_shaderPass     = nullptr;
+
+    struct FrameResources {
+        Graphics::DescriptorSet globalDescriptor;
+        Graphics::DescriptorSet drawDescriptor;
+        Graphics::Buffer        commands;       // VkDrawIndexedIndirectCommand per record
+        Graphics::Buffer        counts;         // Draw count per bucket
+        Graphics::Buffer        instanceIDs;    // Visible instance IDs, listed from the first record of each group
+        Graphics::Buffer        instanceCounts; // Visible instances per group, indexed by the first record of the group
+    };
+    std::vector<FrameResources> m_frames;
+
+    /*Commands and instance lists are sized per record*/
+    void reserve_commands( FrameResources& resources, size_t recordCount );
+
+public:
+    void setup( const ptr<Graphics::Device>& device, std::vector<Graphics::Frame>& frames, Mode mode );
+    /*
+    Records the culling dispatch. Has to be called outside a render pass, before draw(). In LIGHTS mode, only the shadow layers
+    whose bit is set in the mask are tested, a layer per light slot and then the cascades. Passes redrawing a few shadow maps do
+    not draw casters of the rest
+    */
+    void cull( Graphics::Frame& currentFrame, bool frustumCulling = true, uint64_t lightMask = ~0ull );
+    /*
+    Draws the visible instances of a bucket. Pipeline and descriptors have to be bound already
+    */
+    void draw( Graphics::Frame& currentFrame, const Graphics::DrawBucket& bucket, const Graphics::VAO& arenaVAO );
+    /*
+    Instance IDs read by the vertex shaders of the draws. Might be reallocated by cull(), so point descriptors to it afterwards
+    */
+    inline Graphics::Buffer& get_instance_IDs( const Graphics::Frame& currentFrame ) {
+        return m_frames[currentFrame.index].instanceIDs;
+    }
+    void cleanup();
+
+    /*
+    Render state key helpers
+    */
+    static uint32_t       encode_state( Core::Topology topology,
+                                        CullingMode    culling,
+                                        bool           depthTest,
+                                        bool           depthWrite,
+                                        VertexLayout   layout = STANDARD_VERTEX_LAYOUT );
+    static Core::Topology get_topology( uint32_t stateKey );
+    /*Buckets are drawn from the arena of their layout, with pipelines built for it*/
+    static VertexLayout   get_vertex_layout( uint32_t stateKey );
+    /*Sets the dynamic culling and depth states encoded in the key*/
+    static void           apply_state( Graphics::CommandBuffer& cmd, uint32_t stateKey );
+};
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -0,0 +1,110 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef GPU_GEOMETRY_ARENA_H
+#define GPU_GEOMETRY_ARENA_H
+
+#include <engine/common.h>
+#include <engine/core/geometries/geometry.h>
+#include <engine/graphics/device.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+/*
+Free-list range suballocator. Units are elements (vertices or indices). Free blocks are kept sorted by offset so released ranges
+coalesce with their neighbours; allocations take the best fitting block
+*/
+class RangeAllocator
+{
+    std::map<uint32_t, uint32_t> m_freeBlocks; // Offset + size
+    uint32_t                     m_capacity = 0;
+    uint32_t                     m_used     = 0;
+
+public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    void     reset( uint32_t capacity );
+    uint32_t allocate( uint32_t size );
+    void     free( uint32_t offset, uint32_t size );
+    /*Adds space at the end of the range, merged with the last free block if it reaches the old end*/
+    void grow( uint32_t newCapacity );
+
+    inline uint32_t get_capacity() const {
+        return m_capacity;
+    }
+    inline uint32_t get_used() const {
+        return m_used;
+    }
+    inline uint32_t get_free_block_count() const {
+        return static_cast<uint32_t>( m_freeBlocks.size() );
+    }
+    uint32_t get_largest_free_block() const;
+    /*0 when all free space is contiguous, close to 1 when it is scattered in small holes*/
+    float get_fragmentation() const;
+};
+
+struct GeometryArenaStats {
+    uint32_t vertexCapacity      = 0;
+    uint32_t vertexUsed          = 0;
+    uint32_t vertexFreeBlocks    = 0;
+    float    vertexFragmentation = 0.0f;
+    uint32_t indexCapacity       = 0;
+    uint32_t indexUsed           = 0;
+    uint32_t indexFreeBlocks     = 0;
+    float    indexFragmentation  = 0.0f;
+    uint32_t geometries          = 0;
+};
+
+/*
+Shared device-local vertex and index buffers holding the geometry drawn by the GPU-driven passes. Each geometry gets a vertex and
+an index range (non-indexed geometry gets a sequential one) and its VertexArrays store the placement. Ranges can be released and
+reused, so geometry can be evicted and uploaded again without the buffers growing forever. When no block is big enough the
+buffers grow, which stalls the device. An arena holds a single vertex layout; packed arenas keep a position and an attribute
+stream, like packed geometries do.
+*/
+class GeometryArena
+{
+    ptr<Graphics::Device> m_device;
+    Graphics::VAO         m_vao; // Vertex and index buffers of the whole arena
+    RangeAllocator        m_vertices;
+    RangeAllocator        m_indices;
+    uint32_t              m_geometries = 0;
+
+    void reserve( uint32_t vertexCount, uint32_t indexCount );
+
+public:
+    void init( const ptr<Graphics::Device>& device, uint32_t vertexCapacity, uint32_t indexCapacity, VertexLayout layout = STANDARD_VERTEX_LAYOUT );
+    void cleanup();
+
+    /*
+    Copies the resident vertex arrays of the geometry into the arena. Returns false if the geometry is not resident yet or has
+    another vertex layout
+    */
+    bool allocate( Core::Geometry* const g );
+    /*
+    Gives the ranges of the geometry back. Frames in flight must not be reading them anymore
+    */
+    void release( Core::Geometry* const g );
+
+    inline const Graphics::VAO& get_VAO() const {
+        return m_vao;
+    }
+    /*Bytes per vertex of the main (vbo) stream*/
+    inline size_t get_vertex_stride() const {
+        return m_vao.layout == PACKED_VERTEX_LAYOUT ? sizeof( Vec3 ) : sizeof( Graphics::Vertex );
+    }
+    GeometryArenaStats get_stats() const;
+};
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
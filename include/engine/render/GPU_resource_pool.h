@@ -12,6 +12,7 @@
 #include <engine/core/textures/texture.h>
 #include <engine/core/textures/texture_template.h>
 #include <engine/graphics/device.h>
+#include <engine/render/GPU_geometry_arena.h>
 #include <engine/utils.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
@@ -29,6 +30,9 @@ class GPUResourcePool
     Graphics::Image m_fallbackImage3D;
     Graphics::Image m_fallbackCubemap;
 
+    // Shared vertex/index buffers for GPU-driven drawing, one per vertex layout
+    GeometryArena m_geometryArenas[2];
+
     // Resources (GPU/CPU)
     std::unordered_map<std::string, Graphics::Buffer>
                                                      m_ubos;   // string resoruce name + actual buffer
@@ -55,6 +59,25 @@ public:
     const Graphics::Image& get_fallback_cubemap() const {
         return m_fallbackCubemap;
     }
+    const Graphics::VAO& get_arena_VAO( VertexLayout layout = STANDARD_VERTEX_LAYOUT ) const {
+        return m_geometryArenas[layout].get_VAO();
+    }
+    GeometryArenaStats get_arena_stats( VertexLayout layout = STANDARD_VERTEX_LAYOUT ) const {
+        return m_geometryArenas[layout].get_stats();
+    }
+
+    // -----------------------------------------------------
+    // Geometry Arena (GPU-driven drawing)
+    // -----------------------------------------------------
+    /*
+    Copies the vertex arrays of a resident geometry into the arena of its layout and stores its placement in the VAO
+    */
+    void register_arena_geometry( Core::Geometry* const g );
+    /*
+    Releases the GPU data of a geometry (arena ranges included) while keeping its CPU data, so the next scene build uploads it
+    again. Waits for the device to be idle
+    */
+    void evict_geometry( Core::Geometry* const g );
 
     // ----------------------------
     // Uniform Buffer Management
@@ -125,8 +148,16 @@ public:
     // -----------------------------------------------------
     // Utility
     // -----------------------------------------------------
-    static void upload_texture_data( const ptr<Graphics::Device>& device, Core::ITexture* const t );
-    static void upload_geometry_data( const ptr<Graphics::Device>& device, Core::Geometry* const g, bool createAccelStructure = true );
+    /*
+    Uploads are queued into the device transfer batch if one is open (see Device::begin_upload_batch), so many resources can share a
+    single submission. Acceleration structures need their vertex data resident, so building one flushes the pending batch.
+    With async enabled, data goes through the device transfer queue and becomes resident in a later frame (see Device::poll_uploads).
+    */
+    static void upload_texture_data( const ptr<Graphics::Device>& device, Core::ITexture* const t, bool async = false );
+    static void upload_geometry_data( const ptr<Graphics::Device>& device,
+                                      Core::Geometry* const        g,
+                                      bool                         createAccelStructure = true,
+                                      bool                         async                = false );
     static void destroy_texture_data( Core::ITexture* const t );
     static void destroy_geometry_data( Core::Geometry* const g );
 };
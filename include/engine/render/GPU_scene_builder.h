@@ -18,6 +18,7 @@
 #include <engine/core/windows/windowGLFW.h>
 
 #include <engine/graphics/device.h>
+#include <engine/render/GPU_culler.h>
 #include <engine/render/GPU_resource_pool.h>
 
 #include <engine/tools/loaders.h>
@@ -37,22 +38,113 @@ namespace Render {
 //         m_object_UBO_Key = objectUBO_key;
 //     }
 
+/*
+Level of detail selection of the GPU-driven passes. Levels are picked by the screen space size of their error
+*/
+struct LODSettings {
+    float    errorThreshold = 1.0f;  // Pixels of error a level may introduce. 0 always draws full detail
+    float    hysteresis     = 0.25f; // Fraction below the threshold a level has to fall to be switched to, avoiding popping
+    uint32_t shadowBias     = 1;     // Levels coarser shadow casters are drawn with
+};
+
+/*
+Bytes the scene builder wrote to the frame buffers in its last build. Only the payloads that changed since the same frame in
+flight was last built are written
+*/
+struct SceneUploadStats {
+    size_t   globalBytes   = 0; // Camera and scene uniforms
+    size_t   instanceBytes = 0;
+    size_t   materialBytes = 0;
+    size_t   drawBytes     = 0;
+    uint32_t writes        = 0; // Contiguous ranges written, each one maps the buffer once
+
+    inline size_t get_total_bytes() const {
+        return globalBytes + instanceBytes + materialBytes + drawBytes;
+    }
+};
+
 class GPUSceneBuilder
 {
+    /*
+    What was last written to the buffers of a frame in flight. Buffers are only written where the new payloads differ from it
+    */
+    struct FrameUploads {
+        Core::Camera::GPUPayload                 camera   = {};
+        Core::Scene::GPUPayload                  scene    = {};
+        VkBuffer                                 globals  = VK_NULL_HANDLE; // Tables are compared by handle, grown ones start empty
+        std::vector<Core::Object3D::GPUPayload>  instances;
+        VkBuffer                                 instanceTable = VK_NULL_HANDLE;
+        std::vector<Core::IMaterial::GPUPayload> materials;
+        VkBuffer                                 materialTable = VK_NULL_HANDLE;
+        std::vector<GPUDrawRecord>               records;
+        VkBuffer                                 drawTable = VK_NULL_HANDLE;
+    };
+
+    /*
+    Records drawing the same index range with the same flags and render state are instances of one draw
+    */
+    struct InstanceGroupKey {
+        uint32_t stateKey;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t  vertexOffset;
+        uint32_t flags;
+
+        inline bool operator==( const InstanceGroupKey& other ) const {
+            return stateKey == other.stateKey && indexCount == other.indexCount && firstIndex == other.firstIndex &&
+                   vertexOffset == other.vertexOffset && flags == other.flags;
+        }
+    };
+    struct InstanceGroupKeyHash {
+        inline size_t operator()( const InstanceGroupKey& key ) const {
+            size_t seed = 0;
+            for ( uint32_t value : { key.stateKey, key.indexCount, key.firstIndex, static_cast<uint32_t>( key.vertexOffset ), key.flags } )
+                seed ^= std::hash<uint32_t>()( value ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+            return seed;
+        }
+    };
+
+    struct MeshLOD {
+        uint32_t level = 0; // Drawn last time the mesh was built
+        uint32_t build = 0; // Last build the mesh was drawn in
+    };
+    std::unordered_map<const Core::Mesh*, MeshLOD> m_meshLODs;          // Per drawn mesh. Meshes no longer drawn are dropped
+    uint32_t                                       m_LODBuild  = 0;     // Scene builds so far
+    size_t                                         m_LODMeshes = 0;     // Meshes given a level in the current build
+    std::vector<FrameUploads>                      m_frameUploads;      // Per frame index
+    std::unordered_set<const Core::IMaterial*>     m_residentMaterials; // Every texture on the GPU, not dirty since
+    // Reused every frame
+    std::vector<Core::Object3D::GPUPayload>  m_instanceData;
+    std::vector<Core::IMaterial::GPUPayload> m_materialData;
+    SceneUploadStats                         m_uploadStats;
+    std::unordered_map<InstanceGroupKey, uint32_t, InstanceGroupKeyHash> m_instanceGroups; // Group of each distinct draw
+    std::vector<uint32_t>                                                m_recordGroups;   // Group of each record
+    std::vector<uint32_t>                                                m_groupStarts;    // First record of each group
+    std::vector<uint32_t>                                                m_groupSizes;
+    std::vector<GPUDrawRecord>                                           m_groupedRecords;
+
 public:
-    // Build a GPU view of the scene (uploads all data to the GPU)
+    // Build a GPU view of the scene (uploads all data to the GPU). With asyncUploads, meshes whose data is not resident yet are skipped.
+    // Resident geometry is also placed in the pool geometry arena and described in the frame draw records for GPU-driven passes
     void build( const ptr<Graphics::Device>& device,
+                const ptr<GPUResourcePool>&  pool,
                 Graphics::Frame* const       currentFrame,
                 Core::Scene* const           scene,
                 Extent2D                     displayExtent,
                 bool                         raytracingEnabled,
-                bool                         temporalFiltering );
+                bool                         temporalFiltering,
+                bool                         asyncUploads     = false,
+                const LODSettings&           lodSettings      = {},
+                uint32_t                     shadowResolution = 1024 ); // Texel grid the shadow cascades are snapped to
     /*
     Uploads scene's skybox resources (cube mesh and panorama texture)
     */
     void build_skybox_data( const ptr<Graphics::Device>& device, Core::Skybox* const sky );
     // Destroys the GPU view of the scene
     void destroy( Core::Scene* const scene );
+    inline SceneUploadStats get_upload_stats() const {
+        return m_uploadStats;
+    }
 
 private:
     /*
@@ -62,16 +154,45 @@ private:
                              Graphics::Frame* const       currentFrame,
                              Core::Scene* const           scene,
                              Extent2D                     displayExtent,
-                             bool                         jitterCamera );
+                             bool                         jitterCamera,
+                             uint32_t                     shadowResolution );
     /*
     Object descriptor layouts uniforms buffer upload to GPU
     */
     void update_object_data( const ptr<Graphics::Device>& device,
+                             const ptr<GPUResourcePool>&  pool,
                              Graphics::Frame* const       currentFrame,
                              Core::Scene* const           scene,
                              Extent2D                     displayExtent,
-                             bool                         enableRT );
-   
+                             bool                         enableRT,
+                             bool                         asyncUploads,
+                             const LODSettings&           lodSettings );
+    /*
+    Level of detail the mesh is drawn with by the camera this frame. 0 is the full detail geometry
+    */
+    uint32_t select_LOD( Core::Mesh* const m, Core::Camera* const camera, Extent2D displayExtent, const LODSettings& settings );
+    /*
+    Groups the draw records into instance groups, stored contiguously, and the groups by render state into the frame draw buckets.
+    Then uploads them
+    */
+    void update_draw_data( Graphics::Frame* const currentFrame, const std::vector<GPUDrawRecord>& records, const std::vector<uint32_t>& stateKeys );
+    /*
+    Grows the frame's instance and material storage buffers to fit instanceCount entries
+    */
+    void reserve_instance_data( const ptr<Graphics::Device>& device, Graphics::Frame* const currentFrame, size_t instanceCount );
+    /*
+    Grows the frame's draw storage buffer to fit recordCount records
+    */
+    void reserve_draw_data( const ptr<Graphics::Device>& device, Graphics::Frame* const currentFrame, size_t recordCount );
+    /*
+    Copy of the buffer contents of the frame
+    */
+    FrameUploads& get_frame_uploads( Graphics::Frame* const currentFrame );
+    /*
+    Uploads the textures of the material not on the GPU yet. True if all of them are resident. Materials whose textures were
+    all resident, and did not change since, are not walked again
+    */
+    bool upload_material_textures( const ptr<Graphics::Device>& device, Core::IMaterial* const mat, bool asyncUploads );
     /*
     Scene cleanup
     */
@@ -75,6 +75,10 @@ public:
     inline void set_bloom_strength( float st ) {
         m_bloomStrength = st;
     }
+    // Bright lighting is downsampled in compute
+    inline uint32_t get_input_read_stages() const override {
+        return GRAPH_READ_FRAGMENT | GRAPH_READ_COMPUTE;
+    }
 
     void setup_out_attachments( std::vector<Graphics::AttachmentConfig>& attachments, std::vector<Graphics::SubPassDependency>& dependencies ) override;
 
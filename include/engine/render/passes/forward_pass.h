@@ -10,6 +10,7 @@
 #define FORWARD_PASS_H
 #include <engine/core/textures/texture.h>
 #include <engine/render/passes/graphic_pass.h>
+#include <engine/render/render_queue.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 
@@ -34,8 +35,37 @@ class ForwardPass final : public BaseGraphicPass
         Graphics::DescriptorSet textureDescriptor;
     };
     std::vector<FrameDescriptors> m_descriptors;
+    /*Scene list positions of the meshes seen by the camera this frame, in list order*/
+    std::vector<uint32_t> m_visibleMeshes;
+    /*Shader passes of each material shader ID, resolved once, so recording does no string building or layout lookups*/
+    struct MaterialPasses {
+        Graphics::ShaderPass* layouts[2]  = {}; // By vertex layout. Null if the shader has no variant for it
+        bool                  useTextures = false;
+        uint32_t              ID          = 0;
+    };
+    std::unordered_map<std::string, MaterialPasses> m_materialPasses;
+    /*Drawable visible meshes with their resolved pass, and the order they are recorded in*/
+    struct QueuedDraw {
+        uint32_t              mesh;
+        Geometry*             geometry;
+        IMaterial*            material;
+        Graphics::ShaderPass* shaderPass;
+        bool                  useTextures;
+    };
+    std::vector<QueuedDraw> m_draws;
+    RenderQueue             m_queue;
+    /*Instance IDs of the queue in recording order, per frame. Runs of the same geometry and material are drawn instanced over them*/
+    std::vector<Graphics::Buffer> m_instanceIDs;
+    std::vector<uint32_t>         m_queueInstanceIDs;
 
     void setup_material_descriptor( IMaterial* mat );
+    /*Sorts the visible meshes. Opaque ones grouped by pipeline, material and geometry, front to back. Blended ones last, back to front*/
+    void build_queue( Scene* const scene );
+    /*Writes the instance IDs of the queue into the list of the frame*/
+    void upload_instance_IDs( Graphics::Frame& currentFrame );
+    /*Records the draws of the queue in [begin, end). Safe to call from several workers at once*/
+    void record_meshes( Graphics::CommandBuffer& cmd, Graphics::Frame& currentFrame, Scene* const scene, size_t begin, size_t end );
+    void record_skybox( Graphics::CommandBuffer& cmd, Graphics::Frame& currentFrame, Scene* const scene );
 
 public:
     /*
@@ -79,6 +109,8 @@ public:
     void update_uniforms( uint32_t frameIndex, Scene* const scene ) override;
 
     void link_input_attachments() override;
+
+    void cleanup() override;
 };
 
 } // namespace Core
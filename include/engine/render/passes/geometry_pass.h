@@ -8,6 +8,7 @@
 */
 #ifndef GEOMETRY_PASS_H
 #define GEOMETRY_PASS_H
+#include <engine/render/GPU_culler.h>
 #include <engine/render/passes/graphic_pass.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
@@ -30,11 +31,14 @@ class GeometryPass final : public BaseGraphicPass
     struct FrameDescriptors {
         Graphics::DescriptorSet globalDescritor;
         Graphics::DescriptorSet objectDescritor;
-        Graphics::DescriptorSet textureDescritor;
+        MaterialTextures        textures;
     };
     std::vector<FrameDescriptors> m_descriptors;
 
-    void setup_material_descriptor( IMaterial* mat, uint32_t meshIdx );
+    /*GPU-driven drawing*/
+    GPUCuller m_culler;
+    /*Shader pass of each bucket by topology and vertex layout. Resolved once, so recording does no lookups*/
+    Graphics::ShaderPass* m_bucketPasses[4][2] = {};
 
 public:
     /*
@@ -75,6 +79,8 @@ public:
     void link_input_attachments() override;
 
     void update_uniforms( uint32_t frameIndex, Scene* const scene ) override;
+
+    void cleanup() override;
 };
 } // namespace Core
 VULKAN_ENGINE_NAMESPACE_END
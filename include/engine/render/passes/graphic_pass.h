@@ -42,6 +42,11 @@ protected:
 
     virtual void setup_out_attachments( std::vector<Graphics::AttachmentConfig>&  attachments,
                                         std::vector<Graphics::SubPassDependency>& dependencies ) = 0;
+    /*
+    Replaces the external dependencies declared by the pass with the ones its output readers need (see RenderGraph). Only
+    passes whose attachments are exactly their declared outputs are handled; others keep their own
+    */
+    void derive_dependencies( const std::vector<Graphics::AttachmentConfig>& attachments, std::vector<Graphics::SubPassDependency>& dependencies );
 
 public:
     BaseGraphicPass( const ptr<Graphics::Device>&     device,
@@ -36,6 +36,16 @@ namespace Render {
         return;
 
 #pragma region Config
+/*
+Shader stages reading a pass output, as found by the render graph
+*/
+enum GraphReadStageBits
+{
+    GRAPH_READ_NONE     = 0x0,
+    GRAPH_READ_FRAGMENT = 0x1,
+    GRAPH_READ_COMPUTE  = 0x2,
+};
+
 /*
 Pass config <Input Attachments, Output Attachmetns>
 */
@@ -63,6 +73,10 @@ protected:
 
     // Shared resources
     ptr<Render::GPUResourcePool> m_shared;
+    // Workers for parallel command recording. Optional
+    ptr<Utils::JobSystem> m_jobSystem;
+    // Stages reading each output attachment (GraphReadStageBits). Filled by the render graph, empty outside of one
+    std::vector<uint32_t> m_outputReaders;
 
     // Attachment Images
     std::vector<Graphics::Image*> m_inAttachments;
@@ -81,6 +95,34 @@ protected:
 
     virtual void setup_uniforms( std::vector<Graphics::Frame>& frames ) = 0;
     virtual void setup_shader_passes()                                  = 0;
+    /*
+    Points a per-object descriptor set to the frame instance and material tables, and to the instance IDs listed by the pass for
+    its draws. Does nothing unless they have been reallocated
+    */
+    static void update_instance_descriptor( Graphics::DescriptorSet& descriptor, Graphics::Frame& frame, Graphics::Buffer& instanceIDs );
+
+    /*
+    Bindless material textures of a frame. Each material owns MAX_TEXTURES_PER_MATERIAL consecutive slots, starting at its index in the
+    material table times MAX_TEXTURES_PER_MATERIAL. The set lives in a pool of its own, recreated when the material table outgrows it
+    */
+    struct MaterialTextures {
+        Graphics::DescriptorPool pool  = {};
+        Graphics::DescriptorSet  set   = {};
+        uint32_t                 slots = 0;
+    };
+    /*
+    Most slots a material texture set can hold. Length of the array binding in the OBJECT_TEXTURE_LAYOUT
+    */
+    uint32_t get_max_material_textures() const;
+    /*
+    Makes room for the given amount of materials, doubling like the material table does. If the set grew, it is reallocated and comes
+    back empty, so textures are written again. Only safe once the frame is no longer in flight
+    */
+    void reserve_material_textures( MaterialTextures& textures, size_t materialCount );
+    /*
+    Writes the loaded textures of a material into its slots
+    */
+    static void update_material_textures( MaterialTextures& textures, Core::IMaterial* mat, uint32_t materialIdx );
 
     template <std::size_t numberIN, std::size_t numberOUT>
     inline void store_attachments( const PassLinkage<numberIN, numberOUT>& linkage ) {
@@ -145,6 +187,15 @@ public:
     inline bool is_graphical() const {
         return m_isGraphical;
     }
+    inline std::string get_name() const {
+        return m_name;
+    }
+    /*
+    Stages the input attachments are read from (GraphReadStageBits)
+    */
+    virtual inline uint32_t get_input_read_stages() const {
+        return m_isGraphical ? GRAPH_READ_FRAGMENT : GRAPH_READ_COMPUTE;
+    }
 
     inline std::unordered_map<std::string, Graphics::ShaderPass*> const get_shaderpasses() const {
         return m_shaderPasses;
@@ -158,6 +209,18 @@ public:
     inline void set_attachment_clear_value( ClearValue value, size_t attachmentIdx = 0 ) {
         m_outAttachments[attachmentIdx]->config.clearValue = value;
     }
+    /*
+    Passes with long draw lists can split their recording into per worker secondary command buffers
+    */
+    inline void set_job_system( const ptr<Utils::JobSystem>& jobSystem ) {
+        m_jobSystem = jobSystem;
+    }
+    /*
+    Set by the render graph before setup. Graphic passes derive their external dependencies from it
+    */
+    inline void set_output_readers( const std::vector<uint32_t>& readers ) {
+        m_outputReaders = readers;
+    }
 
 #pragma endregion
 #pragma region Core Functions
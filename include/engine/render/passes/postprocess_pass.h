@@ -125,7 +125,7 @@ void PostProcessPass<numberIN, numberOUT>::setup_shader_passes() {
         { POSITION_ATTRIBUTE, true }, { NORMAL_ATTRIBUTE, false }, { UV_ATTRIBUTE, true }, { TANGENT_ATTRIBUTE, false }, { COLOR_ATTRIBUTE, false } };
 
     ppPass->build_shader_stages();
-    ppPass->build( this->m_descriptorPool );
+    ppPass->build( this->m_descriptorPool, this->m_device->get_pipeline_cache() );
 
     this->m_shaderPasses["pp"] = ppPass;
 }
@@ -8,6 +8,7 @@
 */
 #ifndef SHADOW_PASS_H
 #define SHADOW_PASS_H
+#include <engine/render/GPU_culler.h>
 #include <engine/render/passes/graphic_pass.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
@@ -29,6 +30,11 @@ class ShadowPass final : public BaseGraphicPass
     };
     std::vector<FrameDescriptors> m_descriptors;
 
+    /*GPU-driven drawing*/
+    GPUCuller m_culler;
+    /*Shader pass of each bucket by topology and vertex layout. Resolved once, so recording does no lookups*/
+    Graphics::ShaderPass* m_bucketPasses[4][2] = {};
+
 public:
     /*
 
@@ -51,6 +57,8 @@ public:
     void setup_shader_passes() override;
 
     void execute( Graphics::Frame& currentFrame, Scene* const scene, uint32_t presentImageIndex = 0 ) override;
+
+    void cleanup() override;
 };
 
 } // namespace Core
@@ -8,6 +8,7 @@
 */
 #ifndef VSM_PASS_H
 #define VSM_PASS_H
+#include <engine/render/GPU_culler.h>
 #include <engine/render/passes/graphic_pass.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
@@ -30,17 +31,40 @@ class VarianceShadowPass final : public BaseGraphicPass
     };
     std::vector<FrameDescriptors> m_descriptors;
 
+    /*GPU-driven drawing*/
+    GPUCuller m_culler;
+    /*Shader pass of each bucket by topology and vertex layout. Resolved once, so recording does no lookups*/
+    Graphics::ShaderPass* m_bucketPasses[4][2] = {};
+
+    /*Shadow caching. A layer is only redrawn when its light view changed or a caster inside it moved*/
+    struct CachedLayer {
+        Mat4 viewProj    = Mat4(1.0f);
+        bool rasterized  = false;
+        bool drawn       = false; // Has valid content. Layers never drawn skip the update budget
+        bool stale       = true;
+        bool reprojected = false; // View changed since drawn. Shaders sample with the new matrix, so it skips the budget too
+    };
+    std::vector<CachedLayer> m_layers;
+    std::vector<Vec4>        m_casterBounds; // World space sphere of each mesh when last checked. Negative radius if not a caster
+    uint32_t                 m_updateBudget = 0; // Stale layers redrawn per frame. 0 for no limit
+    uint32_t                 m_nextLayer    = 0; // Round robin cursor over the stale layers
+
+    /*Flags the layers whose light view changed, or seeing a caster that moved, appeared or vanished*/
+    void find_stale_layers(Graphics::Frame& currentFrame, Scene* const scene);
+    /*Picks the layers redrawn this frame within the budget*/
+    uint64_t select_layers();
+
 public:
     /*
 
                Output Attachments:
                -
-               - Shadow Maps 2D Array
+               - Shadow Maps 2D Array (a layer per light slot, then the cascades)
                - Depth 2D Array
 
            */
-    VarianceShadowPass( const ptr<Graphics::Device>& device, const ptr<Render::GPUResourcePool>& shared, const PassLinkage<0, 2>& config, Extent2D extent, uint32_t numLights, ColorFormatType depthFormat )
-        : BaseGraphicPass( device, shared, extent, 1, numLights, false, false, "SHADOWS" )
+    VarianceShadowPass( const ptr<Graphics::Device>& device, const ptr<Render::GPUResourcePool>& shared, const PassLinkage<0, 2>& config, Extent2D extent, uint32_t numLayers, ColorFormatType depthFormat )
+        : BaseGraphicPass( device, shared, extent, 1, numLayers, false, false, "SHADOWS" )
         , m_depthFormat( depthFormat ) {
         BasePass::store_attachments<0, 2>( config );
     }
@@ -52,6 +76,28 @@ public:
     void setup_shader_passes() override;
 
     void execute( Graphics::Frame& currentFrame, Scene* const scene, uint32_t presentImageIndex = 0 ) override;
+
+    /*
+    Stale shadow maps redrawn per frame, in round robin. Only maps whose casters moved wait for their turn, as their view is unchanged.
+    Maps never drawn, or whose light view changed (cascades follow the camera), are always redrawn. 0 redraws every stale one
+    */
+    inline void set_update_budget(uint32_t layers) {
+        m_updateBudget = layers;
+    }
+    inline uint32_t get_update_budget() const {
+        return m_updateBudget;
+    }
+    /*
+    Redraws every shadow map next frame. For changes the cache can not see, such as geometry edited in place
+    */
+    inline void invalidate_cache() {
+        for (CachedLayer& layer : m_layers)
+            layer.stale = true;
+    }
+
+    void create_framebuffer() override;
+
+    void cleanup() override;
 };
 
 } // namespace Core
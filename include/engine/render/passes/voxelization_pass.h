@@ -8,6 +8,7 @@
 */
 #ifndef VOXELIZATION_PASS_H
 #define VOXELIZATION_PASS_H
+#include <engine/render/GPU_culler.h>
 #include <engine/render/passes/graphic_pass.h>
 
 #define USE_IMG_ATOMIC_OPERATION
@@ -35,12 +36,16 @@ class VoxelizationPass final : public BaseGraphicPass
     struct FrameDescriptors {
         Graphics::DescriptorSet globalDescritor;
         Graphics::DescriptorSet objectDescritor;
-        Graphics::DescriptorSet textureDescritor;
+        MaterialTextures        textures;
     };
     std::vector<FrameDescriptors> m_descriptors;
 
+    /*GPU-driven drawing*/
+    GPUCuller m_culler;
+    /*Voxelization pass of each vertex layout. Resolved once, so recording does no lookups*/
+    Graphics::ShaderPass* m_layoutPasses[2] = {};
+
     void create_voxelization_image();
-    void setup_material_descriptor( IMaterial* mat, uint32_t meshIdx );
 
 public:
     /*
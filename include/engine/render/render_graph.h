@@ -0,0 +1,91 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <engine/common.h>
+#include <engine/render/passes/graphic_pass.h>
+#include <engine/render/passes/pass.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+/*
+Dependency graph over the renderer passes. Reads and writes are the input and output attachments each pass declares in its
+PassLinkage, in execution order. From them the graph:
+
+- Tells every pass which stages read its outputs, so graphic passes derive their external dependencies (see
+  BaseGraphicPass::derive_dependencies) instead of relying on broad hand written ones.
+- Culls passes whose outputs are never read. Active default passes, passes without outputs and, when there is no active default
+  pass, the last active writing pass are the graph outputs.
+- Aliases attachments declared transient whose lifetimes do not overlap into shared device memory. Transient means the content is
+  produced and consumed within the same frame, so it must not be read back, sampled by debug views or kept as history.
+*/
+class RenderGraph
+{
+    struct ResourceNode {
+        Graphics::Image*      image = nullptr;
+        std::vector<uint32_t> writers;
+        std::vector<uint32_t> readers;
+        bool                  transient = false;
+    };
+    struct AliasSlot {
+        VmaAllocation         memory = VK_NULL_HANDLE;
+        std::vector<uint32_t> resources;
+        uint32_t              lastUse = 0;
+    };
+
+    std::vector<ptr<BasePass>>                           m_passes;
+    std::vector<ResourceNode>                            m_resources;
+    std::unordered_map<const Graphics::Image*, uint32_t> m_resourceIDs;
+    std::vector<bool>                                    m_culled;
+    std::set<const Graphics::Image*>                     m_transients;
+
+    std::vector<AliasSlot> m_aliasSlots;
+    size_t                 m_aliasedBytes = 0; // Memory the aliased attachments would take on their own
+    size_t                 m_slotBytes    = 0; // Memory they actually take
+
+    uint32_t get_resource( Graphics::Image* image );
+    /*Single active graphic writer running before every reader, whose render pass does not load the previous content*/
+    bool can_alias( const ResourceNode& resource ) const;
+
+public:
+    /*
+    The content of the attachment lives only between its writer and its last reader within a frame
+    */
+    void declare_transient( Graphics::Image* attachment );
+    /*
+    Builds the graph. Has to be called before the passes are set up
+    */
+    void compile( const std::vector<ptr<BasePass>>& passes );
+    /*
+    Moves the transient attachments into shared memory slots, recreating the framebuffers of their writers. Passes have to be set
+    up. Input attachments have to be linked again afterwards
+    */
+    void alias_transients( const ptr<Graphics::Device>& device );
+    /*
+    Gives the transient attachments their own memory back and frees the slots. Needed before attachments are resized
+    */
+    void release_aliases( const ptr<Graphics::Device>& device );
+    void cleanup( const ptr<Graphics::Device>& device );
+
+    inline bool is_culled( size_t passIndex ) const {
+        return passIndex < m_culled.size() && m_culled[passIndex];
+    }
+    inline size_t get_saved_memory() const {
+        return m_aliasedBytes - m_slotBytes;
+    }
+};
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    This file is part of Vulkan-Engine, a simple to use Vulkan based 3D library
+
+    MIT License
+
+    Copyright (c) 2023 Antonio Espinosa Garcia
+
+*/
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <engine/common.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+struct RenderQueueItem {
+    uint64_t key;
+    uint32_t index; // Whatever the owner sorts, usually a position in the scene mesh list
+};
+
+/*
+Draws of a pass ordered by a 64 bit key. From the most significant bit:
+
+    Opaque:  layer (2) | pipeline (12) | material (14) | geometry (14) | depth, near to far (22)
+    Blended: layer (2) | depth, far to near (32) | unused (30)
+
+so opaque draws are grouped by pipeline first, then material and geometry, and front to back inside each group for early depth
+rejection. Blended draws go after every opaque one, back to front. Keys are radix sorted, which is stable, so draws with equal
+keys keep the order they were pushed in and none of them is lost.
+*/
+class RenderQueue
+{
+    std::vector<RenderQueueItem> m_items;
+    std::vector<RenderQueueItem> m_scratch;
+
+public:
+    enum Layer
+    {
+        OPAQUE_LAYER  = 0,
+        BLENDED_LAYER = 1,
+    };
+
+    static uint64_t make_opaque_key( uint32_t pipeline, uint32_t material, uint32_t geometry, float depth );
+    static uint64_t make_blended_key( float depth );
+    /*
+    Folds a pointer into an ID of the given width. Equal pointers give equal IDs, so their draws end up together. Colliding ones
+    only interleave
+    */
+    static uint32_t fold_ID( const void* ptr, uint32_t bits );
+    static Layer    get_layer( uint64_t key ) {
+        return static_cast<Layer>( key >> 62 );
+    }
+
+    inline void clear() {
+        m_items.clear();
+    }
+    inline void reserve( size_t count ) {
+        m_items.reserve( count );
+    }
+    inline void push( uint64_t key, uint32_t index ) {
+        m_items.push_back( { key, index } );
+    }
+    /*
+    Least significant digit radix sort, a byte per pass. Passes whose byte is the same for every key are skipped
+    */
+    void sort();
+
+    inline const std::vector<RenderQueueItem>& get_items() const {
+        return m_items;
+    }
+    inline size_t size() const {
+        return m_items.size();
+    }
+    inline bool empty() const {
+        return m_items.empty();
+    }
+};
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
+
+#endif
@@ -64,6 +64,17 @@ class ForwardRenderer : public BaseRenderer
         BaseRenderer::set_settings(settings);
     }
 
+    /*
+    Shadow maps are cached and only redrawn when their light, or a caster they see, moves. Light moves are redrawn right away.
+    This caps the maps redrawn per frame for moved casters. 0 redraws every stale one each frame
+    */
+    inline void set_shadow_update_budget(uint32_t layers) {
+        get_pass<Render::VarianceShadowPass>(SHADOW_PASS)->set_update_budget(layers);
+    }
+    inline uint32_t get_shadow_update_budget() {
+        return get_pass<Render::VarianceShadowPass>(SHADOW_PASS)->get_update_budget();
+    }
+
     inline float get_bloom_strength() {
         if (m_passes[BLOOM_PASS])
         {
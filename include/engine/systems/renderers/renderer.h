@@ -17,6 +17,7 @@
 #include <engine/render/GPU_scene_builder.h>
 #include <engine/render/passes/graphic_pass.h>
 #include <engine/render/passes/pass.h>
+#include <engine/render/render_graph.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 
@@ -27,20 +28,24 @@ Renderer Global Settings Data
 */
 struct RendererSettings {
 
-    MSAASamples      samplesMSAA           = MSAASamples::x4;             // Multisampled AA (when possible)
-    BufferingType    bufferingType         = BufferingType::DOUBLE;       // Buffering type (Usual: double buffering)
-    SyncType         screenSync            = SyncType::MAILBOX;           // Type of display synchronization
-    ColorFormatType  displayColorFormat    = SRGBA_8;                     // Color format used for presentation
-    FloatPrecission  highDynamicPrecission = FloatPrecission::F16;        // HDR operations floating point precission
-    FloatPrecission  depthPrecission       = FloatPrecission::F32;        // Depth operations floating point precission
-    Vec4             clearColor            = Vec4 { 0.0, 0.0, 0.0, 1.0 }; // Clear color of visible color buffer
-    SoftwareAA       softwareAA            = SoftwareAA::NONE;
-    ShadowResolution shadowQuality         = ShadowResolution::MEDIUM;
-    bool             autoClearColor        = true;
-    bool             autoClearDepth        = true;
-    bool             autoClearStencil      = true;
-    bool             enableUI              = false;
-    bool             enableRaytracing      = true;
+    MSAASamples         samplesMSAA           = MSAASamples::x4;             // Multisampled AA (when possible)
+    BufferingType       bufferingType         = BufferingType::DOUBLE;       // Buffering type (Usual: double buffering)
+    SyncType            screenSync            = SyncType::MAILBOX;           // Type of display synchronization
+    ColorFormatType     displayColorFormat    = SRGBA_8;                     // Color format used for presentation
+    FloatPrecission     highDynamicPrecission = FloatPrecission::F16;        // HDR operations floating point precission
+    FloatPrecission     depthPrecission       = FloatPrecission::F32;        // Depth operations floating point precission
+    Vec4                clearColor            = Vec4 { 0.0, 0.0, 0.0, 1.0 }; // Clear color of visible color buffer
+    SoftwareAA          softwareAA            = SoftwareAA::NONE;
+    ShadowResolution    shadowQuality         = ShadowResolution::MEDIUM;
+    bool                autoClearColor        = true;
+    bool                autoClearDepth        = true;
+    bool                autoClearStencil      = true;
+    bool                enableUI              = false;
+    bool                enableRaytracing      = true;
+    bool                asyncUploads          = false; // Stream new geometry/textures through the transfer queue instead of stalling the frame
+    uint32_t            recordingThreads      = 0;     // Workers recording secondary command buffers in parallel. 0 means one per hardware thread
+    bool                parallelSetup         = true;  // Set passes up concurrently on the recording workers (shader compilation and pipelines)
+    Render::LODSettings levelOfDetail         = {};    // Level of detail selection of the GPU-driven passes
 };
 /**
  * Basic class. Renders a given scene data to a given window. Fully
@@ -63,8 +68,10 @@ protected:
     /*Render Resources*/
     std::vector<ptr<Render::BasePass>> m_passes;
     std::vector<Graphics::Image>     m_attachments;
+    Render::RenderGraph              m_graph; // Built from the pass linkages. Transient attachments are declared in create_passes()
     Render::GPUSceneBuilder          m_gpuScene;
     ptr<Render::GPUResourcePool>        m_shared;
+    ptr<Utils::JobSystem>            m_jobSystem;
 
     /*Automatic deletion queue*/
     Utils::DeletionQueue m_deletionQueue;
@@ -74,6 +81,7 @@ protected:
     bool     m_initialized        = false;
     bool     m_headless           = false;
     bool     m_updateFramebuffers = false;
+    uint32_t m_skippedBinds       = 0; // Redundant binds filtered out of the last frame
 
 #pragma endregion
 public:
@@ -109,6 +117,21 @@ public:
     inline RendererSettings get_settings() const {
         return m_settings;
     }
+    inline const Render::RenderGraph& get_render_graph() const {
+        return m_graph;
+    }
+    /*
+    Bytes of scene data written to the GPU last frame
+    */
+    inline Render::SceneUploadStats get_scene_upload_stats() const {
+        return m_gpuScene.get_upload_stats();
+    }
+    /*
+    Pipeline, descriptor set and dynamic state binds skipped last frame because they were already bound
+    */
+    inline uint32_t get_skipped_binds() const {
+        return m_skippedBinds;
+    }
     virtual inline void set_settings( RendererSettings settings ) {
         if ( m_settings.screenSync != settings.screenSync )
             m_updateFramebuffers = true;
@@ -148,6 +171,10 @@ protected:
      */
     virtual void create_passes();
     /*
+    Sets the active passes up, concurrently if enabled, and reports how long each one took
+    */
+    void setup_passes();
+    /*
     What to do when initiating the renderer
     */
     virtual void on_init() {
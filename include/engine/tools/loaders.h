@@ -9,7 +9,9 @@
 #ifndef LOADERS_H
 #define LOADERS_H
 
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <stb_image.h>
 
 #include <thread>
@@ -43,9 +45,16 @@ void load_PLY(Core::Mesh* const mesh,
               bool              calculateTangents = false);
 /*
 Generic loader. It automatically parses the file and find the needed loader for the file extension. Can be called
-asynchronously
+asynchronously. OBJ and PLY files are read from their geometry cache (fileName + ".vkgeom") when it is newer than the source,
+and the cache is written after parsing otherwise
 */
-void load_3D_file(Core::Mesh* const mesh, const std::string fileName, bool asynCall = true);
+void load_3D_file(Core::Mesh* const mesh, const std::string fileName, bool asynCall = true, bool useCache = true);
+/*
+Geometry cache. Binary image of the processed geometry (vertices, indices, voxels, meshlets, levels of detail, bounds and topology)
+that is memory mapped and copied as is, skipping parsing, welding, tangent computation, clustering and simplification. Returns false if the file is missing, outdated or corrupt
+*/
+bool load_geometry_cache(Core::Mesh* const mesh, const std::string fileName);
+void save_geometry_cache(Core::Geometry* const geometry, const std::string fileName);
 /*
 Use on .hair files.
 */
@@ -10,9 +10,12 @@
 #define UTILS_H
 
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <engine/common.h>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 
@@ -52,6 +55,41 @@ class ManualTimer
     }
 };
 
+/*
+Fixed pool of worker threads for fork-join work inside a frame. The calling thread takes part as worker 0, so a system with a
+single worker runs everything inline.
+*/
+class JobSystem
+{
+    std::vector<std::thread>            m_threads;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_wakeCondition;
+    std::condition_variable             m_doneCondition;
+    std::function<void(size_t worker)>  m_job;
+    size_t                              m_jobCount   = 0;
+    size_t                              m_pending    = 0;
+    uint64_t                            m_generation = 0;
+    bool                                m_stop       = false;
+
+    void worker_loop(size_t worker);
+
+  public:
+    /*Zero workers means one per hardware thread*/
+    JobSystem(size_t workerCount = 0);
+    ~JobSystem();
+
+    inline size_t get_worker_count() const {
+        return m_threads.size() + 1;
+    }
+    /*Amount of chunks parallel_for would split count items into*/
+    size_t get_chunk_count(size_t count, size_t minChunkSize) const;
+    /*
+    Splits [0, count) in contiguous chunks of at least minChunkSize items (a single chunk when count is smaller), at most one per worker,
+    and blocks until all of them are done. The callback receives the chunk range and the worker (chunk) index
+    */
+    void parallel_for(size_t count, size_t minChunkSize, const std::function<void(size_t begin, size_t end, size_t worker)>& job);
+};
+
 struct MemoryBuffer : public std::streambuf {
     char*  p_start{nullptr};
     char*  p_end{nullptr};
@@ -106,6 +144,52 @@ inline std::vector<uint8_t> read_file_binary(const std::string& pathToFile) {
     return fileBufferBytes;
 }
 
+/*
+Read-only memory mapping of a whole file. Pages are loaded by the OS on first access, so reading a big file costs I/O only
+*/
+class MappedFile
+{
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file    = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+
+  public:
+    MappedFile() {
+    }
+    ~MappedFile() {
+        close();
+    }
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filePath);
+    void close();
+
+    inline const uint8_t* data() const {
+        return m_data;
+    }
+    inline size_t size() const {
+        return m_size;
+    }
+};
+
+/*
+FNV-1a hash. Unlike std::hash it is stable across runs and platforms, so it can name files on disk
+*/
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t       hash  = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 Vec3 get_tangent_gram_smidt(Vec3& p1, Vec3& p2, Vec3& p3, Vec2& uv1, Vec2& uv2, Vec2& uv3, Vec3 normal);
 
 inline float halton(int index, int base) {
@@ -9,7 +9,13 @@
 
 //Input
 layout(location = 0) in vec3 pos;
+#ifdef PACKED_VERTEX
+#include octahedral_nrm_encoding.glsl
+layout(location = 1) in vec2 packedNormal;
+vec3 normal;
+#else
 layout(location = 1) in vec3 normal;
+#endif
 layout(location = 2) in vec2 uv;
 
 //Output
@@ -17,18 +23,13 @@ layout(location = 0) out vec3 v_pos;
 layout(location = 1) out vec3 v_normal;
 layout(location = 2) out vec2 v_uv;
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec4 slot1;
-    vec4 slot2;
-    vec4 slot3;
-    vec4 slot4;
-    vec4 slot5;
-    vec4 slot6;
-    vec4 slot7;
-    vec4 slot8;
-} material;
+#include material.glsl
 
 void main() {
+#ifdef PACKED_VERTEX
+    normal = decode_normal_oct_snorm(packedNormal);
+#endif
+    v_instanceID = INSTANCE_ID;
 
     v_pos = (object.model * vec4(pos, 1.0)).xyz;
     v_uv = vec2(uv.x * material.slot2.x, (1 - uv.y) * material.slot2.y);
@@ -42,6 +43,7 @@ void main() {
 #shader geometry
 #version 460
 #extension GL_NV_geometry_shader_passthrough : enable
+#include object.glsl
 
 layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
@@ -64,6 +66,7 @@ void main() {
         _pos = v_pos[i];
         _normal = v_normal[i];
         _uv = v_uv[i];
+        v_instanceID = INSTANCE_ID;
         if(p.z > p.x && p.z > p.y) {
             gl_Position = vec4(gl_in[i].gl_Position.x, gl_in[i].gl_Position.y, 0, 1);
         } else if(p.x > p.y && p.x > p.z) {
@@ -108,27 +111,17 @@ layout(set = 0, binding = 6, r32f) uniform image3D voxelImage;
 layout(set = 0, binding = 7, r32ui) uniform uimage3D auxVoxelImages[3];
 #endif
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec4 slot1;
-    vec4 slot2;
-    vec4 slot3;
-    vec4 slot4;
-    vec4 slot5;
-    vec4 slot6;
-    vec4 slot7;
-    vec4 slot8;
-} material;
+#include material.glsl
 
 layout(set = 2, binding = 0) uniform sampler2D textures[];
 
-//Settings current object textures
-int objectID = int(object.materialID);
-#define ALBEDO_TEX textures[objectID * 6]
-#define NORMAL_TEX textures[objectID * 6 + 1]
-#define MATERIAL_TEX textures[objectID * 6 + 2]
-#define MATERIAL_TEX2 textures[objectID * 6 + 3]
-#define MATERIAL_TEX3 textures[objectID * 6 + 4]
-#define MATERIAL_TEX4 textures[objectID * 6 + 5]
+//Settings current material textures
+#define ALBEDO_TEX MATERIAL_TEXTURE(0)
+#define NORMAL_TEX MATERIAL_TEXTURE(1)
+#define MATERIAL_TEX MATERIAL_TEXTURE(2)
+#define MATERIAL_TEX2 MATERIAL_TEXTURE(3)
+#define MATERIAL_TEX3 MATERIAL_TEXTURE(4)
+#define MATERIAL_TEX4 MATERIAL_TEXTURE(5)
 
 ///////////////////////////////////////////
 //Surface Global properties
@@ -0,0 +1,155 @@
+#shader compute
+#version 460
+#include light.glsl
+#include scene.glsl
+#include camera.glsl
+#include object.glsl
+
+// One invocation per draw record (an instance or one of its meshlets). Records drawing the same geometry range with the same state
+// form an instance group, stored contiguously from its first record. Runs twice:
+// - Cull: visible records list their instance ID in the range of their group
+// - Emit: the first record of every group with visible instances appends a single instanced indexed indirect command into the
+//   range of its render state bucket
+
+layout(local_size_x = 64) in;
+
+#define CULL_CAMERA     0
+#define CULL_LIGHTS     1
+#define CULL_NONE       2
+
+#define PHASE_CULL      0
+#define PHASE_EMIT      1
+
+#define DRAWABLE_BIT        1u
+#define CAST_SHADOWS_BIT    2u
+#define SHADOW_ONLY_BIT     4u
+
+struct DrawData {
+    uint    indexCount;
+    uint    firstIndex;
+    int     vertexOffset;
+    uint    flags;
+    uint    bucket;
+    uint    firstCommand;
+    uint    instance;
+    uint    firstInstance;  // First record of the instance group
+    vec4    boundingSphere; // Object space center + radius. Negative radius means no bounds
+    vec4    normalCone;     // Object space axis + cutoff of a meshlet. Cutoff 1 means no cone
+};
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint    indexCount;
+    uint    instanceCount;
+    uint    firstIndex;
+    int     vertexOffset;
+    uint    firstInstance;
+};
+
+layout(set = 1, binding = 1) readonly buffer DrawBuffer {
+    DrawData draws[];
+} drawBuffer;
+layout(set = 1, binding = 2) writeonly buffer CommandBuffer {
+    DrawCommand commands[];
+} commandBuffer;
+layout(set = 1, binding = 3) buffer CountBuffer {
+    uint counts[];
+} countBuffer;
+layout(set = 1, binding = 4) writeonly buffer InstanceIDBuffer {
+    uint ids[];
+} instanceIDBuffer;
+layout(set = 1, binding = 5) buffer InstanceCountBuffer {
+    uint counts[];
+} instanceCountBuffer; // Visible instances per group, indexed by the first record of the group
+
+layout(push_constant) uniform Settings {
+    uint recordCount;
+    uint mode;
+    uint frustumCulling;
+    uint phase;
+    uint lightMaskLow;  // Shadow layers 0 to 31 tested in CULL_LIGHTS mode. A layer per light slot, then the cascades
+    uint lightMaskHigh; // Shadow layers 32 to 63
+} settings;
+
+bool isLayerInMask(int layer) {
+    uint layerBits = layer < 32 ? settings.lightMaskLow >> layer : settings.lightMaskHigh >> (layer - 32);
+    return (layerBits & 1u) != 0u;
+}
+
+// Gribb-Hartmann planes. Works for both regular and reversed depth. Degenerated planes (infinite far) are skipped
+bool isSphereOnFrustum(mat4 viewProj, vec3 center, float radius) {
+    vec4 r0 = vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    vec4 r1 = vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    vec4 r2 = vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    vec4 r3 = vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    vec4 planes[6] = vec4[](r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2);
+    for(int i = 0; i < 6; i++) {
+        float normalLength = length(planes[i].xyz);
+        if(normalLength < 1e-6) continue;
+        if(dot(planes[i].xyz, center) + planes[i].w < -radius * normalLength) return false;
+    }
+    return true;
+}
+
+// Every triangle of the meshlet faces away from the camera. Mirrors Core::is_meshlet_visible
+bool isConeBackfacing(mat4 model, vec3 center, float radius, vec4 cone) {
+    vec3  scales   = vec3(length(model[0].xyz), length(model[1].xyz), length(model[2].xyz));
+    float minScale = min(scales.x, min(scales.y, scales.z));
+    float maxScale = max(scales.x, max(scales.y, scales.z));
+    if(minScale < maxScale * 0.99 || determinant(mat3(model)) <= 0.0) return false;
+
+    vec3 axis     = normalize(mat3(model) * cone.xyz);
+    vec3 toCenter = center - camera.position.xyz;
+    return dot(toCenter, axis) >= cone.w * length(toCenter) + radius;
+}
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if(id >= settings.recordCount) return;
+
+    DrawData draw = drawBuffer.draws[id];
+    if((draw.flags & DRAWABLE_BIT) == 0u) return;
+
+    if(settings.phase == PHASE_EMIT) {
+        if(id != draw.firstInstance) return;
+        uint instanceCount = instanceCountBuffer.counts[id];
+        if(instanceCount == 0u) return;
+        uint slot = draw.firstCommand + atomicAdd(countBuffer.counts[draw.bucket], 1u);
+        commandBuffer.commands[slot] = DrawCommand(draw.indexCount, instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+        return;
+    }
+
+    if(settings.mode == CULL_LIGHTS && (draw.flags & CAST_SHADOWS_BIT) == 0u) return;
+    if(settings.mode != CULL_LIGHTS && (draw.flags & SHADOW_ONLY_BIT) != 0u) return;
+
+    bool visible = true;
+    if(settings.mode != CULL_NONE && settings.frustumCulling != 0u && draw.boundingSphere.w >= 0.0) {
+        mat4  model  = objectBuffer.objects[draw.instance].model;
+        vec3  center = (model * vec4(draw.boundingSphere.xyz, 1.0)).xyz;
+        float scale  = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+        float radius = draw.boundingSphere.w * scale;
+
+        if(settings.mode == CULL_CAMERA) {
+            visible = isSphereOnFrustum(camera.viewProj, center, radius);
+            if(visible && draw.normalCone.w < 1.0)
+                visible = !isConeBackfacing(model, center, radius, draw.normalCone);
+        } else { // Inside the frustum of any shadow layer of the mask
+            visible = false;
+            int numLights = min(scene.numLights, MAX_LIGHTS);
+            for(int i = 0; i < numLights && !visible; i++) {
+                if(scene.lights[i].shadowType == 2) continue; //If some light is raytraced
+                if(!isLayerInMask(i)) continue;
+                visible = isSphereOnFrustum(scene.lights[i].viewProj, center, radius);
+            }
+            // Cascades of the cascaded directional light, whose layers go after the ones of the light slots
+            for(int c = 0; c < scene.cascadeCount && !visible; c++) {
+                if(!isLayerInMask(MAX_LIGHTS + c)) continue;
+                visible = isSphereOnFrustum(scene.cascadeViewProj[c], center, radius);
+            }
+        }
+    }
+    if(!visible) return;
+
+    uint slot = draw.firstInstance + atomicAdd(instanceCountBuffer.counts[draw.firstInstance], 1u);
+    instanceIDBuffer.ids[slot] = draw.instance;
+}
@@ -6,9 +6,20 @@
 
 //Input
 layout(location = 0) in vec3 pos;
+#ifdef PACKED_VERTEX
+#include octahedral_nrm_encoding.glsl
+layout(location = 1) in vec2 packedNormal;
+vec3 normal;
+#else
 layout(location = 1) in vec3 normal;
+#endif
 layout(location = 2) in vec2 uv;
+#ifdef PACKED_VERTEX
+layout(location = 3) in vec2 packedTangent;
+vec3 tangent;
+#else
 layout(location = 3) in vec3 tangent;
+#endif
 
 //Output
 layout(location = 0) out vec3 v_pos;
@@ -18,18 +29,14 @@ layout(location = 3) out vec4 v_currClip;
 layout(location = 4) out vec4 v_prevClip;
 layout(location = 5) out mat3 v_TBN;
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec4 slot1;
-    vec4 slot2;
-    vec4 slot3;
-    vec4 slot4;
-    vec4 slot5;
-    vec4 slot6;
-    vec4 slot7;
-    vec4 slot8;
-} material;
+#include material.glsl
 
 void main() {
+#ifdef PACKED_VERTEX
+    normal = decode_normal_oct_snorm(packedNormal);
+    tangent = decode_tangent_oct_snorm(packedTangent);
+#endif
+    v_instanceID = INSTANCE_ID;
 
      // World position
     vec4 worldPos = object.model * vec4(pos, 1.0);
@@ -77,27 +84,17 @@ layout(location = 3) in vec4 v_currClip;
 layout(location = 4) in vec4 v_prevClip;
 layout(location = 5) in mat3 v_TBN;
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec4 slot1;
-    vec4 slot2;
-    vec4 slot3;
-    vec4 slot4;
-    vec4 slot5;
-    vec4 slot6;
-    vec4 slot7;
-    vec4 slot8;
-} material;
+#include material.glsl
 
 layout(set = 2, binding = 0) uniform sampler2D textures[];
 
-//Settings current object textures
-int objectID = int(object.materialID);
-#define ALBEDO_TEX textures[objectID * 6]
-#define NORMAL_TEX textures[objectID * 6 + 1]
-#define MATERIAL_TEX textures[objectID * 6 + 2]
-#define MATERIAL_TEX2 textures[objectID * 6 + 3]
-#define MATERIAL_TEX3 textures[objectID * 6 + 4]
-#define MATERIAL_TEX4 textures[objectID * 6 + 5]
+//Settings current material textures
+#define ALBEDO_TEX MATERIAL_TEXTURE(0)
+#define NORMAL_TEX MATERIAL_TEXTURE(1)
+#define MATERIAL_TEX MATERIAL_TEXTURE(2)
+#define MATERIAL_TEX2 MATERIAL_TEXTURE(3)
+#define MATERIAL_TEX3 MATERIAL_TEXTURE(4)
+#define MATERIAL_TEX4 MATERIAL_TEXTURE(5)
 
 //Output
 layout(location = 0) out vec4 outNormal; //16F
@@ -14,6 +14,7 @@ layout(location = 0) out vec3 v_color;
 layout(location = 1) out vec3 v_tangent;
 
 void main() {
+    v_instanceID = INSTANCE_ID;
 
     gl_Position = object.model * vec4(position, 1.0);
 
@@ -25,6 +26,7 @@ void main() {
 #shader geometry
 #version 460 core
 #include camera.glsl
+#include object.glsl
 
 //Setup
 layout(lines) in;
@@ -35,10 +37,7 @@ layout(location = 0) in vec3 v_color[];
 layout(location = 1) in vec3 v_tangent[];
 
 //Uniforms
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec3 baseColor;
-    float thickness;
-} material;
+#include material.glsl
 
 //Output
 layout(location = 0) out vec3 g_pos;
@@ -75,6 +74,8 @@ void emitQuadPoint(
     g_modelNormal = normal;
     g_origin = (camera.view * origin).xyz;
 
+    v_instanceID = INSTANCE_ID;
+
     EmitVertex();
 }
 
@@ -99,7 +100,7 @@ void main() {
 
         //<<<----
 
-    float halfLength = material.thickness * 0.5;
+    float halfLength = material.slot1.w * 0.5;
 
     emitQuadPoint(startPoint, right0, halfLength, dir0, normal0, vec2(1.0, 0.0), 0);
     emitQuadPoint(endPoint, right1, halfLength, dir1, normal1, vec2(1.0, 1.0), 1);
@@ -134,7 +135,8 @@ layout(set = 0, binding = 2) uniform sampler2DArray shadowMap;
 layout(set = 0, binding = 4) uniform samplerCube irradianceMap;
 
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3 baseColor;
     float thickness;
 
@@ -155,7 +157,10 @@ layout(set = 1, binding = 1) uniform MaterialUniforms {
 
     bool trt;
     bool occlusion;
-} material;
+    vec2 _padding0;
+    vec4 _padding1[3]; // Keeps IMaterial::GPUPayload stride
+};
+#include material.glsl
 
 float scatterWeight = 0.0;
 
@@ -166,11 +171,8 @@ layout(location = 1) out vec4 outBrightColor;
 
 float computeShadow(LightUniform light, int lightId) {
 
-    vec4 posLightSpace = light.viewProj * vec4(g_modelPos, 1.0);
-
-    vec3 projCoords = posLightSpace.xyz / posLightSpace.w; //For x,y and Z
-
-    projCoords.xy = projCoords.xy * 0.5 + 0.5;
+    vec3 projCoords;
+    int layer = getShadowLayer(light, lightId, g_modelPos, projCoords);
 
     if(projCoords.z > 1.0 || projCoords.z < 0.0)
         return 1.0;
@@ -178,7 +180,7 @@ float computeShadow(LightUniform light, int lightId) {
     vec3 lightDir = normalize(light.position.xyz - g_pos);
     float bias = max(light.shadowData.x * 5.0 * (1.0 - dot(g_dir, lightDir)), light.shadowData.x);  //Modulate by angle of incidence
 
-  return 1.0 - filterPCF(shadowMap, lightId,int(light.shadowData.w), light.shadowData.y, projCoords, light.shadowData.x);
+  return 1.0 - filterPCF(shadowMap, layer,int(light.shadowData.w), light.shadowData.y, projCoords, light.shadowData.x);
 }
 
 
@@ -253,7 +255,7 @@ void main() {
 
 
     // vec3 n1 = cross(g_modelDir, cross(camera.position.xyz, g_modelDir));
-    vec3 fakeNormal = normalize(g_modelPos-object.volumeCenter);
+    vec3 fakeNormal = normalize(g_modelPos-object.otherParams2.yzw);
     // vec3 fakeNormal = mix(n1,n2,0.5);
 
     //AMBIENT COMPONENT ..........................................................
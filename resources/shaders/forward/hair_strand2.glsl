@@ -14,6 +14,7 @@ layout(location = 0) out vec3 v_color;
 layout(location = 1) out vec3 v_tangent;
 
 void main() {
+    v_instanceID = INSTANCE_ID;
 
     gl_Position = object.model * vec4(position, 1.0);
 
@@ -25,6 +26,7 @@ void main() {
 #shader geometry
 #version 460 core
 #include camera.glsl
+#include object.glsl
 
 //Setup
 layout(lines) in;
@@ -35,10 +37,7 @@ layout(location = 0) in vec3 v_color[];
 layout(location = 1) in vec3 v_tangent[];
 
 //Uniforms
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec3 baseColor;
-    float thickness;
-} material;
+#include material.glsl
 
 //Output
 layout(location = 0) out vec3 g_pos;
@@ -74,6 +73,8 @@ void emitQuadPoint(
     g_modelNormal = normal;
     g_origin = (camera.view * origin).xyz;
 
+    v_instanceID = INSTANCE_ID;
+
     EmitVertex();
 }
 
@@ -98,7 +99,7 @@ void main() {
 
         //<<<----
 
-    float halfLength = material.thickness * 0.5;
+    float halfLength = material.slot1.w * 0.5;
 
     emitQuadPoint(startPoint, right0, halfLength, dir0, normal0, vec2(1.0, 0.0), 0);
     emitQuadPoint(endPoint, right1, halfLength, dir1, normal1, vec2(1.0, 1.0), 1);
@@ -133,7 +134,8 @@ layout(set = 0, binding = 2) uniform sampler2DArray shadowMap;
 layout(set = 0, binding = 4) uniform samplerCube irradianceMap;
 
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3 baseColor;
     float thickness;
 
@@ -150,7 +152,9 @@ layout(set = 1, binding = 1) uniform MaterialUniforms {
     bool tt;
     bool trt;
     bool occlusion;
-} material;
+    vec4 _padding[4]; // Keeps IMaterial::GPUPayload stride
+};
+#include material.glsl
 
 layout(set = 2, binding = 0) uniform sampler2D nTex1;
 layout(set = 2, binding = 1) uniform sampler2D nTex2;
@@ -249,7 +253,7 @@ void main() {
 
 
     // vec3 n1 = cross(g_modelDir, cross(camera.position.xyz, g_modelDir));
-    vec3 fakeNormal = normalize(g_modelPos-object.volumeCenter);
+    vec3 fakeNormal = normalize(g_modelPos-object.otherParams2.yzw);
     // vec3 fakeNormal = mix(n1,n2,0.5);
 
     //AMBIENT COMPONENT ..........................................................
@@ -51,20 +51,21 @@ layout(set = 0, binding = 1) uniform SceneUniforms {
     mat4 lightViewProj;
 
 } scene;
-layout(set = 1, binding = 0) uniform ObjectUniforms {
-    mat4 model;
-    vec4 otherParams;
-} object;
+#include object.glsl
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3 color;
     float opacity;
     float shininess;
     float glossiness;
     vec2 tileUV;
-} material;
+    vec4 _padding[6]; // Keeps IMaterial::GPUPayload stride
+};
+#include material.glsl
 
 void main() {
+    v_instanceID = INSTANCE_ID;
     gl_Position = camera.viewProj * object.model * vec4(pos, 1.0);
 
     //OUTS
@@ -80,6 +81,7 @@ void main() {
 
 #shader fragment
 #version 450
+#include object.glsl
 
 //Input
 layout(location = 0) in vec3 v_pos;
@@ -115,7 +117,8 @@ layout(set = 0, binding = 1) uniform SceneUniforms {
     mat4 lightViewProj;
 } scene;
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3 color;
     float opacity;
     float shininess;
@@ -126,8 +129,9 @@ layout(set = 1, binding = 1) uniform MaterialUniforms {
     bool hasOpacityTexture;
     bool hasNormalTexture;
     bool hasGlossinessTexture;
-
-} material;
+    vec4 _padding[5]; // Keeps IMaterial::GPUPayload stride
+};
+#include material.glsl
 layout(set = 2, binding = 0) uniform sampler2D shadowMap;
 // layout(set = 2, binding = 1) uniform sampler2D normalTex;
 
@@ -6,9 +6,20 @@
 
 //Input
 layout(location = 0) in vec3 pos;
+#ifdef PACKED_VERTEX
+#include octahedral_nrm_encoding.glsl
+layout(location = 1) in vec2 packedNormal;
+vec3 normal;
+#else
 layout(location = 1) in vec3 normal;
+#endif
 layout(location = 2) in vec2 uv;
+#ifdef PACKED_VERTEX
+layout(location = 3) in vec2 packedTangent;
+vec3 tangent;
+#else
 layout(location = 3) in vec3 tangent;
+#endif
 
 //Output
 layout(location = 0) out vec3 v_pos;
@@ -20,7 +31,8 @@ layout(location = 5) out vec2 v_screenExtent;
 layout(location = 6) out mat3 v_TBN;
 
 //Uniforms
-layout(set = 1, binding = 1) uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3    albedo;
     float   opacity;
     vec2    tileUV;
@@ -45,9 +57,15 @@ layout(set = 1, binding = 1) uniform MaterialUniforms {
     vec3    emissiveColor;
     float   emissiveWeight;
     float   emissionIntensity;
-} material;
+};
+#include material.glsl
 
 void main() {
+#ifdef PACKED_VERTEX
+    normal = decode_normal_oct_snorm(packedNormal);
+    tangent = decode_tangent_oct_snorm(packedTangent);
+#endif
+    v_instanceID = INSTANCE_ID;
 
     gl_Position = camera.viewProj * object.model * vec4(pos, 1.0);
 
@@ -107,7 +125,8 @@ layout(set = 0, binding = 2)    uniform sampler2DArray              shadowMap;
 layout(set = 0, binding = 4)    uniform samplerCube                 irradianceMap;
 layout(set = 0,  binding = 5)   uniform accelerationStructureEXT    TLAS;
 layout(set = 0,  binding = 6)   uniform sampler2D                   blueNoiseMap;
-layout(set = 1, binding = 1)    uniform MaterialUniforms {
+#define MATERIAL_DATA
+struct MaterialData {
     vec3    albedo;
     float   opacity;
     vec2    tileUV;
@@ -132,7 +151,8 @@ layout(set = 1, binding = 1)    uniform MaterialUniforms {
     vec3    emissiveColor;
     float   emissiveWeight;
     float   emissionIntensity;
-} material;
+};
+#include material.glsl
 layout(set = 2, binding = 0) uniform sampler2D albedoTex;
 layout(set = 2, binding = 1) uniform sampler2D normalTex;
 layout(set = 2, binding = 2) uniform sampler2D maskRoughTex;
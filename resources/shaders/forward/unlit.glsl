@@ -16,21 +16,13 @@ layout(set = 0, binding = 0) uniform CameraUniforms {
     mat4 proj;
     mat4 viewProj;
 } camera;
-layout(set = 1, binding = 0) uniform ObjectUniforms {
-    mat4 model;
-    vec4 color;
-    vec4 otherParams;
-} object;
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-    vec4 color;
-    vec2 tile;
-    float hasColorTexture;
-    float hasOpacityTexture;
-} material;
+#include object.glsl
+#include material.glsl
 
 void main() {
+    v_instanceID = INSTANCE_ID;
     gl_Position = camera.viewProj * object.model * vec4(pos, 1.0);
-    fragColor = material.color.rgb;
+    fragColor = material.slot1.rgb;
     affectedByFog = int(object.otherParams.x);
 }
 
@@ -38,18 +30,13 @@ void main() {
 #version 460
 #include light.glsl
 #include scene.glsl
+#include object.glsl
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in flat int affectedByFog;
 
 
-layout(set = 1, binding = 1) uniform MaterialUniforms {
-     vec4 color;
-    vec2 tile;
-    bool alphaTest;
-    float hasColorTexture;
-    float hasOpacityTexture;
-} material;
+#include material.glsl
 
 layout(location = 0) out vec4 outColor;
 layout(location = 1) out vec4 outBrightColor;
@@ -75,6 +62,6 @@ void main() {
     else
         outBrightColor = vec4(0.0, 0.0, 0.0, 1.0);
 
-    if(material.alphaTest)
-        if(material.color.a<1-EPSILON)discard;
+    if(material.slot2.z != 0.0)
+        if(material.slot1.a<1-EPSILON)discard;
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+// Material table. Requires object.glsl. Shaders can declare their own MaterialData layout (defining MATERIAL_DATA)
+// as long as its size stays 128 bytes, the stride of IMaterial::GPUPayload
+#ifndef MATERIAL_DATA
+struct MaterialData {
+    vec4 slot1;
+    vec4 slot2;
+    vec4 slot3;
+    vec4 slot4;
+    vec4 slot5;
+    vec4 slot6;
+    vec4 slot7;
+    vec4 slot8;
+};
+#endif
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+    MaterialData materials[];
+} materialBuffer;
+
+#define MATERIAL_INDEX int(object.otherParams2.x)
+#define material materialBuffer.materials[MATERIAL_INDEX]
+
+// Bindless material textures, for shaders declaring a textures[] array. Each material owns MAX_TEXTURES_PER_MATERIAL consecutive
+// slots. Requires GL_EXT_nonuniform_qualifier, as the index comes from a per-instance varying
+#define MAX_TEXTURES_PER_MATERIAL 6
+#define MATERIAL_TEXTURE(slot) textures[nonuniformEXT(MATERIAL_INDEX * MAX_TEXTURES_PER_MATERIAL + (slot))]
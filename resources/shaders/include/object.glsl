@@ -1,6 +1,30 @@
-layout(set = 1, binding = 0) uniform ObjectUniforms {
+struct ObjectData {
     mat4    model;
-    vec4    otherParams;
-    float     materialID;
-    vec3    volumeCenter;
-} object;
\ No newline at end of file
+    vec4    otherParams;    // x: affected by fog, y: receive shadows, z: cast shadows, w: instance ID
+    vec4    otherParams2;   // x: material index, yzw: bounding volume center
+};
+// Instance table. Bound once per pass, indexed by instance ID
+layout(set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// The instance ID is forwarded to later stages as a flat varying. Geometry stages must write it before each EmitVertex()
+#if defined(VERTEX_STAGE)
+// Instance IDs listed by the pass. Instanced draws of shared geometry point their firstInstance at the first ID of their run
+layout(set = 1, binding = 2) readonly buffer InstanceIDBuffer {
+    uint ids[];
+} instanceIDBuffer;
+layout(location = 15) flat out uint v_instanceID;
+#define INSTANCE_ID instanceIDBuffer.ids[gl_InstanceIndex]
+#elif defined(GEOMETRY_STAGE)
+layout(location = 15) flat in uint v_instanceIDIn[];
+layout(location = 15) flat out uint v_instanceID;
+#define INSTANCE_ID v_instanceIDIn[0]
+#elif defined(COMPUTE_STAGE)
+// No varyings. Compute shaders index objectBuffer.objects[] directly
+#else
+layout(location = 15) flat in uint v_instanceID;
+#define INSTANCE_ID v_instanceID
+#endif
+
+#define object objectBuffer.objects[INSTANCE_ID]
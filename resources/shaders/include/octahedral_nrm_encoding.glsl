@@ -24,3 +24,13 @@ vec3 decode_normal_oct(vec2 f) {
     }
     return normalize(n);
 }
+
+// Same mapping stored as signed normalized [-1,1] pairs, as written by Graphics::PackedVertex
+vec3 decode_normal_oct_snorm(vec2 f) {
+    return decode_normal_oct(f * 0.5 + 0.5);
+}
+
+// Tangents use the (-1, -1) corner, never written for a direction, for vertices without tangent
+vec3 decode_tangent_oct_snorm(vec2 f) {
+    return all(equal(f, vec2(-1.0))) ? vec3(0.0) : decode_normal_oct_snorm(f);
+}
@@ -4,6 +4,7 @@
 //////////////////////////////////////////////
 
 #define MAX_LIGHTS 50
+#define MAX_CASCADES 4
 
 layout(set = 0, binding = 1) uniform SceneUniforms {
     vec3 fogColor;
@@ -31,6 +32,12 @@ layout(set = 0, binding = 1) uniform SceneUniforms {
     float envColorMultiplier;
 
     float time;
+
+    // Cascaded directional light. Cascade c is drawn into shadow layer MAX_LIGHTS + c
+    int cascadeLight; // Light slot. Negative if none
+    int cascadeCount;
+    vec4 cascadeSplits; // Far distance of each cascade from the camera
+    mat4 cascadeViewProj[MAX_CASCADES];
 } scene;
 
 float computeFog(float coordDepth) {
@@ -1,8 +1,31 @@
 //////////////////////////////////////////////
 // ATTENTTION
-// This script needs: light.glsl
+// This script needs: light.glsl, scene.glsl
 //////////////////////////////////////////////
 
+// Shadow map layer of a light and the fragment coordinates in it. The cascaded directional light picks the finest cascade holding
+// the fragment. Beyond the last one, depth is out of range and the fragment is lit
+int getShadowLayer(LightUniform light, int lightId, vec3 fragModelPos, out vec3 coords) {
+    if(lightId == scene.cascadeLight) {
+        for(int c = 0; c < scene.cascadeCount; c++) {
+            vec4 posLightSpace = scene.cascadeViewProj[c] * vec4(fragModelPos, 1.0);
+            coords = posLightSpace.xyz / posLightSpace.w;
+            // Slightly inset, so filter kernels do not read past the cascade borders
+            if(all(lessThan(abs(coords.xy), vec2(0.98))) && coords.z >= 0.0 && coords.z <= 1.0) {
+                coords.xy = coords.xy * 0.5 + 0.5;
+                return MAX_LIGHTS + c;
+            }
+        }
+        coords = vec3(0.5, 0.5, 2.0);
+        return lightId;
+    }
+
+    vec4 posLightSpace = light.viewProj * vec4(fragModelPos, 1.0);
+    coords = posLightSpace.xyz / posLightSpace.w;
+    coords.xy = coords.xy * 0.5 + 0.5;
+    return lightId;
+}
+
 float filterPCF(sampler2DArray shadowMap ,int lightId ,int kernelSize, float extentMultiplier, vec3 coords, float bias) {
 
     int edge = kernelSize / 2;
@@ -24,16 +47,13 @@ float filterPCF(sampler2DArray shadowMap ,int lightId ,int kernelSize, float ext
 
 float computeShadow(sampler2DArray shadowMap ,LightUniform light, int lightId, vec3 fragModelPos) {
 
-    vec4 pos_lightSpace = light.viewProj * vec4(fragModelPos, 1.0);
-
-    vec3 projCoords = pos_lightSpace.xyz / pos_lightSpace.w;
-
-    projCoords.xy  = projCoords.xy * 0.5 + 0.5;
+    vec3 projCoords;
+    int layer = getShadowLayer(light, lightId, fragModelPos, projCoords);
 
     if(projCoords.z > 1.0 || projCoords.z < 0.0)
         return 1.0;
     
-    return 1.0 - filterPCF(shadowMap, lightId,int(light.shadowData.w), light.shadowData.y, projCoords, light.shadowData.x);
+    return 1.0 - filterPCF(shadowMap, layer,int(light.shadowData.w), light.shadowData.y, projCoords, light.shadowData.x);
 
 }
 
@@ -45,14 +65,11 @@ float linstep(float low, float high, float v){
 
 float computeVarianceShadow(sampler2DArray VSM ,LightUniform light, int lightId, vec3 fragModelPos) {
 
-    vec4 pos_lightSpace = light.viewProj * vec4(fragModelPos, 1.0);
-
-    vec3 projCoords = pos_lightSpace.xyz / pos_lightSpace.w;
-
-    projCoords.xy  = projCoords.xy * 0.5 + 0.5;
+    vec3 projCoords;
+    int layer = getShadowLayer(light, lightId, fragModelPos, projCoords);
 
     // ChebyshevUpperBound {
-    vec2 moments = texture(VSM, vec3(projCoords.xy,lightId)).rg;
+    vec2 moments = texture(VSM, vec3(projCoords.xy,layer)).rg;
     float p = step(projCoords.z,moments.x);
     float variance = max(moments.y-moments.x*moments.x,0.00002);
 
@@ -9,11 +9,10 @@ layout(set = 0, binding = 0) uniform CameraUniforms {
     mat4 viewProj;
 } camera;
 
-layout(set = 1, binding = 0) uniform ObjectUniforms {
-    mat4 model;
-} object;
+#include object.glsl
 
 void main() {
+    v_instanceID = INSTANCE_ID;
     gl_Position = camera.viewProj * object.model * vec4(pos, 1.0);
 }
 
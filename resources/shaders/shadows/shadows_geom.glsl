@@ -1,10 +1,12 @@
 #shader vertex
 #version 460
+#include object.glsl
 
 //Input VBO
 layout(location = 0) in vec3 pos;
 
 void main() {
+   v_instanceID = INSTANCE_ID;
    gl_Position = vec4(pos, 1.0);
 }
 
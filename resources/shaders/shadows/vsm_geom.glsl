@@ -1,10 +1,12 @@
 #shader vertex
 #version 460
+#include object.glsl
 
 //Input VBO
 layout(location = 0) in vec3 pos;
 
 void main() {
+   v_instanceID = INSTANCE_ID;
    gl_Position = vec4(pos, 1.0);
 }
 
@@ -16,8 +18,58 @@ void main() {
 
 
 layout(triangles) in;
-layout(triangle_strip, max_vertices = 150) out;
+layout(triangle_strip, max_vertices = 162) out; // Every light slot and cascade
+
+
+// Layers redrawn this frame. The rest keep their cached shadow map
+layout(push_constant) uniform Settings {
+    uint  layerMaskLow;  // Layers 0 to 31
+    uint  layerMaskHigh; // Layers 32 to 63
+    float resolution;    // Of the shadow maps
+} settings;
+
+// Every vertex beyond the same clip plane of the view
+bool isOutside(vec4 a, vec4 b, vec4 c) {
+    return (a.x < -a.w && b.x < -b.w && c.x < -c.w) || (a.x > a.w && b.x > b.w && c.x > c.w) ||
+           (a.y < -a.w && b.y < -b.w && c.y < -c.w) || (a.y > a.w && b.y > b.w && c.y > c.w) ||
+           (a.z < 0.0 && b.z < 0.0 && c.z < 0.0) || (a.z > a.w && b.z > b.w && c.z > c.w);
+}
+
+// Triangles whose bounds fall between two texel centers cover none. Common for small casters in the far cascades
+bool missesTexelCenters(vec4 a, vec4 b, vec4 c) {
+    if(a.w <= 0.0 || b.w <= 0.0 || c.w <= 0.0) return false;
+    vec2 ta = (a.xy / a.w * 0.5 + 0.5) * settings.resolution;
+    vec2 tb = (b.xy / b.w * 0.5 + 0.5) * settings.resolution;
+    vec2 tc = (c.xy / c.w * 0.5 + 0.5) * settings.resolution;
+    vec2 minTexel = round(min(ta, min(tb, tc)));
+    vec2 maxTexel = round(max(ta, max(tb, tc)));
+    return any(equal(minTexel, maxTexel));
+}
+
+bool isLayerRedrawn(int layer) {
+    uint layerBits = layer < 32 ? settings.layerMaskLow >> layer : settings.layerMaskHigh >> (layer - 32);
+    return (layerBits & 1u) != 0u;
+}
 
+void emitToLayer(int layer, mat4 viewProj) {
+    vec4 clip[3];
+    for(int v = 0; v < 3; v++)
+        clip[v] = viewProj * object.model * gl_in[v].gl_Position;
+    if(isOutside(clip[0], clip[1], clip[2]) || missesTexelCenters(clip[0], clip[1], clip[2])) return;
+
+    gl_Layer = layer;
+
+    gl_Position = clip[0];
+    EmitVertex();
+
+    gl_Position = clip[1];
+    EmitVertex();
+
+    gl_Position = clip[2];
+    EmitVertex();
+
+    EndPrimitive();
+}
 
 void main() {
     for(int i = 0; i < MAX_LIGHTS; i++) {
@@ -25,22 +77,16 @@ void main() {
         //Stop emitting vertex if theres no more lights
         if(i>=scene.numLights) break;
 
-        //Check if object inside area of light
-        gl_Layer = i;
         if(scene.lights[i].shadowType == 2) continue; //If some light is raytraced
+        if(!isLayerRedrawn(i)) continue; // Also the layer of the cascaded light, never redrawn
+
+        emitToLayer(i, scene.lights[i].viewProj);
+    }
 
-        gl_Position = scene.lights[i].viewProj * object.model*gl_in[0].gl_Position;
-        EmitVertex();
-        
-        gl_Position = scene.lights[i].viewProj * object.model*gl_in[1].gl_Position;
-        EmitVertex();
-        
-        gl_Position = scene.lights[i].viewProj * object.model*gl_in[2].gl_Position;
-        EmitVertex();
-
-        EndPrimitive();
-        
-      
+    // Cascades of the cascaded directional light, after the layers of the light slots
+    for(int c = 0; c < scene.cascadeCount; c++) {
+        if(isLayerRedrawn(MAX_LIGHTS + c))
+            emitToLayer(MAX_LIGHTS + c, scene.cascadeViewProj[c]);
     }
 }
 
@@ -1,10 +1,12 @@
 #shader vertex
 #version 460
+#include object.glsl
 
 //Input VBO
 layout(location = 0) in vec3 pos;
 
 void main() {
+   v_instanceID = INSTANCE_ID;
    gl_Position = vec4(pos, 1.0);
 }
 
@@ -16,8 +18,43 @@ void main() {
 
 
 layout(lines) in;
-layout(line_strip, max_vertices = 100) out;
+layout(line_strip, max_vertices = 108) out; // Every light slot and cascade
+
+
+// Layers redrawn this frame. The rest keep their cached shadow map
+layout(push_constant) uniform Settings {
+    uint  layerMaskLow;  // Layers 0 to 31
+    uint  layerMaskHigh; // Layers 32 to 63
+    float resolution;    // Of the shadow maps
+} settings;
+
+// Both vertices beyond the same clip plane of the view
+bool isOutside(vec4 a, vec4 b) {
+    return (a.x < -a.w && b.x < -b.w) || (a.x > a.w && b.x > b.w) || (a.y < -a.w && b.y < -b.w) || (a.y > a.w && b.y > b.w) ||
+           (a.z < 0.0 && b.z < 0.0) || (a.z > a.w && b.z > b.w);
+}
+
+bool isLayerRedrawn(int layer) {
+    uint layerBits = layer < 32 ? settings.layerMaskLow >> layer : settings.layerMaskHigh >> (layer - 32);
+    return (layerBits & 1u) != 0u;
+}
 
+void emitToLayer(int layer, mat4 viewProj) {
+    vec4 clip[2];
+    for(int v = 0; v < 2; v++)
+        clip[v] = viewProj * object.model * gl_in[v].gl_Position;
+    if(isOutside(clip[0], clip[1])) return;
+
+    gl_Layer = layer;
+
+    gl_Position = clip[0];
+    EmitVertex();
+
+    gl_Position = clip[1];
+    EmitVertex();
+
+    EndPrimitive();
+}
 
 void main() {
     for(int i = 0; i < MAX_LIGHTS; i++) {
@@ -25,19 +62,16 @@ void main() {
         //Stop emitting vertex if theres no more lights
         if(i>=scene.numLights) break;
 
-        gl_Layer = i;
         if(scene.lights[i].type == 2) continue; //If some light is raytraced
+        if(!isLayerRedrawn(i)) continue; // Also the layer of the cascaded light, never redrawn
 
-        gl_Position = scene.lights[i].viewProj * object.model*gl_in[0].gl_Position;
-        EmitVertex();
-        
-        gl_Position = scene.lights[i].viewProj * object.model*gl_in[1].gl_Position;
-        EmitVertex();
-        
+        emitToLayer(i, scene.lights[i].viewProj);
+    }
 
-        EndPrimitive();
-        
-      
+    // Cascades of the cascaded directional light, after the layers of the light slots
+    for(int c = 0; c < scene.cascadeCount; c++) {
+        if(isLayerRedrawn(MAX_LIGHTS + c))
+            emitToLayer(MAX_LIGHTS + c, scene.cascadeViewProj[c]);
     }
 }
 
@@ -5,31 +5,96 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 namespace Core {
 
 void Geometry::fill(std::vector<Graphics::Vertex> vertexInfo, Topology topology) {
-    m_properties.vertexData = vertexInfo;
+    m_properties.vertexData = std::move(vertexInfo);
     m_properties.compute_statistics();
     m_properties.topology = topology;
-    m_properties.loaded = true;
+    m_properties.loaded   = true;
+    m_properties.released = false;
 }
 void Geometry::fill(std::vector<Graphics::Vertex> vertexInfo, std::vector<uint32_t> vertexIndex, Topology topology) {
-    m_properties.vertexData  = vertexInfo;
-    m_properties.vertexIndex = vertexIndex;
+    m_properties.vertexData  = std::move(vertexInfo);
+    m_properties.vertexIndex = std::move(vertexIndex);
+    m_properties.meshlets.clear();
+    m_properties.lods.clear();
+    m_properties.lodIndex.clear();
     m_properties.compute_statistics();
     m_properties.topology = topology;
-    m_properties.loaded = true;
+    m_properties.loaded   = true;
+    m_properties.released = false;
 }
 
 void Geometry::fill(Vec3* pos, Vec3* normal, Vec2* uv, Vec3* tangent, uint32_t vertNumber, Topology topology) {
+    m_properties.vertexData.reserve(m_properties.vertexData.size() + vertNumber);
     for (size_t i = 0; i < vertNumber; i++)
     {
         m_properties.vertexData.push_back({pos[i], normal[i], tangent[i], uv[i], Vec3(1.0)});
     }
     m_properties.compute_statistics();
     m_properties.topology = topology;
-    m_properties.loaded = true;
+    m_properties.loaded   = true;
+    m_properties.released = false;
+}
+
+void Geometry::fill(const Graphics::Vertex* vertices,
+                    size_t                  vertexCount,
+                    const uint32_t*         indices,
+                    size_t                  indexCount,
+                    Topology                topology,
+                    const Vec3&             minCoords,
+                    const Vec3&             maxCoords) {
+    m_properties.vertexData.assign(vertices, vertices + vertexCount);
+    m_properties.vertexIndex.assign(indices, indices + indexCount);
+    m_properties.meshlets.clear();
+    m_properties.lods.clear();
+    m_properties.lodIndex.clear();
+    m_properties.minCoords = minCoords;
+    m_properties.maxCoords = maxCoords;
+    m_properties.center    = (maxCoords + minCoords) * 0.5f;
+    m_properties.topology  = topology;
+    m_properties.loaded    = true;
+    m_properties.released  = false;
 }
 
 void Geometry::fill_voxel_array(std::vector<Graphics::Voxel> voxels) {
-    m_properties.voxelData = voxels;
+    m_properties.voxelData = std::move(voxels);
+}
+void Geometry::fill_meshlet_array(std::vector<Meshlet> meshlets) {
+    m_properties.meshlets = std::move(meshlets);
+}
+void Geometry::fill_LOD_array(std::vector<GeometryLOD> lods, std::vector<uint32_t> lodIndex) {
+    m_properties.lods     = std::move(lods);
+    m_properties.lodIndex = std::move(lodIndex);
+}
+bool Geometry::build_LODs(uint32_t maxLevels, float reduction) {
+    if (!CPU_data_available() || m_properties.topology != Topology::TRIANGLES || m_properties.vertexIndex.empty())
+        return false;
+    if (m_VAO.loadedOnGPU)
+    {
+        LOG_WARN("Levels of detail have to be built before the geometry is uploaded");
+        return false;
+    }
+    m_properties.lodIndex.clear();
+    m_properties.lods = Core::build_LODs(m_properties.vertexData, m_properties.vertexIndex, m_properties.lodIndex, maxLevels, reduction);
+    return !m_properties.lods.empty();
+}
+bool Geometry::build_meshlets(uint32_t maxVertices, uint32_t maxTriangles) {
+    if (!CPU_data_available() || m_properties.topology != Topology::TRIANGLES || m_properties.vertexIndex.empty())
+        return false;
+    if (m_VAO.loadedOnGPU)
+    {
+        LOG_WARN("Meshlets have to be built before the geometry is uploaded");
+        return false;
+    }
+    m_properties.meshlets = Core::build_meshlets(m_properties.vertexData, m_properties.vertexIndex, maxVertices, maxTriangles);
+    return !m_properties.meshlets.empty();
+}
+void Geometry::release_CPU_data() {
+    // Swapping actually gives the memory back, clear() would keep the capacity
+    std::vector<Graphics::Vertex>().swap(m_properties.vertexData);
+    std::vector<uint32_t>().swap(m_properties.vertexIndex);
+    std::vector<uint32_t>().swap(m_properties.lodIndex);
+    std::vector<Graphics::Voxel>().swap(m_properties.voxelData);
+    m_properties.released = true;
 }
 void GeometricData::compute_statistics() {
     maxCoords = {0.0f, 0.0f, 0.0f};
@@ -223,7 +288,7 @@ Geometry* Geometry::create_cylinder(int segments, float radius, float height) {
         indices.push_back(base + 1);
     }
 
-    g->fill(vertices, indices);
+    g->fill(std::move(vertices), std::move(indices));
     return g;
 }
 
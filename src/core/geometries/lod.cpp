@@ -0,0 +1,275 @@
+#include <engine/core/geometries/lod.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+namespace {
+// Minimum cosine between a triangle normal before and after a collapse. Lower values let the surface fold
+#define SIMPLIFY_MAX_NORMAL_DEVIATION 0.25f
+// A level has to drop at least this fraction of the triangles of the previous one to be kept
+#define LOD_MIN_REDUCTION 0.15f
+// Levels coarser than this are not worth drawing instead of a smaller mesh
+#define LOD_MIN_TRIANGLES 64
+
+/*
+Area weighted sum of squared distances to the planes of a set of triangles. Evaluating it divided by the total area gives the mean
+squared distance of a point to them
+*/
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0, w = 0;
+
+    void add_plane(const Vec3& n, float d, float weight) {
+        a2 += weight * n.x * n.x;
+        ab += weight * n.x * n.y;
+        ac += weight * n.x * n.z;
+        ad += weight * n.x * d;
+        b2 += weight * n.y * n.y;
+        bc += weight * n.y * n.z;
+        bd += weight * n.y * d;
+        c2 += weight * n.z * n.z;
+        cd += weight * n.z * d;
+        d2 += weight * d * d;
+        w += weight;
+    }
+    void add(const Quadric& q) {
+        a2 += q.a2;
+        ab += q.ab;
+        ac += q.ac;
+        ad += q.ad;
+        b2 += q.b2;
+        bc += q.bc;
+        bd += q.bd;
+        c2 += q.c2;
+        cd += q.cd;
+        d2 += q.d2;
+        w += q.w;
+    }
+    double evaluate(const Vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        double       e = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                   2.0 * (ad * x + bd * y + cd * z) + d2;
+        return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double   cost;
+};
+
+inline uint64_t edge_key(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+} // namespace
+
+std::vector<uint32_t>
+simplify(const std::vector<Graphics::Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float* resultError) {
+    PROFILING_EVENT()
+    std::vector<uint32_t> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    if (resultError)
+        *resultError = 0.0f;
+    if (result.size() <= targetIndexCount)
+        return result;
+
+    // Vertices sharing a position (attribute seams) are one point for quadrics and borders
+    std::vector<uint32_t>              position(vertices.size());
+    std::vector<uint32_t>              positionUses;
+    std::unordered_map<Vec3, uint32_t> positionIDs;
+    positionIDs.reserve(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        auto it = positionIDs.emplace(vertices[v].pos, static_cast<uint32_t>(positionIDs.size())).first;
+        position[v] = it->second;
+    }
+    positionUses.assign(positionIDs.size(), 0);
+    {
+        std::vector<bool> used(vertices.size(), false);
+        for (uint32_t v : result)
+        {
+            if (!used[v])
+                positionUses[position[v]]++;
+            used[v] = true;
+        }
+    }
+
+    // Edges used by a single triangle are borders
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int e = 0; e < 3; e++)
+            edgeUses[edge_key(position[result[i + e]], position[result[i + (e + 1) % 3]])]++;
+    }
+    std::vector<bool> locked(vertices.size(), false);
+    for (size_t v = 0; v < vertices.size(); v++)
+        locked[v] = positionUses[position[v]] > 1;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int e = 0; e < 3; e++)
+        {
+            uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+            if (edgeUses[edge_key(position[a], position[b])] == 1)
+                locked[a] = locked[b] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(positionIDs.size());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const Vec3& p0 = vertices[result[i]].pos;
+        Vec3        n  = math::cross(vertices[result[i + 1]].pos - p0, vertices[result[i + 2]].pos - p0);
+        float       l  = math::length(n);
+        if (l <= 0.0f)
+            continue;
+        n /= l;
+        Quadric q;
+        q.add_plane(n, -math::dot(n, p0), l * 0.5f);
+        for (int c = 0; c < 3; c++)
+            quadrics[position[result[i + c]]].add(q);
+    }
+
+    // Passes of independent collapses, cheapest first. Everything around a collapse is left for the next pass, so the checks of a
+    // pass never see stale triangles
+    double                maxCost = 0.0;
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<bool>     touched(vertices.size());
+    std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    while (result.size() > targetIndexCount)
+    {
+        const size_t triangleCount = result.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t v : result)
+            adjacencyOffsets[v + 1]++;
+        for (size_t v = 0; v < vertices.size(); v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+                if (!locked[a])
+                    collapses.push_back({a, b, quadrics[position[b]].evaluate(vertices[b].pos) + quadrics[position[a]].evaluate(vertices[b].pos)});
+                if (!locked[b])
+                    collapses.push_back({b, a, quadrics[position[a]].evaluate(vertices[a].pos) + quadrics[position[b]].evaluate(vertices[a].pos)});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        for (size_t v = 0; v < vertices.size(); v++)
+            remap[v] = static_cast<uint32_t>(v);
+        std::fill(touched.begin(), touched.end(), false);
+
+        const size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+        size_t       removed           = 0;
+        for (const Collapse& c : collapses)
+        {
+            if (removed >= trianglesToRemove)
+                break;
+            if (touched[c.from] || touched[c.to])
+                continue;
+
+            // Triangles around the collapsed vertex either vanish (they hold the edge) or must keep facing the same way
+            bool     valid     = true;
+            uint32_t vanishing = 0;
+            for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1] && valid; a++)
+            {
+                const uint32_t* tri = &result[adjacency[a] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                {
+                    vanishing++;
+                    continue;
+                }
+                Vec3 p[3], q[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = vertices[tri[k]].pos;
+                    q[k] = vertices[tri[k] == c.from ? c.to : tri[k]].pos;
+                }
+                Vec3  before = math::cross(p[1] - p[0], p[2] - p[0]);
+                Vec3  after  = math::cross(q[1] - q[0], q[2] - q[0]);
+                float lb = math::length(before), la = math::length(after);
+                valid = la > 0.0f && lb > 0.0f && math::dot(before, after) > SIMPLIFY_MAX_NORMAL_DEVIATION * la * lb;
+            }
+            if (!valid || vanishing == 0)
+                continue;
+
+            remap[c.from] = c.to;
+            quadrics[position[c.to]].add(quadrics[position[c.from]]);
+            for (uint32_t a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; a++)
+            {
+                const uint32_t* tri = &result[adjacency[a] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+            }
+            removed += vanishing;
+            maxCost = std::max(maxCost, c.cost);
+        }
+        if (removed == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = static_cast<float>(std::sqrt(maxCost));
+    return result;
+}
+
+std::vector<GeometryLOD> build_LODs(const std::vector<Graphics::Vertex>& vertices,
+                                    const std::vector<uint32_t>&         indices,
+                                    std::vector<uint32_t>&               lodIndices,
+                                    uint32_t                             maxLevels,
+                                    float                                reduction) {
+    PROFILING_EVENT()
+    std::vector<GeometryLOD> lods;
+    std::vector<uint32_t>    current = indices;
+    float                    error   = 0.0f;
+    for (uint32_t level = 0; level < maxLevels; level++)
+    {
+        const size_t target = static_cast<size_t>(current.size() / 3 * reduction) * 3;
+        if (target < 3 * LOD_MIN_TRIANGLES)
+            break;
+
+        // Every level starts from the previous one, so their errors add up
+        float                 levelError = 0.0f;
+        std::vector<uint32_t> simplified = simplify(vertices, current, target, &levelError);
+        if (simplified.size() > current.size() * (1.0f - LOD_MIN_REDUCTION))
+            break;
+
+        error += levelError;
+        GeometryLOD lod;
+        lod.firstIndex = static_cast<uint32_t>(indices.size() + lodIndices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.size());
+        lod.error      = error;
+        lods.push_back(lod);
+        lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+        current = std::move(simplified);
+    }
+    return lods;
+}
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
@@ -0,0 +1,217 @@
+#include <engine/core/geometries/meshlet.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+namespace {
+// Below this the triangles of the cluster face too many directions for the cone to ever cull it
+#define MESHLET_MIN_CONE_DOT 0.1f
+
+Meshlet compute_bounds(const std::vector<Graphics::Vertex>& vertices,
+                       const uint32_t*                      indices,
+                       uint32_t                             firstIndex,
+                       uint32_t                             indexCount,
+                       const std::vector<uint32_t>&         meshletVertices) {
+    Meshlet meshlet;
+    meshlet.firstIndex  = firstIndex;
+    meshlet.indexCount  = indexCount;
+    meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+
+    Vec3 minCoords = Vec3(INFINITY);
+    Vec3 maxCoords = Vec3(-INFINITY);
+    for (uint32_t v : meshletVertices)
+    {
+        minCoords = math::min(minCoords, vertices[v].pos);
+        maxCoords = math::max(maxCoords, vertices[v].pos);
+    }
+    const Vec3 center = (minCoords + maxCoords) * 0.5f;
+    float      radius = 0.0f;
+    for (uint32_t v : meshletVertices)
+        radius = std::max(radius, math::length(vertices[v].pos - center));
+    meshlet.boundingSphere = Vec4(center, radius);
+
+    // Cone around the average face normal wide enough to hold every face normal. Degenerated triangles have none
+    std::vector<Vec3> normals;
+    normals.reserve(indexCount / 3);
+    Vec3 axis = Vec3(0.0f);
+    for (uint32_t i = 0; i < indexCount; i += 3)
+    {
+        const Vec3& a = vertices[indices[i]].pos;
+        const Vec3& b = vertices[indices[i + 1]].pos;
+        const Vec3& c = vertices[indices[i + 2]].pos;
+        Vec3        n = math::cross(b - a, c - a);
+        float       l = math::length(n);
+        if (l <= 1e-12f)
+            continue;
+        normals.push_back(n / l);
+        axis += normals.back();
+    }
+    const float axisLength = math::length(axis);
+    if (normals.empty() || axisLength <= 1e-6f)
+        return meshlet;
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (const Vec3& n : normals)
+        minDot = std::min(minDot, math::dot(axis, n));
+    if (minDot > MESHLET_MIN_CONE_DOT)
+        meshlet.normalCone = Vec4(axis, std::sqrt(1.0f - minDot * minDot));
+    return meshlet;
+}
+
+// Gribb-Hartmann planes, as extracted by the culling shader
+bool is_sphere_on_frustum(const Mat4& viewProj, const Vec3& center, float radius) {
+    const Vec4 r0 = Vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    const Vec4 r1 = Vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    const Vec4 r2 = Vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    const Vec4 r3 = Vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    const Vec4 planes[6] = {r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2};
+    for (const Vec4& plane : planes)
+    {
+        float normalLength = math::length(Vec3(plane));
+        if (normalLength < 1e-6f)
+            continue;
+        if (math::dot(Vec3(plane), center) + plane.w < -radius * normalLength)
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+std::vector<Meshlet>
+build_meshlets(const std::vector<Graphics::Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t maxVertices, uint32_t maxTriangles) {
+    PROFILING_EVENT()
+    std::vector<Meshlet> meshlets;
+    const size_t         triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+        return meshlets;
+
+    // Triangles around every vertex
+    std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacencyOffsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertices.size(); v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> ordered;
+    ordered.reserve(triangleCount * 3);
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> owner(vertices.size(), UINT32_MAX); // Meshlet the vertex was last added to
+    std::vector<uint32_t> meshletVertices;
+    meshletVertices.reserve(maxVertices);
+
+    uint32_t meshletID     = 0;
+    uint32_t meshletStart  = 0;
+    uint32_t lastTriangle  = UINT32_MAX;
+    size_t   nextSeed      = 0;
+    auto     new_vertices  = [&](uint32_t t) {
+        const uint32_t* tri   = &indices[t * 3];
+        uint32_t        count = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bool repeated = (i > 0 && tri[i] == tri[0]) || (i > 1 && tri[i] == tri[1]);
+            if (owner[tri[i]] != meshletID && !repeated)
+                count++;
+        }
+        return count;
+    };
+    // Cheapest not emitted triangle around the given vertices
+    auto pick_neighbour = [&](const uint32_t* around, size_t count, uint32_t& best, uint32_t& bestCost) {
+        for (size_t i = 0; i < count && bestCost > 0; i++)
+        {
+            for (uint32_t a = adjacencyOffsets[around[i]]; a < adjacencyOffsets[around[i] + 1]; a++)
+            {
+                uint32_t t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                uint32_t cost = new_vertices(t);
+                if (cost < bestCost)
+                {
+                    best     = t;
+                    bestCost = cost;
+                }
+            }
+        }
+    };
+    auto flush = [&]() {
+        const uint32_t indexCount = static_cast<uint32_t>(ordered.size()) - meshletStart;
+        meshlets.push_back(compute_bounds(vertices, ordered.data() + meshletStart, meshletStart, indexCount, meshletVertices));
+        meshletStart = static_cast<uint32_t>(ordered.size());
+        meshletVertices.clear();
+        meshletID++;
+    };
+
+    for (size_t n = 0; n < triangleCount; n++)
+    {
+        uint32_t best     = UINT32_MAX;
+        uint32_t bestCost = 4;
+        if (lastTriangle != UINT32_MAX)
+            pick_neighbour(&indices[lastTriangle * 3], 3, best, bestCost);
+        if (best == UINT32_MAX && !meshletVertices.empty())
+            pick_neighbour(meshletVertices.data(), meshletVertices.size(), best, bestCost);
+        if (best == UINT32_MAX)
+        {
+            while (emitted[nextSeed])
+                nextSeed++;
+            best     = static_cast<uint32_t>(nextSeed);
+            bestCost = new_vertices(best);
+        }
+
+        const uint32_t triangles = (static_cast<uint32_t>(ordered.size()) - meshletStart) / 3;
+        if (triangles + 1 > maxTriangles || meshletVertices.size() + bestCost > maxVertices)
+            flush();
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            uint32_t v = indices[best * 3 + i];
+            if (owner[v] != meshletID)
+            {
+                owner[v] = meshletID;
+                meshletVertices.push_back(v);
+            }
+            ordered.push_back(v);
+        }
+        emitted[best] = true;
+        lastTriangle  = best;
+    }
+    if (ordered.size() > meshletStart)
+        flush();
+
+    // Leftover indices of an incomplete triangle are dropped, as they are never drawn
+    indices.swap(ordered);
+    return meshlets;
+}
+
+bool is_meshlet_visible(const Meshlet& meshlet, const Mat4& model, const Mat4& viewProj, const Vec3& cameraPosition, bool coneCulling) {
+    const Vec3 center = Vec3(model * Vec4(Vec3(meshlet.boundingSphere), 1.0f));
+    const Vec3 scales = Vec3(math::length(Vec3(model[0])), math::length(Vec3(model[1])), math::length(Vec3(model[2])));
+    const float radius = meshlet.boundingSphere.w * std::max(scales.x, std::max(scales.y, scales.z));
+
+    if (!is_sphere_on_frustum(viewProj, center, radius))
+        return false;
+    if (!coneCulling || !meshlet.has_cone())
+        return true;
+
+    // The axis only stays valid under rotations and uniform scale
+    const float minScale = std::min(scales.x, std::min(scales.y, scales.z));
+    const float maxScale = std::max(scales.x, std::max(scales.y, scales.z));
+    if (minScale < maxScale * 0.99f || math::determinant(Mat3(model)) <= 0.0f)
+        return true;
+
+    const Vec3  axis     = math::normalize(Mat3(model) * Vec3(meshlet.normalCone));
+    const Vec3  toCenter = center - cameraPosition;
+    const float distance = math::length(toCenter);
+    return math::dot(toCenter, axis) < meshlet.normalCone.w * distance + radius;
+}
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
@@ -5,6 +5,28 @@ namespace Core
 {
 int Camera::m_instanceCount = 0;
 
+Frustum extract_frustum(const Mat4& viewProj)
+{
+    // Gribb-Hartmann planes, normals pointing inwards
+    const Vec4 r0 = Vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    const Vec4 r1 = Vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    const Vec4 r2 = Vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    const Vec4 r3 = Vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    auto to_face = [](const Vec4& plane) {
+        const float length = math::length(Vec3(plane));
+        return Face(-plane.w / length, Vec3(plane));
+    };
+    Frustum frustum;
+    frustum.leftFace   = to_face(r3 + r0);
+    frustum.rightFace  = to_face(r3 - r0);
+    frustum.bottomFace = to_face(r3 + r1);
+    frustum.topFace    = to_face(r3 - r1);
+    frustum.nearFace   = to_face(r2);
+    frustum.farFace    = to_face(r3 - r2);
+    return frustum;
+}
+
 void Camera::set_frustum()
 {
     const float halfVSide = m_far * tanf(math::radians(m_fov) * .5f);
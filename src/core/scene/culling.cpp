@@ -0,0 +1,236 @@
+#include <engine/core/scene/culling.h>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#define CULLING_AVX2
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define CULLING_SSE2
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+#define CULLING_NEON
+#endif
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+namespace {
+struct Planes {
+    float nx[6], ny[6], nz[6], d[6];
+    float ax[6], ay[6], az[6]; // Absolute normal, projects the box extents
+};
+Planes get_planes( const Frustum& frustum ) {
+    const Face* faces[6] = { &frustum.nearFace, &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.farFace };
+    Planes      planes;
+    for ( int p = 0; p < 6; p++ )
+    {
+        planes.nx[p] = faces[p]->normal.x;
+        planes.ny[p] = faces[p]->normal.y;
+        planes.nz[p] = faces[p]->normal.z;
+        planes.d[p]  = faces[p]->distance;
+        planes.ax[p] = std::abs( faces[p]->normal.x );
+        planes.ay[p] = std::abs( faces[p]->normal.y );
+        planes.az[p] = std::abs( faces[p]->normal.z );
+    }
+    return planes;
+}
+
+// Visibility of the 64 objects starting at first, as bits. The SIMD kernels do the same operations in the same order, so they
+// only disagree with it where the compiler fuses multiply adds of the scalar code
+inline uint64_t cull_word_scalar( const CullingBounds& bounds, const Planes& planes, uint32_t first ) {
+    uint64_t word = 0;
+    for ( uint32_t lane = 0; lane < 64; lane++ )
+    {
+        const uint32_t i       = first + lane;
+        bool           visible = true;
+        for ( int p = 0; p < 6 && visible; p++ )
+        {
+            const float distance = planes.nx[p] * bounds.centerX[i] + planes.ny[p] * bounds.centerY[i] + planes.nz[p] * bounds.centerZ[i] - planes.d[p];
+            const float reach    = planes.ax[p] * bounds.extentX[i] + planes.ay[p] * bounds.extentY[i] + planes.az[p] * bounds.extentZ[i];
+            visible              = distance >= -bounds.radius[i] && distance + reach >= 0.0f;
+        }
+        word |= uint64_t( visible ) << lane;
+    }
+    return word;
+}
+
+#if defined( CULLING_AVX2 ) || defined( CULLING_SSE2 ) || defined( CULLING_NEON )
+#if defined( CULLING_AVX2 )
+#define CULLING_LANES 8
+typedef __m256 Lane;
+typedef __m256 LaneMask;
+inline Lane     lane_load( const float* p ) { return _mm256_loadu_ps( p ); }
+inline Lane     lane_set( float v ) { return _mm256_set1_ps( v ); }
+inline Lane     lane_add( Lane a, Lane b ) { return _mm256_add_ps( a, b ); }
+inline Lane     lane_sub( Lane a, Lane b ) { return _mm256_sub_ps( a, b ); }
+inline Lane     lane_mul( Lane a, Lane b ) { return _mm256_mul_ps( a, b ); }
+inline Lane     lane_neg( Lane a ) { return _mm256_sub_ps( _mm256_setzero_ps(), a ); }
+inline LaneMask lane_ge( Lane a, Lane b ) { return _mm256_cmp_ps( a, b, _CMP_GE_OQ ); }
+inline LaneMask lane_and( LaneMask a, LaneMask b ) { return _mm256_and_ps( a, b ); }
+inline uint32_t lane_bits( LaneMask m ) { return static_cast<uint32_t>( _mm256_movemask_ps( m ) ); }
+#elif defined( CULLING_SSE2 )
+#define CULLING_LANES 4
+typedef __m128 Lane;
+typedef __m128 LaneMask;
+inline Lane     lane_load( const float* p ) { return _mm_loadu_ps( p ); }
+inline Lane     lane_set( float v ) { return _mm_set1_ps( v ); }
+inline Lane     lane_add( Lane a, Lane b ) { return _mm_add_ps( a, b ); }
+inline Lane     lane_sub( Lane a, Lane b ) { return _mm_sub_ps( a, b ); }
+inline Lane     lane_mul( Lane a, Lane b ) { return _mm_mul_ps( a, b ); }
+inline Lane     lane_neg( Lane a ) { return _mm_sub_ps( _mm_setzero_ps(), a ); }
+inline LaneMask lane_ge( Lane a, Lane b ) { return _mm_cmpge_ps( a, b ); }
+inline LaneMask lane_and( LaneMask a, LaneMask b ) { return _mm_and_ps( a, b ); }
+inline uint32_t lane_bits( LaneMask m ) { return static_cast<uint32_t>( _mm_movemask_ps( m ) ); }
+#else
+#define CULLING_LANES 4
+typedef float32x4_t Lane;
+typedef uint32x4_t  LaneMask;
+inline Lane     lane_load( const float* p ) { return vld1q_f32( p ); }
+inline Lane     lane_set( float v ) { return vdupq_n_f32( v ); }
+inline Lane     lane_add( Lane a, Lane b ) { return vaddq_f32( a, b ); }
+inline Lane     lane_sub( Lane a, Lane b ) { return vsubq_f32( a, b ); }
+inline Lane     lane_mul( Lane a, Lane b ) { return vmulq_f32( a, b ); }
+inline Lane     lane_neg( Lane a ) { return vnegq_f32( a ); }
+inline LaneMask lane_ge( Lane a, Lane b ) { return vcgeq_f32( a, b ); }
+inline LaneMask lane_and( LaneMask a, LaneMask b ) { return vandq_u32( a, b ); }
+inline uint32_t lane_bits( LaneMask m ) {
+    const uint32_t weights[4] = { 1, 2, 4, 8 };
+    return vaddvq_u32( vandq_u32( m, vld1q_u32( weights ) ) );
+}
+#endif
+
+inline uint64_t cull_word_SIMD( const CullingBounds& bounds, const Planes& planes, uint32_t first ) {
+    // Plane terms are splat once per word
+    Lane nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+    for ( int p = 0; p < 6; p++ )
+    {
+        nx[p] = lane_set( planes.nx[p] );
+        ny[p] = lane_set( planes.ny[p] );
+        nz[p] = lane_set( planes.nz[p] );
+        d[p]  = lane_set( planes.d[p] );
+        ax[p] = lane_set( planes.ax[p] );
+        ay[p] = lane_set( planes.ay[p] );
+        az[p] = lane_set( planes.az[p] );
+    }
+    const Lane zero = lane_set( 0.0f );
+
+    uint64_t word = 0;
+    for ( uint32_t lane = 0; lane < 64; lane += CULLING_LANES )
+    {
+        const uint32_t i         = first + lane;
+        const Lane     cx        = lane_load( &bounds.centerX[i] );
+        const Lane     cy        = lane_load( &bounds.centerY[i] );
+        const Lane     cz        = lane_load( &bounds.centerZ[i] );
+        const Lane     ex        = lane_load( &bounds.extentX[i] );
+        const Lane     ey        = lane_load( &bounds.extentY[i] );
+        const Lane     ez        = lane_load( &bounds.extentZ[i] );
+        const Lane     negRadius = lane_neg( lane_load( &bounds.radius[i] ) );
+
+        LaneMask visible = lane_ge( zero, zero );
+        for ( int p = 0; p < 6; p++ )
+        {
+            const Lane distance = lane_sub( lane_add( lane_add( lane_mul( nx[p], cx ), lane_mul( ny[p], cy ) ), lane_mul( nz[p], cz ) ), d[p] );
+            const Lane reach    = lane_add( lane_add( lane_mul( ax[p], ex ), lane_mul( ay[p], ey ) ), lane_mul( az[p], ez ) );
+            visible             = lane_and( visible, lane_and( lane_ge( distance, negRadius ), lane_ge( lane_add( distance, reach ), zero ) ) );
+        }
+        word |= uint64_t( lane_bits( visible ) ) << lane;
+    }
+    return word;
+}
+#endif
+
+template <uint64_t ( *CullWord )( const CullingBounds&, const Planes&, uint32_t )>
+void cull( const CullingBounds& bounds, const Frustum& frustum, VisibilityMask& visibility ) {
+    PROFILING_EVENT()
+    const Planes planes = get_planes( frustum );
+    visibility.resize( bounds.count );
+    for ( size_t w = 0; w < visibility.words.size(); w++ )
+    {
+        // Words with nothing enabled are skipped
+        const uint64_t enabled = bounds.enabled.words[w];
+        if ( enabled )
+            visibility.words[w] = CullWord( bounds, planes, static_cast<uint32_t>( w * 64 ) ) & enabled;
+    }
+}
+} // namespace
+
+uint32_t VisibilityMask::count_visible() const {
+    uint32_t visible = 0;
+    for ( uint64_t word : words )
+    {
+        while ( word )
+        {
+            word &= word - 1;
+            visible++;
+        }
+    }
+    return visible;
+}
+void VisibilityMask::get_visible( std::vector<uint32_t>& indices ) const {
+    for ( size_t w = 0; w < words.size(); w++ )
+    {
+        uint64_t word = words[w];
+        for ( uint32_t bit = 0; word; bit++, word >>= 1 )
+        {
+            if ( word & 1u )
+                indices.push_back( static_cast<uint32_t>( w * 64 + bit ) );
+        }
+    }
+}
+
+void CullingBounds::resize( uint32_t n ) {
+    // Whole words, so the kernels never read past the arrays
+    const size_t padded = ( ( n + 63 ) / 64 ) * 64;
+    for ( std::vector<float>* array : { &centerX, &centerY, &centerZ, &radius, &extentX, &extentY, &extentZ } )
+        array->resize( padded, 0.0f );
+    enabled.count = n;
+    enabled.words.resize( padded / 64, 0 );
+    // Objects past the new count are not enabled anymore
+    if ( n % 64 )
+        enabled.words.back() &= ( uint64_t( 1 ) << ( n % 64 ) ) - 1;
+    count = n;
+}
+void CullingBounds::set( uint32_t i, const Mat4& model, const Vec3& minCoords, const Vec3& maxCoords ) {
+    const Vec3  center   = Vec3( model * Vec4( ( minCoords + maxCoords ) * 0.5f, 1.0f ) );
+    const Vec3  extent   = ( maxCoords - minCoords ) * 0.5f;
+    const Mat3  m        = Mat3( model );
+    const float maxScale = std::max( math::length( m[0] ), std::max( math::length( m[1] ), math::length( m[2] ) ) );
+
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    radius[i]  = math::length( extent ) * maxScale;
+    // Box of the transformed box
+    const Vec3 worldExtent = math::abs( m[0] ) * extent.x + math::abs( m[1] ) * extent.y + math::abs( m[2] ) * extent.z;
+    extentX[i]             = worldExtent.x;
+    extentY[i]             = worldExtent.y;
+    extentZ[i]             = worldExtent.z;
+    enabled.set_visible( i );
+}
+
+void cull_frustum( const CullingBounds& bounds, const Frustum& frustum, VisibilityMask& visibility ) {
+#if defined( CULLING_AVX2 ) || defined( CULLING_SSE2 ) || defined( CULLING_NEON )
+    cull<cull_word_SIMD>( bounds, frustum, visibility );
+#else
+    cull<cull_word_scalar>( bounds, frustum, visibility );
+#endif
+}
+void cull_frustum_scalar( const CullingBounds& bounds, const Frustum& frustum, VisibilityMask& visibility ) {
+    cull<cull_word_scalar>( bounds, frustum, visibility );
+}
+const char* get_culling_ISA() {
+#if defined( CULLING_AVX2 )
+    return "AVX2";
+#elif defined( CULLING_SSE2 )
+    return "SSE2";
+#elif defined( CULLING_NEON )
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
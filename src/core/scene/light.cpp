@@ -41,6 +41,84 @@ Light::GPUPayload DirectionalLight::get_uniforms(Mat4 cameraView) const {
         uniforms.dataSlot2 = {m_direction, m_shadow.raySamples};
     return uniforms;
 }
+ShadowCascades DirectionalLight::get_shadow_cascades(const Mat4& cameraView,
+                                                    const Mat4& cameraProj,
+                                                    float       cameraNear,
+                                                    float       cameraFar,
+                                                    const Vec3& sceneMin,
+                                                    const Vec3& sceneMax,
+                                                    uint32_t    resolution) const {
+    ShadowCascades cascades{};
+    cascades.count = m_cascades;
+
+    // Rays through the corners of the view in camera space. Depth 0.5 is inside the clip volume for any depth convention
+    const Mat4 invProj = math::inverse(cameraProj);
+    const Mat4 invView = math::inverse(cameraView);
+    Vec3       rays[4];
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        Vec4 corner = invProj * Vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, 0.5f, 1.0f);
+        rays[i]     = Vec3(corner) / corner.w;
+        rays[i] /= -rays[i].z; // One unit of view depth
+    }
+
+    // Rotation of the light view. Only the light direction sets it, so it does not change with the camera
+    const Vec3 toLight  = math::normalize(m_direction);
+    const Vec3 up       = std::abs(toLight.y) > 0.99f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(0.0f, 1.0f, 0.0f);
+    const Mat4 rotation = math::lookAt(Vec3(0.0f), -toLight, up);
+
+    const float nearPlane = cameraNear;
+    const float farPlane  = std::max(std::min(cameraFar, m_shadow.farPlane), nearPlane + 0.01f);
+    float       sliceNear = nearPlane;
+    for (uint32_t c = 0; c < m_cascades; c++)
+    {
+        // Blend of logarithmic and uniform splits
+        const float t          = float(c + 1) / float(m_cascades);
+        const float logSplit   = nearPlane * std::pow(farPlane / nearPlane, t);
+        const float uniSplit   = nearPlane + (farPlane - nearPlane) * t;
+        const float sliceFar   = m_cascadeLambda * logSplit + (1.0f - m_cascadeLambda) * uniSplit;
+        cascades.splits[c]     = sliceFar;
+
+        Vec3 corners[8];
+        Vec3 center = Vec3(0.0f);
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            corners[i]     = Vec3(invView * Vec4(rays[i] * sliceNear, 1.0f));
+            corners[i + 4] = Vec3(invView * Vec4(rays[i] * sliceFar, 1.0f));
+            center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+
+        // Bounding sphere, so the size does not change when the camera rotates. Quantized, so it does not flicker either
+        float radius = 0.0f;
+        for (const Vec3& corner : corners)
+            radius = std::max(radius, math::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        // Room for the snapping below, which moves the center up to a texel
+        const float halfExtent = radius * (1.0f + 4.0f / resolution);
+        const float texel      = 2.0f * halfExtent / resolution;
+
+        // Snap the center to the texel grid of the light view
+        Vec3 lightCenter = Vec3(rotation * Vec4(center, 1.0f));
+        lightCenter      = math::floor(lightCenter / texel) * texel;
+        center           = Vec3(math::inverse(rotation) * Vec4(lightCenter, 1.0f));
+
+        // Pull the view back to the furthest scene point towards the light, so casters outside the slice are not clipped
+        float behind = radius;
+        for (uint32_t i = 0; i < 8 && sceneMin.x <= sceneMax.x; i++)
+        {
+            const Vec3 corner = Vec3(i & 1 ? sceneMax.x : sceneMin.x, i & 2 ? sceneMax.y : sceneMin.y, i & 4 ? sceneMax.z : sceneMin.z);
+            behind            = std::max(behind, math::dot(corner - center, toLight));
+        }
+        behind = std::ceil(behind / (0.25f * radius)) * 0.25f * radius;
+
+        const Mat4 view       = math::lookAt(center + toLight * behind, center, up);
+        const Mat4 proj       = math::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, 0.0f, behind + radius);
+        cascades.viewProj[c]  = proj * view;
+        sliceNear             = sliceFar;
+    }
+    return cascades;
+}
 Vec3 DirectionalLight::get_sun_direction(float elevationDeg, float rotationDeg) {
     Vec3  sunDirection;
     float sunElevationRad = math::radians(elevationDeg);
@@ -1,4 +1,5 @@
 #include <engine/core/scene/mesh.h>
+#include <engine/core/scene/scene_BVH.h>
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 namespace Core {
@@ -43,9 +44,24 @@ bool BoundingSphere::is_on_frustrum(const Frustum& frustum) const
             frustum.topFace.get_signed_distance(globalCenter) >= -globalRadius && frustum.bottomFace.get_signed_distance(globalCenter) >= -globalRadius);
 }
 void AABB::setup(Mesh* const mesh) {
+    const GeometricData& stats = mesh->get_geometry()->get_properties();
+    minCoords                  = stats.minCoords;
+    maxCoords                  = stats.maxCoords;
+    center                     = (maxCoords + minCoords) * 0.5f;
 }
 bool AABB::is_on_frustrum(const Frustum& frustum) const {
-    return false;
+    Vec3 worldMin, worldMax;
+    transform_bounds(obj->get_model_matrix(), minCoords, maxCoords, worldMin, worldMax);
+
+    // Outside if the corner furthest along the normal of any face is behind it
+    const Face* faces[6] = {&frustum.leftFace, &frustum.rightFace, &frustum.farFace, &frustum.nearFace, &frustum.topFace, &frustum.bottomFace};
+    for (const Face* face : faces)
+    {
+        const Vec3 corner = math::mix(worldMin, worldMax, math::greaterThanEqual(face->normal, Vec3(0.0f)));
+        if (face->get_signed_distance(corner) < 0.0f)
+            return false;
+    }
+    return true;
 }
 
 IMaterial* Mesh::change_material(IMaterial* m, size_t id) {
@@ -3,6 +3,60 @@
 void VKFW::Core::set_meshes(Scene* const scene, std::vector<Mesh*> meshes) {
     scene->m_meshes = meshes;
 }
+void VKFW::Core::Scene::update_culling_data() {
+    PROFILING_EVENT()
+    m_BVHStamp++;
+    m_cullingBounds.resize(static_cast<uint32_t>(m_meshes.size()));
+    Vec3 sceneMin = Vec3(INFINITY);
+    Vec3 sceneMax = Vec3(-INFINITY);
+    for (size_t i = 0; i < m_meshes.size(); i++)
+    {
+        // Geometries without vertices have no bounds
+        Mesh* m = m_meshes[i];
+        if (!m || !m->is_active() || !m->get_geometry() || m->get_geometry()->get_properties().minCoords.x > m->get_geometry()->get_properties().maxCoords.x)
+        {
+            m_cullingBounds.disable(static_cast<uint32_t>(i));
+            continue;
+        }
+
+        Vec3                 worldMin, worldMax;
+        const GeometricData& props = m->get_geometry()->get_properties();
+        const Mat4           model = m->get_model_matrix();
+        transform_bounds(model, props.minCoords, props.maxCoords, worldMin, worldMax);
+        m_cullingBounds.set(static_cast<uint32_t>(i), model, props.minCoords, props.maxCoords);
+        sceneMin = math::min(sceneMin, worldMin);
+        sceneMax = math::max(sceneMax, worldMax);
+
+        auto it = m_BVHProxies.find(m);
+        if (it == m_BVHProxies.end())
+        {
+            m_BVHProxies[m] = {m_BVH.insert(m, static_cast<uint32_t>(i), worldMin, worldMax), m_BVHStamp};
+            continue;
+        }
+        m_BVH.move(it->second.id, worldMin, worldMax);
+        m_BVH.set_index(it->second.id, static_cast<uint32_t>(i));
+        it->second.stamp = m_BVHStamp;
+    }
+    // Disabled or removed meshes leave the tree
+    for (auto it = m_BVHProxies.begin(); it != m_BVHProxies.end();)
+    {
+        if (it->second.stamp != m_BVHStamp)
+        {
+            m_BVH.remove(it->second.id);
+            it = m_BVHProxies.erase(it);
+        } else
+            ++it;
+    }
+
+    // The scene volume comes for free from the same pass
+    if (sceneMin.x <= sceneMax.x)
+        fit_volume(sceneMin, sceneMax);
+
+    if (m_activeCamera && m_activeCamera->get_frustrum_culling())
+        cull_frustum(m_cullingBounds, m_activeCamera->get_frustrum(), m_cameraVisibility);
+    else
+        m_cameraVisibility = m_cullingBounds.enabled;
+}
 VKFW::Graphics::TLAS* VKFW::Core::get_TLAS(Scene* const scene) {
     return &scene->m_accel;
 }
@@ -39,6 +93,9 @@ void VKFW::Core::Scene::update_AABB() {
             m_volume.minCoords.z = minCoords.z;
     }
 
+    fit_volume(m_volume.minCoords, m_volume.maxCoords);
+}
+void VKFW::Core::Scene::fit_volume(const Vec3& minCoords, const Vec3& maxCoords) {
     // Make a cube container for voxelization
     // float maxTerm      = std::max(std::max(m_volume.maxCoords.r, m_volume.maxCoords.g), m_volume.maxCoords.b);
     // float minTerm      = std::min(std::min(m_volume.minCoords.r, m_volume.minCoords.g), m_volume.minCoords.b);
@@ -46,8 +103,8 @@ void VKFW::Core::Scene::update_AABB() {
     // m_volume.minCoords = Vec3(minTerm);
 
     // Step 1: Compute bounding box center and extent
-    Vec3 center = (m_volume.maxCoords + m_volume.minCoords) * 0.5f;
-    Vec3 extent = (m_volume.maxCoords - m_volume.minCoords) * 0.5f;
+    Vec3 center = (maxCoords + minCoords) * 0.5f;
+    Vec3 extent = (maxCoords - minCoords) * 0.5f;
 
     // Step 2: Compute the largest extent (to make it a cube)
     float halfSize = std::max({extent.x, extent.y, extent.z});
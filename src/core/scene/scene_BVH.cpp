@@ -0,0 +1,392 @@
+#include <engine/core/scene/scene_BVH.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+namespace {
+inline float surface_area( const Vec3& minCoords, const Vec3& maxCoords ) {
+    const Vec3 d = maxCoords - minCoords;
+    return 2.0f * ( d.x * d.y + d.y * d.z + d.z * d.x );
+}
+inline bool contains( const SceneBVH::Node& node, const Vec3& minCoords, const Vec3& maxCoords ) {
+    return math::all( math::lessThanEqual( node.minCoords, minCoords ) ) && math::all( math::greaterThanEqual( node.maxCoords, maxCoords ) );
+}
+inline bool overlaps_sphere( const SceneBVH::Node& node, const Vec3& center, float radius ) {
+    const Vec3 closest = math::clamp( center, node.minCoords, node.maxCoords );
+    const Vec3 d       = closest - center;
+    return math::dot( d, d ) <= radius * radius;
+}
+
+enum class PlaneTest
+{
+    OUTSIDE,
+    INTERSECTS,
+    INSIDE
+};
+inline PlaneTest test_plane( const Face& face, const Vec3& minCoords, const Vec3& maxCoords ) {
+    // Corners furthest along and against the normal
+    const Vec3 positive = math::mix( minCoords, maxCoords, math::greaterThanEqual( face.normal, Vec3( 0.0f ) ) );
+    const Vec3 negative = math::mix( maxCoords, minCoords, math::greaterThanEqual( face.normal, Vec3( 0.0f ) ) );
+    if ( face.get_signed_distance( positive ) < 0.0f )
+        return PlaneTest::OUTSIDE;
+    return face.get_signed_distance( negative ) >= 0.0f ? PlaneTest::INSIDE : PlaneTest::INTERSECTS;
+}
+inline const Face& get_face( const Frustum& frustum, uint32_t i ) {
+    const Face* faces[6] = { &frustum.nearFace, &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.farFace };
+    return *faces[i];
+}
+// Clears the bits of the planes the box is fully inside of. Returns false if it is outside any of them
+inline bool test_frustum( const Frustum& frustum, const Vec3& minCoords, const Vec3& maxCoords, uint32_t& planeMask ) {
+    for ( uint32_t i = 0; i < 6; i++ )
+    {
+        if ( !( planeMask & ( 1u << i ) ) )
+            continue;
+        PlaneTest test = test_plane( get_face( frustum, i ), minCoords, maxCoords );
+        if ( test == PlaneTest::OUTSIDE )
+            return false;
+        if ( test == PlaneTest::INSIDE )
+            planeMask &= ~( 1u << i );
+    }
+    return true;
+}
+#define ALL_PLANES 0x3Fu
+} // namespace
+
+void transform_bounds( const Mat4& model, const Vec3& minCoords, const Vec3& maxCoords, Vec3& worldMin, Vec3& worldMax ) {
+    const Vec3 center      = Vec3( model * Vec4( ( minCoords + maxCoords ) * 0.5f, 1.0f ) );
+    const Vec3 extent      = ( maxCoords - minCoords ) * 0.5f;
+    const Mat3 m           = Mat3( model );
+    const Vec3 worldExtent = math::abs( m[0] ) * extent.x + math::abs( m[1] ) * extent.y + math::abs( m[2] ) * extent.z;
+    worldMin               = center - worldExtent;
+    worldMax               = center + worldExtent;
+}
+
+int32_t SceneBVH::allocate_node() {
+    if ( m_freeList == NULL_NODE )
+    {
+        m_nodes.emplace_back();
+        return static_cast<int32_t>( m_nodes.size() - 1 );
+    }
+    int32_t node  = m_freeList;
+    m_freeList    = m_nodes[node].parent;
+    m_nodes[node] = Node();
+    return node;
+}
+void SceneBVH::free_node( int32_t node ) {
+    m_nodes[node].parent = m_freeList;
+    m_nodes[node].height = -1;
+    m_nodes[node].mesh   = nullptr;
+    m_freeList           = node;
+}
+
+int32_t SceneBVH::insert( Mesh* mesh, uint32_t index, const Vec3& minCoords, const Vec3& maxCoords ) {
+    const int32_t leaf = allocate_node();
+    const Vec3    fat  = ( maxCoords - minCoords ) * m_margin + Vec3( 1e-4f );
+    Node&         node = m_nodes[leaf];
+    node.minCoords     = minCoords - fat;
+    node.maxCoords     = maxCoords + fat;
+    node.mesh          = mesh;
+    node.index         = index;
+    node.height        = 0;
+    insert_leaf( leaf );
+    m_leafCount++;
+    return leaf;
+}
+void SceneBVH::remove( int32_t proxy ) {
+    remove_leaf( proxy );
+    free_node( proxy );
+    m_leafCount--;
+}
+bool SceneBVH::move( int32_t proxy, const Vec3& minCoords, const Vec3& maxCoords ) {
+    if ( contains( m_nodes[proxy], minCoords, maxCoords ) )
+    {
+        // Shrunk objects are refitted too, so a leaf never stays much larger than what it holds
+        const Vec3 fat = ( maxCoords - minCoords ) * m_margin + Vec3( 1e-4f );
+        if ( surface_area( m_nodes[proxy].minCoords, m_nodes[proxy].maxCoords ) <= 4.0f * surface_area( minCoords - fat, maxCoords + fat ) )
+            return false;
+    }
+    remove_leaf( proxy );
+    const Vec3 fat           = ( maxCoords - minCoords ) * m_margin + Vec3( 1e-4f );
+    m_nodes[proxy].minCoords = minCoords - fat;
+    m_nodes[proxy].maxCoords = maxCoords + fat;
+    insert_leaf( proxy );
+    return true;
+}
+void SceneBVH::clear() {
+    m_nodes.clear();
+    m_root      = NULL_NODE;
+    m_freeList  = NULL_NODE;
+    m_leafCount = 0;
+}
+
+void SceneBVH::insert_leaf( int32_t leaf ) {
+    if ( m_root == NULL_NODE )
+    {
+        m_root               = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend to the sibling that grows the total surface area the least
+    const Vec3 leafMin = m_nodes[leaf].minCoords;
+    const Vec3 leafMax = m_nodes[leaf].maxCoords;
+    int32_t    sibling = m_root;
+    while ( !m_nodes[sibling].is_leaf() )
+    {
+        const Node& node     = m_nodes[sibling];
+        const float area     = surface_area( node.minCoords, node.maxCoords );
+        const float combined = surface_area( math::min( node.minCoords, leafMin ), math::max( node.maxCoords, leafMax ) );
+        // Pairing here creates a parent of the combined area, and every ancestor grows by it
+        const float cost        = 2.0f * combined;
+        const float inheritance = 2.0f * ( combined - area );
+
+        auto child_cost = [&]( int32_t c ) {
+            const Node& child = m_nodes[c];
+            const float grown = surface_area( math::min( child.minCoords, leafMin ), math::max( child.maxCoords, leafMax ) );
+            return child.is_leaf() ? grown + inheritance : grown - surface_area( child.minCoords, child.maxCoords ) + inheritance;
+        };
+        const float leftCost  = child_cost( node.left );
+        const float rightCost = child_cost( node.right );
+        if ( cost < leftCost && cost < rightCost )
+            break;
+        sibling = leftCost < rightCost ? node.left : node.right;
+    }
+
+    const int32_t oldParent = m_nodes[sibling].parent;
+    const int32_t newParent = allocate_node();
+    Node&         parent    = m_nodes[newParent];
+    parent.parent           = oldParent;
+    parent.minCoords        = math::min( leafMin, m_nodes[sibling].minCoords );
+    parent.maxCoords        = math::max( leafMax, m_nodes[sibling].maxCoords );
+    parent.height           = m_nodes[sibling].height + 1;
+    parent.left             = sibling;
+    parent.right            = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent    = newParent;
+    if ( oldParent == NULL_NODE )
+        m_root = newParent;
+    else if ( m_nodes[oldParent].left == sibling )
+        m_nodes[oldParent].left = newParent;
+    else
+        m_nodes[oldParent].right = newParent;
+
+    fit( m_nodes[leaf].parent );
+}
+void SceneBVH::remove_leaf( int32_t leaf ) {
+    if ( leaf == m_root )
+    {
+        m_root = NULL_NODE;
+        return;
+    }
+    const int32_t parent      = m_nodes[leaf].parent;
+    const int32_t grandParent = m_nodes[parent].parent;
+    const int32_t sibling     = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+    // The sibling takes the place of the parent
+    m_nodes[sibling].parent = grandParent;
+    free_node( parent );
+    if ( grandParent == NULL_NODE )
+    {
+        m_root = sibling;
+        return;
+    }
+    if ( m_nodes[grandParent].left == parent )
+        m_nodes[grandParent].left = sibling;
+    else
+        m_nodes[grandParent].right = sibling;
+    fit( grandParent );
+}
+void SceneBVH::fit( int32_t node ) {
+    // Walk back to the root balancing and refitting
+    while ( node != NULL_NODE )
+    {
+        node        = balance( node );
+        Node& n     = m_nodes[node];
+        n.height    = 1 + std::max( m_nodes[n.left].height, m_nodes[n.right].height );
+        n.minCoords = math::min( m_nodes[n.left].minCoords, m_nodes[n.right].minCoords );
+        n.maxCoords = math::max( m_nodes[n.left].maxCoords, m_nodes[n.right].maxCoords );
+        node        = n.parent;
+    }
+}
+int32_t SceneBVH::balance( int32_t a ) {
+    // Rotates the taller child up when the children heights differ by more than one. Returns the new root of the subtree
+    if ( m_nodes[a].is_leaf() || m_nodes[a].height < 2 )
+        return a;
+    const int32_t b       = m_nodes[a].left;
+    const int32_t c       = m_nodes[a].right;
+    const int32_t balance = m_nodes[c].height - m_nodes[b].height;
+    if ( balance >= -1 && balance <= 1 )
+        return a;
+
+    // Up is the taller child, down the other one
+    const int32_t up   = balance > 1 ? c : b;
+    const int32_t down = balance > 1 ? b : c;
+    const int32_t f    = m_nodes[up].left;
+    const int32_t g    = m_nodes[up].right;
+
+    // Up takes the place of a
+    m_nodes[up].left   = a;
+    m_nodes[up].parent = m_nodes[a].parent;
+    m_nodes[a].parent  = up;
+    if ( m_nodes[up].parent == NULL_NODE )
+        m_root = up;
+    else if ( m_nodes[m_nodes[up].parent].left == a )
+        m_nodes[m_nodes[up].parent].left = up;
+    else
+        m_nodes[m_nodes[up].parent].right = up;
+
+    // The taller grandchild stays under up, the other one goes under a next to down
+    const bool    keepF = m_nodes[f].height > m_nodes[g].height;
+    const int32_t keep  = keepF ? f : g;
+    const int32_t moved = keepF ? g : f;
+    m_nodes[up].right     = keep;
+    m_nodes[keep].parent  = up;
+    m_nodes[a].left       = down;
+    m_nodes[a].right      = moved;
+    m_nodes[moved].parent = a;
+
+    Node& na     = m_nodes[a];
+    na.minCoords = math::min( m_nodes[down].minCoords, m_nodes[moved].minCoords );
+    na.maxCoords = math::max( m_nodes[down].maxCoords, m_nodes[moved].maxCoords );
+    na.height    = 1 + std::max( m_nodes[down].height, m_nodes[moved].height );
+    return up;
+}
+
+void SceneBVH::query_frustum( const Frustum& frustum, std::vector<uint32_t>& results ) const {
+    PROFILING_EVENT()
+    results.clear();
+    if ( m_root == NULL_NODE )
+        return;
+
+    // Subtrees fully inside the frustum are gathered without further tests
+    std::vector<std::pair<int32_t, uint32_t>> stack;
+    stack.reserve( 64 );
+    stack.push_back( { m_root, ALL_PLANES } );
+    while ( !stack.empty() )
+    {
+        auto [n, planeMask] = stack.back();
+        stack.pop_back();
+        const Node& node = m_nodes[n];
+        if ( planeMask && !test_frustum( frustum, node.minCoords, node.maxCoords, planeMask ) )
+            continue;
+        if ( node.is_leaf() )
+            results.push_back( node.index );
+        else
+        {
+            stack.push_back( { node.left, planeMask } );
+            stack.push_back( { node.right, planeMask } );
+        }
+    }
+}
+void SceneBVH::query_frustums( const Frustum* frustums, uint32_t count, std::vector<std::pair<uint32_t, uint32_t>>& results ) const {
+    PROFILING_EVENT()
+    results.clear();
+    if ( m_root == NULL_NODE || count == 0 )
+        return;
+    count = std::min( count, MAX_VIEWS );
+
+    // Per node, the views it may be seen from and the ones it is fully inside of
+    struct Entry {
+        int32_t  node;
+        uint32_t views;
+        uint32_t inside;
+    };
+    std::vector<Entry> stack;
+    stack.reserve( 64 );
+    stack.push_back( { m_root, count == 32 ? 0xFFFFFFFFu : ( 1u << count ) - 1u, 0u } );
+    while ( !stack.empty() )
+    {
+        Entry e = stack.back();
+        stack.pop_back();
+        const Node& node = m_nodes[e.node];
+        for ( uint32_t v = 0; v < count; v++ )
+        {
+            const uint32_t bit = 1u << v;
+            if ( !( e.views & bit ) || ( e.inside & bit ) )
+                continue;
+            uint32_t planeMask = ALL_PLANES;
+            if ( !test_frustum( frustums[v], node.minCoords, node.maxCoords, planeMask ) )
+                e.views &= ~bit;
+            else if ( planeMask == 0 )
+                e.inside |= bit;
+        }
+        if ( !e.views )
+            continue;
+        if ( node.is_leaf() )
+            results.push_back( { node.index, e.views } );
+        else
+        {
+            stack.push_back( { node.left, e.views, e.inside } );
+            stack.push_back( { node.right, e.views, e.inside } );
+        }
+    }
+}
+void SceneBVH::query_sphere( const Vec3& center, float radius, std::vector<uint32_t>& results ) const {
+    results.clear();
+    if ( m_root == NULL_NODE )
+        return;
+    std::vector<int32_t> stack;
+    stack.reserve( 64 );
+    stack.push_back( m_root );
+    while ( !stack.empty() )
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if ( !overlaps_sphere( node, center, radius ) )
+            continue;
+        if ( node.is_leaf() )
+            results.push_back( node.index );
+        else
+        {
+            stack.push_back( node.left );
+            stack.push_back( node.right );
+        }
+    }
+}
+void SceneBVH::query_ray( const Vec3& origin, const Vec3& direction, float maxDistance, std::vector<RayHit>& results ) const {
+    results.clear();
+    if ( m_root == NULL_NODE )
+        return;
+    const Vec3 invDirection = 1.0f / direction; // Infinite on axis parallel rays, which the slab test handles
+
+    auto entry_distance = [&]( const Node& node, float& distance ) {
+        const Vec3 t0   = ( node.minCoords - origin ) * invDirection;
+        const Vec3 t1   = ( node.maxCoords - origin ) * invDirection;
+        const Vec3 near = math::min( t0, t1 );
+        const Vec3 far  = math::max( t0, t1 );
+        // NaNs come from an origin on a slab plane of a parallel ray. Treated as inside that slab
+        const float tNear =
+            std::max( { 0.0f, std::isnan( near.x ) ? 0.0f : near.x, std::isnan( near.y ) ? 0.0f : near.y, std::isnan( near.z ) ? 0.0f : near.z } );
+        const float tFar = std::min( { maxDistance,
+                                       std::isnan( far.x ) ? maxDistance : far.x,
+                                       std::isnan( far.y ) ? maxDistance : far.y,
+                                       std::isnan( far.z ) ? maxDistance : far.z } );
+        distance         = tNear;
+        return tNear <= tFar;
+    };
+
+    std::vector<int32_t> stack;
+    stack.reserve( 64 );
+    stack.push_back( m_root );
+    while ( !stack.empty() )
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        float distance;
+        if ( !entry_distance( node, distance ) )
+            continue;
+        if ( node.is_leaf() )
+            results.push_back( { node.index, distance } );
+        else
+        {
+            stack.push_back( node.left );
+            stack.push_back( node.right );
+        }
+    }
+    std::sort( results.begin(), results.end(), []( const RayHit& a, const RayHit& b ) { return a.distance < b.distance; } );
+}
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
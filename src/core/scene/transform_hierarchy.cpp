@@ -0,0 +1,140 @@
+#include <engine/core/scene/object3D.h>
+#include <engine/utils.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Core {
+
+void TransformHierarchy::rebuild() {
+    PROFILING_EVENT()
+    for ( Object3D* obj : m_objects )
+        obj->m_hierarchy = nullptr;
+    m_objects.clear();
+    m_parents.clear();
+    m_subtreeEnds.clear();
+    m_subtrees.clear();
+    m_topologyDirty = false;
+    if ( !m_root )
+    {
+        m_local.clear();
+        m_world.clear();
+        m_flags.clear();
+        return;
+    }
+
+    // Depth first, so every subtree ends up contiguous
+    std::vector<std::pair<Object3D*, int32_t>> stack = { { m_root, -1 } };
+    while ( !stack.empty() )
+    {
+        auto [obj, parent] = stack.back();
+        stack.pop_back();
+        if ( obj->m_hierarchy == this ) // Reachable twice, keep the first parent
+            continue;
+        const uint32_t slot  = static_cast<uint32_t>( m_objects.size() );
+        obj->m_hierarchy     = this;
+        obj->m_hierarchySlot = slot;
+        m_objects.push_back( obj );
+        m_parents.push_back( parent );
+        m_subtreeEnds.push_back( 0 );
+        // Reversed, so children keep their order
+        for ( auto it = obj->m_children.rbegin(); it != obj->m_children.rend(); ++it )
+            stack.push_back( { *it, static_cast<int32_t>( slot ) } );
+    }
+    // Parents come before their children, so walking backwards every subtree end is known before its parent needs it
+    const uint32_t count = static_cast<uint32_t>( m_objects.size() );
+    for ( uint32_t slot = count; slot-- > 0; )
+    {
+        m_subtreeEnds[slot] = std::max( m_subtreeEnds[slot], slot + 1 );
+        if ( m_parents[slot] >= 0 )
+            m_subtreeEnds[m_parents[slot]] = std::max( m_subtreeEnds[m_parents[slot]], m_subtreeEnds[slot] );
+    }
+    for ( uint32_t slot = 1; slot < count; slot = m_subtreeEnds[slot] )
+    {
+        // Small subtrees are merged with the previous ones, so jobs are sized by transforms rather than by subtrees
+        if ( m_subtrees.empty() || m_subtrees.back().second - m_subtrees.back().first >= ENGINE_MIN_TRANSFORMS_PER_JOB )
+            m_subtrees.push_back( { slot, m_subtreeEnds[slot] } );
+        else
+            m_subtrees.back().second = m_subtreeEnds[slot];
+    }
+
+    m_local.assign( count, Mat4( 1.0f ) );
+    m_world.assign( count, Mat4( 1.0f ) );
+    m_flags.assign( count, LOCAL_DIRTY );
+    m_dirty = true;
+}
+
+void TransformHierarchy::mark_dirty( const Object3D* object ) {
+    // Every slot is flagged when rebuilt
+    if ( m_topologyDirty || object->m_hierarchy != this )
+        return;
+    const uint32_t slot = object->m_hierarchySlot;
+    m_flags[slot] |= LOCAL_DIRTY;
+    // Descendants keep their own local flag
+    for ( uint32_t i = slot + 1; i < m_subtreeEnds[slot]; i++ )
+        m_flags[i] |= WORLD_DIRTY;
+    m_dirty = true;
+}
+
+const Mat4& TransformHierarchy::resolve( const Object3D* object ) {
+    if ( m_topologyDirty )
+        rebuild();
+    return resolve_slot( object->m_hierarchySlot );
+}
+const Mat4& TransformHierarchy::resolve_slot( uint32_t slot ) {
+    const uint8_t flags = m_flags[slot];
+    if ( !flags )
+        return m_world[slot];
+    if ( flags & LOCAL_DIRTY )
+    {
+        Object3D* obj                = m_objects[slot];
+        m_local[slot]                = obj->compute_local_matrix();
+        obj->m_transform.worldMatrix = m_local[slot];
+        obj->m_localDirty            = false;
+    }
+    m_world[slot] = m_parents[slot] >= 0 ? resolve_slot( m_parents[slot] ) * m_local[slot] : m_local[slot];
+    m_flags[slot] = 0;
+    return m_world[slot];
+}
+
+void TransformHierarchy::update_range( uint32_t begin, uint32_t end ) {
+    for ( uint32_t slot = begin; slot < end; slot++ )
+    {
+        const uint8_t flags = m_flags[slot];
+        if ( !flags )
+            continue;
+        if ( flags & LOCAL_DIRTY )
+        {
+            Object3D* obj                = m_objects[slot];
+            m_local[slot]                = obj->compute_local_matrix();
+            obj->m_transform.worldMatrix = m_local[slot];
+            obj->m_localDirty            = false;
+        }
+        // The parent was already updated in this pass
+        m_world[slot] = m_parents[slot] >= 0 ? m_world[m_parents[slot]] * m_local[slot] : m_local[slot];
+        m_flags[slot] = 0;
+    }
+}
+
+void TransformHierarchy::update( Utils::JobSystem* jobSystem ) {
+    PROFILING_EVENT()
+    if ( m_topologyDirty )
+        rebuild();
+    if ( !m_dirty || m_objects.empty() )
+        return;
+    m_dirty = false;
+
+    update_range( 0, 1 );
+    if ( !jobSystem || m_subtrees.size() < 2 )
+    {
+        update_range( 1, static_cast<uint32_t>( m_objects.size() ) );
+        return;
+    }
+    // Subtrees of the root only read the root matrix, and it is already up to date. Ranges already hold enough transforms each
+    jobSystem->parallel_for( m_subtrees.size(), 1, [&]( size_t begin, size_t end, size_t worker ) {
+        update_range( m_subtrees[begin].first, m_subtrees[end - 1].second );
+    } );
+}
+
+} // namespace Core
+
+VULKAN_ENGINE_NAMESPACE_END
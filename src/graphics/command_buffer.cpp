@@ -9,6 +9,7 @@ CommandBuffer CommandPool::allocate_command_buffer(uint32_t count, CommandBuffer
     cmd.device                               = device;
     cmd.pool                                 = handle;
     cmd.queue                                = queue;
+    cmd.state                                = std::make_shared<CommandState>();
     VkCommandBufferAllocateInfo cmdAllocInfo = Init::command_buffer_allocate_info(handle, 1, Translator::get(level));
     VK_CHECK(vkAllocateCommandBuffers(device, &cmdAllocInfo, &cmd.handle));
     return cmd;
@@ -49,6 +50,34 @@ void CommandBuffer::begin(VkCommandBufferUsageFlags flags) {
         throw VKFW_Exception("Failed to begin recording command buffer!");
     }
     isRecording = true;
+    if (state)
+        *state = {};
+}
+
+void CommandBuffer::begin_secondary(RenderPass& renderpass, Framebuffer& fbo, uint32_t subpass) {
+    if (isRecording)
+    {
+        throw VKFW_Exception("Command buffer is already recording!");
+    }
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass                     = renderpass.handle;
+    inheritanceInfo.subpass                        = subpass;
+    inheritanceInfo.framebuffer                    = fbo.handle;
+
+    VkCommandBufferBeginInfo beginInfo =
+        Init::command_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(handle, &beginInfo) != VK_SUCCESS)
+    {
+        throw VKFW_Exception("Failed to begin recording secondary command buffer!");
+    }
+    isRecording = true;
+    // Nothing is inherited from the primary
+    if (state)
+        *state = {};
 }
 
 void CommandBuffer::end() {
@@ -136,14 +165,27 @@ void CommandBuffer::end_renderpass(RenderPass& renderpass, Framebuffer& fbo) {
     }
     vkCmdEndRenderPass(handle);
 }
+void CommandBuffer::execute_commands(const std::vector<CommandBuffer>& secondaryBuffers) {
+    if (secondaryBuffers.empty())
+        return;
+    std::vector<VkCommandBuffer> handles;
+    handles.reserve(secondaryBuffers.size());
+    for (const CommandBuffer& secondary : secondaryBuffers)
+        handles.push_back(secondary.handle);
+    vkCmdExecuteCommands(handle, static_cast<uint32_t>(handles.size()), handles.data());
+    // State of the primary is undefined after executing secondaries
+    if (state)
+        state->forget();
+}
 void CommandBuffer::draw_geometry(const VertexArrays& vao, uint32_t instanceCount, uint32_t firstOcurrence, int32_t offset, uint32_t firstInstance) {
     if (!vao.loadedOnGPU)
         return;
     PROFILING_EVENT()
 
-    VkBuffer     vertexBuffers[] = {vao.vbo.handle};
-    VkDeviceSize offsets[]       = {0};
-    vkCmdBindVertexBuffers(handle, 0, 1, vertexBuffers, offsets);
+    // Position only pipelines just ignore the attribute stream
+    VkBuffer     vertexBuffers[] = {vao.vbo.handle, vao.attributeBuffer.handle};
+    VkDeviceSize offsets[]       = {0, 0};
+    vkCmdBindVertexBuffers(handle, 0, vao.layout == PACKED_VERTEX_LAYOUT ? 2 : 1, vertexBuffers, offsets);
 
     if (vao.indexCount > 0)
     {
@@ -154,11 +196,48 @@ void CommandBuffer::draw_geometry(const VertexArrays& vao, uint32_t instanceCoun
         vkCmdDraw(handle, vao.vertexCount, instanceCount, firstOcurrence, firstInstance);
     }
 }
+void CommandBuffer::draw_geometry_indirect(
+    const VertexArrays& vao, Buffer& commands, size_t commandOffset, Buffer& countBuffer, size_t countOffset, uint32_t maxDraws) {
+    if (!vao.loadedOnGPU || maxDraws == 0)
+        return;
+    PROFILING_EVENT()
+
+    // Position only pipelines just ignore the attribute stream
+    VkBuffer     vertexBuffers[] = {vao.vbo.handle, vao.attributeBuffer.handle};
+    VkDeviceSize offsets[]       = {0, 0};
+    vkCmdBindVertexBuffers(handle, 0, vao.layout == PACKED_VERTEX_LAYOUT ? 2 : 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(handle, vao.ibo.handle, 0, VK_INDEX_TYPE_UINT32);
+
+    vkCmdDrawIndexedIndirectCount(
+        handle, commands.handle, commandOffset, countBuffer.handle, countOffset, maxDraws, sizeof(VkDrawIndexedIndirectCommand));
+}
 void CommandBuffer::draw_gui_data() {
     if (ImGui::GetDrawData())
         ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), handle);
+    // The backend binds its own pipeline and state
+    if (state)
+        state->forget();
+}
+namespace {
+inline uint32_t get_bind_point_index(BindingType binding) {
+    return binding == BINDING_TYPE_GRAPHIC ? 0u : binding == BINDING_TYPE_COMPUTE ? 1u : 2u;
 }
-void CommandBuffer::bind_shaderpass(ShaderPass& pass) {
+} // namespace
+
+void CommandBuffer::bind_shaderpass(const ShaderPass& pass) {
+    if (state)
+    {
+        const uint32_t point = pass.QUEUE_TYPE == GRAPHIC_QUEUE ? 0u : pass.QUEUE_TYPE == COMPUTE_QUEUE ? 1u : 2u;
+        if (state->pipelines[point] == pass.pipeline)
+        {
+            state->skippedBinds++;
+            return;
+        }
+        state->pipelines[point] = pass.pipeline;
+        // State the new pipeline does not declare dynamic is overridden by it
+        if (point == 0)
+            state->forget_dynamic_state();
+    }
     switch (pass.QUEUE_TYPE)
     {
     case GRAPHIC_QUEUE:
@@ -174,9 +253,37 @@ void CommandBuffer::bind_shaderpass(ShaderPass& pass) {
         break;
     }
 }
-void CommandBuffer::bind_descriptor_set(DescriptorSet descriptor, uint32_t ocurrence, ShaderPass& pass, std::vector<uint32_t> offsets, BindingType binding) {
+void CommandBuffer::bind_descriptor_set(VkDescriptorSet   descriptor,
+                                        uint32_t          ocurrence,
+                                        const ShaderPass& pass,
+                                        const uint32_t*   offsets,
+                                        uint32_t          offsetCount,
+                                        BindingType       binding) {
+    if (state)
+    {
+        CommandState::BoundSet* sets    = state->sets[get_bind_point_index(binding)];
+        const bool              tracked = ocurrence < CommandState::MAX_BOUND_SETS && offsetCount <= CommandState::MAX_BOUND_OFFSETS;
+        if (tracked && sets[ocurrence].handle == descriptor && sets[ocurrence].layout == pass.pipelineLayout &&
+            sets[ocurrence].offsetCount == offsetCount && std::equal(offsets, offsets + offsetCount, sets[ocurrence].offsets))
+        {
+            state->skippedBinds++;
+            return;
+        }
+        // Sets bound with another layout may be disturbed by this bind
+        for (uint32_t set = 0; set < CommandState::MAX_BOUND_SETS; set++)
+        {
+            if (sets[set].layout != pass.pipelineLayout)
+                sets[set] = {};
+        }
+        if (tracked)
+        {
+            sets[ocurrence] = {descriptor, pass.pipelineLayout, offsetCount};
+            std::copy(offsets, offsets + offsetCount, sets[ocurrence].offsets);
+        } else if (ocurrence < CommandState::MAX_BOUND_SETS)
+            sets[ocurrence] = {};
+    }
     vkCmdBindDescriptorSets(
-        handle, static_cast<VkPipelineBindPoint>(binding), pass.pipelineLayout, ocurrence, 1, &descriptor.handle, offsets.size(), offsets.data());
+        handle, static_cast<VkPipelineBindPoint>(binding), pass.pipelineLayout, ocurrence, 1, &descriptor, offsetCount, offsets);
 }
 void CommandBuffer::set_viewport(Extent2D extent, Offset2D scissorOffset) {
     VkViewport viewport = Init::viewport(extent);
@@ -187,18 +294,26 @@ void CommandBuffer::set_viewport(Extent2D extent, Offset2D scissorOffset) {
     vkCmdSetScissor(handle, 0, 1, &scissor);
 }
 void CommandBuffer::set_cull_mode(CullingMode mode) {
+    if (state && state->is_set(state->cullMode, mode))
+        return;
     vkCmdSetCullMode(handle, (VkCullModeFlags)mode);
 }
 
 void CommandBuffer::set_depth_write_enable(bool op) {
+    if (state && state->is_set(state->depthWrite, op))
+        return;
     vkCmdSetDepthWriteEnable(handle, op);
 }
 
 void CommandBuffer::set_depth_test_enable(bool op) {
+    if (state && state->is_set(state->depthTest, op))
+        return;
     vkCmdSetDepthTestEnable(handle, op);
 }
 void CommandBuffer::set_depth_bias_enable(bool op) {
-    vkCmdSetDepthBiasEnable(handle, true);
+    if (state && state->is_set(state->depthBiasEnable, op))
+        return;
+    vkCmdSetDepthBiasEnable(handle, op);
 }
 void CommandBuffer::set_depth_bias(float depthBiasConstantFactor, float depthBiasClamp, float depthBiasSlopeFactor) {
     vkCmdSetDepthBias(handle, depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor);
@@ -274,6 +389,21 @@ void Graphics::CommandBuffer::clear_image(Image& img, ImageLayout layout, ImageA
 
     vkCmdClearColorImage(handle, img.handle, Translator::get(layout), &vclearColor, 1, &subresourceRange);
 }
+void Graphics::CommandBuffer::clear_attachment(
+    uint32_t attachment, ClearValue clearValue, Extent2D extent, uint32_t baseLayer, uint32_t layerCount, ImageAspect aspect) {
+    VkClearAttachment clearAttachment = {};
+    clearAttachment.aspectMask        = Translator::get(aspect);
+    clearAttachment.colorAttachment   = attachment;
+    clearAttachment.clearValue        = clearValue;
+
+    VkClearRect rect    = {};
+    rect.rect.offset    = {0, 0};
+    rect.rect.extent    = extent;
+    rect.baseArrayLayer = baseLayer;
+    rect.layerCount     = layerCount;
+
+    vkCmdClearAttachments(handle, 1, &clearAttachment, 1, &rect);
+}
 void Graphics::CommandBuffer::blit_image(Image& srcImage, Image& dstImage, FilterType filter, uint32_t mipLevel, ImageAspect srcAspect, ImageAspect dstAspect) {
     VkImageBlit blitRegion                   = {};
     blitRegion.srcOffsets[0]                 = {0, 0, 0};
@@ -342,15 +472,31 @@ void Graphics::CommandBuffer::dispatch_compute(Extent3D grid) {
     vkCmdDispatch(handle, grid.width, grid.height, grid.depth);
 }
 
-void Graphics::CommandBuffer::copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size) {
+void Graphics::CommandBuffer::copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size, size_t srcOffset, size_t dstOffset) {
     VkBufferCopy copy;
-    copy.dstOffset = 0;
-    copy.srcOffset = 0;
+    copy.dstOffset = dstOffset;
+    copy.srcOffset = srcOffset;
     copy.size      = size;
     vkCmdCopyBuffer(handle, srcBuffer.handle, dstBuffer.handle, 1, &copy);
 }
 
+void Graphics::CommandBuffer::fill_buffer(Buffer& buffer, uint32_t value, size_t size, size_t offset) {
+    vkCmdFillBuffer(handle, buffer.handle, offset, size, value);
+}
+
+void Graphics::CommandBuffer::memory_barrier(AccessFlags srcMask, AccessFlags dstMask, PipelineStage srcStage, PipelineStage dstStage) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask   = Translator::get(srcMask);
+    barrier.dstAccessMask   = Translator::get(dstMask);
+    vkCmdPipelineBarrier(handle, Translator::get(srcStage), Translator::get(dstStage), 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
 void Graphics::CommandBuffer::copy_buffer_to_image(Image& img, Buffer& buffer) {
+    copy_buffer_to_image(img, buffer, 0, (img.extent.width * img.extent.height * buffer.size) / img.config.layers);
+}
+
+void Graphics::CommandBuffer::copy_buffer_to_image(Image& img, Buffer& buffer, size_t bufferOffset, size_t layerSize) {
 
     VkImageSubresourceRange range;
     range.aspectMask     = Translator::get(img.config.aspectFlags);
@@ -377,7 +523,7 @@ void Graphics::CommandBuffer::copy_buffer_to_image(Image& img, Buffer& buffer) {
     for (uint32_t layer = 0; layer < img.config.layers; ++layer)
     {
         VkBufferImageCopy copyRegion = {};
-        copyRegion.bufferOffset      = layer * ((img.extent.width * img.extent.height * buffer.size) / img.config.layers); // Offset per face
+        copyRegion.bufferOffset      = bufferOffset + layer * layerSize; // Offset per face
         copyRegion.bufferRowLength   = 0;
         copyRegion.bufferImageHeight = 0;
 
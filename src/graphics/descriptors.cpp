@@ -215,6 +215,9 @@ void DescriptorPool::allocate_descriptor_set(uint32_t layoutSetIndex, Descriptor
     VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &descriptor->handle));
 }
 void DescriptorPool::allocate_variable_descriptor_set(uint32_t layoutSetIndex, DescriptorSet* descriptor, uint32_t count) {
+    allocate_variable_descriptor_set(layouts[layoutSetIndex], layoutSetIndex, descriptor, count);
+}
+void DescriptorPool::allocate_variable_descriptor_set(const DescriptorLayout& layout, uint32_t layoutSetIndex, DescriptorSet* descriptor, uint32_t count) {
     
     VkDescriptorSetVariableDescriptorCountAllocateInfo countInfo = {};
     countInfo.sType                                              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
@@ -226,7 +229,7 @@ void DescriptorPool::allocate_variable_descriptor_set(uint32_t layoutSetIndex, D
     allocInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     allocInfo.descriptorPool              = handle;
     allocInfo.descriptorSetCount          = 1;
-    allocInfo.pSetLayouts                 = &layouts[layoutSetIndex].handle;
+    allocInfo.pSetLayouts                 = &layout.handle;
     
     descriptor->layoutID = layoutSetIndex;
     descriptor->device = device;
@@ -38,6 +38,8 @@ void Device::init(void*           windowHandle,
     m_swapchain.create(m_gpu, m_handle, actualExtent, surfaceExtent, framesPerFlight, Translator::get(presentFormat), Translator::get(presentMode));
 
     create_upload_context();
+    create_transfer_context();
+    create_pipeline_cache();
     load_extensions(m_handle, m_instance);
 
     //------<<<
@@ -65,6 +67,8 @@ void Device::init_headless() {
     m_allocator = Booter::setup_memory(m_instance, m_handle, m_gpu);
 
     create_upload_context();
+    create_transfer_context();
+    create_pipeline_cache();
     load_extensions(m_handle, m_instance);
 
     //------<<<
@@ -75,8 +79,14 @@ void Device::update_swapchain(Extent2D surfaceExtent, uint32_t framesPerFlight,
 
 void Device::cleanup() {
 
+    wait_all_uploads();
+    m_transferContext.cleanup();
     m_uploadContext.cleanup();
 
+    save_pipeline_cache();
+    vkDestroyPipelineCache(m_handle, m_pipelineCache, nullptr);
+    m_pipelineCache = VK_NULL_HANDLE;
+
     m_swapchain.cleanup();
 
     vmaDestroyAllocator(m_allocator);
@@ -92,6 +102,76 @@ void Device::cleanup() {
     vkDestroyInstance(m_instance, nullptr);
 }
 
+void Device::create_pipeline_cache() {
+    if (m_pipelineCachePath.empty())
+        m_pipelineCachePath = GET_RESOURCE_PATH("shaders/.cache/pipelines.bin");
+
+    std::vector<uint8_t> blob;
+    std::ifstream        file(m_pipelineCachePath, std::ios::binary | std::ios::ate);
+    if (file.is_open())
+    {
+        blob.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, std::ios::beg);
+        if (!file.read(reinterpret_cast<char*>(blob.data()), blob.size()))
+            blob.clear();
+    }
+
+    // Blobs from another GPU or driver are ignored instead of handed to the driver
+    if (!blob.empty())
+    {
+        VkPipelineCacheHeaderVersionOne header = {};
+        bool                            valid  = blob.size() >= sizeof(header);
+        if (valid)
+        {
+            memcpy(&header, blob.data(), sizeof(header));
+            valid = header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                    header.vendorID == m_properties.vendorID && header.deviceID == m_properties.deviceID &&
+                    memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+        if (!valid)
+        {
+            LOG_DEBUG("Pipeline cache on disk was written by another device or driver. Starting an empty one");
+            blob.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize           = blob.size();
+    cacheInfo.pInitialData              = blob.empty() ? nullptr : blob.data();
+    VK_CHECK(vkCreatePipelineCache(m_handle, &cacheInfo, nullptr, &m_pipelineCache));
+}
+void Device::save_pipeline_cache() {
+    if (!m_pipelineCache)
+        return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_handle, m_pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
+    std::vector<uint8_t> blob(size);
+    if (vkGetPipelineCacheData(m_handle, m_pipelineCache, &size, blob.data()) != VK_SUCCESS)
+        return;
+
+    std::error_code             error;
+    const std::filesystem::path path(m_pipelineCachePath);
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // Written aside and renamed, so a crash while saving does not leave a truncated cache behind
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARN("Could not write pipeline cache to " + tmpPath.string());
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(blob.data()), size);
+    }
+    std::filesystem::rename(tmpPath, path, error);
+    if (error)
+        std::filesystem::remove(tmpPath, error);
+}
 Buffer Device::create_buffer_VMA(size_t allocSize, BufferUsageFlags usage, VmaMemoryUsage memoryUsage, uint32_t strideSize) {
 
     Buffer buffer = {};
@@ -145,7 +225,7 @@ Buffer Device::create_buffer(size_t allocSize, BufferUsageFlags usage, MemoryPro
 
     return buffer;
 }
-Image Device::create_image(Extent3D extent, ImageConfig config, VmaMemoryUsage memoryUsage) {
+Image Device::create_image(Extent3D extent, ImageConfig config, VmaMemoryUsage memoryUsage, VmaAllocation aliasedMemory) {
     Image img  = {};
     img.extent = extent;
     img.device = m_handle;
@@ -179,10 +259,43 @@ Image Device::create_image(Extent3D extent, ImageConfig config, VmaMemoryUsage m
                                                          img.config.viewType == TextureTypeFlagBits::TEXTURE_CUBE ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0);
     img_info.initialLayout     = Translator::get(config.layout);
 
+    if (aliasedMemory)
+    {
+        VK_CHECK(vmaCreateAliasingImage(m_allocator, aliasedMemory, &img_info, &img.handle));
+        img.aliasedMemory = aliasedMemory;
+        return img;
+    }
     VK_CHECK(vmaCreateImage(m_allocator, &img_info, &img_allocinfo, &img.handle, &img.allocation, nullptr));
 
     return img;
 }
+VmaAllocation Device::allocate_aliasing_memory(const std::vector<Image*>& images, size_t* allocatedSize) {
+    VkMemoryRequirements requirements = {};
+    requirements.memoryTypeBits       = ~0u;
+    for (const Image* img : images)
+    {
+        VkMemoryRequirements imgRequirements;
+        vkGetImageMemoryRequirements(m_handle, img->handle, &imgRequirements);
+        requirements.size      = std::max(requirements.size, imgRequirements.size);
+        requirements.alignment = std::max(requirements.alignment, imgRequirements.alignment);
+        requirements.memoryTypeBits &= imgRequirements.memoryTypeBits;
+    }
+    if (requirements.memoryTypeBits == 0)
+        return VK_NULL_HANDLE;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VmaAllocation memory = VK_NULL_HANDLE;
+    VK_CHECK(vmaAllocateMemory(m_allocator, &requirements, &allocInfo, &memory, nullptr));
+    if (allocatedSize)
+        *allocatedSize = requirements.size;
+    return memory;
+}
+void Device::free_aliasing_memory(VmaAllocation memory) {
+    if (memory)
+        vmaFreeMemory(m_allocator, memory);
+}
 Texture Device::create_texture(const ptr<Image>& img, TextureConfig config) {
     Texture tex = {};
 
@@ -229,6 +342,11 @@ CommandPool Device::create_command_pool(QueueType QueueType, CommandPoolCreateFl
     case QueueType::PRESENT_QUEUE:
         poolInfo.queueFamilyIndex = Booter::find_queue_families(m_gpu, m_swapchain.get_surface()).presentFamily.value();
         break;
+    case QueueType::TRANSFER_QUEUE: {
+        Booter::QueueFamilyIndices families = Booter::find_queue_families(m_gpu, m_swapchain.get_surface());
+        poolInfo.queueFamilyIndex           = families.transferFamily.value_or(families.graphicsFamily.value());
+        break;
+    }
     default:
         break;
     }
@@ -267,10 +385,16 @@ DescriptorPool Device::create_descriptor_pool(uint32_t                       max
     DescriptorPool pool = {};
     pool.device         = m_handle;
 
-    std::vector<VkDescriptorPoolSize> sizes = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, numUBO},
-                                               {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, numUBODynamic},
-                                               {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, numUBOStorage},
-                                               {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, numImageCombined}};
+    // Pool sizes can not be empty
+    std::vector<VkDescriptorPoolSize> sizes;
+    if (numUBO > 0)
+        sizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, numUBO});
+    if (numUBODynamic > 0)
+        sizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, numUBODynamic});
+    if (numUBOStorage > 0)
+        sizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, numUBOStorage});
+    if (numImageCombined > 0)
+        sizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, numImageCombined});
     if (numSampler > 0)
         sizes.push_back({VK_DESCRIPTOR_TYPE_SAMPLER, numSampler});
     if (numSampledImage > 0)
@@ -399,7 +523,10 @@ Framebuffer Device::create_framebuffer(RenderPass& renderpass, std::vector<Image
         if (!renderpass.attachmentsConfig[i].isDefault) // If its not present image
         {
             renderpass.attachmentsConfig[i].imageConfig.layers = layers;
-            *attachments[i]                                    = create_image({extent.width, extent.height, 1}, renderpass.attachmentsConfig[i].imageConfig);
+            *attachments[i]                                    = create_image({extent.width, extent.height, 1},
+                                                   renderpass.attachmentsConfig[i].imageConfig,
+                                                   VMA_MEMORY_USAGE_GPU_ONLY,
+                                                   attachments[i]->aliasedMemory);
             attachments[i]->create_view(renderpass.attachmentsConfig[i].imageConfig);
             attachments[i]->create_sampler(renderpass.attachmentsConfig[i].samplerConfig);
 
@@ -455,13 +582,16 @@ Fence Device::create_fence(bool signaled) {
     VK_CHECK(vkCreateFence(m_handle, &fenceCreateInfo, nullptr, &fence.handle));
     return fence;
 }
-Frame Device::create_frame(uint16_t id) {
+Frame Device::create_frame(uint16_t id, uint32_t recordingWorkers) {
     Frame frame                = {};
     frame.index                = id;
     frame.commandPool          = create_command_pool(QueueType::GRAPHIC_QUEUE, COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER);
     frame.commandBuffer        = create_command_buffer(frame.commandPool);
     frame.computeCommandPool   = create_command_pool(QueueType::COMPUTE_QUEUE, COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER);
     frame.computeCommandBuffer = create_command_buffer(frame.computeCommandPool);
+    frame.workerCommands.resize(recordingWorkers);
+    for (WorkerCommands& commands : frame.workerCommands)
+        commands.pool = create_command_pool(QueueType::GRAPHIC_QUEUE, COMMAND_POOL_CREATE_TRANSIENT);
     frame.renderFence          = create_fence();
     frame.renderSemaphore      = create_semaphore();
     frame.presentSemaphore     = create_semaphore();
@@ -479,6 +609,7 @@ RenderResult Device::wait_frame(Frame& frame, uint32_t& imageIndex) {
 void Device::start_frame(Frame& frame) {
     frame.renderFence.reset();
     frame.commandBuffer.reset();
+    frame.reset_worker_commands();
     frame.commandBuffer.begin();
 }
 RenderResult Device::submit_frame(Frame& frame, uint32_t imageIndex) {
@@ -510,64 +641,98 @@ RenderResult Device::present_image(Semaphore& signalSemaphore, uint32_t imageInd
     return static_cast<RenderResult>(result);
 }
 
+void Device::begin_upload_batch() {
+    if (m_uploadContext.batchDepth++ == 0 && !m_uploadContext.commandBuffer.isRecording)
+        m_uploadContext.commandBuffer.begin();
+}
+void Device::end_upload_batch() {
+    if (m_uploadContext.batchDepth == 0)
+        return;
+    if (--m_uploadContext.batchDepth == 0)
+        m_uploadContext.flush();
+}
+void Device::flush_uploads() {
+    m_uploadContext.flush();
+}
 void Device::upload_vertex_arrays(VertexArrays& vao,
                                   size_t        vboSize,
                                   const void*   vboData,
                                   size_t        iboSize,
                                   const void*   iboData,
                                   size_t        voxelSize,
-                                  const void*   voxelData) {
+                                  const void*   voxelData,
+                                  size_t        attributeSize,
+                                  const void*   attributeData) {
     PROFILING_EVENT()
     // Should be executed only once if geometry data is not changed
 
-    Buffer vboStagingBuffer = create_buffer_VMA(vboSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
-    vboStagingBuffer.upload_data(vboData, vboSize);
+    // All the streams of the geometry go through the same batch
+    begin_upload_batch();
 
     // GPU vertex buffer
     vao.vbo = create_buffer_VMA(
         vboSize,
-        BUFFER_USAGE_VERTEX_BUFFER | BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS | BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY,
+        BUFFER_USAGE_VERTEX_BUFFER | BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS |
+            BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY,
         VMA_MEMORY_USAGE_GPU_ONLY);
 
-    m_uploadContext.immediate_submit([&](CommandBuffer cmd) { cmd.copy_buffer(vboStagingBuffer, vao.vbo, vboSize); });
+    size_t  vboOffset  = 0;
+    Buffer& vboStaging = stage_data(vboData, vboSize, vboOffset);
+    record_upload([&](CommandBuffer cmd) { cmd.copy_buffer(vboStaging, vao.vbo, vboSize, vboOffset); });
 
-    vboStagingBuffer.cleanup();
+    if (vao.layout == PACKED_VERTEX_LAYOUT)
+    {
+        // GPU quantized attribute buffer
+        vao.attributeBuffer =
+            create_buffer_VMA(attributeSize, BUFFER_USAGE_VERTEX_BUFFER | BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST, VMA_MEMORY_USAGE_GPU_ONLY);
 
+        size_t  attributeOffset  = 0;
+        Buffer& attributeStaging = stage_data(attributeData, attributeSize, attributeOffset);
+        record_upload([&](CommandBuffer cmd) { cmd.copy_buffer(attributeStaging, vao.attributeBuffer, attributeSize, attributeOffset); });
+    }
     if (vao.indexCount > 0)
     {
-        // Staging index buffer (CPU only)
-        Buffer iboStagingBuffer = create_buffer_VMA(iboSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
-        iboStagingBuffer.upload_data(iboData, iboSize);
-
         // GPU index buffer
         vao.ibo = create_buffer_VMA(iboSize,
-                                    BUFFER_USAGE_INDEX_BUFFER | BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS |
+                                    BUFFER_USAGE_INDEX_BUFFER | BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS |
                                         BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY,
                                     VMA_MEMORY_USAGE_GPU_ONLY);
 
-        m_uploadContext.immediate_submit([&](CommandBuffer cmd) { cmd.copy_buffer(iboStagingBuffer, vao.ibo, iboSize); });
-
-        iboStagingBuffer.cleanup();
+        size_t  iboOffset  = 0;
+        Buffer& iboStaging = stage_data(iboData, iboSize, iboOffset);
+        record_upload([&](CommandBuffer cmd) { cmd.copy_buffer(iboStaging, vao.ibo, iboSize, iboOffset); });
     }
     if (vao.voxelCount > 0)
     {
-        // Staging Voxel buffer (CPU only)
-        Buffer voxelStagingBuffer = create_buffer_VMA(voxelSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
-        voxelStagingBuffer.upload_data(voxelData, voxelSize);
-
         // GPU Voxel buffer
         vao.voxelBuffer =
             create_buffer_VMA(voxelSize,
                               BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS | BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY,
                               VMA_MEMORY_USAGE_GPU_ONLY);
 
-        m_uploadContext.immediate_submit([&](CommandBuffer cmd) { cmd.copy_buffer(voxelStagingBuffer, vao.voxelBuffer, voxelSize); });
-
-        voxelStagingBuffer.cleanup();
+        size_t  voxelOffset  = 0;
+        Buffer& voxelStaging = stage_data(voxelData, voxelSize, voxelOffset);
+        record_upload([&](CommandBuffer cmd) { cmd.copy_buffer(voxelStaging, vao.voxelBuffer, voxelSize, voxelOffset); });
     }
 
+    end_upload_batch();
+
     vao.loadedOnGPU = true;
 }
+void Device::upload_buffer_data(Buffer& dstBuffer, const void* data, size_t size, size_t dstOffset) {
+    PROFILING_EVENT()
+    size_t  stagingOffset = 0;
+    Buffer& staging       = stage_data(data, size, stagingOffset);
+    record_upload([&](CommandBuffer cmd) { cmd.copy_buffer(staging, dstBuffer, size, stagingOffset, dstOffset); });
+}
+void Device::copy_buffer(Buffer& srcBuffer, Buffer& dstBuffer, size_t size, size_t srcOffset, size_t dstOffset) {
+    PROFILING_EVENT()
+    record_upload([&](CommandBuffer cmd) {
+        // The source might have been written by a copy recorded earlier in the same batch
+        cmd.memory_barrier(ACCESS_TRANSFER_WRITE, ACCESS_TRANSFER_READ, STAGE_TRANSFER, STAGE_TRANSFER);
+        cmd.copy_buffer(srcBuffer, dstBuffer, size, srcOffset, dstOffset);
+    });
+}
 void Device::upload_texture_image(Image& img, ImageConfig config, SamplerConfig samplerConfig, const void* imgCache, size_t bytesPerPixel) {
     PROFILING_EVENT()
 
@@ -580,15 +745,164 @@ void Device::upload_texture_image(Image& img, ImageConfig config, SamplerConfig
 
     VkDeviceSize imageSize = img.extent.width * img.extent.height * img.extent.depth * bytesPerPixel;
 
-    Buffer stagingBuffer = create_buffer_VMA(imageSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
-    stagingBuffer.upload_data(imgCache, static_cast<size_t>(imageSize));
+    if (img.config.mipLevels > 1)
+    {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(m_gpu, Translator::get(config.format), &formatProperties);
+        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            throw std::runtime_error("texture image format does not support linear blitting!");
+        }
+    }
+
+    // COPY AND GENERATE MIPMAPS IN THE SAME BATCH
+    size_t  stagingOffset = 0;
+    Buffer& staging       = stage_data(imgCache, static_cast<size_t>(imageSize), stagingOffset);
+    Image*  image         = &img;
+    record_upload([=, &staging](CommandBuffer cmd) {
+        cmd.copy_buffer_to_image(*image, staging, stagingOffset, static_cast<size_t>(imageSize) / image->config.layers);
+        if (image->config.mipLevels > 1)
+            cmd.generate_mipmaps(*image);
+    });
 
-    m_uploadContext.immediate_submit([&](CommandBuffer cmd) { cmd.copy_buffer_to_image(img, stagingBuffer); });
+    // CREATE SAMPLER
+    samplerConfig.mipmapMode    = MipmapMode::MIPMAP_LINEAR;
+    samplerConfig.maxAnysotropy = m_properties.limits.maxSamplerAnisotropy;
+    img.create_sampler(samplerConfig);
 
-    stagingBuffer.cleanup();
+    if (ImGui::GetCurrentContext())
+        img.create_GUI_handle();
 
-    // GENERATE MIPMAPS
-    if (img.config.mipLevels > 1)
+    img.loadedOnGPU = true;
+}
+static VkBufferMemoryBarrier buffer_ownership_barrier(const Buffer& buffer, VkAccessFlags srcMask, VkAccessFlags dstMask, uint32_t srcFamily, uint32_t dstFamily) {
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask         = srcMask;
+    barrier.dstAccessMask         = dstMask;
+    barrier.srcQueueFamilyIndex   = srcFamily;
+    barrier.dstQueueFamilyIndex   = dstFamily;
+    barrier.buffer                = buffer.handle;
+    barrier.offset                = 0;
+    barrier.size                  = VK_WHOLE_SIZE;
+    return barrier;
+}
+UploadTicket Device::upload_vertex_arrays_async(VertexArrays& vao,
+                                                size_t        vboSize,
+                                                const void*   vboData,
+                                                size_t        iboSize,
+                                                const void*   iboData,
+                                                size_t        voxelSize,
+                                                const void*   voxelData,
+                                                size_t        attributeSize,
+                                                const void*   attributeData) {
+    PROFILING_EVENT()
+    TransferContext& ctx = m_transferContext;
+
+    const BufferUsageFlags usage =
+        BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST | BUFFER_USAGE_SHADER_DEVICE_ADDRESS | BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY;
+    vao.vbo = create_buffer_VMA(vboSize, BUFFER_USAGE_VERTEX_BUFFER | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+    if (vao.indexCount > 0)
+        vao.ibo = create_buffer_VMA(iboSize, BUFFER_USAGE_INDEX_BUFFER | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+    if (vao.voxelCount > 0)
+        vao.voxelBuffer = create_buffer_VMA(voxelSize, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+    const bool PACKED = vao.layout == PACKED_VERTEX_LAYOUT;
+    if (PACKED)
+        vao.attributeBuffer = create_buffer_VMA(attributeSize, BUFFER_USAGE_VERTEX_BUFFER | BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    // One staging buffer for all the streams
+    auto         align           = [](size_t size) { return (size + ENGINE_STAGING_ALIGNMENT - 1) & ~(size_t(ENGINE_STAGING_ALIGNMENT) - 1); };
+    const size_t iboOffset       = align(vboSize);
+    const size_t voxelOffset     = iboOffset + (vao.indexCount > 0 ? align(iboSize) : 0);
+    const size_t attributeOffset = voxelOffset + (vao.voxelCount > 0 ? align(voxelSize) : 0);
+    const size_t stagingSize     = attributeOffset + (PACKED ? attributeSize : 0);
+
+    TransferContext::Submission& submission = acquire_transfer_submission();
+    submission.staging                      = create_buffer_VMA(stagingSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
+    submission.vao                          = &vao;
+
+    std::vector<Buffer*> dstBuffers = {&vao.vbo};
+    submission.staging.upload_data(vboData, vboSize, 0);
+    if (vao.indexCount > 0)
+    {
+        submission.staging.upload_data(iboData, iboSize, iboOffset);
+        dstBuffers.push_back(&vao.ibo);
+    }
+    if (vao.voxelCount > 0)
+    {
+        submission.staging.upload_data(voxelData, voxelSize, voxelOffset);
+        dstBuffers.push_back(&vao.voxelBuffer);
+    }
+    if (PACKED)
+    {
+        submission.staging.upload_data(attributeData, attributeSize, attributeOffset);
+        dstBuffers.push_back(&vao.attributeBuffer);
+    }
+
+    CommandBuffer& cmd = submission.transferCmd;
+    cmd.begin();
+    cmd.copy_buffer(submission.staging, vao.vbo, vboSize, 0);
+    if (vao.indexCount > 0)
+        cmd.copy_buffer(submission.staging, vao.ibo, iboSize, iboOffset);
+    if (vao.voxelCount > 0)
+        cmd.copy_buffer(submission.staging, vao.voxelBuffer, voxelSize, voxelOffset);
+    if (PACKED)
+        cmd.copy_buffer(submission.staging, vao.attributeBuffer, attributeSize, attributeOffset);
+
+    if (ctx.needs_ownership_transfer())
+    {
+        // Release on the transfer family ...
+        std::vector<VkBufferMemoryBarrier> barriers;
+        for (Buffer* b : dstBuffers)
+            barriers.push_back(buffer_ownership_barrier(*b, VK_ACCESS_TRANSFER_WRITE_BIT, 0, ctx.transferFamily, ctx.graphicFamily));
+        vkCmdPipelineBarrier(cmd.handle,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             static_cast<uint32_t>(barriers.size()),
+                             barriers.data(),
+                             0,
+                             nullptr);
+        // ... and acquire on the graphic one
+        for (VkBufferMemoryBarrier& barrier : barriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        }
+        submission.graphicCmd.begin();
+        vkCmdPipelineBarrier(submission.graphicCmd.handle,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             static_cast<uint32_t>(barriers.size()),
+                             barriers.data(),
+                             0,
+                             nullptr);
+        submission.graphicCmd.end();
+    }
+    cmd.end();
+
+    vao.loadedOnGPU   = false;
+    vao.pendingUpload = submit_transfer(submission, ctx.needs_ownership_transfer());
+    return vao.pendingUpload;
+}
+UploadTicket Device::upload_texture_image_async(Image& img, ImageConfig config, SamplerConfig samplerConfig, const void* imgCache, size_t bytesPerPixel) {
+    PROFILING_EVENT()
+    TransferContext& ctx = m_transferContext;
+
+    // CREATE IMAGE
+    config.usageFlags  = IMAGE_USAGE_SAMPLED | IMAGE_USAGE_TRANSFER_SRC | IMAGE_USAGE_TRANSFER_DST;
+    config.samples     = 1;
+    config.aspectFlags = ASPECT_COLOR;
+    img                = create_image(img.extent, config);
+    img.create_view(config);
+
+    const bool hasMipmaps = img.config.mipLevels > 1;
+    if (hasMipmaps)
     {
         VkFormatProperties formatProperties;
         vkGetPhysicalDeviceFormatProperties(m_gpu, Translator::get(config.format), &formatProperties);
@@ -596,9 +910,80 @@ void Device::upload_texture_image(Image& img, ImageConfig config, SamplerConfig
         {
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
+    }
+
+    const size_t imageSize = img.extent.width * img.extent.height * img.extent.depth * bytesPerPixel;
+
+    TransferContext::Submission& submission = acquire_transfer_submission();
+    submission.staging                      = create_buffer_VMA(imageSize, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
+    submission.staging.upload_data(imgCache, imageSize);
+    submission.image = &img;
+
+    VkImageSubresourceRange range = {};
+    range.aspectMask              = Translator::get(img.config.aspectFlags);
+    range.baseMipLevel            = img.config.baseMipLevel;
+    range.levelCount              = img.config.mipLevels;
+    range.baseArrayLayer          = 0;
+    range.layerCount              = img.config.layers;
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barrier.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask        = 0;
+    barrier.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.image                = img.handle;
+    barrier.subresourceRange     = range;
+
+    CommandBuffer& cmd = submission.transferCmd;
+    cmd.begin();
+    vkCmdPipelineBarrier(cmd.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    for (uint32_t layer = 0; layer < img.config.layers; ++layer)
+    {
+        VkBufferImageCopy copyRegion               = {};
+        copyRegion.bufferOffset                    = layer * (imageSize / img.config.layers);
+        copyRegion.imageSubresource.aspectMask     = range.aspectMask;
+        copyRegion.imageSubresource.mipLevel       = 0;
+        copyRegion.imageSubresource.baseArrayLayer = layer;
+        copyRegion.imageSubresource.layerCount     = 1;
+        copyRegion.imageExtent                     = img.extent;
+        vkCmdCopyBufferToImage(cmd.handle, submission.staging.handle, img.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+    }
 
-        m_uploadContext.immediate_submit([&](CommandBuffer cmd) { cmd.generate_mipmaps(img); });
+    // Mipmaps are generated with blits, so they need a graphic-capable queue. Keep TRANSFER_DST layout until then
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = hasMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (ctx.needs_ownership_transfer())
+    {
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = 0;
+        barrier.srcQueueFamilyIndex = ctx.transferFamily;
+        barrier.dstQueueFamilyIndex = ctx.graphicFamily;
+        vkCmdPipelineBarrier(cmd.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = hasMipmaps ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+        submission.graphicCmd.begin();
+        vkCmdPipelineBarrier(
+            submission.graphicCmd.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        if (hasMipmaps)
+            submission.graphicCmd.generate_mipmaps(img);
+        submission.graphicCmd.end();
+    } else
+    {
+        // Transfer queue belongs to the graphic family here
+        if (hasMipmaps)
+            cmd.generate_mipmaps(img);
+        else
+        {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(cmd.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
     }
+    cmd.end();
 
     // CREATE SAMPLER
     samplerConfig.mipmapMode    = MipmapMode::MIPMAP_LINEAR;
@@ -608,7 +993,69 @@ void Device::upload_texture_image(Image& img, ImageConfig config, SamplerConfig
     if (ImGui::GetCurrentContext())
         img.create_GUI_handle();
 
-    img.loadedOnGPU = true;
+    img.loadedOnGPU   = false;
+    img.pendingUpload = submit_transfer(submission, ctx.needs_ownership_transfer());
+    return img.pendingUpload;
+}
+void Device::poll_uploads() {
+    PROFILING_EVENT()
+    TransferContext& ctx = m_transferContext;
+    for (size_t i = 0; i < ctx.inFlight.size();)
+    {
+        TransferContext::Submission& submission = ctx.inFlight[i];
+        if (!submission.fence.is_signaled())
+        {
+            i++;
+            continue;
+        }
+        // Resource is now resident (unless it was re-uploaded meanwhile)
+        if (submission.vao && submission.vao->pendingUpload == submission.ticket)
+        {
+            submission.vao->loadedOnGPU   = true;
+            submission.vao->pendingUpload = 0;
+        }
+        if (submission.image && submission.image->pendingUpload == submission.ticket)
+        {
+            submission.image->loadedOnGPU   = true;
+            submission.image->pendingUpload = 0;
+        }
+        submission.staging.cleanup();
+        submission.fence.reset();
+        submission.vao    = nullptr;
+        submission.image  = nullptr;
+        submission.ticket = 0;
+        ctx.available.push_back(submission);
+
+        ctx.inFlight[i] = ctx.inFlight.back();
+        ctx.inFlight.pop_back();
+    }
+}
+bool Device::is_upload_complete(UploadTicket ticket) {
+    if (ticket == 0)
+        return true;
+    poll_uploads();
+    for (const TransferContext::Submission& submission : m_transferContext.inFlight)
+    {
+        if (submission.ticket == ticket)
+            return false;
+    }
+    return true;
+}
+void Device::wait_upload(UploadTicket ticket) {
+    for (TransferContext::Submission& submission : m_transferContext.inFlight)
+    {
+        if (submission.ticket == ticket)
+        {
+            submission.fence.wait();
+            break;
+        }
+    }
+    poll_uploads();
+}
+void Device::wait_all_uploads() {
+    for (TransferContext::Submission& submission : m_transferContext.inFlight)
+        submission.fence.wait();
+    poll_uploads();
 }
 void Device::upload_BLAS(BLAS& accel, VAO& vao) {
     if (!vao.loadedOnGPU)
@@ -634,7 +1081,7 @@ void Device::upload_BLAS(BLAS& accel, VAO& vao) {
         accelerationStructureGeometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
         accelerationStructureGeometry.geometry.triangles.vertexData   = vertexBufferDeviceAddress;
         accelerationStructureGeometry.geometry.triangles.maxVertex    = vao.vertexCount - 1;
-        accelerationStructureGeometry.geometry.triangles.vertexStride = sizeof(Vertex);
+        accelerationStructureGeometry.geometry.triangles.vertexStride = vao.layout == PACKED_VERTEX_LAYOUT ? sizeof(Vec3) : sizeof(Vertex);
 
         if (vao.indexCount > 0)
         {
@@ -880,6 +1327,7 @@ void Device::init_imgui(void* windowHandle, WindowingSystem windowingSystem, Ren
     init_info.Device                    = m_handle;
     init_info.Queue                     = m_queues[QueueType::GRAPHIC_QUEUE];
     init_info.DescriptorPool            = m_guiPool.handle;
+    init_info.PipelineCache             = m_pipelineCache;
     init_info.MinImageCount             = 3;
     init_info.ImageCount                = 3;
     init_info.RenderPass                = renderPass.handle;
@@ -933,10 +1381,106 @@ void Device::create_upload_context() {
     m_uploadContext.uploadFence   = create_fence(false);
     m_uploadContext.commandPool   = create_command_pool(QueueType::GRAPHIC_QUEUE);
     m_uploadContext.commandBuffer = create_command_buffer(m_uploadContext.commandPool);
+
+    m_uploadContext.stagingBuffer = create_buffer_VMA(ENGINE_STAGING_BUFFER_SIZE, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
+    VK_CHECK(vmaMapMemory(m_allocator, m_uploadContext.stagingBuffer.allocation, (void**)&m_uploadContext.stagingData));
+}
+
+Buffer& Device::stage_data(const void* data, size_t size, size_t& offset) {
+    PROFILING_EVENT()
+    UploadContext& ctx = m_uploadContext;
+
+    // Too big for the ring. Give it its own staging buffer, released on flush
+    if (size > ENGINE_STAGING_BUFFER_SIZE)
+    {
+        Buffer staging = create_buffer_VMA(size, BUFFER_USAGE_TRANSFER_SRC, VMA_MEMORY_USAGE_CPU_ONLY);
+        staging.upload_data(data, size);
+        ctx.overflowBuffers.push_back(staging);
+        offset = 0;
+        return ctx.overflowBuffers.back();
+    }
+
+    size_t alignedOffset = (ctx.stagingOffset + ENGINE_STAGING_ALIGNMENT - 1) & ~(size_t(ENGINE_STAGING_ALIGNMENT) - 1);
+    // Ring is full. Submit what is pending so the memory can be recycled
+    if (alignedOffset + size > ENGINE_STAGING_BUFFER_SIZE)
+    {
+        ctx.flush();
+        alignedOffset = 0;
+    }
+
+    if (data)
+        memcpy(ctx.stagingData + alignedOffset, data, size);
+    ctx.stagingOffset = alignedOffset + size;
+
+    offset = alignedOffset;
+    return ctx.stagingBuffer;
+}
+
+void Device::record_upload(std::function<void(CommandBuffer cmd)>&& function) {
+    if (!is_batching_uploads())
+    {
+        m_uploadContext.immediate_submit(std::move(function));
+        return;
+    }
+    function(m_uploadContext.commandBuffer);
+    m_uploadContext.pendingCopies++;
+}
+
+void Device::create_transfer_context() {
+    Booter::QueueFamilyIndices families = Booter::find_queue_families(m_gpu, m_swapchain.get_surface());
+    m_transferContext.graphicFamily     = families.graphicsFamily.value();
+    m_transferContext.transferFamily    = families.transferFamily.value_or(families.graphicsFamily.value());
+    m_transferContext.transferPool      = create_command_pool(QueueType::TRANSFER_QUEUE);
+    m_transferContext.graphicPool       = create_command_pool(QueueType::GRAPHIC_QUEUE);
+}
+
+Device::TransferContext::Submission& Device::acquire_transfer_submission() {
+    TransferContext&            ctx        = m_transferContext;
+    TransferContext::Submission submission = {};
+    if (!ctx.available.empty())
+    {
+        submission = ctx.available.back();
+        ctx.available.pop_back();
+    } else
+    {
+        submission.transferCmd        = create_command_buffer(ctx.transferPool);
+        submission.graphicCmd         = create_command_buffer(ctx.graphicPool);
+        submission.ownershipSemaphore = create_semaphore();
+        submission.fence              = create_fence(false);
+    }
+    ctx.inFlight.push_back(submission);
+    return ctx.inFlight.back();
+}
+
+UploadTicket Device::submit_transfer(TransferContext::Submission& submission, bool needsGraphicStage) {
+    PROFILING_EVENT()
+    submission.ticket = ++m_transferContext.lastTicket;
+
+    if (!needsGraphicStage)
+    {
+        submission.transferCmd.submit(submission.fence);
+        return submission.ticket;
+    }
+
+    submission.transferCmd.submit({}, {}, {submission.ownershipSemaphore});
+
+    // Graphic queue waits for the copies before acquiring the resources
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo         submitInfo = Init::submit_info(&submission.graphicCmd.handle);
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.pWaitSemaphores      = &submission.ownershipSemaphore.handle;
+    submitInfo.pWaitDstStageMask    = &waitStage;
+    VK_CHECK(vkQueueSubmit(m_queues[QueueType::GRAPHIC_QUEUE], 1, &submitInfo, submission.fence.handle));
+
+    return submission.ticket;
 }
 
 void Device::UploadContext::immediate_submit(std::function<void(CommandBuffer cmd)>&& function) {
 
+    // Work that depends on previously batched transfers (e.g. BLAS builds) must see them finished
+    if (batchDepth > 0)
+        submit_pending();
+
     commandBuffer.begin();
 
     function(commandBuffer);
@@ -948,9 +1492,70 @@ void Device::UploadContext::immediate_submit(std::function<void(CommandBuffer cm
     uploadFence.reset();
 
     commandPool.reset();
+    release_staging();
+
+    // Retake the batch where it was
+    if (batchDepth > 0)
+        commandBuffer.begin();
+}
+
+void Device::UploadContext::submit_pending() {
+    PROFILING_EVENT()
+    if (commandBuffer.isRecording)
+    {
+        commandBuffer.end();
+        if (pendingCopies > 0)
+        {
+            commandBuffer.submit(uploadFence);
+
+            uploadFence.wait(9999999999);
+            uploadFence.reset();
+        }
+        commandPool.reset();
+    }
+    release_staging();
+}
+
+void Device::UploadContext::release_staging() {
+    // Staging memory can be safely reused now
+    for (Buffer& b : overflowBuffers)
+        b.cleanup();
+    overflowBuffers.clear();
+    stagingOffset = 0;
+    pendingCopies = 0;
+}
+
+void Device::UploadContext::flush() {
+    submit_pending();
+    if (batchDepth > 0)
+        commandBuffer.begin();
+}
+
+void Device::TransferContext::cleanup() {
+    for (std::vector<Submission>* list : {&inFlight, &available})
+    {
+        for (Submission& submission : *list)
+        {
+            submission.staging.cleanup();
+            submission.ownershipSemaphore.cleanup();
+            submission.fence.cleanup();
+        }
+        list->clear();
+    }
+    transferPool.cleanup();
+    graphicPool.cleanup();
 }
 
 void Device::UploadContext::cleanup() {
+    if (stagingData)
+    {
+        vmaUnmapMemory(stagingBuffer.allocator, stagingBuffer.allocation);
+        stagingData = nullptr;
+    }
+    stagingBuffer.cleanup();
+    for (Buffer& b : overflowBuffers)
+        b.cleanup();
+    overflowBuffers.clear();
     uploadFence.cleanup();
     commandPool.cleanup();
 }
@@ -6,6 +6,35 @@ namespace Graphics {
 
 bool Frame::guiEnabled = false;
 
+CommandBuffer& Frame::get_secondary_command_buffer(uint32_t worker) {
+    WorkerCommands& commands = workerCommands[worker];
+    if (commands.usedBuffers == commands.secondaryBuffers.size())
+        commands.secondaryBuffers.push_back(commands.pool.allocate_command_buffer(1, COMMAND_BUFFER_LEVEL_SECONDARY));
+    return commands.secondaryBuffers[commands.usedBuffers++];
+}
+
+void Frame::reset_worker_commands() {
+    for (WorkerCommands& commands : workerCommands)
+    {
+        if (commands.usedBuffers == 0)
+            continue;
+        commands.pool.reset();
+        for (CommandBuffer& cmd : commands.secondaryBuffers)
+            cmd.isRecording = false;
+        commands.usedBuffers = 0;
+    }
+}
+
+uint32_t Frame::get_skipped_binds() const {
+    uint32_t skipped = commandBuffer.get_skipped_binds();
+    for (const WorkerCommands& commands : workerCommands)
+    {
+        for (uint32_t i = 0; i < commands.usedBuffers; i++)
+            skipped += commands.secondaryBuffers[i].get_skipped_binds();
+    }
+    return skipped;
+}
+
 void Frame::cleanup() {
     for (Buffer& buffer : uniformBuffers)
     {
@@ -13,6 +42,12 @@ void Frame::cleanup() {
     }
     commandPool.cleanup();
     computeCommandPool.cleanup();
+    for (WorkerCommands& commands : workerCommands)
+    {
+        commands.pool.cleanup();
+        commands.secondaryBuffers.clear();
+    }
+    workerCommands.clear();
     renderFence.cleanup();
     renderSemaphore.cleanup();
     presentSemaphore.cleanup();
@@ -40,7 +40,12 @@ void Image::cleanup(bool destroySampler) {
         vkDestroyImageView(device, view, nullptr);
         view = VK_NULL_HANDLE;
     }
-    if (handle && memory)
+    if (handle && aliasedMemory)
+    {
+        // Memory belongs to whoever aliased it
+        vkDestroyImage(device, handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    } else if (handle && memory)
     {
         vmaDestroyImage(memory, handle, allocation);
         handle = VK_NULL_HANDLE;
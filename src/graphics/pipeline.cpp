@@ -40,6 +40,7 @@ void PipelineBuilder::build_pipeline_layout(VkPipelineLayout& layout,
 void PipelineBuilder::build_graphic_pipeline(VkPipeline&                                  pipeline,
                                              VkPipelineLayout&                            layout,
                                              VkDevice                                     device,
+                                             VkPipelineCache                              cache,
                                              VkRenderPass                                 renderPass,
                                              VkExtent2D                                   extent,
                                              GraphicPipelineSettings&                     settings,
@@ -49,16 +50,19 @@ void PipelineBuilder::build_graphic_pipeline(VkPipeline&
     VkPipelineVertexInputStateCreateInfo   vertexInputInfo = Init::vertex_input_state_create_info();
     VkPipelineInputAssemblyStateCreateInfo inputAssembly   = Init::input_assembly_create_info(settings.topology);
 
-    auto bindingDescription                       = Vertex::getBindingDescription();
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions    = &bindingDescription;
+    const bool POSITION_ONLY = !settings.attributes[VertexAttributeType::NORMAL_ATTRIBUTE] && !settings.attributes[VertexAttributeType::TANGENT_ATTRIBUTE] &&
+                               !settings.attributes[VertexAttributeType::UV_ATTRIBUTE] && !settings.attributes[VertexAttributeType::COLOR_ATTRIBUTE];
+    auto bindingDescriptions                      = Vertex::getBindingDescriptions(settings.vertexLayout, POSITION_ONLY);
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions    = bindingDescriptions.data();
 
     auto attributeDescriptions =
         Vertex::getAttributeDescriptions(settings.attributes[VertexAttributeType::POSITION_ATTRIBUTE],
                                          settings.attributes[VertexAttributeType::NORMAL_ATTRIBUTE],
                                          settings.attributes[VertexAttributeType::TANGENT_ATTRIBUTE],
                                          settings.attributes[VertexAttributeType::UV_ATTRIBUTE],
-                                         settings.attributes[VertexAttributeType::COLOR_ATTRIBUTE]);
+                                         settings.attributes[VertexAttributeType::COLOR_ATTRIBUTE],
+                                         settings.vertexLayout);
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
     vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
 
@@ -126,7 +130,7 @@ void PipelineBuilder::build_graphic_pipeline(VkPipeline&
     pipelineInfo.subpass            = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
     {
         throw VKFW_Exception("Failed to create Grahic "
                              "Pipeline");
@@ -135,6 +139,7 @@ void PipelineBuilder::build_graphic_pipeline(VkPipeline&
 void PipelineBuilder::build_compute_pipeline(VkPipeline&                     pipeline,
                                              VkPipelineLayout&               layout,
                                              VkDevice                        device,
+                                             VkPipelineCache                 cache,
                                              VkPipelineShaderStageCreateInfo computeStage) {
 
     VkComputePipelineCreateInfo pipelineInfo = {};
@@ -142,7 +147,7 @@ void PipelineBuilder::build_compute_pipeline(VkPipeline&                     pip
     pipelineInfo.stage                       = computeStage;
     pipelineInfo.layout                      = layout;
 
-    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    if (vkCreateComputePipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
     {
         throw VKFW_Exception("Failed to create compute pipeline!");
     }
@@ -25,5 +25,8 @@ void Fence::wait(uint64_t timeout) {
     if (handle)
         VK_CHECK(vkWaitForFences(device, 1, &handle, VK_TRUE, timeout));
 }
+bool Fence::is_signaled() const {
+    return handle && vkGetFenceStatus(device, handle) == VK_SUCCESS;
+}
 } // namespace Graphics
 VULKAN_ENGINE_NAMESPACE_END
\ No newline at end of file
@@ -4,6 +4,70 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 
 namespace Graphics {
 
+// Bump when the compile options below change, so entries compiled with the old ones miss
+#define SPIRV_CACHE_VERSION 1
+#define SPIRV_MAGIC_NUMBER 0x07230203
+
+bool        ShaderSource::cacheEnabled   = true;
+std::string ShaderSource::cacheDirectory = ""; // Resolved on use, resource path might not be initialized yet
+
+static std::filesystem::path get_cache_directory() {
+    return ShaderSource::cacheDirectory.empty() ? std::filesystem::path(GET_RESOURCE_PATH("shaders/.cache/"))
+                                                : std::filesystem::path(ShaderSource::cacheDirectory);
+}
+static std::filesystem::path get_cache_path(const std::string& src, shaderc_shader_kind kind, shaderc_optimization_level optimization) {
+    const uint32_t options[] = {SPIRV_CACHE_VERSION,
+                                static_cast<uint32_t>(kind),
+                                static_cast<uint32_t>(optimization),
+                                static_cast<uint32_t>(shaderc_env_version_vulkan_1_3),
+                                static_cast<uint32_t>(shaderc_spirv_version_1_6)};
+    uint64_t       key       = Utils::hash_bytes(src.data(), src.size(), Utils::hash_bytes(options, sizeof(options)));
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+    return get_cache_directory() / name;
+}
+static bool read_cache_entry(const std::filesystem::path& path, std::vector<uint32_t>& spirv) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size < sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+        return false;
+
+    spirv.resize(size / sizeof(uint32_t));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(spirv.data()), size) || spirv[0] != SPIRV_MAGIC_NUMBER)
+    {
+        spirv.clear();
+        return false;
+    }
+    return true;
+}
+static void write_cache_entry(const std::filesystem::path& path, const std::vector<uint32_t>& spirv) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // Written aside and renamed, so a concurrent reader never sees half an entry
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return;
+        file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tmpPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, error);
+    if (error)
+        std::filesystem::remove(tmpPath, error);
+}
+
 ShaderStage ShaderSource::create_shader_stage(VkDevice device, VkShaderStageFlagBits stageType, const std::vector<uint32_t> code) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -70,10 +134,11 @@ ShaderSource ShaderSource::read_file(const std::string& filePath) {
             std::string fullIncludePath = scriptsPath + includeFile;
 
             std::string includeContent = Utils::read_file(fullIncludePath);
-            ss[(int)type] << includeContent << '\n';
+            if (type != StageType::NONE)
+                ss[(int)type] << includeContent << '\n';
         }
         // FILL THE ACTUAL STAGE CODE
-        else
+        else if (type != StageType::NONE)
         {
             ss[(int)type] << line << '\n';
         }
@@ -83,6 +148,16 @@ ShaderSource ShaderSource::read_file(const std::string& filePath) {
 
 std::vector<uint32_t>
 ShaderSource::compile_shader(const std::string src, const std::string shaderName, shaderc_shader_kind kind, shaderc_optimization_level optimization) {
+    std::filesystem::path cachePath;
+    std::vector<uint32_t> spirv;
+    if (cacheEnabled)
+    {
+        cachePath = get_cache_path(src, kind, optimization);
+        // Truncated or corrupted entries are compiled again and overwritten
+        if (read_cache_entry(cachePath, spirv))
+            return spirv;
+    }
+
     shaderc::Compiler       compiler;
     shaderc::CompileOptions options;
     options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
@@ -90,21 +165,95 @@ ShaderSource::compile_shader(const std::string src, const std::string shaderName
 
     options.SetOptimizationLevel(optimization);
 
+    // Stage macros, so shared includes can adapt their interface to the stage being compiled
+    switch (kind)
+    {
+    case shaderc_vertex_shader:
+        options.AddMacroDefinition("VERTEX_STAGE");
+        break;
+    case shaderc_geometry_shader:
+        options.AddMacroDefinition("GEOMETRY_STAGE");
+        break;
+    case shaderc_tess_control_shader:
+        options.AddMacroDefinition("TESS_CONTROL_STAGE");
+        break;
+    case shaderc_tess_evaluation_shader:
+        options.AddMacroDefinition("TESS_EVALUATION_STAGE");
+        break;
+    case shaderc_fragment_shader:
+        options.AddMacroDefinition("FRAGMENT_STAGE");
+        break;
+    case shaderc_compute_shader:
+        options.AddMacroDefinition("COMPUTE_STAGE");
+        break;
+    default:
+        break;
+    }
+
     shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(src, kind, shaderName.c_str(), options);
     if (result.GetCompilationStatus() != shaderc_compilation_status_success)
     {
         Logger::log(LogLevel::Error, Logger::format_with_tag("[Shader]", "\033[35m", "Compile Error - " + result.GetErrorMessage()));
+        return {result.cbegin(), result.cend()};
     }
 
-    std::vector<uint32_t> spirv = {result.cbegin(), result.cend()};
+    spirv = {result.cbegin(), result.cend()};
+    if (cacheEnabled && !spirv.empty())
+        write_cache_entry(cachePath, spirv);
 
     return spirv;
 }
 
+uint32_t ShaderSource::prewarm_cache(const std::string& shaderDirectory, shaderc_optimization_level optimization) {
+    const std::filesystem::path includePath(GET_RESOURCE_PATH("shaders/include"));
+
+    uint32_t        stages = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(shaderDirectory, error))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".glsl")
+            continue;
+        // Includes are only compiled as part of the shaders using them
+        if (std::filesystem::equivalent(entry.path().parent_path(), includePath, error))
+            continue;
+
+        ShaderSource shader = read_file(entry.path().string());
+
+        std::vector<std::pair<std::string*, shaderc_shader_kind>> sources = {{&shader.vertSource, shaderc_vertex_shader},
+                                                                             {&shader.fragSource, shaderc_fragment_shader},
+                                                                             {&shader.geomSource, shaderc_geometry_shader},
+                                                                             {&shader.tessControlSource, shaderc_tess_control_shader},
+                                                                             {&shader.tessEvalSource, shaderc_tess_evaluation_shader},
+                                                                             {&shader.computeSource, shaderc_compute_shader}};
+        for (const auto& [source, kind] : sources)
+        {
+            if (source->empty())
+                continue;
+            compile_shader(*source, shader.name, kind, optimization);
+            stages++;
+        }
+    }
+    LOG_DEBUG("SPIR-V cache prewarmed with " + std::to_string(stages) + " shader stages");
+    return stages;
+}
+
+void ShaderSource::clear_cache() {
+    std::error_code error;
+    std::filesystem::remove_all(get_cache_directory(), error);
+}
+
 void GraphicShaderPass::build_shader_stages(shaderc_optimization_level optimization) {
     if (filePath == "")
         return;
     auto shader = ShaderSource::read_file(filePath);
+    // Vertex shaders decode the quantized attributes under this define
+    if (graphicSettings.vertexLayout == PACKED_VERTEX_LAYOUT && shader.vertSource != "")
+    {
+        size_t versionLine = shader.vertSource.find("#version");
+        size_t insertAt    = versionLine == std::string::npos ? 0 : shader.vertSource.find('\n', versionLine);
+        insertAt           = insertAt == std::string::npos ? shader.vertSource.size() : insertAt + 1;
+        shader.vertSource.insert(insertAt, "#define PACKED_VERTEX\n");
+    }
 
     if (shader.vertSource != "")
     {
@@ -155,7 +304,14 @@ void ComputeShaderPass::build_shader_stages(shaderc_optimization_level optimizat
     }
 }
 
-void GraphicShaderPass::build(DescriptorPool& descriptorManager) {
+GraphicShaderPass* GraphicShaderPass::create_packed_variant() const {
+    GraphicShaderPass* variant            = new GraphicShaderPass(device, *renderpass, extent, filePath);
+    variant->settings                     = settings;
+    variant->graphicSettings              = graphicSettings;
+    variant->graphicSettings.vertexLayout = PACKED_VERTEX_LAYOUT;
+    return variant;
+}
+void GraphicShaderPass::build(DescriptorPool& descriptorManager, VkPipelineCache pipelineCache) {
     PipelineBuilder::build_pipeline_layout(pipelineLayout, device, descriptorManager, settings);
 
     std::vector<VkPipelineShaderStageCreateInfo> stages;
@@ -163,14 +319,14 @@ void GraphicShaderPass::build(DescriptorPool& descriptorManager) {
     {
         stages.push_back(Init::pipeline_shader_stage_create_info(stage.stage, stage.shaderModule));
     }
-    PipelineBuilder::build_graphic_pipeline(pipeline, pipelineLayout, device, renderpass->handle, extent, graphicSettings, stages);
+    PipelineBuilder::build_graphic_pipeline(pipeline, pipelineLayout, device, pipelineCache, renderpass->handle, extent, graphicSettings, stages);
 }
-void ComputeShaderPass::build(DescriptorPool& descriptorManager) {
+void ComputeShaderPass::build(DescriptorPool& descriptorManager, VkPipelineCache pipelineCache) {
 
     PipelineBuilder::build_pipeline_layout(pipelineLayout, device, descriptorManager, settings);
 
     PipelineBuilder::build_compute_pipeline(
-        pipeline, pipelineLayout, device, Init::pipeline_shader_stage_create_info(computeStage.stage, computeStage.shaderModule));
+        pipeline, pipelineLayout, device, pipelineCache, Init::pipeline_shader_stage_create_info(computeStage.stage, computeStage.shaderModule));
 }
 void GraphicShaderPass::cleanup() {
 
@@ -262,6 +262,16 @@ Booter::QueueFamilyIndices Booter::find_queue_families(VkPhysicalDevice device,
 
         i++;
     }
+    // DEDICATED TRANSFER SUPPORT (DMA engines). Left empty if the GPU has none
+    for (uint32_t j = 0; j < queueFamilyCount; j++)
+    {
+        const VkQueueFlags flags = queueFamilies[j].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT))
+        {
+            indices.transferFamily = j;
+            break;
+        }
+    }
 
     return indices;
 }
@@ -281,15 +291,28 @@ VkDevice Booter::create_logical_device(std::unordered_map<QueueType, VkQueue>& q
         uniqueQueueFamilies = {queueFamilies.graphicsFamily.value(), queueFamilies.presentFamily.value(), queueFamilies.computeFamily.value()};
     else // If headless
         uniqueQueueFamilies = {queueFamilies.graphicsFamily.value(), queueFamilies.computeFamily.value()};
+    if (queueFamilies.transferFamily.has_value())
+        uniqueQueueFamilies.insert(queueFamilies.transferFamily.value());
+
+    // Without a dedicated transfer family, try to get a second queue from the graphics family for async uploads
+    uint32_t graphicsQueueCount = 1;
+    if (!queueFamilies.transferFamily.has_value())
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> familyProperties(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, familyProperties.data());
+        graphicsQueueCount = std::min(familyProperties[queueFamilies.graphicsFamily.value()].queueCount, 2u);
+    }
 
-    float queuePriority = 1.0f;
+    float queuePriorities[2] = {1.0f, 1.0f};
     for (uint32_t queueFamily : uniqueQueueFamilies)
     {
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount       = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount       = queueFamily == queueFamilies.graphicsFamily.value() ? graphicsQueueCount : 1;
+        queueCreateInfo.pQueuePriorities = queuePriorities;
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
@@ -305,6 +328,10 @@ VkDevice Booter::create_logical_device(std::unordered_map<QueueType, VkQueue>& q
     if (Booter::is_device_extension_supported(gpu, "VK_NV_geometry_shader_passthrough"))
         enabledExtensions.push_back("VK_NV_geometry_shader_passthrough");
 
+    // GPU-driven passes issue vkCmdDrawIndexedIndirectCount
+    if (Booter::is_device_extension_supported(gpu, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
     VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
 
     if (Booter::is_device_extension_supported(gpu, "VK_EXT_extended_dynamic_state"))
@@ -421,6 +448,11 @@ VkDevice Booter::create_logical_device(std::unordered_map<QueueType, VkQueue>& q
     vkGetDeviceQueue(device, queueFamilies.computeFamily.value(), 0, &queues[QueueType::COMPUTE_QUEUE]);
     if (surface != VK_NULL_HANDLE)
         vkGetDeviceQueue(device, queueFamilies.presentFamily.value(), 0, &queues[QueueType::PRESENT_QUEUE]);
+    // Transfer queue: dedicated family, second graphics queue or, as last resort, the graphics queue itself
+    if (queueFamilies.transferFamily.has_value())
+        vkGetDeviceQueue(device, queueFamilies.transferFamily.value(), 0, &queues[QueueType::TRANSFER_QUEUE]);
+    else
+        vkGetDeviceQueue(device, queueFamilies.graphicsFamily.value(), graphicsQueueCount - 1, &queues[QueueType::TRANSFER_QUEUE]);
 
     return device;
 }
@@ -87,6 +87,8 @@ VkDescriptorType get(UniformDataType uniformDataType) {
         return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
     case UniformDataType::UNIFORM_STORAGE_IMAGE:
         return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    case UniformDataType::UNIFORM_STORAGE_BUFFER:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     default:
         throw std::invalid_argument("VKEngine error: Unknown UniformDataType");
     }
@@ -227,6 +229,8 @@ VkPipelineStageFlags get(PipelineStage stageFlags) {
         return VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
     case PipelineStage::STAGE_FRAGMENT_SHADER:
         return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    case PipelineStage::STAGE_DRAW_INDIRECT:
+        return VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
     default:
         throw std::invalid_argument("VKEngine error: Unknown PipelineStageFlags");
     }
@@ -255,6 +259,10 @@ VkAccessFlags get(AccessFlags accessFlags) {
         return VK_ACCESS_SHADER_WRITE_BIT;
     case AccessFlags::ACCESS_MEMORY_READ:
         return VK_ACCESS_MEMORY_READ_BIT;
+    case AccessFlags::ACCESS_INDIRECT_COMMAND_READ:
+        return VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    case AccessFlags::ACCESS_SHADER_READ_WRITE:
+        return VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
     default:
         throw std::invalid_argument("VKEngine error: Unknown AccessFlags");
     }
@@ -0,0 +1,115 @@
+#include <engine/graphics/vao.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Graphics {
+
+std::vector<VkVertexInputBindingDescription> Vertex::getBindingDescriptions(VertexLayout layout, bool positionOnly) {
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+
+    VkVertexInputBindingDescription mainBinding{};
+    mainBinding.binding   = 0;
+    mainBinding.stride    = layout == PACKED_VERTEX_LAYOUT ? sizeof(Vec3) : sizeof(Vertex);
+    mainBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindingDescriptions.push_back(mainBinding);
+
+    if (layout == PACKED_VERTEX_LAYOUT && !positionOnly)
+    {
+        VkVertexInputBindingDescription attributeBinding{};
+        attributeBinding.binding   = 1;
+        attributeBinding.stride    = sizeof(PackedVertex);
+        attributeBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindingDescriptions.push_back(attributeBinding);
+    }
+    return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription>
+Vertex::getAttributeDescriptions(bool position, bool normal, bool tangent, bool texCoord, bool color, VertexLayout layout) {
+    const bool PACKED = layout == PACKED_VERTEX_LAYOUT;
+
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    if (position)
+    {
+        VkVertexInputAttributeDescription posAtt{};
+        posAtt.binding  = 0;
+        posAtt.location = 0;
+        posAtt.format   = VK_FORMAT_R32G32B32_SFLOAT;
+        posAtt.offset   = PACKED ? 0 : offsetof(Vertex, pos);
+        attributeDescriptions.push_back(posAtt);
+    }
+    if (normal)
+    {
+        VkVertexInputAttributeDescription normalAtt{};
+        normalAtt.binding  = PACKED ? 1 : 0;
+        normalAtt.location = 1;
+        normalAtt.format   = PACKED ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        normalAtt.offset   = PACKED ? offsetof(PackedVertex, normal) : offsetof(Vertex, normal);
+        attributeDescriptions.push_back(normalAtt);
+    }
+    if (texCoord)
+    {
+        VkVertexInputAttributeDescription texCoordAtt{};
+        texCoordAtt.binding  = PACKED ? 1 : 0;
+        texCoordAtt.location = 2;
+        texCoordAtt.format   = PACKED ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+        texCoordAtt.offset   = PACKED ? offsetof(PackedVertex, texCoord) : offsetof(Vertex, texCoord);
+        attributeDescriptions.push_back(texCoordAtt);
+    }
+    if (tangent)
+    {
+        VkVertexInputAttributeDescription tangentAtt{};
+        tangentAtt.binding  = PACKED ? 1 : 0;
+        tangentAtt.location = 3;
+        tangentAtt.format   = PACKED ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        tangentAtt.offset   = PACKED ? offsetof(PackedVertex, tangent) : offsetof(Vertex, tangent);
+        attributeDescriptions.push_back(tangentAtt);
+    }
+    if (color)
+    {
+        VkVertexInputAttributeDescription colorAtt{};
+        colorAtt.binding  = PACKED ? 1 : 0;
+        colorAtt.location = 4;
+        colorAtt.format   = PACKED ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+        colorAtt.offset   = PACKED ? offsetof(PackedVertex, color) : offsetof(Vertex, color);
+        attributeDescriptions.push_back(colorAtt);
+    }
+
+    return attributeDescriptions;
+}
+
+namespace {
+// Octahedral mapping into [-1, 1]. Zero vectors map to the origin, which decodes as +Z
+uint32_t pack_direction(Vec3 v) {
+    float sum = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (sum <= 0.0f)
+        return glm::packSnorm2x16(Vec2(0.0f));
+    v /= sum;
+    Vec2 enc = Vec2(v.x, v.y);
+    if (v.z < 0.0f)
+        enc = (Vec2(1.0f) - Vec2(std::abs(enc.y), std::abs(enc.x))) * Vec2(enc.x >= 0.0f ? 1.0f : -1.0f, enc.y >= 0.0f ? 1.0f : -1.0f);
+    return glm::packSnorm2x16(enc);
+}
+// Vertices without tangent keep a zero one. Packed, it takes the (-1, -1) corner. The four corners all decode as -Z and the (1, 1)
+// one is what -Z encodes to, so directions that land on (-1, -1) are moved there
+uint32_t pack_tangent(Vec3 t) {
+    const uint32_t NO_TANGENT = glm::packSnorm2x16(Vec2(-1.0f));
+    if (std::abs(t.x) + std::abs(t.y) + std::abs(t.z) <= 0.0f)
+        return NO_TANGENT;
+    const uint32_t packed = pack_direction(t);
+    return packed != NO_TANGENT ? packed : glm::packSnorm2x16(Vec2(1.0f));
+}
+} // namespace
+
+PackedVertex PackedVertex::pack(const Vertex& v) {
+    PackedVertex packed;
+    packed.normal   = pack_direction(v.normal);
+    packed.tangent  = pack_tangent(v.tangent);
+    packed.texCoord = glm::packHalf2x16(v.texCoord);
+    packed.color    = glm::packUnorm4x8(Vec4(glm::clamp(v.color, Vec3(0.0f), Vec3(1.0f)), 1.0f));
+    return packed;
+}
+
+} // namespace Graphics
+
+VULKAN_ENGINE_NAMESPACE_END
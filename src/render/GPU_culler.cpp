@@ -0,0 +1,179 @@
+#include <engine/render/GPU_culler.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+void GPUCuller::setup( const ptr<Graphics::Device>& device, std::vector<Graphics::Frame>& frames, Mode mode ) {
+    m_device = device;
+    m_mode   = mode;
+
+    const uint32_t FRAMES = static_cast<uint32_t>( frames.size() );
+    m_descriptorPool      = m_device->create_descriptor_pool( 2 * FRAMES, 2 * FRAMES, 0, 6 * FRAMES, 0 );
+
+    // GLOBAL SET (camera and scene)
+    Graphics::LayoutBinding camBufferBinding( UNIFORM_BUFFER, SHADER_STAGE_COMPUTE, 0 );
+    Graphics::LayoutBinding sceneBufferBinding( UNIFORM_BUFFER, SHADER_STAGE_COMPUTE, 1 );
+    m_descriptorPool.set_layout( 0, { camBufferBinding, sceneBufferBinding } );
+    // DRAW SET (instances, draw records, commands, counts and visible instance lists)
+    Graphics::LayoutBinding instanceBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 0 );
+    Graphics::LayoutBinding drawBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 1 );
+    Graphics::LayoutBinding commandBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 2 );
+    Graphics::LayoutBinding countBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 3 );
+    Graphics::LayoutBinding instanceIDBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 4 );
+    Graphics::LayoutBinding instanceCountBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_COMPUTE, 5 );
+    m_descriptorPool.set_layout( 1, { instanceBinding, drawBinding, commandBinding, countBinding, instanceIDBinding, instanceCountBinding } );
+
+    m_frames.resize( frames.size() );
+    for ( size_t i = 0; i < frames.size(); i++ )
+    {
+        Graphics::Buffer& globalBuffer = frames[i].uniformBuffers[GLOBAL_BUFFER];
+        m_descriptorPool.allocate_descriptor_set( 0, &m_frames[i].globalDescriptor );
+        m_frames[i].globalDescriptor.update( &globalBuffer, sizeof( Core::Camera::GPUPayload ), 0, UNIFORM_BUFFER, 0 );
+        m_frames[i].globalDescriptor.update( &globalBuffer,
+                                             sizeof( Core::Scene::GPUPayload ),
+                                             m_device->pad_uniform_buffer_size( sizeof( Core::Camera::GPUPayload ) ),
+                                             UNIFORM_BUFFER,
+                                             1 );
+
+        m_descriptorPool.allocate_descriptor_set( 1, &m_frames[i].drawDescriptor );
+        m_frames[i].counts = m_device->create_buffer_VMA( ENGINE_MAX_DRAW_BUCKETS * sizeof( uint32_t ),
+                                                          BUFFER_USAGE_STORAGE_BUFFER | BUFFER_USAGE_INDIRECT_BUFFER | BUFFER_USAGE_TRANSFER_DST,
+                                                          VMA_MEMORY_USAGE_GPU_ONLY );
+        reserve_commands( m_frames[i], ENGINE_INITIAL_INSTANCES );
+    }
+
+    m_shaderPass = new Graphics::ComputeShaderPass( m_device->get_handle(), GET_RESOURCE_PATH( "shaders/culling/instance_culling.glsl" ) );
+    m_shaderPass->settings.descriptorSetLayoutIDs = { { 0, true }, { 1, true } };
+    m_shaderPass->settings.pushConstants          = { Graphics::PushConstant( SHADER_STAGE_COMPUTE, 6 * sizeof( uint32_t ) ) };
+    m_shaderPass->build_shader_stages();
+    m_shaderPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
+}
+
+void GPUCuller::reserve_commands( FrameResources& resources, size_t recordCount ) {
+    const size_t STRIDE = sizeof( VkDrawIndexedIndirectCommand );
+    if ( resources.commands.handle && resources.commands.size >= recordCount * STRIDE )
+        return;
+
+    size_t capacity = std::max( resources.commands.size / STRIDE, (size_t)ENGINE_INITIAL_INSTANCES );
+    while ( capacity < recordCount )
+        capacity *= 2;
+
+    // Frame fence has been waited, so this frame's buffers are not in use. New buffers first, so descriptors see new handles
+    Graphics::Buffer commands = m_device->create_buffer_VMA(
+        capacity * STRIDE, BUFFER_USAGE_STORAGE_BUFFER | BUFFER_USAGE_INDIRECT_BUFFER, VMA_MEMORY_USAGE_GPU_ONLY, (uint32_t)STRIDE );
+    Graphics::Buffer instanceIDs =
+        m_device->create_buffer_VMA( capacity * sizeof( uint32_t ), BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_GPU_ONLY, sizeof( uint32_t ) );
+    Graphics::Buffer instanceCounts = m_device->create_buffer_VMA(
+        capacity * sizeof( uint32_t ), BUFFER_USAGE_STORAGE_BUFFER | BUFFER_USAGE_TRANSFER_DST, VMA_MEMORY_USAGE_GPU_ONLY, sizeof( uint32_t ) );
+    resources.commands.cleanup();
+    resources.instanceIDs.cleanup();
+    resources.instanceCounts.cleanup();
+    resources.commands       = commands;
+    resources.instanceIDs    = instanceIDs;
+    resources.instanceCounts = instanceCounts;
+}
+
+void GPUCuller::cull( Graphics::Frame& currentFrame, bool frustumCulling, uint64_t lightMask ) {
+    PROFILING_EVENT()
+    const uint32_t recordCount = currentFrame.drawRecordCount;
+    if ( currentFrame.drawBuckets.empty() || recordCount == 0 )
+        return;
+
+    FrameResources&         resources = m_frames[currentFrame.index];
+    Graphics::CommandBuffer cmd       = currentFrame.commandBuffer;
+
+    reserve_commands( resources, recordCount );
+    // Instance and draw tables might have grown this frame
+    resources.drawDescriptor.update(
+        &currentFrame.uniformBuffers[INSTANCE_BUFFER], currentFrame.uniformBuffers[INSTANCE_BUFFER].size, 0, UNIFORM_STORAGE_BUFFER, 0 );
+    resources.drawDescriptor.update(
+        &currentFrame.uniformBuffers[DRAW_BUFFER], currentFrame.uniformBuffers[DRAW_BUFFER].size, 0, UNIFORM_STORAGE_BUFFER, 1 );
+    resources.drawDescriptor.update( &resources.commands, resources.commands.size, 0, UNIFORM_STORAGE_BUFFER, 2 );
+    resources.drawDescriptor.update( &resources.counts, resources.counts.size, 0, UNIFORM_STORAGE_BUFFER, 3 );
+    resources.drawDescriptor.update( &resources.instanceIDs, resources.instanceIDs.size, 0, UNIFORM_STORAGE_BUFFER, 4 );
+    resources.drawDescriptor.update( &resources.instanceCounts, resources.instanceCounts.size, 0, UNIFORM_STORAGE_BUFFER, 5 );
+
+    // Reset bucket and group counters
+    cmd.fill_buffer( resources.counts, 0, resources.counts.size );
+    cmd.fill_buffer( resources.instanceCounts, 0, recordCount * sizeof( uint32_t ) );
+    cmd.memory_barrier( ACCESS_TRANSFER_WRITE, ACCESS_SHADER_READ_WRITE, STAGE_TRANSFER, STAGE_COMPUTE_SHADER );
+
+    cmd.bind_shaderpass( *m_shaderPass );
+    cmd.bind_descriptor_set( resources.globalDescriptor, 0, *m_shaderPass, {}, BINDING_TYPE_COMPUTE );
+    cmd.bind_descriptor_set( resources.drawDescriptor, 1, *m_shaderPass, {}, BINDING_TYPE_COMPUTE );
+
+    // Without frustum culling the mode still selects which records are drawn
+    const uint32_t WORK_GROUP_SIZE = 64;
+    uint32_t       pushData[6]     = { recordCount,
+                                       static_cast<uint32_t>( m_mode ),
+                                       frustumCulling ? 1u : 0u,
+                                       0u,
+                                       static_cast<uint32_t>( lightMask ),
+                                       static_cast<uint32_t>( lightMask >> 32 ) };
+    cmd.push_constants( *m_shaderPass, SHADER_STAGE_COMPUTE, pushData, sizeof( pushData ) );
+    cmd.dispatch_compute( { ( recordCount + WORK_GROUP_SIZE - 1 ) / WORK_GROUP_SIZE, 1, 1 } );
+
+    // Every instance group knows its visible instances. Their first records emit the instanced commands
+    cmd.memory_barrier( ACCESS_SHADER_WRITE, ACCESS_SHADER_READ_WRITE, STAGE_COMPUTE_SHADER, STAGE_COMPUTE_SHADER );
+    pushData[3] = 1u;
+    cmd.push_constants( *m_shaderPass, SHADER_STAGE_COMPUTE, pushData, sizeof( pushData ) );
+    cmd.dispatch_compute( { ( recordCount + WORK_GROUP_SIZE - 1 ) / WORK_GROUP_SIZE, 1, 1 } );
+
+    // Commands and counts are consumed by the indirect draws, instance lists by the vertex shaders
+    cmd.memory_barrier( ACCESS_SHADER_WRITE, ACCESS_INDIRECT_COMMAND_READ, STAGE_COMPUTE_SHADER, STAGE_DRAW_INDIRECT );
+    cmd.memory_barrier( ACCESS_SHADER_WRITE, ACCESS_SHADER_READ, STAGE_COMPUTE_SHADER, STAGE_ALL_GRAPHICS );
+}
+
+void GPUCuller::draw( Graphics::Frame& currentFrame, const Graphics::DrawBucket& bucket, const Graphics::VAO& arenaVAO ) {
+    FrameResources& resources = m_frames[currentFrame.index];
+    currentFrame.commandBuffer.draw_geometry_indirect( arenaVAO,
+                                                        resources.commands,
+                                                        bucket.firstCommand * sizeof( VkDrawIndexedIndirectCommand ),
+                                                        resources.counts,
+                                                        ( &bucket - currentFrame.drawBuckets.data() ) * sizeof( uint32_t ),
+                                                        bucket.maxCommands );
+}
+
+void GPUCuller::cleanup() {
+    for ( FrameResources& resources : m_frames )
+    {
+        resources.commands.cleanup();
+        resources.counts.cleanup();
+        resources.instanceIDs.cleanup();
+        resources.instanceCounts.cleanup();
+    }
+    m_frames.clear();
+    if ( m_shaderPass )
+    {
+        m_shaderPass->cleanup();
+        delete m_shaderPass;
+        m_shaderPass = nullptr;
+    }
+    m_descriptorPool.cleanup();
+}
+
+uint32_t GPUCuller::encode_state( Core::Topology topology, CullingMode culling, bool depthTest, bool depthWrite, VertexLayout layout ) {
+    uint32_t cullBits = culling == FRONT_CULLING ? 1u : culling == BACK_CULLING ? 2u : 0u;
+    return ( static_cast<uint32_t>( topology ) & 0x3 ) | ( cullBits << 2 ) | ( ( depthTest ? 1u : 0u ) << 4 ) | ( ( depthWrite ? 1u : 0u ) << 5 ) |
+           ( ( static_cast<uint32_t>( layout ) & 0x1 ) << 6 );
+}
+
+Core::Topology GPUCuller::get_topology( uint32_t stateKey ) {
+    return static_cast<Core::Topology>( stateKey & 0x3 );
+}
+
+VertexLayout GPUCuller::get_vertex_layout( uint32_t stateKey ) {
+    return static_cast<VertexLayout>( ( stateKey >> 6 ) & 0x1 );
+}
+
+void GPUCuller::apply_state( Graphics::CommandBuffer& cmd, uint32_t stateKey ) {
+    uint32_t cullBits = ( stateKey >> 2 ) & 0x3;
+    cmd.set_cull_mode( cullBits == 1u ? FRONT_CULLING : cullBits == 2u ? BACK_CULLING : NO_CULLING );
+    cmd.set_depth_test_enable( ( stateKey >> 4 ) & 0x1 );
+    cmd.set_depth_write_enable( ( stateKey >> 5 ) & 0x1 );
+}
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
@@ -0,0 +1,248 @@
+#include <engine/render/GPU_geometry_arena.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+void RangeAllocator::reset( uint32_t capacity ) {
+    m_freeBlocks.clear();
+    m_capacity = capacity;
+    m_used     = 0;
+    if ( capacity > 0 )
+        m_freeBlocks[0] = capacity;
+}
+
+uint32_t RangeAllocator::allocate( uint32_t size ) {
+    if ( size == 0 )
+        return INVALID_OFFSET;
+
+    // Best fit keeps the big blocks for big meshes
+    auto best = m_freeBlocks.end();
+    for ( auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it )
+    {
+        if ( it->second >= size && ( best == m_freeBlocks.end() || it->second < best->second ) )
+        {
+            best = it;
+            if ( it->second == size )
+                break;
+        }
+    }
+    if ( best == m_freeBlocks.end() )
+        return INVALID_OFFSET;
+
+    uint32_t offset    = best->first;
+    uint32_t remaining = best->second - size;
+    m_freeBlocks.erase( best );
+    if ( remaining > 0 )
+        m_freeBlocks[offset + size] = remaining;
+
+    m_used += size;
+    return offset;
+}
+
+void RangeAllocator::free( uint32_t offset, uint32_t size ) {
+    if ( size == 0 || offset == INVALID_OFFSET )
+        return;
+
+    auto next = m_freeBlocks.lower_bound( offset );
+    // Merge with the previous block
+    if ( next != m_freeBlocks.begin() )
+    {
+        auto prev = std::prev( next );
+        if ( prev->first + prev->second == offset )
+        {
+            offset = prev->first;
+            size += prev->second;
+            m_freeBlocks.erase( prev );
+        }
+    }
+    // Merge with the next block
+    if ( next != m_freeBlocks.end() && offset + size == next->first )
+    {
+        size += next->second;
+        m_freeBlocks.erase( next );
+    }
+    m_freeBlocks[offset] = size;
+    m_used -= std::min( m_used, size );
+}
+
+void RangeAllocator::grow( uint32_t newCapacity ) {
+    if ( newCapacity <= m_capacity )
+        return;
+    uint32_t oldCapacity = m_capacity;
+    m_capacity           = newCapacity;
+    // Releasing the new tail merges it with a free block ending at the old capacity
+    m_used += newCapacity - oldCapacity;
+    free( oldCapacity, newCapacity - oldCapacity );
+}
+
+uint32_t RangeAllocator::get_largest_free_block() const {
+    uint32_t largest = 0;
+    for ( const auto& [offset, size] : m_freeBlocks )
+        largest = std::max( largest, size );
+    return largest;
+}
+
+float RangeAllocator::get_fragmentation() const {
+    uint32_t freeSpace = m_capacity - m_used;
+    if ( freeSpace == 0 )
+        return 0.0f;
+    return 1.0f - static_cast<float>( get_largest_free_block() ) / static_cast<float>( freeSpace );
+}
+
+void GeometryArena::init( const ptr<Graphics::Device>& device, uint32_t vertexCapacity, uint32_t indexCapacity, VertexLayout layout ) {
+    m_device     = device;
+    m_vao.layout = layout;
+    m_vertices.reset( 0 );
+    m_indices.reset( 0 );
+    // Without an initial capacity buffers are created along with the first geometry
+    if ( vertexCapacity > 0 || indexCapacity > 0 )
+        reserve( vertexCapacity, indexCapacity );
+    m_vao.loadedOnGPU = true;
+}
+
+void GeometryArena::cleanup() {
+    m_vao.vbo.cleanup();
+    m_vao.ibo.cleanup();
+    m_vao.attributeBuffer.cleanup();
+    m_vao.loadedOnGPU = false;
+    m_vertices.reset( 0 );
+    m_indices.reset( 0 );
+    m_geometries = 0;
+}
+
+void GeometryArena::reserve( uint32_t vertexCount, uint32_t indexCount ) {
+    uint32_t vertexCapacity = m_vertices.get_capacity();
+    uint32_t indexCapacity  = m_indices.get_capacity();
+    if ( m_vao.vbo.handle && vertexCapacity >= vertexCount && indexCapacity >= indexCount )
+        return;
+
+    uint32_t newVertexCapacity = std::max( vertexCapacity, (uint32_t)ENGINE_INITIAL_ARENA_VERTICES );
+    while ( newVertexCapacity < vertexCount )
+        newVertexCapacity *= 2;
+    uint32_t newIndexCapacity = std::max( indexCapacity, (uint32_t)ENGINE_INITIAL_ARENA_INDICES );
+    while ( newIndexCapacity < indexCount )
+        newIndexCapacity *= 2;
+
+    const bool       PACKED = m_vao.layout == PACKED_VERTEX_LAYOUT;
+    const size_t     STRIDE = get_vertex_stride();
+    BufferUsageFlags usage  = BUFFER_USAGE_TRANSFER_SRC | BUFFER_USAGE_TRANSFER_DST;
+    Graphics::Buffer vbo    = m_device->create_buffer_VMA( newVertexCapacity * STRIDE, BUFFER_USAGE_VERTEX_BUFFER | usage, VMA_MEMORY_USAGE_GPU_ONLY );
+    Graphics::Buffer ibo =
+        m_device->create_buffer_VMA( newIndexCapacity * sizeof( uint32_t ), BUFFER_USAGE_INDEX_BUFFER | usage, VMA_MEMORY_USAGE_GPU_ONLY );
+    Graphics::Buffer attributes = {};
+    if ( PACKED )
+        attributes = m_device->create_buffer_VMA(
+            newVertexCapacity * sizeof( Graphics::PackedVertex ), BUFFER_USAGE_VERTEX_BUFFER | usage, VMA_MEMORY_USAGE_GPU_ONLY );
+
+    if ( m_vao.vbo.handle )
+    {
+        // Live ranges can be anywhere, so the whole old buffers are moved
+        m_device->copy_buffer( m_vao.vbo, vbo, vertexCapacity * STRIDE );
+        m_device->copy_buffer( m_vao.ibo, ibo, indexCapacity * sizeof( uint32_t ) );
+        if ( PACKED )
+            m_device->copy_buffer( m_vao.attributeBuffer, attributes, vertexCapacity * sizeof( Graphics::PackedVertex ) );
+        // Copies have to land and frames in flight might still be reading the old buffers
+        m_device->flush_uploads();
+        m_device->wait_idle();
+        m_vao.vbo.cleanup();
+        m_vao.ibo.cleanup();
+        m_vao.attributeBuffer.cleanup();
+
+        GeometryArenaStats stats = get_stats();
+        LOG_DEBUG( "Geometry arena grown to " + std::to_string( newVertexCapacity ) + " vertices / " + std::to_string( newIndexCapacity ) +
+                  " indices. Fragmentation: " + std::to_string( stats.vertexFragmentation ) + " (vertices) " +
+                  std::to_string( stats.indexFragmentation ) + " (indices)" );
+    }
+    m_vao.vbo             = vbo;
+    m_vao.ibo             = ibo;
+    m_vao.attributeBuffer = attributes;
+    m_vertices.grow( newVertexCapacity );
+    m_indices.grow( newIndexCapacity );
+}
+
+bool GeometryArena::allocate( Core::Geometry* const g ) {
+    PROFILING_EVENT()
+    Graphics::VertexArrays* rd = get_VAO( g );
+    if ( rd->inArena )
+        return true;
+    if ( !rd->loadedOnGPU || rd->vertexCount == 0 || rd->layout != m_vao.layout )
+        return false;
+
+    uint32_t indexCount   = rd->indexCount > 0 ? rd->indexCount + rd->lodIndexCount : rd->vertexCount;
+    uint32_t vertexOffset = m_vertices.allocate( rd->vertexCount );
+    uint32_t firstIndex   = m_indices.allocate( indexCount );
+    if ( vertexOffset == RangeAllocator::INVALID_OFFSET || firstIndex == RangeAllocator::INVALID_OFFSET )
+    {
+        // Growing the exhausted range leaves a free tail at least as big as the request
+        reserve( m_vertices.get_capacity() + ( vertexOffset == RangeAllocator::INVALID_OFFSET ? rd->vertexCount : 0 ),
+                 m_indices.get_capacity() + ( firstIndex == RangeAllocator::INVALID_OFFSET ? indexCount : 0 ) );
+        if ( vertexOffset == RangeAllocator::INVALID_OFFSET )
+            vertexOffset = m_vertices.allocate( rd->vertexCount );
+        if ( firstIndex == RangeAllocator::INVALID_OFFSET )
+            firstIndex = m_indices.allocate( indexCount );
+    }
+
+    const size_t STRIDE = get_vertex_stride();
+    m_device->copy_buffer( rd->vbo, m_vao.vbo, rd->vertexCount * STRIDE, 0, vertexOffset * STRIDE );
+    if ( m_vao.layout == PACKED_VERTEX_LAYOUT )
+        m_device->copy_buffer( rd->attributeBuffer,
+                               m_vao.attributeBuffer,
+                               rd->vertexCount * sizeof( Graphics::PackedVertex ),
+                               0,
+                               vertexOffset * sizeof( Graphics::PackedVertex ) );
+    if ( rd->indexCount > 0 )
+        m_device->copy_buffer( rd->ibo, m_vao.ibo, indexCount * sizeof( uint32_t ), 0, firstIndex * sizeof( uint32_t ) );
+    else
+    {
+        std::vector<uint32_t> sequentialIndices( indexCount );
+        for ( uint32_t i = 0; i < indexCount; i++ )
+            sequentialIndices[i] = i;
+        m_device->upload_buffer_data( m_vao.ibo, sequentialIndices.data(), indexCount * sizeof( uint32_t ), firstIndex * sizeof( uint32_t ) );
+    }
+
+    rd->arenaVertexOffset = vertexOffset;
+    rd->arenaVertexCount  = rd->vertexCount;
+    rd->arenaFirstIndex   = firstIndex;
+    rd->arenaIndexCount   = indexCount;
+    rd->inArena           = true;
+
+    m_vao.vertexCount = m_vertices.get_used();
+    m_vao.indexCount  = m_indices.get_used();
+    m_geometries++;
+    return true;
+}
+
+void GeometryArena::release( Core::Geometry* const g ) {
+    Graphics::VertexArrays* rd = get_VAO( g );
+    if ( !rd->inArena )
+        return;
+
+    m_vertices.free( rd->arenaVertexOffset, rd->arenaVertexCount );
+    m_indices.free( rd->arenaFirstIndex, rd->arenaIndexCount );
+    rd->inArena          = false;
+    rd->arenaVertexCount = 0;
+    rd->arenaIndexCount  = 0;
+
+    m_vao.vertexCount = m_vertices.get_used();
+    m_vao.indexCount  = m_indices.get_used();
+    m_geometries--;
+}
+
+GeometryArenaStats GeometryArena::get_stats() const {
+    GeometryArenaStats stats;
+    stats.vertexCapacity      = m_vertices.get_capacity();
+    stats.vertexUsed          = m_vertices.get_used();
+    stats.vertexFreeBlocks    = m_vertices.get_free_block_count();
+    stats.vertexFragmentation = m_vertices.get_fragmentation();
+    stats.indexCapacity       = m_indices.get_capacity();
+    stats.indexUsed           = m_indices.get_used();
+    stats.indexFreeBlocks     = m_indices.get_free_block_count();
+    stats.indexFragmentation  = m_indices.get_fragmentation();
+    stats.geometries          = m_geometries;
+    return stats;
+}
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
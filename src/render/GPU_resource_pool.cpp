@@ -6,6 +6,7 @@ void Render::GPUResourcePool::init( const std::shared_ptr<Graphics::Device>& dev
     m_device = device;
 
     // Init basic resources
+    m_device->begin_upload_batch();
     auto vignette = Core::Geometry::create_quad();
     upload_geometry_data( device, vignette, false );
     m_vignetteVAO = *get_VAO(vignette);
@@ -24,6 +25,11 @@ void Render::GPUResourcePool::init( const std::shared_ptr<Graphics::Device>& dev
     upload_texture_data( device, FallbackCube );
     m_fallbackCubemap = *get_image( FallbackCube );
     delete FallbackCube;
+    m_device->end_upload_batch();
+
+    m_geometryArenas[STANDARD_VERTEX_LAYOUT].init( device, ENGINE_INITIAL_ARENA_VERTICES, ENGINE_INITIAL_ARENA_INDICES );
+    // Only created once a packed geometry shows up
+    m_geometryArenas[PACKED_VERTEX_LAYOUT].init( device, 0, 0, PACKED_VERTEX_LAYOUT );
 }
 void Render::GPUResourcePool::cleanup() {
     m_vignetteVAO.ibo.cleanup();
@@ -31,6 +37,8 @@ void Render::GPUResourcePool::cleanup() {
     m_fallbackCubemap.cleanup();
     m_fallbackImage2D.cleanup();
     m_fallbackImage3D.cleanup();
+    for ( GeometryArena& arena : m_geometryArenas )
+        arena.cleanup();
 
     for ( auto& [name, buffer] : m_ubos )
     {
@@ -45,16 +53,27 @@ void Render::GPUResourcePool::cleanup() {
     m_images.clear();
 }
 
+void Render::GPUResourcePool::register_arena_geometry( Core::Geometry* const g ) {
+    m_geometryArenas[g->get_vertex_layout()].allocate( g );
+}
+
+void Render::GPUResourcePool::evict_geometry( Core::Geometry* const g ) {
+    // Frames in flight might still be drawing its ranges
+    m_device->wait_idle();
+    m_geometryArenas[g->get_vertex_layout()].release( g );
+    destroy_geometry_data( g );
+}
+
 void Render::GPUResourcePool::register_image( const std::string& name, Core::ITexture* const t ) {
 
     upload_texture_data( m_device, t );
     m_images[name] = *get_image( t );
 }
 
-void Render::GPUResourcePool::upload_texture_data( const ptr<Graphics::Device>& device, Core::ITexture* const t ) {
+void Render::GPUResourcePool::upload_texture_data( const ptr<Graphics::Device>& device, Core::ITexture* const t, bool async ) {
     if ( t && t->loaded_on_CPU() )
     {
-        if ( !t->loaded_on_GPU() )
+        if ( !t->loaded_on_GPU() && !get_image( t )->pendingUpload )
         {
             Graphics::ImageConfig   config        = {};
             Graphics::SamplerConfig samplerConfig = {};
@@ -70,7 +89,10 @@ void Render::GPUResourcePool::upload_texture_data( const ptr<Graphics::Device>&
 
             void* imgCache { nullptr };
             t->get_image_cache( imgCache );
-            device->upload_texture_image( *get_image( t ), config, samplerConfig, imgCache, t->get_bytes_per_pixel() );
+            if ( async )
+                device->upload_texture_image_async( *get_image( t ), config, samplerConfig, imgCache, t->get_bytes_per_pixel() );
+            else
+                device->upload_texture_image( *get_image( t ), config, samplerConfig, imgCache, t->get_bytes_per_pixel() );
         }
     }
 }
@@ -79,23 +101,74 @@ void Render::GPUResourcePool::destroy_texture_data( Core::ITexture* const t ) {
     if ( t )
         get_image( t )->cleanup();
 }
-void Render::GPUResourcePool::upload_geometry_data( const ptr<Graphics::Device>& device, Core::Geometry* const g, bool createAccelStructure ) {
+void Render::GPUResourcePool::upload_geometry_data( const ptr<Graphics::Device>& device,
+                                                     Core::Geometry* const        g,
+                                                     bool                         createAccelStructure,
+                                                     bool                         async ) {
     PROFILING_EVENT()
     /*
     VERTEX ARRAYS
     */
     Graphics::VertexArrays* rd = get_VAO( g );
+    if ( rd->pendingUpload ) // Still in flight
+        return;
     if ( !rd->loadedOnGPU )
     {
+        if ( !g->CPU_data_available() )
+        {
+            LOG_WARN( "Geometry arrays were released after a previous upload, it can't be uploaded again" );
+            return;
+        }
         const Core::GeometricData& gd        = g->get_properties();
         size_t                     vboSize   = sizeof( gd.vertexData[0] ) * gd.vertexData.size();
-        size_t                     iboSize   = sizeof( gd.vertexIndex[0] ) * gd.vertexIndex.size();
+        size_t                     iboSize   = sizeof( uint32_t ) * ( gd.vertexIndex.size() + gd.lodIndex.size() );
         size_t                     voxelSize = sizeof( gd.voxelData[0] ) * gd.voxelData.size();
         rd->indexCount                       = gd.vertexIndex.size();
+        rd->lodIndexCount                    = gd.lodIndex.size();
         rd->vertexCount                      = gd.vertexData.size();
         rd->voxelCount                       = gd.voxelData.size();
 
-        device->upload_vertex_arrays( *rd, vboSize, gd.vertexData.data(), iboSize, gd.vertexIndex.data(), voxelSize, gd.voxelData.data() );
+        // Packed layout splits the vertices into a position stream and a quantized attribute stream
+        std::vector<Vec3>                   positions;
+        std::vector<Graphics::PackedVertex> attributes;
+        const void*                         vboData = gd.vertexData.data();
+        if ( rd->layout == PACKED_VERTEX_LAYOUT )
+        {
+            positions.resize( gd.vertexData.size() );
+            attributes.resize( gd.vertexData.size() );
+            for ( size_t i = 0; i < gd.vertexData.size(); i++ )
+            {
+                positions[i]  = gd.vertexData[i].pos;
+                attributes[i] = Graphics::PackedVertex::pack( gd.vertexData[i] );
+            }
+            vboSize = sizeof( Vec3 ) * positions.size();
+            vboData = positions.data();
+        }
+        size_t attributeSize = sizeof( Graphics::PackedVertex ) * attributes.size();
+
+        // Levels of detail share the index buffer, after the full detail indices
+        std::vector<uint32_t> indices;
+        const void*           iboData = gd.vertexIndex.data();
+        if ( !gd.lodIndex.empty() )
+        {
+            indices.reserve( gd.vertexIndex.size() + gd.lodIndex.size() );
+            indices.insert( indices.end(), gd.vertexIndex.begin(), gd.vertexIndex.end() );
+            indices.insert( indices.end(), gd.lodIndex.begin(), gd.lodIndex.end() );
+            iboData = indices.data();
+        }
+
+        if ( async )
+        {
+            device->upload_vertex_arrays_async(
+                *rd, vboSize, vboData, iboSize, iboData, voxelSize, gd.voxelData.data(), attributeSize, attributes.data() );
+            // Data is in the staging buffer already
+            if ( g->get_CPU_residency() == Core::CPUResidency::RELEASE_AFTER_UPLOAD )
+                g->release_CPU_data();
+            return; // Acceleration structure has to wait until the geometry is resident
+        }
+        device->upload_vertex_arrays( *rd, vboSize, vboData, iboSize, iboData, voxelSize, gd.voxelData.data(), attributeSize, attributes.data() );
+        if ( g->get_CPU_residency() == Core::CPUResidency::RELEASE_AFTER_UPLOAD )
+            g->release_CPU_data();
     }
     /*
     ACCELERATION STRUCTURE
@@ -116,8 +189,12 @@ void Render::GPUResourcePool::destroy_geometry_data( Core::Geometry* const g ) {
             rd->ibo.cleanup();
         if ( rd->voxelCount > 0 )
             rd->voxelBuffer.cleanup();
+        if ( rd->layout == PACKED_VERTEX_LAYOUT )
+            rd->attributeBuffer.cleanup();
 
         rd->loadedOnGPU = false;
+        // Arena ranges are only given back through GPUResourcePool::evict_geometry
+        rd->inArena = false;
         get_BLAS( g )->cleanup();
     }
 }
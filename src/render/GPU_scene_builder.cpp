@@ -5,32 +5,105 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 namespace Render {
 
 void GPUSceneBuilder::build( const ptr<Graphics::Device>& device,
+                             const ptr<GPUResourcePool>&  pool,
                              Graphics::Frame* const       currentFrame,
                              Core::Scene* const           scene,
                              Extent2D                     displayExtent,
                              bool                         raytracingEnabled,
-                             bool                         temporalFiltering ) {
-    update_global_data( device, currentFrame, scene, displayExtent, temporalFiltering );
-    update_object_data( device, currentFrame, scene, displayExtent, raytracingEnabled );
+                             bool                         temporalFiltering,
+                             bool                         asyncUploads,
+                             const LODSettings&           lodSettings,
+                             uint32_t                     shadowResolution ) {
+    // Flag the resources whose transfers finished since last frame as resident
+    device->poll_uploads();
+    m_uploadStats = {};
+    // Culling reads the camera frustum, so the projection has to be up to date before the objects are processed
+    Core::Camera* camera = scene->get_active_camera();
+    if ( camera && camera->is_dirty() )
+        camera->set_projection( displayExtent.width, displayExtent.height );
+    // Objects first, the scene volume uploaded with the globals is fitted while culling them
+    update_object_data( device, pool, currentFrame, scene, displayExtent, raytracingEnabled, asyncUploads, lodSettings );
+    update_global_data( device, currentFrame, scene, displayExtent, temporalFiltering, shadowResolution );
 }
 
 void GPUSceneBuilder::destroy( Core::Scene* const scene ) {
     clean_scene( scene );
+    m_meshLODs.clear();
+    m_frameUploads.clear();
+    m_residentMaterials.clear();
+}
+
+namespace {
+/*
+Writes the entries of data that differ from what was written before, merging neighbouring ones into a single write. Entries
+past the end of written are always written. Tables are tightly packed, one entry per stride
+*/
+template <typename T> size_t upload_changed( Graphics::Buffer& table, const std::vector<T>& data, std::vector<T>& written, uint32_t& writes ) {
+    auto changed = [&]( size_t i ) { return i >= written.size() || std::memcmp( &data[i], &written[i], sizeof( T ) ) != 0; };
+    size_t bytes = 0;
+    for ( size_t i = 0; i < data.size(); )
+    {
+        if ( !changed( i ) )
+        {
+            i++;
+            continue;
+        }
+        size_t end = i + 1;
+        while ( end < data.size() && changed( end ) )
+            end++;
+        table.upload_data( &data[i], ( end - i ) * sizeof( T ), i * sizeof( T ) );
+        bytes += ( end - i ) * sizeof( T );
+        writes++;
+        i = end;
+    }
+    written = data;
+    return bytes;
+}
+/*
+Writes the smallest range of 16 byte words of value that differs from what was written before, or all of it if forced
+*/
+template <typename T> size_t upload_changed( Graphics::Buffer& buffer, size_t offset, const T& value, T& written, bool force, uint32_t& writes ) {
+    const char* current  = reinterpret_cast<const char*>( &value );
+    const char* previous = reinterpret_cast<const char*>( &written );
+    size_t      first    = 0;
+    size_t      last     = sizeof( T );
+    if ( !force )
+    {
+        while ( first < last && current[first] == previous[first] )
+            first++;
+        if ( first == last )
+            return 0;
+        while ( current[last - 1] == previous[last - 1] )
+            last--;
+        first = first & ~size_t( 15 );
+        last  = std::min( sizeof( T ), ( last + 15 ) & ~size_t( 15 ) );
+    }
+    buffer.upload_data( current + first, last - first, offset + first );
+    written = value;
+    writes++;
+    return last - first;
 }
+// A table that grew is a new buffer, nothing was written to it yet
+template <typename T> void track_table( const Graphics::Buffer& table, VkBuffer& handle, std::vector<T>& written ) {
+    if ( handle == table.handle )
+        return;
+    handle = table.handle;
+    written.clear();
+}
+} // namespace
 
 void GPUSceneBuilder::update_global_data( const ptr<Graphics::Device>& device,
                                           Graphics::Frame* const       currentFrame,
                                           Core::Scene* const           scene,
                                           Extent2D                     displayExtent,
-                                          bool                         jitterCamera ) {
+                                          bool                         jitterCamera,
+                                          uint32_t                     shadowResolution ) {
     PROFILING_EVENT()
     /*
     CAMERA UNIFORMS LOAD
     */
-    Core::Camera* camera = scene->get_active_camera();
-    if ( camera->is_dirty() )
-        camera->set_projection( displayExtent.width, displayExtent.height );
-    Core::Camera::GPUPayload camData;
+    Core::Camera*            camera  = scene->get_active_camera();
+    Core::Camera::GPUPayload camData = {}; // Zeroed, so payloads compare equal byte by byte
     camData.view     = camera->get_view();
     camData.proj     = camera->get_projection();
     camData.viewProj = camera->get_projection() * camera->get_view();
@@ -69,13 +142,17 @@ void GPUSceneBuilder::update_global_data( const ptr<Graphics::Device>& device,
     camData.nearPlane    = camera->get_near();
     camData.farPlane     = camera->get_far();
 
-    currentFrame->uniformBuffers[GLOBAL_LAYOUT].upload_data( &camData, sizeof( Core::Camera::GPUPayload ), 0 );
+    FrameUploads&     uploads = get_frame_uploads( currentFrame );
+    Graphics::Buffer& globals = currentFrame->uniformBuffers[GLOBAL_LAYOUT];
+    const bool        rewrite = uploads.globals != globals.handle;
+    uploads.globals           = globals.handle;
+    m_uploadStats.globalBytes += upload_changed( globals, 0, camData, uploads.camera, rewrite, m_uploadStats.writes );
 
     /*
     SCENE UNIFORMS LOAD
     */
 
-    Core::Scene::GPUPayload sceneParams;
+    Core::Scene::GPUPayload sceneParams = {};
     sceneParams.fogParams       = { camera->get_near(), camera->get_far(), scene->get_fog_intensity(), scene->is_fog_enabled() };
     sceneParams.fogColorAndSSAO = Vec4( scene->get_fog_color(), 0.0f );
     sceneParams.SSAOtype        = 0;
@@ -90,8 +167,7 @@ void GPUSceneBuilder::update_global_data( const ptr<Graphics::Device>& device,
     sceneParams.time = 0.0;
 
     /*Limits*/
-    // UPDATE AABB OF SCENE FOR VOXELIZATION PURPOSES
-    scene->update_AABB();
+    // AABB OF SCENE FOR VOXELIZATION PURPOSES. Fitted while culling the objects
     Core::AABB aabb      = scene->get_AABB();
     sceneParams.maxCoord = Vec4( aabb.maxCoords, 1.0f );
     sceneParams.minCoord = Vec4( aabb.minCoords, 1.0f );
@@ -102,6 +178,9 @@ void GPUSceneBuilder::update_global_data( const ptr<Graphics::Device>& device,
             return math::length( a->get_position() - camera->get_position() ) < math::length( b->get_position() - camera->get_position() );
         } );
 
+    // Shadow passes read the views of the slots from the frame, so they can tell which ones changed
+    currentFrame->shadowViews.clear();
+    sceneParams.cascadeLight = -1;
     size_t lightIdx { 0 };
     for ( Core::Light* l : lights )
     {
@@ -122,109 +201,219 @@ void GPUSceneBuilder::update_global_data( const ptr<Graphics::Device>& device,
             Mat4 depthProjectionMatrix                   = math::perspective( math::radians( l->get_shadow_fov() ), 1.0f, l->get_shadow_near(), l->get_shadow_far() );
             Mat4 depthViewMatrix                         = math::lookAt( l->get_position(), l->get_shadow_target(), Vec3( 0, 1, 0 ) );
             sceneParams.lightUniforms[lightIdx].viewProj = depthProjectionMatrix * depthViewMatrix;
+            bool rasterized = l->get_shadow_type() != ShadowType::RAYTRACED_SHADOW;
+
+            // The first cascaded directional light draws its cascades instead of its own layer
+            if ( rasterized && sceneParams.cascadeLight < 0 && l->get_light_type() == LightType::DIRECTIONAL &&
+                 static_cast<Core::DirectionalLight*>( l )->get_cascade_count() > 1 )
+            {
+                Core::ShadowCascades cascades = static_cast<Core::DirectionalLight*>( l )->get_shadow_cascades(
+                    camData.view, camData.proj, camera->get_near(), camera->get_far(), aabb.minCoords, aabb.maxCoords, shadowResolution );
+                sceneParams.cascadeLight = static_cast<int>( lightIdx );
+                sceneParams.cascadeCount = static_cast<int>( cascades.count );
+                for ( uint32_t c = 0; c < cascades.count; c++ )
+                {
+                    sceneParams.cascadeSplits[c]   = cascades.splits[c];
+                    sceneParams.cascadeViewProj[c] = cascades.viewProj[c];
+                }
+                rasterized = false;
+            }
+            currentFrame->shadowViews.push_back( { sceneParams.lightUniforms[lightIdx].viewProj, rasterized } );
             lightIdx++;
         }
         if ( lightIdx >= ENGINE_MAX_LIGHTS )
             break;
     }
     sceneParams.numLights = static_cast<int>( lights.size() );
+    // Cascade layers go after the layers of every light slot
+    if ( sceneParams.cascadeLight >= 0 )
+    {
+        currentFrame->shadowViews.resize( ENGINE_MAX_LIGHTS );
+        for ( int c = 0; c < sceneParams.cascadeCount; c++ )
+            currentFrame->shadowViews.push_back( { sceneParams.cascadeViewProj[c], true } );
+    }
 
-    currentFrame->uniformBuffers[GLOBAL_LAYOUT].upload_data(
-        &sceneParams, sizeof(  Core::Scene::GPUPayload ), device->pad_uniform_buffer_size( sizeof( Core::Camera::GPUPayload ) ) );
+    // Lights that did not change since this frame was last built are not written again
+    m_uploadStats.globalBytes += upload_changed(
+        globals, device->pad_uniform_buffer_size( sizeof( Core::Camera::GPUPayload ) ), sceneParams, uploads.scene, rewrite, m_uploadStats.writes );
 }
 void GPUSceneBuilder::update_object_data( const ptr<Graphics::Device>& device,
+                                          const ptr<GPUResourcePool>&  pool,
                                           Graphics::Frame* const       currentFrame,
                                           Core::Scene* const           scene,
                                           Extent2D                     displayExtent,
-                                          bool                         enableRT ) {
+                                          bool                         enableRT,
+                                          bool                         asyncUploads,
+                                          const LODSettings&           lodSettings ) {
 
     PROFILING_EVENT()
 
+    currentFrame->drawBuckets.clear();
+    currentFrame->drawRecordCount = 0;
     if ( scene->get_active_camera() && scene->get_active_camera()->is_active() )
     {
-        std::vector<Core::Mesh*> meshes;
-        std::vector<Core::Mesh*> blendMeshes;
-
-        for ( Core::Mesh* m : scene->get_meshes() )
-        {
-            if ( m->get_material() )
-                m->get_material()->get_parameters().blending ? blendMeshes.push_back( m ) : meshes.push_back( m );
-        }
+        // The scene list is not reordered. Passes drawing in order sort their own draws (transparent ones back to front), so
+        // instance IDs stay put while the camera moves. CPU side culling of every pass shares the same bounds and camera visibility
+        scene->update_culling_data();
 
-        // Calculate distance
-        if ( !blendMeshes.empty() )
-        {
-
-            std::map<float, Core::Mesh*> sorted;
-            for ( unsigned int i = 0; i < blendMeshes.size(); i++ )
-            {
-                float distance   = glm::distance( scene->get_active_camera()->get_position(), blendMeshes[i]->get_position() );
-                sorted[distance] = blendMeshes[i];
-            }
-
-            // SECOND = TRANSPARENT OBJECTS SORTED FROM NEAR TO FAR
-            for ( std::map<float, Core::Mesh*>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it )
-            {
-                meshes.push_back( it->second );
-            }
-            Core::set_meshes( scene, meshes );
-        }
+        // Instance ID and material index are the mesh position in the scene list
+        const size_t instanceCount = scene->get_meshes().size();
+        reserve_instance_data( device, currentFrame, instanceCount );
+        // Payloads are gathered first and only the ones that changed since this frame was last built are written. Inactive
+        // instances keep what they had
+        FrameUploads& uploads = get_frame_uploads( currentFrame );
+        track_table( currentFrame->uniformBuffers[INSTANCE_BUFFER], uploads.instanceTable, uploads.instances );
+        track_table( currentFrame->uniformBuffers[MATERIAL_BUFFER], uploads.materialTable, uploads.materials );
+        m_instanceData = uploads.instances;
+        m_materialData = uploads.materials;
+        m_instanceData.resize( instanceCount );
+        m_materialData.resize( instanceCount );
+        // One record per drawable instance, or per meshlet of its geometry
+        std::vector<GPUDrawRecord> drawRecords;
+        std::vector<uint32_t>      stateKeys;
+        drawRecords.reserve( instanceCount );
+        stateKeys.reserve( instanceCount );
 
         std::vector<Graphics::BLASInstance> BLASInstances; // RT Acceleration Structures per instanced mesh
         BLASInstances.reserve( scene->get_meshes().size() );
+        std::vector<Core::Mesh*> rayHittableMeshes;
+        // Every geometry and texture first seen this frame goes to the GPU in a single transfer submission
+        device->begin_upload_batch();
+        m_LODBuild++;
+        m_LODMeshes           = 0;
         unsigned int mesh_idx = 0;
         for ( Core::Mesh* m : scene->get_meshes() )
         {
             if ( m ) // If mesh exists
             {
-                if ( m->is_active() &&                                                                        // Check if is active
-                     m->get_geometry() &&                                                                     // Check if has geometry
-                     m->get_bounding_volume()->is_on_frustrum( scene->get_active_camera()->get_frustrum() ) ) // Check if is inside frustrum
+                // Every active instance is written. Visibility is resolved per pass (GPU culling for shadows and voxelization needs
+                // instances outside the camera frustum too)
+                if ( m->is_active() &&   // Check if is active
+                     m->get_geometry() ) // Check if has geometry
                 {
-                    // Offset calculation
-                    uint32_t objectOffset = currentFrame->uniformBuffers[OBJECT_LAYOUT].strideSize * mesh_idx;
-
-                    Core::Object3D::GPUPayload objectData;
-                    objectData.model        = m->get_model_matrix();
-                    objectData.otherParams1 = { m->affected_by_fog(), m->receive_shadows(), m->cast_shadows(), mesh_idx };
-                    objectData.otherParams2 = { mesh_idx, m->get_bounding_volume()->center };
-                    currentFrame->uniformBuffers[OBJECT_LAYOUT].upload_data( &objectData, sizeof(  Core::Object3D::GPUPayload ), objectOffset );
-
-                    // Object vertex buffer setup
-                    Core::Geometry* g = m->get_geometry();
-                    GPUResourcePool::upload_geometry_data( device, g, enableRT && m->ray_hittable() );
-                    // Add BLASS to instances list
-                    if ( enableRT && m->ray_hittable() && get_BLAS( g )->handle )
-                        BLASInstances.push_back( { *get_BLAS( g ), m->get_model_matrix() } );
+                    Core::Object3D::GPUPayload& objectData = m_instanceData[mesh_idx];
+                    objectData.model                       = m->get_model_matrix();
+                    objectData.otherParams1                = { m->affected_by_fog(), m->receive_shadows(), m->cast_shadows(), mesh_idx };
+                    objectData.otherParams2                = { mesh_idx, m->get_bounding_volume()->center };
 
                     // Object material setup
+                    Core::Geometry*  g   = m->get_geometry();
                     Core::IMaterial* mat = m->get_material( g->get_material_ID() );
                     if ( !mat )
                     {
                         m->add_material( Core::IMaterial::debugMaterial );
                     }
-                    mat = m->get_material( g->get_material_ID() );
-                    if ( mat )
+                    mat                         = m->get_material( g->get_material_ID() );
+                    const bool texturesResident = !mat || upload_material_textures( device, mat, asyncUploads );
+
+                    // Object vertex buffer setup. When uploading asynchronously, geometry is only queued once its textures are
+                    // resident, so a drawable VAO never samples a missing texture (non-resident VAOs are skipped at draw time)
+                    if ( !asyncUploads || texturesResident )
+                        GPUResourcePool::upload_geometry_data( device, g, false, asyncUploads );
+                    // Resident geometry joins the arena drawn by the GPU-driven passes
+                    pool->register_arena_geometry( g );
+                    const Graphics::VertexArrays* vao = get_VAO( g );
+                    if ( vao->inArena )
                     {
-                        auto textures = mat->get_textures();
-                        for ( auto pair : textures )
+                        GPUDrawRecord record;
+                        record.indexCount   = vao->arenaIndexCount - vao->lodIndexCount;
+                        record.firstIndex   = vao->arenaFirstIndex;
+                        record.vertexOffset = static_cast<int32_t>( vao->arenaVertexOffset );
+                        record.instance     = mesh_idx;
+
+                        const Core::BV* volume = m->get_bounding_volume();
+                        record.boundingSphere  = volume && volume->TYPE == VolumeType::SPHERE_VOLUME
+                                                     ? Vec4( volume->center, static_cast<const Core::BoundingSphere*>( volume )->radius )
+                                                     : Vec4( 0.0f, 0.0f, 0.0f, -1.0f );
+
+                        Core::MaterialSettings params   = mat->get_parameters();
+                        CullingMode            culling  = params.faceCulling ? params.culling : NO_CULLING;
+                        const uint32_t         stateKey = GPUCuller::encode_state(
+                            g->get_properties().topology, culling, params.depthTest, params.depthWrite, g->get_vertex_layout() );
+
+                        const std::vector<Core::Meshlet>&     meshlets = g->get_properties().meshlets;
+                        const std::vector<Core::GeometryLOD>& lods     = g->get_properties().lods;
+                        auto                                  push_level = [&]( uint32_t level, uint32_t flags ) {
+                            GPUDrawRecord levelRecord = record;
+                            levelRecord.flags         = flags;
+                            if ( level > 0 )
+                            {
+                                levelRecord.firstIndex = vao->arenaFirstIndex + lods[level - 1].firstIndex;
+                                levelRecord.indexCount = lods[level - 1].indexCount;
+                            }
+                            if ( level > 0 || meshlets.empty() )
+                            {
+                                drawRecords.push_back( levelRecord );
+                                stateKeys.push_back( stateKey );
+                                return;
+                            }
+                            // Meshlets are culled on their own. Normal cones only hold when back faces are culled
+                            for ( const Core::Meshlet& meshlet : meshlets )
+                            {
+                                GPUDrawRecord meshletRecord  = levelRecord;
+                                meshletRecord.indexCount     = meshlet.indexCount;
+                                meshletRecord.firstIndex     = vao->arenaFirstIndex + meshlet.firstIndex;
+                                meshletRecord.boundingSphere = meshlet.boundingSphere;
+                                if ( culling == BACK_CULLING )
+                                    meshletRecord.normalCone = meshlet.normalCone;
+                                drawRecords.push_back( meshletRecord );
+                                stateKeys.push_back( stateKey );
+                            }
+                        };
+
+                        // Shadow casters may be drawn coarser than the camera sees them. They get records of their own then
+                        const uint32_t level       = select_LOD( m, scene->get_active_camera(), displayExtent, lodSettings );
+                        const uint32_t shadowLevel = std::min( level + lodSettings.shadowBias, static_cast<uint32_t>( lods.size() ) );
+                        const uint32_t castBit     = m->cast_shadows() ? GPUDrawRecord::CAST_SHADOWS_BIT : 0u;
+                        if ( shadowLevel == level || !castBit )
+                            push_level( level, GPUDrawRecord::DRAWABLE_BIT | castBit );
+                        else
                         {
-                            Core::ITexture* texture = pair.second;
-                            GPUResourcePool::upload_texture_data( device, texture );
+                            push_level( level, GPUDrawRecord::DRAWABLE_BIT );
+                            push_level( shadowLevel, GPUDrawRecord::DRAWABLE_BIT | castBit | GPUDrawRecord::SHADOW_ONLY_BIT );
                         }
                     }
+                    // BLAS builds are deferred until vertex data is resident
+                    if ( enableRT && m->ray_hittable() )
+                        rayHittableMeshes.push_back( m );
 
-                    // ObjectUniforms materialData;
-                    Core::IMaterial::GPUPayload materialData = mat->get_uniforms();
-                    currentFrame->uniformBuffers[OBJECT_LAYOUT].upload_data(
-                        &materialData, sizeof(  Core::IMaterial::GPUPayload ), objectOffset + device->pad_uniform_buffer_size( sizeof(  Core::IMaterial::GPUPayload ) ) );
+                    m_materialData[mesh_idx] = mat->get_uniforms();
                 }
             }
             mesh_idx++;
         }
+        device->end_upload_batch();
+
+        // Levels of meshes not drawn this frame are dropped, so the map does not keep the address of every mesh ever removed from the
+        // scene. A mesh drawn again starts over from full detail
+        if ( m_meshLODs.size() > m_LODMeshes )
+        {
+            for ( auto it = m_meshLODs.begin(); it != m_meshLODs.end(); )
+                it = it->second.build != m_LODBuild ? m_meshLODs.erase( it ) : std::next( it );
+        }
+
+        m_uploadStats.instanceBytes +=
+            upload_changed( currentFrame->uniformBuffers[INSTANCE_BUFFER], m_instanceData, uploads.instances, m_uploadStats.writes );
+        m_uploadStats.materialBytes +=
+            upload_changed( currentFrame->uniformBuffers[MATERIAL_BUFFER], m_materialData, uploads.materials, m_uploadStats.writes );
+
+        reserve_draw_data( device, currentFrame, drawRecords.size() );
+        update_draw_data( currentFrame, drawRecords, stateKeys );
+
         // CREATE TOP LEVEL (STATIC) ACCELERATION STRUCTURE
         if ( enableRT )
         {
+            for ( Core::Mesh* m : rayHittableMeshes )
+            {
+                Core::Geometry* g = m->get_geometry();
+                if ( !get_VAO( g )->loadedOnGPU )
+                    continue;
+                GPUResourcePool::upload_geometry_data( device, g, true );
+                // Add BLASS to instances list
+                if ( get_BLAS( g )->handle )
+                    BLASInstances.push_back( { *get_BLAS( g ), m->get_model_matrix() } );
+            }
+
             Graphics::TLAS* accel = get_TLAS( scene );
             if ( !accel->handle )
                 device->upload_TLAS( *accel, BLASInstances );
@@ -239,6 +428,164 @@ void GPUSceneBuilder::update_object_data( const ptr<Graphics::Device>& device,
     }
 }
 
+uint32_t GPUSceneBuilder::select_LOD( Core::Mesh* const m, Core::Camera* const camera, Extent2D displayExtent, const LODSettings& settings ) {
+    const std::vector<Core::GeometryLOD>& lods = m->get_geometry()->get_properties().lods;
+    if ( lods.empty() || settings.errorThreshold <= 0.0f )
+        return 0;
+
+    // World space bounds
+    const Core::GeometricData& props  = m->get_geometry()->get_properties();
+    const Mat4                 model  = m->get_model_matrix();
+    const float                scale  = std::max( math::length( Vec3( model[0] ) ), std::max( math::length( Vec3( model[1] ) ), math::length( Vec3( model[2] ) ) ) );
+    const Vec3                 center = Vec3( model * Vec4( props.center, 1.0f ) );
+    const float                radius = math::length( props.maxCoords - props.minCoords ) * 0.5f * scale;
+
+    // Pixels an object space unit takes at the closest point of the bounds
+    const float distance      = std::max( math::length( center - camera->get_position() ) - radius, camera->get_near() );
+    const float pixelsPerUnit = displayExtent.height * 0.5f / ( std::tan( math::radians( camera->get_field_of_view() ) * 0.5f ) * distance ) * scale;
+
+    // Coarser levels are only taken well below the threshold and left as soon as it is exceeded, so objects around the switching
+    // distance do not pop back and forth every frame
+    MeshLOD& meshLOD = m_meshLODs[m];
+    if ( meshLOD.build != m_LODBuild )
+        m_LODMeshes++;
+    meshLOD.build     = m_LODBuild;
+    uint32_t& current = meshLOD.level;
+    current           = std::min( current, static_cast<uint32_t>( lods.size() ) );
+    uint32_t level    = current;
+    while ( level > 0 && lods[level - 1].error * pixelsPerUnit > settings.errorThreshold )
+        level--;
+    if ( level == current )
+    {
+        while ( level < lods.size() && lods[level].error * pixelsPerUnit <= settings.errorThreshold * ( 1.0f - settings.hysteresis ) )
+            level++;
+    }
+    current = level;
+    return level;
+}
+
+void GPUSceneBuilder::update_draw_data( Graphics::Frame* const currentFrame, const std::vector<GPUDrawRecord>& records, const std::vector<uint32_t>& stateKeys ) {
+    PROFILING_EVENT()
+    // Copies of a geometry are instances of the same draw. Each group gets a single command slot, and instance groups sharing render
+    // state get contiguous command ranges, so each bucket is a single indirect draw
+    uint32_t bucketCounts[ENGINE_MAX_DRAW_BUCKETS] = {};
+    m_instanceGroups.clear();
+    m_groupSizes.clear();
+    m_recordGroups.resize( records.size() );
+    for ( size_t i = 0; i < records.size(); i++ )
+    {
+        const GPUDrawRecord&   record = records[i];
+        const InstanceGroupKey key    = { stateKeys[i], record.indexCount, record.firstIndex, record.vertexOffset, record.flags };
+        auto                   group  = m_instanceGroups.emplace( key, static_cast<uint32_t>( m_groupSizes.size() ) );
+        if ( group.second )
+        {
+            m_groupSizes.push_back( 0 );
+            if ( record.flags & GPUDrawRecord::DRAWABLE_BIT )
+                bucketCounts[stateKeys[i]]++;
+        }
+        m_recordGroups[i] = group.first->second;
+        m_groupSizes[group.first->second]++;
+    }
+
+    uint32_t bucketIndex[ENGINE_MAX_DRAW_BUCKETS];
+    uint32_t firstCommand = 0;
+    // Buckets drawn with the same pipeline (vertex layout and topology) go one after another, so passes rebind it as little as
+    // possible. The order holds them in its highest bits and the culling and depth states in the lowest
+    for ( uint32_t order = 0; order < ENGINE_MAX_DRAW_BUCKETS; order++ )
+    {
+        const uint32_t key = ( order & 0x40 ) | ( ( order >> 4 ) & 0x3 ) | ( ( order & 0xF ) << 2 );
+        if ( bucketCounts[key] == 0 )
+            continue;
+        bucketIndex[key] = static_cast<uint32_t>( currentFrame->drawBuckets.size() );
+        currentFrame->drawBuckets.push_back( { key, firstCommand, bucketCounts[key] } );
+        firstCommand += bucketCounts[key];
+    }
+
+    // Groups are laid out in the order they were first seen, which only changes with the scene, so unchanged records are not
+    // uploaded again
+    m_groupStarts.resize( m_groupSizes.size() );
+    uint32_t firstRecord = 0;
+    for ( size_t group = 0; group < m_groupSizes.size(); group++ )
+    {
+        m_groupStarts[group] = firstRecord;
+        firstRecord += m_groupSizes[group];
+        m_groupSizes[group] = 0;
+    }
+    m_groupedRecords.resize( records.size() );
+    for ( size_t i = 0; i < records.size(); i++ )
+    {
+        const uint32_t group  = m_recordGroups[i];
+        GPUDrawRecord  record = records[i];
+        record.firstInstance  = m_groupStarts[group];
+        if ( record.flags & GPUDrawRecord::DRAWABLE_BIT )
+        {
+            record.bucket       = bucketIndex[stateKeys[i]];
+            record.firstCommand = currentFrame->drawBuckets[record.bucket].firstCommand;
+        }
+        m_groupedRecords[m_groupStarts[group] + m_groupSizes[group]++] = record;
+    }
+
+    currentFrame->drawRecordCount = static_cast<uint32_t>( m_groupedRecords.size() );
+    FrameUploads& uploads         = get_frame_uploads( currentFrame );
+    track_table( currentFrame->uniformBuffers[DRAW_BUFFER], uploads.drawTable, uploads.records );
+    m_uploadStats.drawBytes += upload_changed( currentFrame->uniformBuffers[DRAW_BUFFER], m_groupedRecords, uploads.records, m_uploadStats.writes );
+}
+
+GPUSceneBuilder::FrameUploads& GPUSceneBuilder::get_frame_uploads( Graphics::Frame* const currentFrame ) {
+    if ( m_frameUploads.size() <= currentFrame->index )
+        m_frameUploads.resize( currentFrame->index + 1 );
+    return m_frameUploads[currentFrame->index];
+}
+
+bool GPUSceneBuilder::upload_material_textures( const ptr<Graphics::Device>& device, Core::IMaterial* const mat, bool asyncUploads ) {
+    if ( !mat->is_dirty() && m_residentMaterials.count( mat ) )
+        return true;
+
+    bool resident = true;
+    for ( const auto& pair : mat->get_textures() )
+    {
+        Core::ITexture* texture = pair.second;
+        GPUResourcePool::upload_texture_data( device, texture, asyncUploads );
+        if ( texture && texture->loaded_on_CPU() && !texture->loaded_on_GPU() )
+            resident = false;
+    }
+    // Checked again every frame until its last texture lands
+    if ( resident )
+    {
+        m_residentMaterials.insert( mat );
+        mat->set_dirty( false );
+    } else
+        m_residentMaterials.erase( mat );
+    return resident;
+}
+
+namespace {
+void reserve_table( const ptr<Graphics::Device>& device, Graphics::Buffer& table, size_t stride, size_t count ) {
+    if ( table.size >= count * stride )
+        return;
+
+    size_t capacity = std::max( table.size / stride, (size_t)ENGINE_INITIAL_INSTANCES );
+    while ( capacity < count )
+        capacity *= 2;
+
+    // The frame fence has already been waited, so the old table is not in use. The new one is created first so
+    // its handle can not alias the old one, which lets passes detect the change and rewrite their descriptors
+    Graphics::Buffer grownTable =
+        device->create_buffer_VMA( capacity * stride, BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)stride );
+    table.cleanup();
+    table = grownTable;
+}
+} // namespace
+
+void GPUSceneBuilder::reserve_instance_data( const ptr<Graphics::Device>& device, Graphics::Frame* const currentFrame, size_t instanceCount ) {
+    reserve_table( device, currentFrame->uniformBuffers[INSTANCE_BUFFER], sizeof( Core::Object3D::GPUPayload ), instanceCount );
+    reserve_table( device, currentFrame->uniformBuffers[MATERIAL_BUFFER], sizeof( Core::IMaterial::GPUPayload ), instanceCount );
+}
+
+void GPUSceneBuilder::reserve_draw_data( const ptr<Graphics::Device>& device, Graphics::Frame* const currentFrame, size_t recordCount ) {
+    reserve_table( device, currentFrame->uniformBuffers[DRAW_BUFFER], sizeof( GPUDrawRecord ), recordCount );
+}
+
 void GPUSceneBuilder::build_skybox_data( const ptr<Graphics::Device>& device, Core::Skybox* const sky ) {
     if ( sky )
     {
@@ -69,7 +69,7 @@ void BloomPass::setup_shader_passes() {
     downsamplePass->settings.pushConstants.push_back( PushConstant( SHADER_STAGE_COMPUTE, MIPMAP_UNIFORM_SIZE ) );
 
     downsamplePass->build_shader_stages();
-    downsamplePass->build( m_descriptorPool );
+    downsamplePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["downsample"] = downsamplePass;
 
@@ -78,7 +78,7 @@ void BloomPass::setup_shader_passes() {
     upsamplePass->settings.pushConstants.push_back( PushConstant( SHADER_STAGE_COMPUTE, MIPMAP_UNIFORM_SIZE ) );
 
     upsamplePass->build_shader_stages();
-    upsamplePass->build( m_descriptorPool );
+    upsamplePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["upsample"] = upsamplePass;
 
@@ -89,7 +89,7 @@ void BloomPass::setup_shader_passes() {
     bloomPass->settings.pushConstants.push_back( PushConstant( SHADER_STAGE_FRAGMENT, SETTINGS_UNIFORM_SIZE ) );
 
     bloomPass->build_shader_stages();
-    bloomPass->build( m_descriptorPool );
+    bloomPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["bloom"] = bloomPass;
 }
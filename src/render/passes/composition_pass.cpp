@@ -103,7 +103,7 @@ void CompositionPass::setup_shader_passes() {
     compPass->settings.pushConstants           = { PushConstant( SHADER_STAGE_FRAGMENT, sizeof( Settings ) ) };
 
     compPass->build_shader_stages();
-    compPass->build( m_descriptorPool );
+    compPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["composition"] = compPass;
 }
@@ -78,7 +78,7 @@ void EnviromentPass::setup_shader_passes() {
     converterPass->settings.pushConstants = { PushConstant( SHADER_STAGE_FRAGMENT, sizeof( float ) ) };
 
     converterPass->build_shader_stages();
-    converterPass->build( m_descriptorPool );
+    converterPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["converter"] = converterPass;
 
@@ -91,7 +91,7 @@ void EnviromentPass::setup_shader_passes() {
         { POSITION_ATTRIBUTE, true }, { NORMAL_ATTRIBUTE, false }, { UV_ATTRIBUTE, false }, { TANGENT_ATTRIBUTE, false }, { COLOR_ATTRIBUTE, false } };
 
     irradiancePass->build_shader_stages();
-    irradiancePass->build( m_descriptorPool );
+    irradiancePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["irr"] = irradiancePass;
 
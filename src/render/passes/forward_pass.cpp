@@ -114,9 +114,10 @@ void ForwardPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
     m_descriptorPool.set_layout( GLOBAL_LAYOUT, { camBufferBinding, sceneBufferBinding, shadowBinding, envBinding, iblBinding, accelBinding, noiseBinding } );
 
     // PER-OBJECT SET
-    LayoutBinding objectBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
-    LayoutBinding materialBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
-    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding } );
+    LayoutBinding objectBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
+    LayoutBinding materialBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
+    LayoutBinding instanceIDBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX, 2 );
+    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding, instanceIDBufferBinding } );
 
     // MATERIAL TEXTURE SET
     LayoutBinding textureBinding1( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 0 );
@@ -127,6 +128,7 @@ void ForwardPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
     LayoutBinding textureBinding6( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 5 );
     m_descriptorPool.set_layout( OBJECT_TEXTURE_LAYOUT, { textureBinding1, textureBinding2, textureBinding3, textureBinding4, textureBinding5, textureBinding6 } );
 
+    m_instanceIDs.resize( frames.size() );
     for ( size_t i = 0; i < frames.size(); i++ )
     {
         // Global
@@ -147,13 +149,9 @@ void ForwardPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
 
         // Per-object
         m_descriptorPool.allocate_descriptor_set( OBJECT_LAYOUT, &m_descriptors[i].objectDescritor );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT], sizeof( Core::Object3D::GPUPayload ), 0, UNIFORM_DYNAMIC_BUFFER, 0 );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT],
-                                                 sizeof( Core::IMaterial::GPUPayload ),
-                                                 m_device->pad_uniform_buffer_size( sizeof( Core::IMaterial::GPUPayload ) ),
-
-                                                 UNIFORM_DYNAMIC_BUFFER,
-                                                 1 );
+        m_instanceIDs[i] = m_device->create_buffer_VMA(
+            ENGINE_INITIAL_INSTANCES * sizeof( uint32_t ), BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, sizeof( uint32_t ) );
+        update_instance_descriptor( m_descriptors[i].objectDescritor, frames[i], m_instanceIDs[i] );
         // Set up enviroment fallback texture
         m_descriptors[i].globalDescritor.update( m_shared->get_fallback_cubemap(), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 3 );
         m_descriptors[i].globalDescritor.update( m_shared->get_fallback_cubemap(), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 4 );
@@ -234,12 +232,31 @@ void ForwardPass::setup_shader_passes() {
     skyboxPass->graphicSettings.depthOp          = VK_COMPARE_OP_LESS_OR_EQUAL;
     m_shaderPasses["skybox"]                     = skyboxPass;
 
+    // Variants fed by the packed vertex layout. Other shaders only draw standard geometry
+    m_shaderPasses["unlitPacked"]    = unlitPass->create_packed_variant();
+    m_shaderPasses["physicalPacked"] = PBRPass->create_packed_variant();
+
     for ( auto pair : m_shaderPasses )
     {
         ShaderPass* pass = pair.second;
 
         pass->build_shader_stages();
-        pass->build( m_descriptorPool );
+        pass->build( m_descriptorPool, m_device->get_pipeline_cache() );
+    }
+
+    m_materialPasses.clear();
+    for ( auto& pair : m_shaderPasses )
+    {
+        const std::string& name = pair.first;
+        if ( name.size() > 6 && name.compare( name.size() - 6, 6, "Packed" ) == 0 )
+            continue;
+        auto packedPass = m_shaderPasses.find( name + "Packed" );
+
+        MaterialPasses& passes                 = m_materialPasses[name];
+        passes.ID                              = static_cast<uint32_t>( m_materialPasses.size() - 1 );
+        passes.layouts[STANDARD_VERTEX_LAYOUT] = pair.second;
+        passes.layouts[PACKED_VERTEX_LAYOUT]   = packedPass != m_shaderPasses.end() ? packedPass->second : nullptr;
+        passes.useTextures                     = pair.second->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT];
     }
 }
 
@@ -250,76 +267,180 @@ void ForwardPass::execute( Graphics::Frame& currentFrame, Scene* const scene, ui
         for ( size_t i = 0; i < 2; i++ )
             m_interAttachments[i].config.clearValue = m_outAttachments[i]->config.clearValue;
 
-    CommandBuffer cmd = currentFrame.commandBuffer;
-    cmd.begin_renderpass( m_renderpass, m_framebuffers[0] );
-    cmd.set_viewport( m_imageExtent );
+    CommandBuffer cmd          = currentFrame.commandBuffer;
+    bool          cameraActive = scene->get_active_camera() && scene->get_active_camera()->is_active();
 
-    if ( scene->get_active_camera() && scene->get_active_camera()->is_active() )
+    // Culled once per frame by the scene for every recording worker, and sorted once too
+    m_visibleMeshes.clear();
+    m_draws.clear();
+    m_queue.clear();
+    if ( cameraActive )
     {
+        scene->get_camera_visibility().get_visible( m_visibleMeshes );
+        build_queue( scene );
+    }
+    const size_t MESH_COUNT    = m_queue.size();
+    const size_t RECORD_CHUNKS = cameraActive && m_jobSystem ? m_jobSystem->get_chunk_count( MESH_COUNT, ENGINE_MIN_DRAWS_PER_RECORDING_JOB ) : 1;
+
+    if ( cameraActive )
+    {
+        upload_instance_IDs( currentFrame );
+        // Instance tables might have grown this frame
+        update_instance_descriptor( m_descriptors[currentFrame.index].objectDescritor, currentFrame, m_instanceIDs[currentFrame.index] );
+    }
 
-        unsigned int mesh_idx = 0;
-        for ( Mesh* m : scene->get_meshes() )
+    if ( RECORD_CHUNKS <= 1 )
+    {
+        cmd.begin_renderpass( m_renderpass, m_framebuffers[0] );
+        cmd.set_viewport( m_imageExtent );
+        if ( cameraActive )
         {
-            if ( m )
-            {
-                if ( m->is_active() &&    // Check if is active
-                     m->get_geometry() && // Check if has geometry
-                     ( scene->get_active_camera()->get_frustrum_culling() && m->get_bounding_volume()
-                           ? m->get_bounding_volume()->is_on_frustrum( scene->get_active_camera()->get_frustrum() )
-                           : true ) ) // Check if is inside frustrum
-                {
-                    // Offset calculation
-                    uint32_t objectOffset = currentFrame.uniformBuffers[1].strideSize * mesh_idx;
-
-                    auto g   = m->get_geometry();
-                    auto mat = m->get_material();
-
-                    cmd.set_depth_test_enable( mat->get_parameters().depthTest );
-                    cmd.set_depth_write_enable( mat->get_parameters().depthWrite );
-                    cmd.set_cull_mode( mat->get_parameters().faceCulling ? mat->get_parameters().culling : CullingMode::NO_CULLING );
-
-                    ShaderPass* shaderPass = m_shaderPasses[mat->get_shaderpass_ID()];
-
-                    // Bind pipeline
-                    cmd.bind_shaderpass( *shaderPass );
-                    // GLOBAL LAYOUT BINDING
-                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
-                    // PER OBJECT LAYOUT BINDING
-                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass, { objectOffset, objectOffset } );
-                    // TEXTURE LAYOUT BINDING
-                    if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
-                        cmd.bind_descriptor_set( mat->get_texture_descriptor(), 2, *shaderPass );
-
-                    // DRAW
-                    cmd.draw_geometry( *get_VAO( g ) );
-                }
-            }
-            mesh_idx++;
+            record_meshes( cmd, currentFrame, scene, 0, MESH_COUNT );
+            record_skybox( cmd, currentFrame, scene );
         }
-        // Skybox
-        if ( scene->get_skybox() )
-        {
-            if ( scene->get_skybox()->is_active() )
-            {
+        cmd.end_renderpass( m_renderpass, m_framebuffers[0] );
+        return;
+    }
 
-                cmd.set_depth_test_enable( true );
-                cmd.set_depth_write_enable( true );
-                cmd.set_cull_mode( CullingMode::NO_CULLING );
+    // Long mesh lists are split across workers, each one recording its range into a secondary command buffer of its own pool
+    std::vector<CommandBuffer> secondaryBuffers( RECORD_CHUNKS );
+    m_jobSystem->parallel_for( MESH_COUNT, ENGINE_MIN_DRAWS_PER_RECORDING_JOB, [&]( size_t begin, size_t end, size_t worker ) {
+        CommandBuffer& secondary = currentFrame.get_secondary_command_buffer( static_cast<uint32_t>( worker ) );
+        secondary.begin_secondary( m_renderpass, m_framebuffers[0] );
+        secondary.set_viewport( m_imageExtent );
+        record_meshes( secondary, currentFrame, scene, begin, end );
+        if ( end == MESH_COUNT )
+            record_skybox( secondary, currentFrame, scene );
+        secondary.end();
+        secondaryBuffers[worker] = secondary;
+    } );
+
+    cmd.begin_renderpass( m_renderpass, m_framebuffers[0], VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+    cmd.execute_commands( secondaryBuffers );
+    cmd.end_renderpass( m_renderpass, m_framebuffers[0] );
+}
 
-                ShaderPass* shaderPass = m_shaderPasses["skybox"];
+void ForwardPass::build_queue( Scene* const scene ) {
+    PROFILING_EVENT()
+    const std::vector<Mesh*>& meshes = scene->get_meshes();
+    const CullingBounds&      bounds = scene->get_culling_bounds();
+    const Vec3                eye    = scene->get_active_camera()->get_position();
 
-                // Bind pipeline
-                cmd.bind_shaderpass( *shaderPass );
+    m_draws.reserve( m_visibleMeshes.size() );
+    m_queue.reserve( m_visibleMeshes.size() );
+    for ( const uint32_t mesh_idx : m_visibleMeshes )
+    {
+        Mesh* m = meshes[mesh_idx];
+        if ( !m || !m->is_active() || !m->get_geometry() || !m->get_material() )
+            continue;
+        Geometry*  g   = m->get_geometry();
+        IMaterial* mat = m->get_material();
+
+        auto passes = m_materialPasses.find( mat->get_shaderpass_ID() );
+        if ( passes == m_materialPasses.end() )
+            continue;
+        const VertexLayout layout     = g->get_vertex_layout();
+        ShaderPass*        shaderPass = passes->second.layouts[layout];
+        if ( !shaderPass )
+            continue;
+
+        const float    depth = math::distance( eye, Vec3( bounds.centerX[mesh_idx], bounds.centerY[mesh_idx], bounds.centerZ[mesh_idx] ) );
+        const uint64_t key   = mat->get_parameters().blending
+                                   ? RenderQueue::make_blended_key( depth )
+                                   : RenderQueue::make_opaque_key(
+                                       2 * passes->second.ID + layout, RenderQueue::fold_ID( mat, 14 ), RenderQueue::fold_ID( g, 14 ), depth );
+        m_queue.push( key, static_cast<uint32_t>( m_draws.size() ) );
+        m_draws.push_back( { mesh_idx, g, mat, shaderPass, passes->second.useTextures } );
+    }
+    m_queue.sort();
+}
 
-                // GLOBAL LAYOUT BINDING
-                cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
+void ForwardPass::upload_instance_IDs( Graphics::Frame& currentFrame ) {
+    PROFILING_EVENT()
+    const std::vector<RenderQueueItem>& items = m_queue.get_items();
+    m_queueInstanceIDs.resize( items.size() );
+    for ( size_t i = 0; i < items.size(); i++ )
+        m_queueInstanceIDs[i] = m_draws[items[i].index].mesh;
+    if ( m_queueInstanceIDs.empty() )
+        return;
+
+    // Frame fence has been waited, so this frame's list is not in use. New buffer first, so the descriptor sees a new handle
+    Graphics::Buffer& instanceIDs = m_instanceIDs[currentFrame.index];
+    const size_t      SIZE        = m_queueInstanceIDs.size() * sizeof( uint32_t );
+    if ( instanceIDs.size < SIZE )
+    {
+        size_t capacity = std::max( (size_t)instanceIDs.size, ENGINE_INITIAL_INSTANCES * sizeof( uint32_t ) );
+        while ( capacity < SIZE )
+            capacity *= 2;
+        Graphics::Buffer buffer = m_device->create_buffer_VMA( capacity, BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, sizeof( uint32_t ) );
+        instanceIDs.cleanup();
+        instanceIDs = buffer;
+    }
+    instanceIDs.upload_data( m_queueInstanceIDs.data(), SIZE );
+}
 
-                cmd.draw_geometry( *get_VAO( scene->get_skybox()->get_box() ) );
-            }
+void ForwardPass::record_meshes( Graphics::CommandBuffer& cmd, Graphics::Frame& currentFrame, Scene* const scene, size_t begin, size_t end ) {
+    PROFILING_EVENT()
+    const std::vector<RenderQueueItem>& items = m_queue.get_items();
+
+    ShaderPass* boundPass = nullptr;
+    for ( size_t queue_idx = begin; queue_idx < end; )
+    {
+        const QueuedDraw& draw = m_draws[items[queue_idx].index];
+        Geometry*         g    = draw.geometry;
+        IMaterial*        mat  = draw.material;
+
+        // Copies of the geometry with the same material follow each other in the queue. They are drawn as instances of one draw
+        size_t run_end = queue_idx + 1;
+        while ( run_end < end && m_draws[items[run_end].index].geometry == g && m_draws[items[run_end].index].material == mat )
+            run_end++;
+
+        cmd.set_depth_test_enable( mat->get_parameters().depthTest );
+        cmd.set_depth_write_enable( mat->get_parameters().depthWrite );
+        cmd.set_cull_mode( mat->get_parameters().faceCulling ? mat->get_parameters().culling : CullingMode::NO_CULLING );
+
+        ShaderPass* shaderPass = draw.shaderPass;
+        if ( shaderPass != boundPass )
+        {
+            // Bind pipeline
+            cmd.bind_shaderpass( *shaderPass );
+            // GLOBAL LAYOUT BINDING
+            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
+            // PER OBJECT LAYOUT BINDING (instance and material tables, indexed in shader by instance ID)
+            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass );
+            boundPass = shaderPass;
         }
+        // TEXTURE LAYOUT BINDING. Draws of the same material are adjacent, so the command buffer skips most of these
+        if ( draw.useTextures )
+            cmd.bind_descriptor_set( mat->get_texture_descriptor(), 2, *shaderPass );
+
+        // DRAW (instance IDs are read from the list of the queue, starting at the first instance)
+        cmd.draw_geometry( *get_VAO( g ), static_cast<uint32_t>( run_end - queue_idx ), 0, 0, static_cast<uint32_t>( queue_idx ) );
+        queue_idx = run_end;
     }
+}
 
-    cmd.end_renderpass( m_renderpass, m_framebuffers[0] );
+void ForwardPass::record_skybox( Graphics::CommandBuffer& cmd, Graphics::Frame& currentFrame, Scene* const scene ) {
+    if ( scene->get_skybox() )
+    {
+        if ( scene->get_skybox()->is_active() )
+        {
+
+            cmd.set_depth_test_enable( true );
+            cmd.set_depth_write_enable( true );
+            cmd.set_cull_mode( CullingMode::NO_CULLING );
+
+            ShaderPass* shaderPass = m_shaderPasses.at( "skybox" );
+
+            // Bind pipeline
+            cmd.bind_shaderpass( *shaderPass );
+
+            // GLOBAL LAYOUT BINDING
+            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
+
+            cmd.draw_geometry( *get_VAO( scene->get_skybox()->get_box() ) );
+        }
+    }
 }
 
 void ForwardPass::update_uniforms( uint32_t frameIndex, Scene* const scene ) {
@@ -381,5 +502,12 @@ void ForwardPass::setup_material_descriptor( IMaterial* mat ) {
     }
 }
 
+void ForwardPass::cleanup() {
+    for ( Graphics::Buffer& instanceIDs : m_instanceIDs )
+        instanceIDs.cleanup();
+    m_instanceIDs.clear();
+    BaseGraphicPass::cleanup();
+}
+
 } // namespace Render
 VULKAN_ENGINE_NAMESPACE_END
\ No newline at end of file
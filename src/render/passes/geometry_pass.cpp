@@ -57,7 +57,9 @@ void GeometryPass::setup_out_attachments( std::vector<Graphics::AttachmentConfig
 }
 void GeometryPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
 
-    m_descriptorPool = m_device->create_descriptor_pool( ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS );
+    // Global and per-object sets of each frame. Material textures live in pools of their own
+    const uint32_t FRAMES = static_cast<uint32_t>( frames.size() );
+    m_descriptorPool      = m_device->create_descriptor_pool( 2 * FRAMES, 0, 2 * FRAMES, 3 * FRAMES, 5 * FRAMES );
     m_descriptors.resize( frames.size() );
 
     // GLOBAL SET
@@ -73,17 +75,20 @@ void GeometryPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
         GLOBAL_LAYOUT, { camBufferBinding, sceneBufferBinding, shadowBinding, envBinding, iblBinding, accelBinding, noiseBinding, skyBinding } );
 
     // PER-OBJECT SET
-    LayoutBinding objectBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
-    LayoutBinding materialBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
-    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding } );
+    LayoutBinding objectBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
+    LayoutBinding materialBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
+    LayoutBinding instanceIDBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX, 2 );
+    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding, instanceIDBufferBinding } );
 
     // MATERIAL TEXTURE SET
-    LayoutBinding materialTextureBufferBinding( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 0, MAX_TEXTURES );
+    LayoutBinding materialTextureBufferBinding( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 0, get_max_material_textures() );
     m_descriptorPool.set_layout( OBJECT_TEXTURE_LAYOUT,
                                  { materialTextureBufferBinding },
                                  0,
                                  VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT );
 
+    m_culler.setup( m_device, frames, GPUCuller::Mode::CAMERA );
+
     for ( size_t i = 0; i < frames.size(); i++ )
     {
         // Global
@@ -102,18 +107,13 @@ void GeometryPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
 
         // Per-object
         m_descriptorPool.allocate_descriptor_set( OBJECT_LAYOUT, &m_descriptors[i].objectDescritor );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT], sizeof( Core::Object3D::GPUPayload ), 0, UNIFORM_DYNAMIC_BUFFER, 0 );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT],
-                                                 sizeof(  Core::IMaterial::GPUPayload ),
-                                                 m_device->pad_uniform_buffer_size( sizeof(  Core::IMaterial::GPUPayload ) ),
-                                                 UNIFORM_DYNAMIC_BUFFER,
-                                                 1 );
+        update_instance_descriptor( m_descriptors[i].objectDescritor, frames[i], m_culler.get_instance_IDs( frames[i] ) );
         // Set up enviroment fallback texture
         m_descriptors[i].globalDescritor.update( m_shared->get_fallback_cubemap(), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 3 );
         m_descriptors[i].globalDescritor.update( m_shared->get_fallback_cubemap(), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 4 );
 
-        // Textures
-        m_descriptorPool.allocate_variable_descriptor_set( OBJECT_TEXTURE_LAYOUT, &m_descriptors[i].textureDescritor, MAX_TEXTURES );
+        // Textures. Sized after the material table, in a pool of their own
+        reserve_material_textures( m_descriptors[i].textures, ENGINE_INITIAL_INSTANCES );
     }
 }
 void GeometryPass::setup_shader_passes() {
@@ -136,7 +136,7 @@ void GeometryPass::setup_shader_passes() {
     geomPass->graphicSettings.depthOp          = VK_COMPARE_OP_GREATER_OR_EQUAL;
 
     geomPass->build_shader_stages();
-    geomPass->build( m_descriptorPool );
+    geomPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["geometryTri"] = geomPass;
 
@@ -149,7 +149,7 @@ void GeometryPass::setup_shader_passes() {
         { POSITION_ATTRIBUTE, true }, { NORMAL_ATTRIBUTE, false }, { UV_ATTRIBUTE, true }, { TANGENT_ATTRIBUTE, true }, { COLOR_ATTRIBUTE, false } };
 
     geomLinePass->build_shader_stages();
-    geomLinePass->build( m_descriptorPool );
+    geomLinePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["geometryLineTri"] = geomLinePass;
 
@@ -162,10 +162,26 @@ void GeometryPass::setup_shader_passes() {
         { POSITION_ATTRIBUTE, true }, { NORMAL_ATTRIBUTE, false }, { UV_ATTRIBUTE, true }, { TANGENT_ATTRIBUTE, true }, { COLOR_ATTRIBUTE, false } };
 
     linePass->build_shader_stages();
-    linePass->build( m_descriptorPool );
+    linePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["geometryLine"] = linePass;
 
+    // Variants fed by the packed vertex layout
+    for ( const std::string name : { "geometryTri", "geometryLineTri", "geometryLine" } )
+    {
+        GraphicShaderPass* packedPass = static_cast<GraphicShaderPass*>( m_shaderPasses[name] )->create_packed_variant();
+        packedPass->build_shader_stages();
+        packedPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
+        m_shaderPasses[name + "Packed"] = packedPass;
+    }
+    // Indexed by topology. Other topologies are drawn as triangles
+    const std::string bucketPassNames[4] = { "geometryTri", "geometryLine", "geometryLineTri", "geometryTri" };
+    for ( uint32_t topology = 0; topology < 4; topology++ )
+    {
+        m_bucketPasses[topology][STANDARD_VERTEX_LAYOUT] = m_shaderPasses[bucketPassNames[topology]];
+        m_bucketPasses[topology][PACKED_VERTEX_LAYOUT]   = m_shaderPasses[bucketPassNames[topology] + "Packed"];
+    }
+
     GraphicShaderPass* skyboxPass =
         new GraphicShaderPass( m_device->get_handle(), m_renderpass, m_imageExtent, GET_RESOURCE_PATH( "shaders/deferred/skybox.glsl" ) );
     skyboxPass->settings.descriptorSetLayoutIDs = { { GLOBAL_LAYOUT, true }, { OBJECT_LAYOUT, false }, { OBJECT_TEXTURE_LAYOUT, false } };
@@ -175,7 +191,7 @@ void GeometryPass::setup_shader_passes() {
     skyboxPass->graphicSettings.blendAttachments = geomPass->graphicSettings.blendAttachments;
 
     skyboxPass->build_shader_stages();
-    skyboxPass->build( m_descriptorPool );
+    skyboxPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["skybox"] = skyboxPass;
 }
@@ -183,10 +199,16 @@ void GeometryPass::execute( Graphics::Frame& currentFrame, Scene* const scene, u
     PROFILING_EVENT()
 
     CommandBuffer cmd = currentFrame.commandBuffer;
+
+    const bool cameraActive = scene->get_active_camera() && scene->get_active_camera()->is_active();
+    // Instance culling runs on the GPU and has to be recorded outside the render pass
+    if ( cameraActive )
+        m_culler.cull( currentFrame, scene->get_active_camera()->get_frustrum_culling() );
+
     cmd.begin_renderpass( m_renderpass, m_framebuffers[0] );
     cmd.set_viewport( m_imageExtent );
 
-    if ( scene->get_active_camera() && scene->get_active_camera()->is_active() )
+    if ( cameraActive )
     {
         // Skybox
         if ( scene->get_skybox() )
@@ -210,71 +232,33 @@ void GeometryPass::execute( Graphics::Frame& currentFrame, Scene* const scene, u
             }
         }
 
-        ShaderPass* shaderPass;
-        shaderPass = m_shaderPasses["geometryTri"];
-        cmd.bind_shaderpass( *shaderPass );
-        // GLOBAL LAYOUT BINDING
-        cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
-        // TEXTURE LAYOUT BINDING
-        if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
-            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].textureDescritor, 2, *shaderPass );
+        // Instance tables might have grown this frame
+        update_instance_descriptor( m_descriptors[currentFrame.index].objectDescritor, currentFrame, m_culler.get_instance_IDs( currentFrame ) );
 
-        Topology prevTopology = Topology::TRIANGLES;
-
-        unsigned int mesh_idx = 0;
-        for ( Mesh* m : scene->get_meshes() )
+        // One indirect draw per render state bucket. Commands were written by the culling pass
+        ShaderPass* boundPass = nullptr;
+        for ( const DrawBucket& bucket : currentFrame.drawBuckets )
         {
-            if ( m )
+            // Choose shader pass based on topology and vertex layout
+            Topology     topology   = GPUCuller::get_topology( bucket.stateKey );
+            VertexLayout layout     = GPUCuller::get_vertex_layout( bucket.stateKey );
+            ShaderPass*  shaderPass = m_bucketPasses[static_cast<uint32_t>( topology )][layout];
+            if ( shaderPass != boundPass )
             {
-                if ( m->is_active() &&    // Check if is active
-                     m->get_geometry() && // Check if has geometry
-                     ( scene->get_active_camera()->get_frustrum_culling() && m->get_bounding_volume()
-                           ? m->get_bounding_volume()->is_on_frustrum( scene->get_active_camera()->get_frustrum() )
-                           : true ) ) // Check if is inside frustrum
-                {
-                    // Offset calculation
-                    uint32_t objectOffset = currentFrame.uniformBuffers[1].strideSize * mesh_idx;
-
-                    Geometry*  g   = m->get_geometry();
-                    IMaterial* mat = m->get_material();
-
-                    cmd.set_depth_test_enable( mat->get_parameters().depthTest );
-                    cmd.set_depth_write_enable( mat->get_parameters().depthWrite );
-                    cmd.set_cull_mode( mat->get_parameters().faceCulling ? mat->get_parameters().culling : CullingMode::NO_CULLING );
-
-                    if ( prevTopology != g->get_properties().topology )
-                    {
-                        // Choose shader pass based on topology
-                        switch ( g->get_properties().topology )
-                        {
-                            case Topology::TRIANGLES:
-                                shaderPass = m_shaderPasses["geometryTri"];
-                                break;
-                            case Topology::LINES_TO_TRIANGLES:
-                                shaderPass = m_shaderPasses["geometryLineTri"];
-                                break;
-                            case Topology::LINES:
-                                shaderPass = m_shaderPasses["geometryLine"];
-                                break;
-                            default:
-                                break;
-                        }
-                        // Rebind global descriptors
-                        cmd.bind_shaderpass( *shaderPass );
-                        // GLOBAL LAYOUT BINDING
-                        cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
-                        // TEXTURE LAYOUT BINDING
-                        if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
-                            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].textureDescritor, 2, *shaderPass );
-                    }
-                    // PER OBJECT LAYOUT BINDING
-                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass, { objectOffset, objectOffset } );
-
-                    // DRAW
-                    cmd.draw_geometry( *get_VAO( g ) );
-                }
+                cmd.bind_shaderpass( *shaderPass );
+                // GLOBAL LAYOUT BINDING
+                cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
+                // PER OBJECT LAYOUT BINDING (instance and material tables, indexed in shader by instance ID)
+                cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass );
+                // TEXTURE LAYOUT BINDING
+                if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
+                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].textures.set, 2, *shaderPass );
+                boundPass = shaderPass;
             }
-            mesh_idx++;
+
+            GPUCuller::apply_state( cmd, bucket.stateKey );
+            // DRAW (instance IDs are read from the culler lists)
+            m_culler.draw( currentFrame, bucket, m_shared->get_arena_VAO( layout ) );
         }
     }
 
@@ -291,35 +275,22 @@ void GeometryPass::link_input_attachments() {
     }
 }
 
-void GeometryPass::update_uniforms( uint32_t frameIndex, Scene* const scene ) {
-    uint32_t meshIdx = 0;
-    for ( Mesh* m : scene->get_meshes() )
-    {
-        if ( m )
-        {
-            auto g   = m->get_geometry();
-            auto mat = m->get_material();
-            setup_material_descriptor( mat, meshIdx );
-        }
-        meshIdx++;
-    }
+void GeometryPass::cleanup() {
+    for ( FrameDescriptors& descriptors : m_descriptors )
+        descriptors.textures.pool.cleanup();
+    m_culler.cleanup();
+    BaseGraphicPass::cleanup();
 }
 
-void GeometryPass::setup_material_descriptor( IMaterial* mat, uint32_t meshIdx ) {
-    auto textures = mat->get_textures();
-    for ( auto pair : textures )
+void GeometryPass::update_uniforms( uint32_t frameIndex, Scene* const scene ) {
+    // Material indices are positions in the scene mesh list, as laid out in the material table
+    const std::vector<Mesh*>& meshes   = scene->get_meshes();
+    MaterialTextures&         textures = m_descriptors[frameIndex].textures;
+    reserve_material_textures( textures, meshes.size() );
+    for ( size_t materialIdx = 0; materialIdx < meshes.size(); materialIdx++ )
     {
-        ITexture* texture = pair.second;
-        if ( texture && texture->loaded_on_GPU() )
-        {
-
-            for ( size_t i = 0; i < m_descriptors.size(); i++ )
-            {
-                uint32_t bindingPoint = 0;
-                m_descriptors[i].textureDescritor.update(
-                    get_image( texture ), LAYOUT_SHADER_READ_ONLY_OPTIMAL, bindingPoint, UNIFORM_COMBINED_IMAGE_SAMPLER, pair.first + 6 * meshIdx );
-            }
-        }
+        if ( meshes[materialIdx] )
+            update_material_textures( textures, meshes[materialIdx]->get_material(), static_cast<uint32_t>( materialIdx ) );
     }
 }
 } // namespace Core
@@ -8,6 +8,8 @@ void BaseGraphicPass::setup(std::vector<Graphics::Frame>& frames) {
     std::vector<Graphics::AttachmentConfig>  attachments;
     std::vector<Graphics::SubPassDependency> dependencies;
     setup_out_attachments(attachments, dependencies);
+    if (!m_outputReaders.empty())
+        derive_dependencies(attachments, dependencies);
 
     if (!attachments.empty())
     {
@@ -21,6 +23,62 @@ void BaseGraphicPass::setup(std::vector<Graphics::Frame>& frames) {
     setup_uniforms(frames);
     setup_shader_passes();
 }
+void BaseGraphicPass::derive_dependencies(const std::vector<Graphics::AttachmentConfig>& attachments,
+                                          std::vector<Graphics::SubPassDependency>&     dependencies) {
+    if (m_isDefault || attachments.size() != m_outAttachments.size())
+        return;
+    for (const Graphics::AttachmentConfig& attachment : attachments)
+    {
+        if (attachment.isDefault || attachment.type == AttachmentType::RESOLVE_ATTACHMENT)
+            return;
+    }
+
+    std::vector<Graphics::SubPassDependency> derived;
+    auto add_dependency = [&](uint32_t srcSubpass, PipelineStage srcStage, PipelineStage dstStage, AccessFlags srcAccess, AccessFlags dstAccess) {
+        for (const Graphics::SubPassDependency& dep : derived)
+        {
+            if (dep.srcSubpass == srcSubpass && dep.srcStageMask == srcStage && dep.dstStageMask == dstStage && dep.srcAccessMask == srcAccess &&
+                dep.dstAccessMask == dstAccess)
+                return;
+        }
+        Graphics::SubPassDependency dep(srcStage, dstStage, dstAccess, SUBPASS_DEPENDENCY_NONE);
+        dep.srcAccessMask = srcAccess;
+        dep.srcSubpass    = srcSubpass;
+        dep.dstSubpass    = srcSubpass == VK_SUBPASS_EXTERNAL ? 0 : VK_SUBPASS_EXTERNAL;
+        derived.push_back(dep);
+    };
+
+    for (size_t i = 0; i < attachments.size(); i++)
+    {
+        const bool  depth       = attachments[i].type == AttachmentType::DEPTH_ATTACHMENT;
+        AccessFlags writeAccess = depth ? ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE : ACCESS_COLOR_ATTACHMENT_WRITE;
+        // Debug views can sample any output, so fragment readers are always assumed
+        uint32_t readers = GRAPH_READ_FRAGMENT | (i < m_outputReaders.size() ? m_outputReaders[i] : GRAPH_READ_NONE);
+
+        for (PipelineStage readStage : {STAGE_FRAGMENT_SHADER, STAGE_COMPUTE_SHADER})
+        {
+            if (readStage == STAGE_COMPUTE_SHADER && !(readers & GRAPH_READ_COMPUTE))
+                continue;
+            // Write after read (previous frame readers). Execution only
+            add_dependency(VK_SUBPASS_EXTERNAL, readStage, depth ? STAGE_EARLY_FRAGMENT_TESTS : STAGE_COLOR_ATTACHMENT_OUTPUT, ACCESS_NONE, writeAccess);
+            // Read after write
+            if (depth)
+            {
+                add_dependency(0, STAGE_EARLY_FRAGMENT_TESTS, readStage, writeAccess, ACCESS_SHADER_READ);
+                add_dependency(0, STAGE_LATE_FRAGMENT_TESTS, readStage, writeAccess, ACCESS_SHADER_READ);
+            } else
+                add_dependency(0, STAGE_COLOR_ATTACHMENT_OUTPUT, readStage, writeAccess, ACCESS_SHADER_READ);
+        }
+    }
+
+    // Dependencies between subpasses are kept
+    for (const Graphics::SubPassDependency& dep : dependencies)
+    {
+        if (dep.srcSubpass != VK_SUBPASS_EXTERNAL && dep.dstSubpass != VK_SUBPASS_EXTERNAL)
+            derived.push_back(dep);
+    }
+    dependencies = derived;
+}
 void BaseGraphicPass::cleanup() {
     m_renderpass.cleanup();
     clean_framebuffer();
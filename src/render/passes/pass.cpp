@@ -22,6 +22,53 @@ void BasePass::setup( std::vector<Graphics::Frame>& frames ) {
     setup_uniforms( frames );
     setup_shader_passes();
 }
+void BasePass::update_instance_descriptor( Graphics::DescriptorSet& descriptor, Graphics::Frame& frame, Graphics::Buffer& instanceIDs ) {
+    descriptor.update( &frame.uniformBuffers[INSTANCE_BUFFER], frame.uniformBuffers[INSTANCE_BUFFER].size, 0, UNIFORM_STORAGE_BUFFER, 0 );
+    descriptor.update( &frame.uniformBuffers[MATERIAL_BUFFER], frame.uniformBuffers[MATERIAL_BUFFER].size, 0, UNIFORM_STORAGE_BUFFER, 1 );
+    descriptor.update( &instanceIDs, instanceIDs.size, 0, UNIFORM_STORAGE_BUFFER, 2 );
+}
+uint32_t BasePass::get_max_material_textures() const {
+    // Leaves room for the samplers of the other sets
+    const uint32_t OTHER_SAMPLERS = 16;
+    const uint32_t STAGE_LIMIT    = m_device->get_max_stage_textures();
+    const uint32_t MAX_SLOTS      = std::min<uint32_t>( ENGINE_MAX_BINDLESS_TEXTURES, STAGE_LIMIT > OTHER_SAMPLERS ? STAGE_LIMIT - OTHER_SAMPLERS : 0 );
+    // Whole materials only
+    return std::max<uint32_t>( MAX_SLOTS - MAX_SLOTS % MAX_TEXTURES_PER_MATERIAL, MAX_TEXTURES_PER_MATERIAL );
+}
+void BasePass::reserve_material_textures( MaterialTextures& textures, size_t materialCount ) {
+    if ( materialCount * MAX_TEXTURES_PER_MATERIAL <= textures.slots )
+        return;
+    size_t capacity = std::max<size_t>( textures.slots / MAX_TEXTURES_PER_MATERIAL, ENGINE_INITIAL_INSTANCES );
+    while ( capacity < materialCount )
+        capacity *= 2;
+
+    const uint32_t MAX_SLOTS = get_max_material_textures();
+    const uint32_t SLOTS     = static_cast<uint32_t>( std::min<size_t>( capacity * MAX_TEXTURES_PER_MATERIAL, MAX_SLOTS ) );
+    if ( SLOTS <= textures.slots )
+        return;
+    if ( materialCount * MAX_TEXTURES_PER_MATERIAL > MAX_SLOTS )
+        LOG_WARN( "Material table exceeds the bindless texture limit. Materials past " + std::to_string( MAX_SLOTS / MAX_TEXTURES_PER_MATERIAL ) +
+                  " have no textures bound" );
+
+    // Variable count sets can not grow. Its pool is recreated with room for the new size
+    textures.pool.cleanup();
+    textures.pool = m_device->create_descriptor_pool( 1, 0, 0, 0, SLOTS );
+    textures.set  = {};
+    textures.pool.allocate_variable_descriptor_set( m_descriptorPool.get_layout( OBJECT_TEXTURE_LAYOUT ), OBJECT_TEXTURE_LAYOUT, &textures.set, SLOTS );
+    textures.slots = SLOTS;
+}
+void BasePass::update_material_textures( MaterialTextures& textures, Core::IMaterial* mat, uint32_t materialIdx ) {
+    const size_t FIRST_SLOT = static_cast<size_t>( materialIdx ) * MAX_TEXTURES_PER_MATERIAL;
+    if ( FIRST_SLOT + MAX_TEXTURES_PER_MATERIAL > textures.slots )
+        return;
+    for ( auto pair : mat->get_textures() )
+    {
+        ITexture* texture = pair.second;
+        if ( texture && texture->loaded_on_GPU() && pair.first < MAX_TEXTURES_PER_MATERIAL )
+            textures.set.update(
+                get_image( texture ), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, UNIFORM_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>( FIRST_SLOT ) + pair.first );
+    }
+}
 void BasePass::cleanup() {
     CHECK_INITIALIZATION()
     for ( auto pair : m_shaderPasses )
@@ -128,7 +128,7 @@ void PreCompositionPass::setup_shader_passes() {
     compPass->settings.pushConstants = { PushConstant( SHADER_STAGE_FRAGMENT, sizeof( AO ) ) };
 
     compPass->build_shader_stages();
-    compPass->build( m_descriptorPool );
+    compPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
     m_shaderPasses["pre"] = compPass;
 
     GraphicShaderPass* blurPass =
@@ -140,7 +140,7 @@ void PreCompositionPass::setup_shader_passes() {
     blurPass->settings.pushConstants = { PushConstant( SHADER_STAGE_FRAGMENT, sizeof( float ) ) };
 
     blurPass->build_shader_stages();
-    blurPass->build( m_descriptorPool );
+    blurPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
     m_shaderPasses["blur"] = blurPass;
 }
 
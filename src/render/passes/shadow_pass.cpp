@@ -49,9 +49,12 @@ void ShadowPass::setup_uniforms(std::vector<Graphics::Frame>& frames) {
     m_descriptorPool.set_layout(GLOBAL_LAYOUT, {camBufferBinding, sceneBufferBinding, shadowBinding, envBinding, iblBinding});
 
     // PER-OBJECT SET
-    LayoutBinding objectBufferBinding(UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0);
-    LayoutBinding materialBufferBinding(UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1);
-    m_descriptorPool.set_layout(OBJECT_LAYOUT, {objectBufferBinding, materialBufferBinding});
+    LayoutBinding objectBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0);
+    LayoutBinding materialBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1);
+    LayoutBinding instanceIDBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX, 2);
+    m_descriptorPool.set_layout(OBJECT_LAYOUT, {objectBufferBinding, materialBufferBinding, instanceIDBufferBinding});
+
+    m_culler.setup(m_device, frames, GPUCuller::Mode::LIGHTS);
 
     for (size_t i = 0; i < frames.size(); i++)
     {
@@ -67,12 +70,7 @@ void ShadowPass::setup_uniforms(std::vector<Graphics::Frame>& frames) {
 
         // Per-object
         m_descriptorPool.allocate_descriptor_set(OBJECT_LAYOUT, &m_descriptors[i].objectDescritor);
-        m_descriptors[i].objectDescritor.update(&frames[i].uniformBuffers[OBJECT_LAYOUT], sizeof(Core::Object3D::GPUPayload), 0, UNIFORM_DYNAMIC_BUFFER, 0);
-        m_descriptors[i].objectDescritor.update(&frames[i].uniformBuffers[OBJECT_LAYOUT],
-                                                sizeof( Core::IMaterial::GPUPayload),
-                                                m_device->pad_uniform_buffer_size(sizeof( Core::IMaterial::GPUPayload)),
-                                                UNIFORM_DYNAMIC_BUFFER,
-                                                1);
+        update_instance_descriptor(m_descriptors[i].objectDescritor, frames[i], m_culler.get_instance_IDs(frames[i]));
     }
 }
 void ShadowPass::setup_shader_passes() {
@@ -98,7 +96,7 @@ void ShadowPass::setup_shader_passes() {
     depthPass->settings        = settings;
     depthPass->graphicSettings = gfxSettings;
     depthPass->build_shader_stages();
-    depthPass->build(m_descriptorPool);
+    depthPass->build(m_descriptorPool, m_device->get_pipeline_cache());
     m_shaderPasses["shadow"] = depthPass;
 
     GraphicShaderPass* depthLinePass =
@@ -108,14 +106,33 @@ void ShadowPass::setup_shader_passes() {
     depthLinePass->graphicSettings.topology    = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
     depthLinePass->graphicSettings.poligonMode = VK_POLYGON_MODE_LINE;
     depthLinePass->build_shader_stages();
-    depthLinePass->build(m_descriptorPool);
+    depthLinePass->build(m_descriptorPool, m_device->get_pipeline_cache());
     m_shaderPasses["shadowLine"] = depthLinePass;
+
+    // Packed geometry only feeds its position stream to these
+    for (const std::string name : {"shadow", "shadowLine"})
+    {
+        GraphicShaderPass* packedPass = static_cast<GraphicShaderPass*>(m_shaderPasses[name])->create_packed_variant();
+        packedPass->build_shader_stages();
+        packedPass->build(m_descriptorPool, m_device->get_pipeline_cache());
+        m_shaderPasses[name + "Packed"] = packedPass;
+    }
+    // Indexed by topology. Line geometry (hair strands) goes through the line shader
+    const std::string bucketPassNames[4] = {"shadow", "shadowLine", "shadowLine", "shadowLine"};
+    for (uint32_t topology = 0; topology < 4; topology++)
+    {
+        m_bucketPasses[topology][STANDARD_VERTEX_LAYOUT] = m_shaderPasses[bucketPassNames[topology]];
+        m_bucketPasses[topology][PACKED_VERTEX_LAYOUT]   = m_shaderPasses[bucketPassNames[topology] + "Packed"];
+    }
 }
 
 void ShadowPass::execute(Graphics::Frame& currentFrame, Scene* const scene, uint32_t presentImageIndex) {
     PROFILING_EVENT()
 
     CommandBuffer cmd = currentFrame.commandBuffer;
+    // Instances outside every light frustum are culled on the GPU. Recorded outside the render pass
+    m_culler.cull(currentFrame);
+
     cmd.begin_renderpass(m_renderpass, m_framebuffers[presentImageIndex]);
     cmd.set_viewport(m_imageExtent);
 
@@ -124,42 +141,41 @@ void ShadowPass::execute(Graphics::Frame& currentFrame, Scene* const scene, uint
     float depthBiasSlope    = 0.0f;
     cmd.set_depth_bias(depthBiasConstant, 0.0f, depthBiasSlope);
 
-    int mesh_idx = 0;
-    for (Mesh* m : scene->get_meshes())
+    // Instance tables might have grown this frame
+    update_instance_descriptor(m_descriptors[currentFrame.index].objectDescritor, currentFrame, m_culler.get_instance_IDs(currentFrame));
+
+    // One indirect draw per render state bucket. Commands were written by the culling pass
+    ShaderPass* boundPass = nullptr;
+    for (const DrawBucket& bucket : currentFrame.drawBuckets)
     {
-        if (m)
+        Topology     topology   = GPUCuller::get_topology(bucket.stateKey);
+        VertexLayout layout     = GPUCuller::get_vertex_layout(bucket.stateKey);
+        ShaderPass*  shaderPass = m_bucketPasses[static_cast<uint32_t>(topology)][layout];
+
+        GPUCuller::apply_state(cmd, bucket.stateKey);
+
+        if (shaderPass != boundPass)
         {
-            if (m->is_active() && m->cast_shadows() && m->get_geometry())
-            {
-                uint32_t objectOffset = currentFrame.uniformBuffers[1].strideSize * mesh_idx;
-
-                // Setup per object render state
-                auto g   = m->get_geometry();
-                auto mat = m->get_material();
-
-                ShaderPass* shaderPass =
-                    mat->get_shaderpass_ID() != "hairstr" && mat->get_shaderpass_ID() != "hairstr2" ? m_shaderPasses["shadow"] : m_shaderPasses["shadowLine"];
-
-                cmd.set_depth_test_enable(mat->get_parameters().depthTest);
-                cmd.set_depth_write_enable(mat->get_parameters().depthWrite);
-                cmd.set_cull_mode(mat->get_parameters().faceCulling ? mat->get_parameters().culling : CullingMode::NO_CULLING);
-
-                cmd.bind_shaderpass(*shaderPass);
-                // GLOBAL LAYOUT BINDING
-                cmd.bind_descriptor_set(m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, {0, 0});
-                // PER OBJECT LAYOUT BINDING
-                cmd.bind_descriptor_set(m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass, {objectOffset, objectOffset});
-
-                // DRAW
-                cmd.draw_geometry(*get_VAO(g));
-            }
-            mesh_idx++;
+            cmd.bind_shaderpass(*shaderPass);
+            // GLOBAL LAYOUT BINDING
+            cmd.bind_descriptor_set(m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, {0, 0});
+            // PER OBJECT LAYOUT BINDING (instance tables, indexed in shader by instance ID)
+            cmd.bind_descriptor_set(m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass);
+            boundPass = shaderPass;
         }
+
+        // DRAW (first instance of each command carries the instance ID)
+        m_culler.draw(currentFrame, bucket, m_shared->get_arena_VAO(layout));
     }
 
     cmd.end_renderpass(m_renderpass, m_framebuffers[0]);
 }
 
+void ShadowPass::cleanup() {
+    m_culler.cleanup();
+    BaseGraphicPass::cleanup();
+}
+
 } // namespace Core
 
 VULKAN_ENGINE_NAMESPACE_END
\ No newline at end of file
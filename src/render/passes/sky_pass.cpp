@@ -66,7 +66,7 @@ void SkyPass::setup_shader_passes() {
         {POSITION_ATTRIBUTE, true}, {NORMAL_ATTRIBUTE, false}, {UV_ATTRIBUTE, true}, {TANGENT_ATTRIBUTE, false}, {COLOR_ATTRIBUTE, false}};
 
     ttPass->build_shader_stages();
-    ttPass->build(m_descriptorPool);
+    ttPass->build(m_descriptorPool, m_device->get_pipeline_cache());
 
     m_shaderPasses["tt"] = ttPass;
 
@@ -76,7 +76,7 @@ void SkyPass::setup_shader_passes() {
     skyPass->graphicSettings.attributes      = ttPass->graphicSettings.attributes;
 
     skyPass->build_shader_stages();
-    skyPass->build(m_descriptorPool);
+    skyPass->build(m_descriptorPool, m_device->get_pipeline_cache());
 
     m_shaderPasses["sky"] = skyPass;
 
@@ -86,7 +86,7 @@ void SkyPass::setup_shader_passes() {
     projPass->graphicSettings.attributes      = ttPass->graphicSettings.attributes;
 
     projPass->build_shader_stages();
-    projPass->build(m_descriptorPool);
+    projPass->build(m_descriptorPool, m_device->get_pipeline_cache());
 
     m_shaderPasses["proj"] = projPass;
 }
@@ -17,7 +17,7 @@ void TonemappingPass::setup_shader_passes() {
     ppPass->settings.pushConstants = {Graphics::PushConstant(SHADER_STAGE_FRAGMENT, sizeof(float) * 2)};
 
     ppPass->build_shader_stages();
-    ppPass->build(m_descriptorPool);
+    ppPass->build(m_descriptorPool, m_device->get_pipeline_cache());
 
     m_shaderPasses["pp"] = ppPass;
 }
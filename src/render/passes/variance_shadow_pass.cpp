@@ -4,6 +4,24 @@ VULKAN_ENGINE_NAMESPACE_BEGIN
 using namespace Graphics;
 namespace Render {
 
+// Redrawn layers travel as a 64 bit mask
+static_assert(ENGINE_MAX_SHADOW_LAYERS <= 64, "Shadow layer masks hold up to 64 layers");
+
+namespace {
+// Negative radius for meshes not casting shadows
+bool is_sphere_in_view(const Core::Frustum& frustum, const Vec4& sphere) {
+    if (sphere.w < 0.0f)
+        return false;
+    const Vec3 center = Vec3(sphere);
+    for (const Core::Face* face : {&frustum.leftFace, &frustum.rightFace, &frustum.bottomFace, &frustum.topFace, &frustum.nearFace, &frustum.farFace})
+    {
+        if (face->get_signed_distance(center) < -sphere.w)
+            return false;
+    }
+    return true;
+}
+} // namespace
+
 void VarianceShadowPass::setup_out_attachments(std::vector<Graphics::AttachmentConfig>& attachments, std::vector<Graphics::SubPassDependency>& dependencies) {
 
     attachments.resize(2);
@@ -18,6 +36,9 @@ void VarianceShadowPass::setup_out_attachments(std::vector<Graphics::AttachmentC
                                                 TEXTURE_2D_ARRAY,
                                                 FILTER_LINEAR,
                                                 ADDRESS_MODE_CLAMP_TO_BORDER);
+    // Cached shadow maps are kept. Redrawn layers are cleared in the pass
+    attachments[0].loadOp        = ATTACHMENT_LOAD_OP_LOAD;
+    attachments[0].initialLayout = LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
     attachments[1] = Graphics::AttachmentConfig(m_depthFormat,
                                                 1,
@@ -50,9 +71,12 @@ void VarianceShadowPass::setup_uniforms(std::vector<Graphics::Frame>& frames) {
     m_descriptorPool.set_layout(GLOBAL_LAYOUT, {camBufferBinding, sceneBufferBinding, shadowBinding, envBinding, iblBinding});
 
     // PER-OBJECT SET
-    LayoutBinding objectBufferBinding(UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0);
-    LayoutBinding materialBufferBinding(UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1);
-    m_descriptorPool.set_layout(OBJECT_LAYOUT, {objectBufferBinding, materialBufferBinding});
+    LayoutBinding objectBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0);
+    LayoutBinding materialBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1);
+    LayoutBinding instanceIDBufferBinding(UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX, 2);
+    m_descriptorPool.set_layout(OBJECT_LAYOUT, {objectBufferBinding, materialBufferBinding, instanceIDBufferBinding});
+
+    m_culler.setup(m_device, frames, GPUCuller::Mode::LIGHTS);
 
     for (size_t i = 0; i < frames.size(); i++)
     {
@@ -68,12 +92,7 @@ void VarianceShadowPass::setup_uniforms(std::vector<Graphics::Frame>& frames) {
 
         // Per-object
         m_descriptorPool.allocate_descriptor_set(OBJECT_LAYOUT, &m_descriptors[i].objectDescritor);
-        m_descriptors[i].objectDescritor.update(&frames[i].uniformBuffers[OBJECT_LAYOUT], sizeof(Core::Object3D::GPUPayload), 0, UNIFORM_DYNAMIC_BUFFER, 0);
-        m_descriptors[i].objectDescritor.update(&frames[i].uniformBuffers[OBJECT_LAYOUT],
-                                                sizeof( Core::IMaterial::GPUPayload),
-                                                m_device->pad_uniform_buffer_size(sizeof( Core::IMaterial::GPUPayload)),
-                                                UNIFORM_DYNAMIC_BUFFER,
-                                                1);
+        update_instance_descriptor(m_descriptors[i].objectDescritor, frames[i], m_culler.get_instance_IDs(frames[i]));
     }
 }
 void VarianceShadowPass::setup_shader_passes() {
@@ -83,6 +102,7 @@ void VarianceShadowPass::setup_shader_passes() {
     PipelineSettings        settings{};
     GraphicPipelineSettings gfxSettings{};
     settings.descriptorSetLayoutIDs = {{GLOBAL_LAYOUT, true}, {OBJECT_LAYOUT, true}, {OBJECT_TEXTURE_LAYOUT, false}};
+    settings.pushConstants          = {PushConstant(SHADER_STAGE_GEOMETRY, 3 * sizeof(uint32_t))}; // Redrawn layers and resolution
     gfxSettings.attributes          = {
         {POSITION_ATTRIBUTE, true}, {NORMAL_ATTRIBUTE, false}, {UV_ATTRIBUTE, false}, {TANGENT_ATTRIBUTE, false}, {COLOR_ATTRIBUTE, false}};
     gfxSettings.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT,
@@ -99,7 +119,7 @@ void VarianceShadowPass::setup_shader_passes() {
     depthPass->settings        = settings;
     depthPass->graphicSettings = gfxSettings;
     depthPass->build_shader_stages();
-    depthPass->build(m_descriptorPool);
+    depthPass->build(m_descriptorPool, m_device->get_pipeline_cache());
     m_shaderPasses["shadowTri"] = depthPass;
 
     GraphicShaderPass* depthLinePass =
@@ -109,84 +129,208 @@ void VarianceShadowPass::setup_shader_passes() {
     depthLinePass->graphicSettings.topology    = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
     depthLinePass->graphicSettings.poligonMode = VK_POLYGON_MODE_LINE;
     depthLinePass->build_shader_stages();
-    depthLinePass->build(m_descriptorPool);
+    depthLinePass->build(m_descriptorPool, m_device->get_pipeline_cache());
     m_shaderPasses["shadowLine"] = depthLinePass;
+
+    // Packed geometry only feeds its position stream to these
+    for (const std::string name : {"shadowTri", "shadowLine"})
+    {
+        GraphicShaderPass* packedPass = static_cast<GraphicShaderPass*>(m_shaderPasses[name])->create_packed_variant();
+        packedPass->build_shader_stages();
+        packedPass->build(m_descriptorPool, m_device->get_pipeline_cache());
+        m_shaderPasses[name + "Packed"] = packedPass;
+    }
+    // Indexed by topology. Line geometry (hair strands) goes through the line shader
+    const std::string bucketPassNames[4] = {"shadowTri", "shadowLine", "shadowLine", "shadowTri"};
+    for (uint32_t topology = 0; topology < 4; topology++)
+    {
+        m_bucketPasses[topology][STANDARD_VERTEX_LAYOUT] = m_shaderPasses[bucketPassNames[topology]];
+        m_bucketPasses[topology][PACKED_VERTEX_LAYOUT]   = m_shaderPasses[bucketPassNames[topology] + "Packed"];
+    }
+}
+
+void VarianceShadowPass::create_framebuffer() {
+    BaseGraphicPass::create_framebuffer();
+    // New images hold nothing
+    m_layers.clear();
+}
+
+void VarianceShadowPass::find_stale_layers(Graphics::Frame& currentFrame, Scene* const scene) {
+    PROFILING_EVENT()
+    const size_t LAYERS = std::min(currentFrame.shadowViews.size(), std::min((size_t)m_framebufferImageDepth, (size_t)ENGINE_MAX_SHADOW_LAYERS));
+    m_layers.resize(LAYERS);
+    for (size_t i = 0; i < LAYERS; i++)
+    {
+        // Light moved, changed its shadow volume or another light took the slot. Cascades move with the camera
+        const ShadowView& view  = currentFrame.shadowViews[i];
+        CachedLayer&      layer = m_layers[i];
+        if (layer.viewProj != view.viewProj || layer.rasterized != view.rasterized)
+        {
+            layer.viewProj    = view.viewProj;
+            layer.rasterized  = view.rasterized;
+            layer.stale       = true;
+            layer.reprojected = true;
+        }
+    }
+
+    // Casters are indexed by their position in the scene list. If its size changed, indices did too
+    const std::vector<Mesh*>&  meshes = scene->get_meshes();
+    const Core::CullingBounds& bounds = scene->get_culling_bounds();
+    if (m_casterBounds.size() != bounds.count)
+    {
+        m_casterBounds.assign(bounds.count, Vec4(0.0f, 0.0f, 0.0f, -1.0f));
+        invalidate_cache();
+    }
+
+    // Light frustums are only extracted if some caster changed
+    std::vector<Core::Frustum> frustums;
+    for (uint32_t m = 0; m < bounds.count; m++)
+    {
+        const bool caster = bounds.enabled.is_visible(m) && meshes[m]->cast_shadows();
+        const Vec4 sphere = caster ? Vec4(bounds.centerX[m], bounds.centerY[m], bounds.centerZ[m], bounds.radius[m]) : Vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        if (sphere == m_casterBounds[m])
+            continue;
+
+        if (frustums.empty())
+        {
+            frustums.resize(LAYERS);
+            for (size_t i = 0; i < LAYERS; i++)
+                frustums[i] = Core::extract_frustum(m_layers[i].viewProj);
+        }
+        // Both where it was and where it is now
+        for (size_t i = 0; i < LAYERS; i++)
+        {
+            CachedLayer& layer = m_layers[i];
+            if (!layer.stale && layer.rasterized && (is_sphere_in_view(frustums[i], m_casterBounds[m]) || is_sphere_in_view(frustums[i], sphere)))
+                layer.stale = true;
+        }
+        m_casterBounds[m] = sphere;
+    }
+}
+
+uint64_t VarianceShadowPass::select_layers() {
+    const uint32_t LAYERS = static_cast<uint32_t>(m_layers.size());
+    uint64_t       mask   = 0;
+
+    // Layers never drawn have nothing to show meanwhile, and reprojected ones would be sampled with a matrix they were not drawn with.
+    // Neither waits for its turn
+    for (uint32_t i = 0; i < LAYERS; i++)
+    {
+        const CachedLayer& layer = m_layers[i];
+        if (layer.rasterized && layer.stale && (!layer.drawn || layer.reprojected))
+            mask |= uint64_t(1) << i;
+    }
+    // The rest only miss some moved caster. They keep showing their outdated map, still matching the light view, until their turn comes
+    uint32_t selected = 0;
+    for (uint32_t n = 0; n < LAYERS && (m_updateBudget == 0 || selected < m_updateBudget); n++)
+    {
+        const uint32_t     i     = (m_nextLayer + n) % LAYERS;
+        const CachedLayer& layer = m_layers[i];
+        if (!layer.rasterized || !layer.stale || (mask & (uint64_t(1) << i)))
+            continue;
+        mask |= uint64_t(1) << i;
+        selected++;
+        m_nextLayer = (i + 1) % LAYERS;
+    }
+
+    for (uint32_t i = 0; i < LAYERS; i++)
+    {
+        if (mask & (uint64_t(1) << i))
+        {
+            m_layers[i].stale       = false;
+            m_layers[i].drawn       = true;
+            m_layers[i].reprojected = false;
+        }
+    }
+    return mask;
 }
 
 void VarianceShadowPass::execute(Graphics::Frame& currentFrame, Scene* const scene, uint32_t presentImageIndex) {
     PROFILING_EVENT()
     CommandBuffer cmd = currentFrame.commandBuffer;
+    // The render pass loads the cached layers, so they have to be readable from the start
+    if (m_outAttachments[0]->currentLayout == LAYOUT_UNDEFINED)
+        cmd.pipeline_barrier(*m_outAttachments[0],
+                             LAYOUT_UNDEFINED,
+                             LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             ACCESS_NONE,
+                             ACCESS_SHADER_READ,
+                             STAGE_TOP_OF_PIPE,
+                             STAGE_FRAGMENT_SHADER);
+
     if ((Core::Light::get_non_raytraced_count() == 0) || scene->get_lights().empty())
-    {
-        if (m_outAttachments[0]->currentLayout == LAYOUT_UNDEFINED)
-            cmd.pipeline_barrier(*m_outAttachments[0],
-                                 LAYOUT_UNDEFINED,
-                                 LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                                 ACCESS_NONE,
-                                 ACCESS_SHADER_READ,
-                                 STAGE_TOP_OF_PIPE,
-                                 STAGE_FRAGMENT_SHADER);
+        return;
 
+    find_stale_layers(currentFrame, scene);
+    const uint64_t layerMask = select_layers();
+    // Every shadow map is up to date
+    if (layerMask == 0)
         return;
-    }
+
+    // Instances outside the frustums of the redrawn lights are culled on the GPU. Recorded outside the render pass
+    m_culler.cull(currentFrame, true, layerMask);
 
     cmd.begin_renderpass(m_renderpass, m_framebuffers[0]);
     cmd.set_viewport(m_imageExtent);
 
+    // Redrawn layers start from scratch, in runs of consecutive layers
+    for (uint32_t first = 0; first < 64; first++)
+    {
+        if (!(layerMask & (uint64_t(1) << first)))
+            continue;
+        uint32_t count = 1;
+        while (first + count < 64 && (layerMask & (uint64_t(1) << (first + count))))
+            count++;
+        cmd.clear_attachment(0, m_outAttachments[0]->config.clearValue, m_imageExtent, first, count);
+        first += count;
+    }
+
     cmd.set_depth_bias_enable(true);
     float depthBiasConstant = 0.0;
     float depthBiasSlope    = 0.0f;
     cmd.set_depth_bias(depthBiasConstant, 0.0f, depthBiasSlope);
 
-    int mesh_idx = 0;
-    for (Mesh* m : scene->get_meshes())
+    // Instance tables might have grown this frame
+    update_instance_descriptor(m_descriptors[currentFrame.index].objectDescritor, currentFrame, m_culler.get_instance_IDs(currentFrame));
+
+    // One indirect draw per render state bucket. Commands were written by the culling pass
+    struct LayerSettings {
+        uint32_t layerMaskLow;
+        uint32_t layerMaskHigh;
+        float    resolution;
+    } layerSettings = {static_cast<uint32_t>(layerMask), static_cast<uint32_t>(layerMask >> 32), static_cast<float>(m_imageExtent.width)};
+    ShaderPass* boundPass = nullptr;
+    for (const DrawBucket& bucket : currentFrame.drawBuckets)
     {
-        if (m)
+        Topology     topology   = GPUCuller::get_topology(bucket.stateKey);
+        VertexLayout layout     = GPUCuller::get_vertex_layout(bucket.stateKey);
+        ShaderPass*  shaderPass = m_bucketPasses[static_cast<uint32_t>(topology)][layout];
+
+        GPUCuller::apply_state(cmd, bucket.stateKey);
+
+        if (shaderPass != boundPass)
         {
-            if (m->is_active() && m->cast_shadows() && m->get_geometry())
-            {
-                uint32_t objectOffset = currentFrame.uniformBuffers[1].strideSize * mesh_idx;
-
-                // Setup per object render state
-                auto g   = m->get_geometry();
-                auto mat = m->get_material();
-
-                ShaderPass* shaderPass;
-                switch (g->get_properties().topology)
-                {
-                case Topology::TRIANGLES:
-                    shaderPass = m_shaderPasses["shadowTri"];
-                    break;
-                case Topology::LINES_TO_TRIANGLES:
-                    shaderPass = m_shaderPasses["shadowLine"];
-                    break;
-                case Topology::LINES:
-                    shaderPass = m_shaderPasses["shadowLine"];
-                    break;
-                default:
-                    break;
-                }
-
-                cmd.set_depth_test_enable(mat->get_parameters().depthTest);
-                cmd.set_depth_write_enable(mat->get_parameters().depthWrite);
-                cmd.set_cull_mode(mat->get_parameters().faceCulling ? mat->get_parameters().culling : CullingMode::NO_CULLING);
-
-                cmd.bind_shaderpass(*shaderPass);
-                // GLOBAL LAYOUT BINDING
-                cmd.bind_descriptor_set(m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, {0, 0});
-                // PER OBJECT LAYOUT BINDING
-                cmd.bind_descriptor_set(m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass, {objectOffset, objectOffset});
-
-                // DRAW
-                cmd.draw_geometry(*get_VAO(g));
-            }
-            mesh_idx++;
+            cmd.bind_shaderpass(*shaderPass);
+            // GLOBAL LAYOUT BINDING
+            cmd.bind_descriptor_set(m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, {0, 0});
+            // PER OBJECT LAYOUT BINDING (instance tables, indexed in shader by instance ID)
+            cmd.bind_descriptor_set(m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass);
+            cmd.push_constants(*shaderPass, SHADER_STAGE_GEOMETRY, &layerSettings, sizeof(layerSettings));
+            boundPass = shaderPass;
         }
+
+        // DRAW (instance IDs are read from the culler lists)
+        m_culler.draw(currentFrame, bucket, m_shared->get_arena_VAO(layout));
     }
 
     cmd.end_renderpass(m_renderpass, m_framebuffers[0]);
 }
 
+void VarianceShadowPass::cleanup() {
+    m_culler.cleanup();
+    BaseGraphicPass::cleanup();
+}
+
 } // namespace Core
 
 VULKAN_ENGINE_NAMESPACE_END
\ No newline at end of file
@@ -67,7 +67,9 @@ void VoxelizationPass::setup_out_attachments( std::vector<Graphics::AttachmentCo
 }
 void VoxelizationPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
 
-    m_descriptorPool = m_device->create_descriptor_pool( ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS, ENGINE_MAX_OBJECTS );
+    // Global and per-object sets of each frame. Material textures live in pools of their own
+    const uint32_t FRAMES = static_cast<uint32_t>( frames.size() );
+    m_descriptorPool      = m_device->create_descriptor_pool( 2 * FRAMES, 0, 2 * FRAMES, 3 * FRAMES, 6 * FRAMES, 0, 0, 4 * FRAMES );
     m_descriptors.resize( frames.size() );
 
     // GLOBAL SET
@@ -86,18 +88,21 @@ void VoxelizationPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
         { camBufferBinding, sceneBufferBinding, shadowBinding, iblBinding, accelBinding, noiseBinding, voxelBinding, auxVoxelBinding, auxVoxelBindingSampler } );
 
     // PER-OBJECT SET
-    LayoutBinding objectBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
-    LayoutBinding materialBufferBinding( UNIFORM_DYNAMIC_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
-    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding } );
+    LayoutBinding objectBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 0 );
+    LayoutBinding materialBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_FRAGMENT, 1 );
+    LayoutBinding instanceIDBufferBinding( UNIFORM_STORAGE_BUFFER, SHADER_STAGE_VERTEX, 2 );
+    m_descriptorPool.set_layout( OBJECT_LAYOUT, { objectBufferBinding, materialBufferBinding, instanceIDBufferBinding } );
 
     // MATERIAL TEXTURE SET
-    // MATERIAL TEXTURE SET
-    LayoutBinding materialTextureBufferBinding( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 0, MAX_TEXTURES );
+    LayoutBinding materialTextureBufferBinding( UNIFORM_COMBINED_IMAGE_SAMPLER, SHADER_STAGE_FRAGMENT, 0, get_max_material_textures() );
     m_descriptorPool.set_layout( OBJECT_TEXTURE_LAYOUT,
                                  { materialTextureBufferBinding },
                                  0,
                                  VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT );
 
+    // The whole scene is voxelized, so the culler only compacts the drawable instances
+    m_culler.setup( m_device, frames, GPUCuller::Mode::NONE );
+
     for ( size_t i = 0; i < frames.size(); i++ )
     {
         // Global
@@ -116,12 +121,7 @@ void VoxelizationPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
 
         // Per-object
         m_descriptorPool.allocate_descriptor_set( OBJECT_LAYOUT, &m_descriptors[i].objectDescritor );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT], sizeof( Core::Object3D::GPUPayload ), 0, UNIFORM_DYNAMIC_BUFFER, 0 );
-        m_descriptors[i].objectDescritor.update( &frames[i].uniformBuffers[OBJECT_LAYOUT],
-                                                 sizeof( Core::IMaterial::GPUPayload ),
-                                                 m_device->pad_uniform_buffer_size( sizeof(  Core::IMaterial::GPUPayload ) ),
-                                                 UNIFORM_DYNAMIC_BUFFER,
-                                                 1 );
+        update_instance_descriptor( m_descriptors[i].objectDescritor, frames[i], m_culler.get_instance_IDs( frames[i] ) );
         // Set up enviroment fallback texture
         m_descriptors[i].globalDescritor.update( m_shared->get_fallback_cubemap(), LAYOUT_SHADER_READ_ONLY_OPTIMAL, 3 );
         // Voxelization Image
@@ -133,8 +133,8 @@ void VoxelizationPass::setup_uniforms( std::vector<Graphics::Frame>& frames ) {
         m_descriptors[i].globalDescritor.update( auxImages, LAYOUT_GENERAL, 8 );
 #endif
 
-        // Textures
-        m_descriptorPool.allocate_variable_descriptor_set( OBJECT_TEXTURE_LAYOUT, &m_descriptors[i].textureDescritor, MAX_TEXTURES );
+        // Textures. Sized after the material table, in a pool of their own
+        reserve_material_textures( m_descriptors[i].textures, ENGINE_INITIAL_INSTANCES );
     }
 }
 void VoxelizationPass::setup_shader_passes() {
@@ -150,17 +150,26 @@ void VoxelizationPass::setup_shader_passes() {
     voxelPass->graphicSettings.blendAttachments = { state };
 
     voxelPass->build_shader_stages();
-    voxelPass->build( m_descriptorPool );
+    voxelPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["voxelization"] = voxelPass;
 
+    GraphicShaderPass* packedVoxelPass = voxelPass->create_packed_variant();
+    packedVoxelPass->build_shader_stages();
+    packedVoxelPass->build( m_descriptorPool, m_device->get_pipeline_cache() );
+
+    m_shaderPasses["voxelizationPacked"] = packedVoxelPass;
+
+    m_layoutPasses[STANDARD_VERTEX_LAYOUT] = voxelPass;
+    m_layoutPasses[PACKED_VERTEX_LAYOUT]   = packedVoxelPass;
+
 #ifdef USE_IMG_ATOMIC_OPERATION
 
     ComputeShaderPass* mergePass               = new ComputeShaderPass( m_device->get_handle(), GET_RESOURCE_PATH( "shaders/VXGI/merge_intermediates.glsl" ) );
     mergePass->settings.descriptorSetLayoutIDs = { { GLOBAL_LAYOUT, true }, { OBJECT_LAYOUT, false }, { OBJECT_TEXTURE_LAYOUT, false } };
 
     mergePass->build_shader_stages();
-    mergePass->build( m_descriptorPool );
+    mergePass->build( m_descriptorPool, m_device->get_pipeline_cache() );
 
     m_shaderPasses["merge"] = mergePass;
 
@@ -202,6 +211,13 @@ void VoxelizationPass::execute( Graphics::Frame& currentFrame, Scene* const scen
             m_interAttachments[i], LAYOUT_UNDEFINED, LAYOUT_GENERAL, ACCESS_NONE, ACCESS_SHADER_READ, STAGE_TOP_OF_PIPE, STAGE_FRAGMENT_SHADER );
     }
 
+    /*
+    BUILD INDIRECT COMMANDS
+    */
+    const bool cameraActive = scene->get_active_camera() && scene->get_active_camera()->is_active();
+    if ( cameraActive )
+        m_culler.cull( currentFrame );
+
     /*
     POPULATE AUXILIAR IMAGES WITH DIRECT IRRADIANCE
     */
@@ -209,40 +225,32 @@ void VoxelizationPass::execute( Graphics::Frame& currentFrame, Scene* const scen
 
     cmd.set_viewport( m_imageExtent );
 
-    if ( scene->get_active_camera() && scene->get_active_camera()->is_active() )
+    if ( cameraActive )
     {
 
-        ShaderPass* shaderPass = m_shaderPasses["voxelization"];
-        // Bind pipeline
-        cmd.bind_shaderpass( *shaderPass );
-        // GLOBAL LAYOUT BINDING
-        cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
-        // TEXTURE LAYOUT BINDING
-        if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
-            cmd.bind_descriptor_set( m_descriptors[currentFrame.index].textureDescritor, 2, *shaderPass );
-
-        unsigned int mesh_idx = 0;
-        for ( Mesh* m : scene->get_meshes() )
+        // Instance tables might have grown this frame
+        update_instance_descriptor( m_descriptors[currentFrame.index].objectDescritor, currentFrame, m_culler.get_instance_IDs( currentFrame ) );
+
+        // Same pipeline for every bucket of a vertex layout, render state is not relevant for voxelization
+        ShaderPass* boundPass = nullptr;
+        for ( const DrawBucket& bucket : currentFrame.drawBuckets )
         {
-            if ( m )
+            VertexLayout layout     = GPUCuller::get_vertex_layout( bucket.stateKey );
+            ShaderPass*  shaderPass = m_layoutPasses[layout];
+            if ( shaderPass != boundPass )
             {
-                if ( m->is_active() &&   // Check if is active
-                     m->get_geometry() ) // Check if is inside frustrum
-                {
-                    // Offset calculation
-                    uint32_t objectOffset = currentFrame.uniformBuffers[1].strideSize * mesh_idx;
-
-                    auto g   = m->get_geometry();
-                    auto mat = m->get_material();
-
-                    // PER OBJECT LAYOUT BINDING
-                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass, { objectOffset, objectOffset } );
-
-                    // DRAW
-                    cmd.draw_geometry( *get_VAO( g ) );
-                }
+                // Bind pipeline
+                cmd.bind_shaderpass( *shaderPass );
+                // GLOBAL LAYOUT BINDING
+                cmd.bind_descriptor_set( m_descriptors[currentFrame.index].globalDescritor, 0, *shaderPass, { 0, 0 } );
+                // PER OBJECT LAYOUT BINDING (instance and material tables, indexed in shader by instance ID)
+                cmd.bind_descriptor_set( m_descriptors[currentFrame.index].objectDescritor, 1, *shaderPass );
+                // TEXTURE LAYOUT BINDING
+                if ( shaderPass->settings.descriptorSetLayoutIDs[OBJECT_TEXTURE_LAYOUT] )
+                    cmd.bind_descriptor_set( m_descriptors[currentFrame.index].textures.set, 2, *shaderPass );
+                boundPass = shaderPass;
             }
-            mesh_idx++;
+            m_culler.draw( currentFrame, bucket, m_shared->get_arena_VAO( layout ) );
         }
     }
 
@@ -276,16 +284,14 @@ void VoxelizationPass::execute( Graphics::Frame& currentFrame, Scene* const scen
 }
 
 void VoxelizationPass::update_uniforms( uint32_t frameIndex, Scene* const scene ) {
-    uint32_t meshIdx = 0;
-    for ( Mesh* m : scene->get_meshes() )
+    // Material indices are positions in the scene mesh list, as laid out in the material table
+    const std::vector<Mesh*>& meshes   = scene->get_meshes();
+    MaterialTextures&         textures = m_descriptors[frameIndex].textures;
+    reserve_material_textures( textures, meshes.size() );
+    for ( size_t materialIdx = 0; materialIdx < meshes.size(); materialIdx++ )
     {
-        if ( m )
-        {
-            auto g   = m->get_geometry();
-            auto mat = m->get_material();
-            setup_material_descriptor( mat, meshIdx );
-        }
-        meshIdx++;
+        if ( meshes[materialIdx] )
+            update_material_textures( textures, meshes[materialIdx]->get_material(), static_cast<uint32_t>( materialIdx ) );
     }
 
     for ( size_t i = 0; i < m_descriptors.size(); i++ )
@@ -316,22 +322,6 @@ void VoxelizationPass::resize_attachments() {
 #endif
     }
 }
-void VoxelizationPass::setup_material_descriptor( IMaterial* mat, uint32_t meshIdx ) {
-    auto textures = mat->get_textures();
-    for ( auto pair : textures )
-    {
-        ITexture* texture = pair.second;
-        if ( texture && texture->loaded_on_GPU() )
-        {
-            for ( size_t i = 0; i < m_descriptors.size(); i++ )
-            {
-                uint32_t bindingPoint = 0;
-                m_descriptors[i].textureDescritor.update(
-                    get_image( texture ), LAYOUT_SHADER_READ_ONLY_OPTIMAL, bindingPoint, UNIFORM_COMBINED_IMAGE_SAMPLER, pair.first + 6 * meshIdx );
-            }
-        }
-    }
-}
 
 void VoxelizationPass::create_framebuffer() {
     std::vector<Graphics::Image*> out = { &m_interAttachments[3] };
@@ -346,6 +336,9 @@ void VoxelizationPass::cleanup() {
     {
         m_interAttachments[i].cleanup();
     }
+    for ( FrameDescriptors& descriptors : m_descriptors )
+        descriptors.textures.pool.cleanup();
+    m_culler.cleanup();
     BaseGraphicPass::cleanup();
 }
 } // namespace Core
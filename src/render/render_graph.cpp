@@ -0,0 +1,255 @@
+#include <engine/render/render_graph.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+void RenderGraph::declare_transient( Graphics::Image* attachment ) {
+    if ( attachment )
+        m_transients.insert( attachment );
+}
+
+uint32_t RenderGraph::get_resource( Graphics::Image* image ) {
+    auto it = m_resourceIDs.find( image );
+    if ( it != m_resourceIDs.end() )
+        return it->second;
+
+    ResourceNode resource;
+    resource.image     = image;
+    resource.transient = m_transients.count( image ) > 0;
+    m_resources.push_back( resource );
+    m_resourceIDs[image] = static_cast<uint32_t>( m_resources.size() - 1 );
+    return m_resourceIDs[image];
+}
+
+void RenderGraph::compile( const std::vector<ptr<BasePass>>& passes ) {
+    PROFILING_EVENT()
+    m_passes = passes;
+    m_resources.clear();
+    m_resourceIDs.clear();
+
+    // Reads and writes
+    for ( uint32_t i = 0; i < m_passes.size(); i++ )
+    {
+        for ( Graphics::Image* img : m_passes[i]->get_input_attachments() )
+            m_resources[get_resource( img )].readers.push_back( i );
+        for ( Graphics::Image* img : m_passes[i]->get_output_attachments() )
+            m_resources[get_resource( img )].writers.push_back( i );
+    }
+
+    // Who reads every output
+    for ( uint32_t i = 0; i < m_passes.size(); i++ )
+    {
+        std::vector<Graphics::Image*> outputs = m_passes[i]->get_output_attachments();
+        std::vector<uint32_t>         readers( outputs.size(), GRAPH_READ_NONE );
+        for ( size_t j = 0; j < outputs.size(); j++ )
+        {
+            const ResourceNode& resource = m_resources[m_resourceIDs[outputs[j]]];
+            for ( uint32_t reader : resource.readers )
+                readers[j] |= m_passes[reader]->get_input_read_stages();
+            // Memory of aliased attachments is next written by a pass that knows nothing of these readers, so every stage has to
+            // be waited on before writing
+            if ( resource.transient )
+                readers[j] |= GRAPH_READ_FRAGMENT | GRAPH_READ_COMPUTE;
+        }
+        m_passes[i]->set_output_readers( readers );
+    }
+
+    // Culling. Passes are live when a live pass reads any of their outputs. Graph outputs are the active default passes (a GUI pass
+    // switched off for headless rendering presents nothing)
+    bool outputFound = false;
+    for ( auto& pass : m_passes )
+        outputFound |= pass->is_active() && pass->default_pass();
+
+    std::vector<bool> live( m_passes.size(), false );
+    for ( int i = static_cast<int>( m_passes.size() ) - 1; i >= 0; i-- )
+    {
+        std::vector<Graphics::Image*> outputs = m_passes[i]->get_output_attachments();
+        if ( m_passes[i]->default_pass() || outputs.empty() )
+        {
+            live[i] = true;
+            continue;
+        }
+        // Without an active default pass, the last active writing pass is the output of the graph
+        if ( !outputFound && m_passes[i]->is_active() )
+        {
+            live[i]     = true;
+            outputFound = true;
+            continue;
+        }
+        // Readers always run later, so they are resolved already
+        for ( Graphics::Image* img : outputs )
+        {
+            for ( uint32_t reader : m_resources[m_resourceIDs[img]].readers )
+                live[i] = live[i] || ( reader > static_cast<uint32_t>( i ) && live[reader] );
+        }
+    }
+
+    m_culled.assign( m_passes.size(), false );
+    for ( size_t i = 0; i < m_passes.size(); i++ )
+    {
+        m_culled[i] = !live[i];
+        if ( m_culled[i] )
+            LOG_DEBUG( "Render graph: culled " + m_passes[i]->get_name() + ", its outputs are never read" );
+    }
+}
+
+bool RenderGraph::can_alias( const ResourceNode& resource ) const {
+    if ( !resource.transient || resource.writers.size() != 1 || !resource.image )
+        return false;
+
+    const uint32_t writer = resource.writers.front();
+    ptr<BasePass>  pass   = m_passes[writer];
+    if ( m_culled[writer] || !pass->is_active() || !pass->is_graphical() || pass->default_pass() || !pass->initialized() )
+        return false;
+    for ( uint32_t reader : resource.readers )
+    {
+        if ( reader <= writer )
+            return false;
+    }
+
+    ptr<BaseGraphicPass> graphicPass = std::dynamic_pointer_cast<BaseGraphicPass>( pass );
+    if ( !graphicPass )
+        return false;
+    std::vector<Graphics::Image*>                  outputs = pass->get_output_attachments();
+    const std::vector<Graphics::AttachmentConfig>& configs = graphicPass->get_renderpass().attachmentsConfig;
+    if ( configs.size() != outputs.size() )
+        return false;
+    for ( size_t i = 0; i < outputs.size(); i++ )
+    {
+        if ( outputs[i] != resource.image )
+            continue;
+        // Previous content has to be discardable
+        return !configs[i].isDefault && configs[i].initialLayout == LAYOUT_UNDEFINED && configs[i].loadOp != ATTACHMENT_LOAD_OP_LOAD;
+    }
+    return false;
+}
+
+void RenderGraph::alias_transients( const ptr<Graphics::Device>& device ) {
+    PROFILING_EVENT()
+    if ( !m_aliasSlots.empty() )
+        release_aliases( device );
+
+    // Lifetimes go from the writer to the last reader
+    struct Lifetime {
+        uint32_t resource;
+        uint32_t firstUse;
+        uint32_t lastUse;
+    };
+    std::vector<Lifetime> lifetimes;
+    for ( uint32_t i = 0; i < m_resources.size(); i++ )
+    {
+        const ResourceNode& resource = m_resources[i];
+        if ( !can_alias( resource ) )
+            continue;
+        uint32_t lastUse = resource.writers.front();
+        for ( uint32_t reader : resource.readers )
+            lastUse = std::max( lastUse, reader );
+        lifetimes.push_back( { i, resource.writers.front(), lastUse } );
+    }
+    std::sort( lifetimes.begin(), lifetimes.end(), []( const Lifetime& a, const Lifetime& b ) { return a.firstUse < b.firstUse; } );
+
+    // Greedy interval assignment. A slot is free again once the last reader of its last member has run
+    std::vector<AliasSlot> slots;
+    for ( const Lifetime& lifetime : lifetimes )
+    {
+        AliasSlot* slot = nullptr;
+        for ( AliasSlot& candidate : slots )
+        {
+            if ( candidate.lastUse < lifetime.firstUse )
+            {
+                slot = &candidate;
+                break;
+            }
+        }
+        if ( !slot )
+        {
+            slots.push_back( {} );
+            slot = &slots.back();
+        }
+        slot->resources.push_back( lifetime.resource );
+        slot->lastUse = lifetime.lastUse;
+    }
+
+    std::set<uint32_t> writers;
+    for ( AliasSlot& slot : slots )
+    {
+        // Nothing to share
+        if ( slot.resources.size() < 2 )
+            continue;
+
+        std::vector<Graphics::Image*> images;
+        size_t                        separateBytes = 0;
+        for ( uint32_t resource : slot.resources )
+        {
+            Graphics::Image* img = m_resources[resource].image;
+            images.push_back( img );
+            VmaAllocationInfo allocationInfo = {};
+            vmaGetAllocationInfo( img->memory, img->allocation, &allocationInfo );
+            separateBytes += allocationInfo.size;
+        }
+
+        size_t slotBytes = 0;
+        slot.memory      = device->allocate_aliasing_memory( images, &slotBytes );
+        if ( !slot.memory )
+        {
+            LOG_WARN( "Render graph: transient attachments have no memory type in common, not aliasing them" );
+            continue;
+        }
+        // Own allocations are released now. Writers recreate the images on the shared memory
+        for ( Graphics::Image* img : images )
+        {
+            img->cleanup();
+            img->aliasedMemory = slot.memory;
+        }
+        for ( uint32_t resource : slot.resources )
+            writers.insert( m_resources[resource].writers.front() );
+
+        m_aliasedBytes += separateBytes;
+        m_slotBytes += slotBytes;
+        m_aliasSlots.push_back( slot );
+    }
+
+    for ( uint32_t writer : writers )
+        m_passes[writer]->resize_attachments();
+
+    if ( !m_aliasSlots.empty() )
+        LOG_DEBUG( "Render graph: " + std::to_string( m_aliasSlots.size() ) + " aliasing slots save " + std::to_string( get_saved_memory() / 1024 ) +
+                   " KB of attachment memory" );
+}
+
+void RenderGraph::release_aliases( const ptr<Graphics::Device>& device ) {
+    std::set<uint32_t> writers;
+    for ( AliasSlot& slot : m_aliasSlots )
+    {
+        for ( uint32_t resource : slot.resources )
+        {
+            Graphics::Image* img = m_resources[resource].image;
+            img->cleanup();
+            img->aliasedMemory = VK_NULL_HANDLE;
+            writers.insert( m_resources[resource].writers.front() );
+        }
+    }
+    for ( uint32_t writer : writers )
+        m_passes[writer]->resize_attachments();
+
+    for ( AliasSlot& slot : m_aliasSlots )
+        device->free_aliasing_memory( slot.memory );
+    m_aliasSlots.clear();
+    m_aliasedBytes = 0;
+    m_slotBytes    = 0;
+}
+
+void RenderGraph::cleanup( const ptr<Graphics::Device>& device ) {
+    // Images are cleaned along with the rest of attachments
+    for ( AliasSlot& slot : m_aliasSlots )
+        device->free_aliasing_memory( slot.memory );
+    m_aliasSlots.clear();
+    m_aliasedBytes = 0;
+    m_slotBytes    = 0;
+    m_passes.clear();
+}
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
@@ -0,0 +1,72 @@
+#include <cstring>
+#include <engine/render/render_queue.h>
+
+VULKAN_ENGINE_NAMESPACE_BEGIN
+
+namespace Render {
+
+namespace {
+// Bits of a non negative float keep its order when read as an unsigned integer
+uint32_t get_depth_bits( float depth ) {
+    if ( !( depth > 0.0f ) ) // Also catches NaN
+        return 0;
+    uint32_t bits;
+    std::memcpy( &bits, &depth, sizeof( bits ) );
+    return bits;
+}
+} // namespace
+
+uint64_t RenderQueue::make_opaque_key( uint32_t pipeline, uint32_t material, uint32_t geometry, float depth ) {
+    return ( uint64_t( OPAQUE_LAYER ) << 62 ) | ( uint64_t( pipeline & 0xFFF ) << 50 ) | ( uint64_t( material & 0x3FFF ) << 36 ) |
+           ( uint64_t( geometry & 0x3FFF ) << 22 ) | uint64_t( get_depth_bits( depth ) >> 10 );
+}
+
+uint64_t RenderQueue::make_blended_key( float depth ) {
+    return ( uint64_t( BLENDED_LAYER ) << 62 ) | ( uint64_t( ~get_depth_bits( depth ) ) << 30 );
+}
+
+uint32_t RenderQueue::fold_ID( const void* ptr, uint32_t bits ) {
+    // Allocations are at least 16 byte aligned, the lowest bits carry nothing
+    uint64_t value = static_cast<uint64_t>( reinterpret_cast<uintptr_t>( ptr ) ) >> 4;
+    value ^= value >> 29;
+    value *= 0x9E3779B97F4A7C15ull;
+    return static_cast<uint32_t>( value >> ( 64 - bits ) );
+}
+
+void RenderQueue::sort() {
+    PROFILING_EVENT()
+    const size_t COUNT = m_items.size();
+    if ( COUNT < 2 )
+        return;
+
+    // Histograms of every byte in a single read
+    uint32_t histograms[8][256] = {};
+    for ( const RenderQueueItem& item : m_items )
+    {
+        for ( uint32_t digit = 0; digit < 8; digit++ )
+            histograms[digit][( item.key >> ( 8 * digit ) ) & 0xFF]++;
+    }
+
+    m_scratch.resize( COUNT );
+    for ( uint32_t digit = 0; digit < 8; digit++ )
+    {
+        uint32_t* histogram = histograms[digit];
+        if ( histogram[( m_items[0].key >> ( 8 * digit ) ) & 0xFF] == COUNT )
+            continue;
+
+        uint32_t offset = 0;
+        for ( uint32_t bucket = 0; bucket < 256; bucket++ )
+        {
+            const uint32_t count = histogram[bucket];
+            histogram[bucket]    = offset;
+            offset += count;
+        }
+        for ( const RenderQueueItem& item : m_items )
+            m_scratch[histogram[( item.key >> ( 8 * digit ) ) & 0xFF]++] = item;
+        m_items.swap( m_scratch );
+    }
+}
+
+} // namespace Render
+
+VULKAN_ENGINE_NAMESPACE_END
@@ -82,7 +82,7 @@ void DeferredRenderer::create_passes() {
 
     m_passes[SKY_PASS]            = std::make_shared<Render::SkyPass>( m_device, m_shared, skyPassConfig, SKY_RES );
     m_passes[ENVIROMENT_PASS]     = std::make_shared<Render::EnviromentPass>( m_device, m_shared, enviromentPassConfig );
-    m_passes[SHADOW_PASS]         = std::make_shared<Render::VarianceShadowPass>( m_device, m_shared, shadowPassConfig, SHADOW_RES, ENGINE_MAX_LIGHTS, DEPTH_FORMAT );
+    m_passes[SHADOW_PASS]         = std::make_shared<Render::VarianceShadowPass>( m_device, m_shared, shadowPassConfig, SHADOW_RES, ENGINE_MAX_SHADOW_LAYERS, DEPTH_FORMAT );
     m_passes[VOXELIZATION_PASS]   = std::make_shared<Render::VoxelizationPass>( m_device, m_shared, voxelPassConfig, 256 );
     m_passes[GEOMETRY_PASS]       = std::make_shared<Render::GeometryPass>( m_device, m_shared, geometryPassConfig, DISPLAY_EXTENT, HDR_FORMAT, DEPTH_FORMAT );
     m_passes[PRECOMPOSITION_PASS] = std::make_shared<Render::PreCompositionPass>( m_device, m_shared, preCompPassConfig, DISPLAY_EXTENT );
@@ -106,6 +106,12 @@ void DeferredRenderer::create_passes() {
         m_passes[AA_PASS]->set_active( false );
     if ( m_headless )
         m_passes[GUI_PASS]->set_active( false );
+
+    // Produced and consumed within the frame. Precomposition and bloom outputs end up sharing memory
+    m_graph.declare_transient( &m_attachments[12] );
+    m_graph.declare_transient( &m_attachments[13] );
+    m_graph.declare_transient( &m_attachments[14] );
+    m_graph.declare_transient( &m_attachments[15] );
 }
 void DeferredRenderer::update_enviroment( Core::Skybox* const skybox ) {
     if ( skybox )
@@ -57,7 +57,7 @@ void ForwardRenderer::create_passes() {
 
     m_passes[SKY_PASS]        = std::make_shared<Render::SkyPass>( m_device, m_shared, skyPassConfig, Extent2D { 1024, 512 } );
     m_passes[ENVIROMENT_PASS] = std::make_shared<Render::EnviromentPass>( m_device, m_shared, enviromentPassConfig );
-    m_passes[SHADOW_PASS]     = std::make_shared<Render::VarianceShadowPass>( m_device, m_shared, shadowPassConfig, SHADOW_RES, ENGINE_MAX_LIGHTS, DEPTH_FORMAT );
+    m_passes[SHADOW_PASS]     = std::make_shared<Render::VarianceShadowPass>( m_device, m_shared, shadowPassConfig, SHADOW_RES, ENGINE_MAX_SHADOW_LAYERS, DEPTH_FORMAT );
     m_passes[FORWARD_PASS]    = std::make_shared<Render::ForwardPass>( m_device, m_shared, forwardPassConfig, DISPLAY_EXTENT, HDR_FORMAT, DEPTH_FORMAT, m_settings.samplesMSAA );
     m_passes[BLOOM_PASS]      = std::make_shared<Render::BloomPass>( m_device, m_shared, bloomPassConfig, DISPLAY_EXTENT );
 
@@ -34,14 +34,19 @@ void BaseRenderer::init() {
         m_device->init_headless();
     }
 
+    // Command recording workers
+    m_jobSystem = std::make_shared<Utils::JobSystem>( m_settings.recordingThreads );
     // Init resources
     init_resources();
     // User defined renderpasses
     create_passes();
-    // Init renderpasses
     for ( auto& pass : m_passes )
-        if ( pass->is_active() )
-            pass->setup( m_frames );
+        pass->set_job_system( m_jobSystem );
+    // Dependencies between passes
+    m_graph.compile( m_passes );
+    // Init renderpasses
+    setup_passes();
+    m_graph.alias_transients( m_device );
     // Connect renderpasses
     for ( auto& pass : m_passes )
         if ( pass->is_active() )
@@ -68,6 +73,7 @@ void BaseRenderer::run( Core::Scene* const scene ) {
 
 void BaseRenderer::shutdown( Core::Scene* const scene ) {
     m_device->wait_idle();
+    m_device->wait_all_uploads();
 
     on_shutdown( scene );
 
@@ -80,6 +86,7 @@ void BaseRenderer::shutdown( Core::Scene* const scene ) {
         }
 
         clean_resources();
+        m_graph.cleanup( m_device );
         m_gpuScene.destroy( scene );
 
         if ( m_settings.enableUI && !m_headless )
@@ -93,6 +100,55 @@ void BaseRenderer::shutdown( Core::Scene* const scene ) {
 
     glfwTerminate();
 }
+void BaseRenderer::setup_passes() {
+    PROFILING_EVENT()
+
+    std::vector<ptr<Render::BasePass>> passes;
+    for ( auto& pass : m_passes )
+        if ( pass->is_active() )
+            passes.push_back( pass );
+
+    // Passes only create objects they own, and shaderc, VMA and pipeline creation are thread safe, so each pass can be set up on
+    // its own worker. Errors are rethrown on this thread once every worker is done
+    std::vector<double>             setupTimes( passes.size(), 0.0 );
+    std::vector<std::exception_ptr> errors( passes.size() );
+    auto                            setup_pass = [&]( size_t i ) {
+        Utils::ManualTimer timer;
+        timer.start();
+        try
+        {
+            passes[i]->setup( m_frames );
+        } catch ( ... )
+        { errors[i] = std::current_exception(); }
+        timer.stop();
+        setupTimes[i] = timer.get();
+    };
+
+    Utils::ManualTimer totalTimer;
+    totalTimer.start();
+    if ( m_settings.parallelSetup )
+        m_jobSystem->parallel_for( passes.size(), 1, [&]( size_t begin, size_t end, size_t worker ) {
+            for ( size_t i = begin; i < end; i++ )
+                setup_pass( i );
+        } );
+    else
+        for ( size_t i = 0; i < passes.size(); i++ )
+            setup_pass( i );
+    totalTimer.stop();
+
+    for ( std::exception_ptr& error : errors )
+        if ( error )
+            std::rethrow_exception( error );
+
+    // Startup report
+    double workTime = 0.0;
+    for ( size_t i = 0; i < passes.size(); i++ )
+    {
+        LOG_DEBUG( "Pass setup: " + passes[i]->get_name() + " " + std::to_string( setupTimes[i] ) + " ms" );
+        workTime += setupTimes[i];
+    }
+    LOG_DEBUG( "Passes set up in " + std::to_string( totalTimer.get() ) + " ms (" + std::to_string( workTime ) + " ms of work)" );
+}
 void BaseRenderer::create_passes() {
 
     throw VKFW_Exception( "Implement setup_renderpasses function ! Hint: Add at least a forward pass ... " );
@@ -101,7 +157,18 @@ void BaseRenderer::on_before_render( Core::Scene* const scene ) {
     PROFILING_EVENT()
 
     const Extent2D DISPLAY_EXTENT = !m_headless ? m_window->get_extent() : m_headlessExtent;
-    m_gpuScene.build( m_device, &m_frames[m_currentFrame], scene, DISPLAY_EXTENT, m_settings.enableRaytracing, m_settings.softwareAA == SoftwareAA::TAA );
+    // Every world matrix read in the frame comes from this update
+    scene->update_transforms( m_jobSystem.get() );
+    m_gpuScene.build( m_device,
+                      m_shared,
+                      &m_frames[m_currentFrame],
+                      scene,
+                      DISPLAY_EXTENT,
+                      m_settings.enableRaytracing,
+                      m_settings.softwareAA == SoftwareAA::TAA,
+                      m_settings.asyncUploads && !m_headless, // Headless captures need everything resident in the first frame
+                      m_settings.levelOfDetail,
+                      static_cast<uint32_t>( m_settings.shadowQuality ) );
 
     for ( auto& pass : m_passes )
     {
@@ -164,11 +231,12 @@ void BaseRenderer::render( Core::Scene* const scene ) {
 
     m_device->start_frame( m_frames[m_currentFrame] );
 
-    for ( auto& pass : m_passes )
+    for ( size_t i = 0; i < m_passes.size(); i++ )
     {
-        if ( pass->is_active() )
-            pass->execute( m_frames[m_currentFrame], scene, imageIndex );
+        if ( m_passes[i]->is_active() && !m_graph.is_culled( i ) )
+            m_passes[i]->execute( m_frames[m_currentFrame], scene, imageIndex );
     }
+    m_skippedBinds = m_frames[m_currentFrame].get_skipped_binds();
 
     RenderResult renderResult = RenderResult::SUCCESS;
     if ( !m_headless )
@@ -187,7 +255,8 @@ void BaseRenderer::update_framebuffers( Extent2D extent ) {
     m_device->wait_idle();
     m_device->update_swapchain( extent, static_cast<uint32_t>( m_settings.bufferingType ), m_settings.displayColorFormat, m_settings.screenSync );
 
-    // Renderpass framebuffer updating
+    // Renderpass framebuffer updating. Aliased attachments might not fit their shared memory anymore
+    m_graph.release_aliases( m_device );
     for ( auto& pass : m_passes )
     {
         if ( pass->is_active() )
@@ -197,6 +266,7 @@ void BaseRenderer::update_framebuffers( Extent2D extent ) {
                 pass->resize_attachments();
             }
     };
+    m_graph.alias_transients( m_device );
     // Connect renderpasses
     for ( auto& pass : m_passes )
         if ( pass->is_active() )
@@ -233,7 +303,7 @@ void BaseRenderer::init_resources() {
     // Setup frames
     m_frames.resize( static_cast<uint32_t>( m_settings.bufferingType ) );
     for ( size_t i = 0; i < m_frames.size(); i++ )
-        m_frames[i] = m_device->create_frame( i );
+        m_frames[i] = m_device->create_frame( i, static_cast<uint32_t>( m_jobSystem->get_worker_count() ) );
     for ( size_t i = 0; i < m_frames.size(); i++ )
     {
         // Global Buffer
@@ -243,12 +313,23 @@ void BaseRenderer::init_resources() {
             m_device->create_buffer_VMA( globalStrideSize, BUFFER_USAGE_UNIFORM_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)globalStrideSize );
         m_frames[i].uniformBuffers.push_back( globalBuffer );
 
-        // Object Buffer
-        const size_t objectStrideSize =
-            ( m_device->pad_uniform_buffer_size( sizeof( Core::Object3D::GPUPayload ) ) + m_device->pad_uniform_buffer_size( sizeof( Core::IMaterial::GPUPayload ) ) );
-        Graphics::Buffer objectBuffer = m_device->create_buffer_VMA(
-            ENGINE_MAX_OBJECTS * objectStrideSize, BUFFER_USAGE_UNIFORM_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)objectStrideSize );
-        m_frames[i].uniformBuffers.push_back( objectBuffer );
+        // Instance Buffer (storage). Tightly packed, indexed by instance ID. Grown by the scene builder when needed
+        const size_t instanceStrideSize = sizeof( Core::Object3D::GPUPayload );
+        Graphics::Buffer instanceBuffer = m_device->create_buffer_VMA(
+            ENGINE_INITIAL_INSTANCES * instanceStrideSize, BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)instanceStrideSize );
+        m_frames[i].uniformBuffers.push_back( instanceBuffer );
+
+        // Material Buffer (storage). Indexed by the material index stored in each instance
+        const size_t materialStrideSize = sizeof( Core::IMaterial::GPUPayload );
+        Graphics::Buffer materialBuffer = m_device->create_buffer_VMA(
+            ENGINE_INITIAL_INSTANCES * materialStrideSize, BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)materialStrideSize );
+        m_frames[i].uniformBuffers.push_back( materialBuffer );
+
+        // Draw Buffer (storage). One draw record per instance ID, read by the GPU culling passes
+        const size_t drawStrideSize = sizeof( Render::GPUDrawRecord );
+        Graphics::Buffer drawBuffer = m_device->create_buffer_VMA(
+            ENGINE_INITIAL_INSTANCES * drawStrideSize, BUFFER_USAGE_STORAGE_BUFFER, VMA_MEMORY_USAGE_CPU_TO_GPU, (uint32_t)drawStrideSize );
+        m_frames[i].uniformBuffers.push_back( drawBuffer );
     }
 
     m_shared = std::make_shared<Render::GPUResourcePool>();
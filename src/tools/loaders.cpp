@@ -2,138 +2,148 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
-void VKFW::Tools::Loaders::load_OBJ(Core::Mesh* const mesh, const std::string fileName, bool importMaterials, bool calculateTangents) {
-    // std::this_thread::sleep_for(std::chrono::seconds(4)); //Debuging
-
-    // Preparing output
-    tinyobj::attrib_t                attrib;
-    std::vector<tinyobj::shape_t>    shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string                      warn;
-    std::string                      err;
-
-    tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, fileName.c_str(), importMaterials ? nullptr : nullptr);
+// Corners a thread welds at least before the OBJ loader spawns another one
+#define OBJ_MIN_CORNERS_PER_THREAD (64 * 1024)
+// Bump when the cache layout or the processing done by the loaders changes
+#define GEOMETRY_CACHE_VERSION 3
+#define GEOMETRY_CACHE_EXTENSION ".vkgeom"
+
+namespace {
+/*
+Open addressing (linear probing) table welding the OBJ corners that reference the same position, normal and uv into one vertex.
+Corners are compared by their attribute indices, so vertices are neither built nor hashed per corner. Slots only store the vertex,
+its key is read back from the unique corner list.
+*/
+class OBJCornerWeldTable
+{
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    std::vector<uint32_t>                m_slots;
+    size_t                               m_mask = 0;
+    const std::vector<tinyobj::index_t>& m_uniqueCorners;
+
+    static inline size_t hash(const tinyobj::index_t& corner) {
+        uint64_t h = static_cast<uint32_t>(corner.vertex_index) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint32_t>(corner.normal_index) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint32_t>(corner.texcoord_index) * 0x165667B19E3779F9ull;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
 
-    // Check for errors
-    if (!warn.empty())
-    {
-        LOG_WARN("WARN: " + warn);
+  public:
+    OBJCornerWeldTable(size_t corners, const std::vector<tinyobj::index_t>& uniqueCorners)
+        : m_uniqueCorners(uniqueCorners) {
+        // Load factor stays under 2/3 even if no corner is shared
+        size_t capacity = 16;
+        while (capacity < corners + corners / 2)
+            capacity <<= 1;
+        m_slots.assign(capacity, EMPTY_SLOT);
+        m_mask = capacity - 1;
     }
-    if (!err.empty())
+    /*
+    Vertex the corner welds to. If the corner is new, it is recorded as newVertex and that is returned
+    */
+    inline uint32_t weld(const tinyobj::index_t& corner, uint32_t newVertex) {
+        for (size_t slot = hash(corner) & m_mask;; slot = (slot + 1) & m_mask)
+        {
+            uint32_t vertex = m_slots[slot];
+            if (vertex == EMPTY_SLOT)
+            {
+                m_slots[slot] = newVertex;
+                return newVertex;
+            }
+            const tinyobj::index_t& key = m_uniqueCorners[vertex];
+            if (key.vertex_index == corner.vertex_index && key.normal_index == corner.normal_index &&
+                key.texcoord_index == corner.texcoord_index)
+                return vertex;
+        }
+    }
+};
+
+void build_OBJ_shape(const tinyobj::attrib_t&             attrib,
+                     const tinyobj::shape_t&              shape,
+                     bool                                 calculateTangents,
+                     std::vector<VKFW::Graphics::Vertex>& vertices,
+                     std::vector<uint32_t>&               indices) {
+    const std::vector<tinyobj::index_t>& corners = shape.mesh.indices;
+
+    // Weld first, so the vertex array is allocated once with its final size
+    std::vector<tinyobj::index_t> uniqueCorners;
+    uniqueCorners.reserve(corners.size());
+    OBJCornerWeldTable weldTable(corners.size(), uniqueCorners);
+
+    indices.resize(corners.size());
+    for (size_t i = 0; i < corners.size(); i++)
     {
-        LOG_ERROR(err);
-        LOG_ERROR("ERROR: Couldn't load mesh");
-        return;
+        uint32_t vertex = weldTable.weld(corners[i], static_cast<uint32_t>(uniqueCorners.size()));
+        if (vertex == uniqueCorners.size())
+            uniqueCorners.push_back(corners[i]);
+        indices[i] = vertex;
     }
 
-    size_t shape_id = 0;
-    for (const tinyobj::shape_t& shape : shapes)
+    vertices.resize(uniqueCorners.size());
+    for (size_t i = 0; i < uniqueCorners.size(); i++)
     {
-        std::vector<Graphics::Vertex>                  vertices;
-        std::vector<uint32_t>                          indices;
-        std::unordered_map<Graphics::Vertex, uint32_t> uniqueVertices;
-        if (!shape.mesh.indices.empty())
-        {
-            // IS INDEXED
-            for (const tinyobj::index_t& index : shape.mesh.indices)
-            {
-                Graphics::Vertex vertex = {};
+        const tinyobj::index_t& corner = uniqueCorners[i];
+        VKFW::Graphics::Vertex& vertex = vertices[i];
+        vertex                         = {};
 
-                // Position and color
-                if (index.vertex_index >= 0)
-                {
-                    vertex.pos.x = attrib.vertices[3 * index.vertex_index + 0];
-                    vertex.pos.y = attrib.vertices[3 * index.vertex_index + 1];
-                    vertex.pos.z = attrib.vertices[3 * index.vertex_index + 2];
-
-                    vertex.color.r = attrib.colors[3 + index.vertex_index + 0];
-                    vertex.color.g = attrib.colors[3 + index.vertex_index + 1];
-                    vertex.color.b = attrib.colors[3 + index.vertex_index + 2];
-                }
-                // Normal
-                if (index.normal_index >= 0)
-                {
-                    vertex.normal.x = attrib.normals[3 * index.normal_index + 0];
-                    vertex.normal.y = attrib.normals[3 * index.normal_index + 1];
-                    vertex.normal.z = attrib.normals[3 * index.normal_index + 2];
-                }
-
-                // Tangent
-                vertex.tangent = {0.0, 0.0, 0.0};
-
-                // UV
-                if (index.texcoord_index >= 0)
-                {
-                    vertex.texCoord.x = attrib.texcoords[2 * index.texcoord_index + 0];
-                    vertex.texCoord.y = attrib.texcoords[2 * index.texcoord_index + 1];
-                }
-
-                // Check if the vertex is already in the map
-                if (uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+        // Position and color
+        if (corner.vertex_index >= 0)
+        {
+            vertex.pos.x = attrib.vertices[3 * corner.vertex_index + 0];
+            vertex.pos.y = attrib.vertices[3 * corner.vertex_index + 1];
+            vertex.pos.z = attrib.vertices[3 * corner.vertex_index + 2];
 
-                indices.push_back(uniqueVertices[vertex]);
-            }
-        } else
-            // NOT INDEXED
-            for (size_t i = 0; i < shape.mesh.num_face_vertices.size(); i++)
+            if (attrib.colors.size() >= attrib.vertices.size())
             {
-                for (size_t j = 0; j < shape.mesh.num_face_vertices[i]; j++)
-                {
-                    Graphics::Vertex vertex{};
-                    size_t           vertex_index = shape.mesh.indices[i * shape.mesh.num_face_vertices[i] + j].vertex_index;
-                    // Pos
-                    if (!attrib.vertices.empty())
-                    {
-                        vertex.pos.x = attrib.vertices[3 * vertex_index + 0];
-                        vertex.pos.y = attrib.vertices[3 * vertex_index + 1];
-                        vertex.pos.z = attrib.vertices[3 * vertex_index + 2];
-                    }
-                    // Normals
-                    if (!attrib.normals.empty())
-                    {
-                        vertex.normal.x = attrib.normals[3 * vertex_index + 0];
-                        vertex.normal.y = attrib.normals[3 * vertex_index + 1];
-                        vertex.normal.z = attrib.normals[3 * vertex_index + 2];
-                    }
-                    // Tangents
-
-                    vertex.tangent = {0.0, 0.0, 0.0};
-
-                    // UV
-                    if (!attrib.texcoords.empty())
-                    {
-                        vertex.texCoord.x = attrib.texcoords[2 * vertex_index + 0];
-                        vertex.texCoord.y = attrib.texcoords[2 * vertex_index + 1];
-                    }
-                    // COLORS
-                    if (!attrib.colors.empty())
-                    {
-                        vertex.color.r = attrib.colors[3 * vertex_index + 0];
-                        vertex.color.g = attrib.colors[3 * vertex_index + 1];
-                        vertex.color.b = attrib.colors[3 * vertex_index + 2];
-                    }
-
-                    vertices.push_back(vertex);
-                }
+                vertex.color.r = attrib.colors[3 * corner.vertex_index + 0];
+                vertex.color.g = attrib.colors[3 * corner.vertex_index + 1];
+                vertex.color.b = attrib.colors[3 * corner.vertex_index + 2];
             }
-
-        if (calculateTangents)
+        }
+        // Normal
+        if (corner.normal_index >= 0)
         {
-            Core::Geometry::compute_tangents_gram_smidt(vertices, indices);
+            vertex.normal.x = attrib.normals[3 * corner.normal_index + 0];
+            vertex.normal.y = attrib.normals[3 * corner.normal_index + 1];
+            vertex.normal.z = attrib.normals[3 * corner.normal_index + 2];
         }
+        // UV
+        if (corner.texcoord_index >= 0)
+        {
+            vertex.texCoord.x = attrib.texcoords[2 * corner.texcoord_index + 0];
+            vertex.texCoord.y = attrib.texcoords[2 * corner.texcoord_index + 1];
+        }
+    }
 
-        Core::Geometry* g = new Core::Geometry();
-        g->fill(vertices, indices);
-        mesh->set_geometry(g);
+    if (calculateTangents)
+        VKFW::Core::Geometry::compute_tangents_gram_smidt(vertices, indices);
+}
+/*
+Geometry cache header. Vertex, index, voxel, meshlet, LOD index and LOD arrays follow it in that order, tightly packed
+*/
+struct GeometryCacheHeader {
+    char     magic[4]      = {'V', 'K', 'G', 'M'};
+    uint32_t version       = GEOMETRY_CACHE_VERSION;
+    uint32_t vertexSize    = sizeof(VKFW::Graphics::Vertex);
+    uint32_t voxelSize     = sizeof(VKFW::Graphics::Voxel);
+    uint32_t meshletSize   = sizeof(VKFW::Core::Meshlet);
+    uint32_t lodSize       = sizeof(VKFW::Core::GeometryLOD);
+    uint32_t topology      = 0;
+    uint32_t vertexCount   = 0;
+    uint32_t indexCount    = 0;
+    uint32_t voxelCount    = 0;
+    uint32_t meshletCount  = 0;
+    uint32_t lodIndexCount = 0;
+    uint32_t lodCount      = 0;
+    float    minCoords[3]  = {0.0f, 0.0f, 0.0f};
+    float    maxCoords[3]  = {0.0f, 0.0f, 0.0f};
+};
+} // namespace
 
-        shape_id++;
-    }
-    mesh->set_file_route(fileName);
-    return;
+void VKFW::Tools::Loaders::load_OBJ(Core::Mesh* const mesh, const std::string fileName, bool importMaterials, bool calculateTangents) {
+    load_OBJ_topology(mesh, Core::Topology::TRIANGLES, fileName, importMaterials, calculateTangents);
 }
 
 void VKFW::Tools::Loaders::load_OBJ_topology(Core::Mesh* const mesh,
@@ -163,111 +173,45 @@ void VKFW::Tools::Loaders::load_OBJ_topology(Core::Mesh* const mesh,
         return;
     }
 
-    size_t shape_id = 0;
-    for (const tinyobj::shape_t& shape : shapes)
-    {
-        std::vector<Graphics::Vertex>                  vertices;
-        std::vector<uint32_t>                          indices;
-        std::unordered_map<Graphics::Vertex, uint32_t> uniqueVertices;
-        if (!shape.mesh.indices.empty())
-        {
-            // IS INDEXED
-            for (const tinyobj::index_t& index : shape.mesh.indices)
-            {
-                Graphics::Vertex vertex = {};
-
-                // Position and color
-                if (index.vertex_index >= 0)
-                {
-                    vertex.pos.x = attrib.vertices[3 * index.vertex_index + 0];
-                    vertex.pos.y = attrib.vertices[3 * index.vertex_index + 1];
-                    vertex.pos.z = attrib.vertices[3 * index.vertex_index + 2];
-
-                    vertex.color.r = attrib.colors[3 + index.vertex_index + 0];
-                    vertex.color.g = attrib.colors[3 + index.vertex_index + 1];
-                    vertex.color.b = attrib.colors[3 + index.vertex_index + 2];
-                }
-                // Normal
-                if (index.normal_index >= 0)
-                {
-                    vertex.normal.x = attrib.normals[3 * index.normal_index + 0];
-                    vertex.normal.y = attrib.normals[3 * index.normal_index + 1];
-                    vertex.normal.z = attrib.normals[3 * index.normal_index + 2];
-                }
-
-                // Tangent
-                vertex.tangent = {0.0, 0.0, 0.0};
-
-                // UV
-                if (index.texcoord_index >= 0)
-                {
-                    vertex.texCoord.x = attrib.texcoords[2 * index.texcoord_index + 0];
-                    vertex.texCoord.y = attrib.texcoords[2 * index.texcoord_index + 1];
-                }
-
-                // Check if the vertex is already in the map
-                if (uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-
-                indices.push_back(uniqueVertices[vertex]);
-            }
-        } else
-            // NOT INDEXED
-            for (size_t i = 0; i < shape.mesh.num_face_vertices.size(); i++)
-            {
-                for (size_t j = 0; j < shape.mesh.num_face_vertices[i]; j++)
-                {
-                    Graphics::Vertex vertex{};
-                    size_t           vertex_index = shape.mesh.indices[i * shape.mesh.num_face_vertices[i] + j].vertex_index;
-                    // Pos
-                    if (!attrib.vertices.empty())
-                    {
-                        vertex.pos.x = attrib.vertices[3 * vertex_index + 0];
-                        vertex.pos.y = attrib.vertices[3 * vertex_index + 1];
-                        vertex.pos.z = attrib.vertices[3 * vertex_index + 2];
-                    }
-                    // Normals
-                    if (!attrib.normals.empty())
-                    {
-                        vertex.normal.x = attrib.normals[3 * vertex_index + 0];
-                        vertex.normal.y = attrib.normals[3 * vertex_index + 1];
-                        vertex.normal.z = attrib.normals[3 * vertex_index + 2];
-                    }
-                    // Tangents
-
-                    vertex.tangent = {0.0, 0.0, 0.0};
-
-                    // UV
-                    if (!attrib.texcoords.empty())
-                    {
-                        vertex.texCoord.x = attrib.texcoords[2 * vertex_index + 0];
-                        vertex.texCoord.y = attrib.texcoords[2 * vertex_index + 1];
-                    }
-                    // COLORS
-                    if (!attrib.colors.empty())
-                    {
-                        vertex.color.r = attrib.colors[3 * vertex_index + 0];
-                        vertex.color.g = attrib.colors[3 * vertex_index + 1];
-                        vertex.color.b = attrib.colors[3 * vertex_index + 2];
-                    }
+    // Shapes are welded in parallel. Small files stay on this thread
+    std::vector<std::vector<Graphics::Vertex>>  shapeVertices(shapes.size());
+    std::vector<std::vector<uint32_t>>          shapeIndices(shapes.size());
+    std::vector<std::vector<Core::Meshlet>>     shapeMeshlets(shapes.size());
+    std::vector<std::vector<Core::GeometryLOD>> shapeLODs(shapes.size());
+    std::vector<std::vector<uint32_t>>          shapeLODIndices(shapes.size());
+    std::atomic<size_t>                         nextShape{0};
+    auto                                        build_shapes = [&]() {
+        for (size_t i = nextShape++; i < shapes.size(); i = nextShape++)
+        {
+            build_OBJ_shape(attrib, shapes[i], calculateTangents, shapeVertices[i], shapeIndices[i]);
+            if (topology != Core::Topology::TRIANGLES)
+                continue;
+            if (shapeIndices[i].size() >= 3 * ENGINE_LOD_MIN_TRIANGLES)
+                shapeLODs[i] = Core::build_LODs(shapeVertices[i], shapeIndices[i], shapeLODIndices[i]);
+            if (shapeIndices[i].size() >= 3 * ENGINE_MESHLET_MIN_TRIANGLES)
+                shapeMeshlets[i] = Core::build_meshlets(shapeVertices[i], shapeIndices[i]);
+        }
+    };
 
-                    vertices.push_back(vertex);
-                }
-            }
+    size_t corners = 0;
+    for (const tinyobj::shape_t& shape : shapes)
+        corners += shape.mesh.indices.size();
+    size_t threadCount = std::min<size_t>({shapes.size(), std::max(1u, std::thread::hardware_concurrency()), corners / OBJ_MIN_CORNERS_PER_THREAD + 1});
 
-        if (calculateTangents)
-        {
-            Core::Geometry::compute_tangents_gram_smidt(vertices, indices);
-        }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++)
+        threads.emplace_back(build_shapes);
+    build_shapes();
+    for (std::thread& thread : threads)
+        thread.join();
 
+    for (size_t i = 0; i < shapes.size(); i++)
+    {
         Core::Geometry* g = new Core::Geometry();
-        g->fill(vertices, indices, topology);
+        g->fill(std::move(shapeVertices[i]), std::move(shapeIndices[i]), topology);
+        g->fill_meshlet_array(std::move(shapeMeshlets[i]));
+        g->fill_LOD_array(std::move(shapeLODs[i]), std::move(shapeLODIndices[i]));
         mesh->set_geometry(g);
-
-        shape_id++;
     }
     mesh->set_file_route(fileName);
     return;
@@ -424,6 +368,8 @@ void VKFW::Tools::Loaders::load_PLY(Core::Mesh* const mesh, const std::string fi
             if (texcoords)
                 uvData = reinterpret_cast<const float*>(texcoords->buffer.get());
 
+            vertices.reserve(positions->count);
+
             for (size_t i = 0; i < positions->count; i++)
             {
 
@@ -435,31 +381,33 @@ void VKFW::Tools::Loaders::load_PLY(Core::Mesh* const mesh, const std::string fi
                 vertices.push_back({position, normal, {0.0f, 0.0f, 0.0f}, uv, color});
             }
         }
-        unsigned* facesData = reinterpret_cast<unsigned*>(faces->buffer.get());
-        for (size_t i = 0; i < faces->count; ++i)
-        {
-            unsigned int vertexIndex1 = static_cast<unsigned int>(facesData[i]);
-            unsigned int vertexIndex2 = static_cast<unsigned int>(facesData[i + 1]);
-            unsigned int vertexIndex3 = static_cast<unsigned int>(facesData[i + 2]);
-
-            indices.push_back(facesData[3 * i]);
-            indices.push_back(facesData[3 * i + 1]);
-            indices.push_back(facesData[3 * i + 2]);
-        }
+        // Faces are already a packed triangle list
+        const uint32_t* facesData = reinterpret_cast<const uint32_t*>(faces->buffer.get());
+        indices.assign(facesData, facesData + 3 * faces->count);
 
         if (calculateTangents && normals)
         {
             Core::Geometry::compute_tangents_gram_smidt(vertices, indices);
         }
 
+        std::vector<Core::GeometryLOD> lods;
+        std::vector<uint32_t>          lodIndices;
+        if (faces->count >= ENGINE_LOD_MIN_TRIANGLES)
+            lods = Core::build_LODs(vertices, indices, lodIndices);
+        std::vector<Core::Meshlet> meshlets;
+        if (faces->count >= ENGINE_MESHLET_MIN_TRIANGLES)
+            meshlets = Core::build_meshlets(vertices, indices);
+
         Core::Geometry* g = new Core::Geometry();
-        g->fill(vertices, indices);
+        g->fill(std::move(vertices), std::move(indices));
+        g->fill_meshlet_array(std::move(meshlets));
+        g->fill_LOD_array(std::move(lods), std::move(lodIndices));
         mesh->set_geometry(g);
         mesh->set_file_route(fileName);
     } catch (const std::exception& e)
     { std::cerr << "Caught tinyply exception: " << e.what() << std::endl; }
 }
-void VKFW::Tools::Loaders::load_3D_file(Core::Mesh* const mesh, const std::string fileName, bool asynCall) {
+void VKFW::Tools::Loaders::load_3D_file(Core::Mesh* const mesh, const std::string fileName, bool asynCall, bool useCache) {
     size_t dotPosition = fileName.find_last_of(".");
 
     if (dotPosition != std::string::npos)
@@ -467,25 +415,37 @@ void VKFW::Tools::Loaders::load_3D_file(Core::Mesh* const mesh, const std::strin
 
         std::string fileExtension = fileName.substr(dotPosition + 1);
 
-        if (fileExtension == OBJ)
+        if (fileExtension == OBJ || fileExtension == PLY)
         {
-            if (asynCall)
-            {
-                std::thread loadThread(Loaders::load_OBJ, mesh, fileName, false, true);
-                loadThread.detach();
-            } else
-                Loaders::load_OBJ(mesh, fileName, false, true);
+            auto load = [mesh, fileName, fileExtension, useCache]() {
+                const std::string cacheName = fileName + GEOMETRY_CACHE_EXTENSION;
+                if (useCache)
+                {
+                    std::error_code error;
+                    auto            cacheTime  = std::filesystem::last_write_time(cacheName, error);
+                    bool            cacheFound = !error;
+                    auto            sourceTime = std::filesystem::last_write_time(fileName, error);
+                    if (cacheFound && (error || cacheTime >= sourceTime) && load_geometry_cache(mesh, cacheName))
+                    {
+                        mesh->set_file_route(fileName);
+                        return;
+                    }
+                }
 
-            return;
-        }
-        if (fileExtension == PLY)
-        {
+                if (fileExtension == OBJ)
+                    Loaders::load_OBJ(mesh, fileName, false, true);
+                else
+                    Loaders::load_PLY(mesh, fileName, true, false, true);
+
+                if (useCache && mesh->get_geometry() && mesh->get_geometry()->data_loaded())
+                    save_geometry_cache(mesh->get_geometry(), cacheName);
+            };
             if (asynCall)
             {
-                std::thread loadThread(Loaders::load_PLY, mesh, fileName, true, false, true);
+                std::thread loadThread(load);
                 loadThread.detach();
             } else
-                Loaders::load_PLY(mesh, fileName, true, false, true);
+                load();
 
             return;
         }
@@ -507,6 +467,113 @@ void VKFW::Tools::Loaders::load_3D_file(Core::Mesh* const mesh, const std::strin
         std::cerr << "Invalid file name: " << fileName << std::endl;
     }
 }
+bool VKFW::Tools::Loaders::load_geometry_cache(Core::Mesh* const mesh, const std::string fileName) {
+    PROFILING_EVENT()
+    Utils::MappedFile file;
+    if (!file.open(fileName) || file.size() < sizeof(GeometryCacheHeader))
+        return false;
+
+    GeometryCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(GeometryCacheHeader));
+    const GeometryCacheHeader expected;
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version ||
+        header.vertexSize != expected.vertexSize || header.voxelSize != expected.voxelSize || header.meshletSize != expected.meshletSize ||
+        header.lodSize != expected.lodSize || header.topology > static_cast<uint32_t>(Core::Topology::OTHER))
+    {
+        LOG_WARN("Outdated geometry cache " + fileName + ", importing the source file again");
+        return false;
+    }
+
+    const size_t vertexBytes  = size_t(header.vertexCount) * sizeof(Graphics::Vertex);
+    const size_t indexBytes   = size_t(header.indexCount) * sizeof(uint32_t);
+    const size_t voxelBytes   = size_t(header.voxelCount) * sizeof(Graphics::Voxel);
+    const size_t meshletBytes  = size_t(header.meshletCount) * sizeof(Core::Meshlet);
+    const size_t lodIndexBytes = size_t(header.lodIndexCount) * sizeof(uint32_t);
+    const size_t lodBytes      = size_t(header.lodCount) * sizeof(Core::GeometryLOD);
+    if (file.size() != sizeof(GeometryCacheHeader) + vertexBytes + indexBytes + voxelBytes + meshletBytes + lodIndexBytes + lodBytes)
+    {
+        LOG_WARN("Corrupt geometry cache " + fileName + ", importing the source file again");
+        return false;
+    }
+
+    // The mapping is page aligned and every array is 4 byte aligned within it, so they are copied straight out of it
+    const uint8_t*  data = file.data() + sizeof(GeometryCacheHeader);
+    Core::Geometry* g    = new Core::Geometry();
+    g->fill(reinterpret_cast<const Graphics::Vertex*>(data),
+            header.vertexCount,
+            reinterpret_cast<const uint32_t*>(data + vertexBytes),
+            header.indexCount,
+            static_cast<Core::Topology>(header.topology),
+            Vec3(header.minCoords[0], header.minCoords[1], header.minCoords[2]),
+            Vec3(header.maxCoords[0], header.maxCoords[1], header.maxCoords[2]));
+    if (header.voxelCount > 0)
+    {
+        const Graphics::Voxel* voxels = reinterpret_cast<const Graphics::Voxel*>(data + vertexBytes + indexBytes);
+        g->fill_voxel_array(std::vector<Graphics::Voxel>(voxels, voxels + header.voxelCount));
+    }
+    if (header.meshletCount > 0)
+    {
+        const Core::Meshlet* meshlets = reinterpret_cast<const Core::Meshlet*>(data + vertexBytes + indexBytes + voxelBytes);
+        g->fill_meshlet_array(std::vector<Core::Meshlet>(meshlets, meshlets + header.meshletCount));
+    }
+    if (header.lodCount > 0)
+    {
+        const uint8_t*           lodData    = data + vertexBytes + indexBytes + voxelBytes + meshletBytes;
+        const uint32_t*          lodIndices = reinterpret_cast<const uint32_t*>(lodData);
+        const Core::GeometryLOD* lods       = reinterpret_cast<const Core::GeometryLOD*>(lodData + lodIndexBytes);
+        g->fill_LOD_array(std::vector<Core::GeometryLOD>(lods, lods + header.lodCount),
+                          std::vector<uint32_t>(lodIndices, lodIndices + header.lodIndexCount));
+    }
+    mesh->set_geometry(g);
+    return true;
+}
+void VKFW::Tools::Loaders::save_geometry_cache(Core::Geometry* const geometry, const std::string fileName) {
+    PROFILING_EVENT()
+    const Core::GeometricData& props = geometry->get_properties();
+
+    GeometryCacheHeader header;
+    header.topology     = static_cast<uint32_t>(props.topology);
+    header.vertexCount  = static_cast<uint32_t>(props.vertexData.size());
+    header.indexCount   = static_cast<uint32_t>(props.vertexIndex.size());
+    header.voxelCount   = static_cast<uint32_t>(props.voxelData.size());
+    header.meshletCount  = static_cast<uint32_t>(props.meshlets.size());
+    header.lodIndexCount = static_cast<uint32_t>(props.lodIndex.size());
+    header.lodCount      = static_cast<uint32_t>(props.lods.size());
+    for (int i = 0; i < 3; i++)
+    {
+        header.minCoords[i] = props.minCoords[i];
+        header.maxCoords[i] = props.maxCoords[i];
+    }
+
+    // Written aside and renamed, so a concurrent load never maps half a file
+    std::error_code       error;
+    std::filesystem::path tmpPath = fileName + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARN("Could not write geometry cache " + fileName);
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(GeometryCacheHeader));
+        file.write(reinterpret_cast<const char*>(props.vertexData.data()), props.vertexData.size() * sizeof(Graphics::Vertex));
+        file.write(reinterpret_cast<const char*>(props.vertexIndex.data()), props.vertexIndex.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(props.voxelData.data()), props.voxelData.size() * sizeof(Graphics::Voxel));
+        file.write(reinterpret_cast<const char*>(props.meshlets.data()), props.meshlets.size() * sizeof(Core::Meshlet));
+        file.write(reinterpret_cast<const char*>(props.lodIndex.data()), props.lodIndex.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(props.lods.data()), props.lods.size() * sizeof(Core::GeometryLOD));
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tmpPath, error);
+            LOG_WARN("Could not write geometry cache " + fileName);
+            return;
+        }
+    }
+    std::filesystem::rename(tmpPath, fileName, error);
+    if (error)
+        std::filesystem::remove(tmpPath, error);
+}
 void VKFW::Tools::Loaders::load_hair(Core::Mesh* const mesh, const char* fileName) {
 
 #define HAIR_FILE_SEGMENTS_BIT 1
@@ -767,7 +834,7 @@ void VKFW::Tools::Loaders::load_hair(Core::Mesh* const mesh, const char* fileNam
     }
 
     Core::Geometry* g = new Core::Geometry();
-    g->fill(vertices, indices, Core::Topology::LINES_TO_TRIANGLES);
+    g->fill(std::move(vertices), std::move(indices), Core::Topology::LINES_TO_TRIANGLES);
     mesh->set_geometry(g);
     mesh->set_file_route(std::string(fileName));
 }
@@ -289,6 +289,11 @@ void VKFW::Tools::SceneLoader::load_children(tinyxml2::XMLElement* element, Core
 
                 dirLight->set_direction(dir);
             }
+            if (lightElement->FirstChildElement("cascades"))
+            {
+                dirLight->set_cascade_count(lightElement->FirstChildElement("cascades")->IntAttribute("count", ENGINE_MAX_CASCADES));
+                dirLight->set_cascade_lambda(lightElement->FirstChildElement("cascades")->FloatAttribute("lambda", 0.75f));
+            }
         }
         if (lightType == "spot")
         {
@@ -490,6 +495,10 @@ void VKFW::Tools::SceneLoader::save_children(tinyxml2::XMLElement* parentElement
                 directionElement->SetAttribute("y", direction.y);
                 directionElement->SetAttribute("z", direction.z);
                 lightElement->InsertEndChild(directionElement);
+                auto* cascadesElement = doc->NewElement("cascades");
+                cascadesElement->SetAttribute("count", static_cast<Core::DirectionalLight*>(light)->get_cascade_count());
+                cascadesElement->SetAttribute("lambda", static_cast<Core::DirectionalLight*>(light)->get_cascade_lambda());
+                lightElement->InsertEndChild(cascadesElement);
                 break;
             }
 
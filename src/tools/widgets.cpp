@@ -1225,6 +1225,12 @@ void ObjectExplorerWidget::render() {
                 {
                     dirL->set_direction(Vec3(dir[0], dir[1], dir[2]));
                 };
+            int cascades = static_cast<int>(dirL->get_cascade_count());
+            if (ImGui::SliderInt("Shadow Cascades", &cascades, 1, ENGINE_MAX_CASCADES))
+                dirL->set_cascade_count(cascades);
+            float lambda = dirL->get_cascade_lambda();
+            if (ImGui::SliderFloat("Cascade Split Lambda", &lambda, 0.0f, 1.0f))
+                dirL->set_cascade_lambda(lambda);
         }
 
         float intensity = light->get_intensity();
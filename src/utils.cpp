@@ -1,4 +1,10 @@
 #include <engine/utils.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 VULKAN_ENGINE_NAMESPACE_BEGIN
 
@@ -20,6 +26,69 @@ std::string Utils::read_file(const std::string& filePath) {
     return buffer.str();
 }
 
+bool Utils::MappedFile::open(const std::string& filePath) {
+    close();
+#ifdef _WIN32
+    m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        close();
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(filePath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat fileStats;
+    if (fstat(file, &fileStats) != 0 || fileStats.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(fileStats.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps the file referenced
+    ::close(file);
+    if (data == MAP_FAILED)
+        return false;
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(fileStats.st_size);
+#endif
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+void Utils::MappedFile::close() {
+#ifdef _WIN32
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+#else
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
 Vec3 Utils::get_tangent_gram_smidt(Vec3& p1, Vec3& p2, Vec3& p3, Vec2& uv1, Vec2& uv2, Vec2& uv3, Vec3 normal) {
 
     Vec3      edge1    = p2 - p1;
@@ -151,4 +220,82 @@ size_t Utils::get_pixel_size_in_bytes(ColorFormatType format) {
         throw std::invalid_argument("Unknown format in get_pixel_size");
     }
 }
-VULKAN_ENGINE_NAMESPACE_END
\ No newline at end of file
+
+Utils::JobSystem::JobSystem(size_t workerCount) {
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 1; i < workerCount; i++)
+        m_threads.emplace_back(&JobSystem::worker_loop, this, i);
+}
+Utils::JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCondition.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+void Utils::JobSystem::worker_loop(size_t worker) {
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        std::function<void(size_t)> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop)
+                return;
+            seenGeneration = m_generation;
+            if (worker >= m_jobCount)
+                continue;
+            job = m_job;
+        }
+        job(worker);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_doneCondition.notify_one();
+    }
+}
+size_t Utils::JobSystem::get_chunk_count(size_t count, size_t minChunkSize) const {
+    if (count == 0)
+        return 0;
+    size_t chunks = std::max<size_t>(count / std::max<size_t>(minChunkSize, 1), 1);
+    return std::min(chunks, get_worker_count());
+}
+void Utils::JobSystem::parallel_for(size_t                                                          count,
+                                    size_t                                                          minChunkSize,
+                                    const std::function<void(size_t begin, size_t end, size_t worker)>& job) {
+    size_t chunks = get_chunk_count(count, minChunkSize);
+    if (chunks == 0)
+        return;
+    // Even split: chunk sizes differ by one item at most, so none falls under count / chunks
+    auto runChunk = [&](size_t worker) {
+        size_t begin = worker * count / chunks;
+        size_t end   = (worker + 1) * count / chunks;
+        if (begin < end)
+            job(begin, end, worker);
+    };
+    if (chunks == 1)
+    {
+        runChunk(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job      = runChunk;
+        m_jobCount = chunks;
+        m_pending  = chunks - 1;
+        m_generation++;
+    }
+    m_wakeCondition.notify_all();
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [&] { return m_pending == 0; });
+    m_job = nullptr;
+}
+VULKAN_ENGINE_NAMESPACE_END
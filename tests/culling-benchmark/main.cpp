@@ -0,0 +1,115 @@
+#include <engine/core/scene/culling.h>
+#include <engine/core/scene/mesh.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Frustum culling micro-benchmark. Culls random scenes of 10k, 100k and 1M meshes with the per mesh bounding volume test and with
+the structure of arrays kernel, and checks the SIMD kernel against its scalar version. No device needed
+*/
+
+namespace {
+Core::Geometry* create_cube() {
+    std::vector<Graphics::Vertex> vertices;
+    for (uint32_t v = 0; v < 8; v++)
+    {
+        Vec3 p = Vec3(v & 1 ? 1.0f : -1.0f, v & 2 ? 1.0f : -1.0f, v & 4 ? 1.0f : -1.0f);
+        vertices.push_back({p, math::normalize(p), Vec3(0.0f), Vec2(0.0f), Vec3(1.0f)});
+    }
+    std::vector<uint32_t> indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                     2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+    Core::Geometry* g = new Core::Geometry();
+    g->fill(std::move(vertices), std::move(indices));
+    return g;
+}
+template <typename F> double best_time(uint32_t runs, F&& f) {
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t r = 0; r < runs; r++)
+    {
+        Utils::ManualTimer timer;
+        timer.start();
+        f();
+        timer.stop();
+        best = std::min(best, timer.get());
+    }
+    return best;
+}
+} // namespace
+
+int main() {
+    const uint32_t RUNS = 5;
+
+    Core::Geometry* cube = create_cube();
+    Mat4            proj = math::perspective(math::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    proj[1][1] *= -1;
+    const Core::Frustum frustum = Core::extract_frustum(proj * math::lookAt(Vec3(0.0f), Vec3(1.0f, 0.1f, 0.3f), Vec3(0.0f, 1.0f, 0.0f)));
+
+    std::cout << "Kernel: " << Core::get_culling_ISA() << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(10) << "Meshes" << std::setw(14) << "Per mesh" << std::setw(14) << "Update" << std::setw(14) << "Scalar"
+              << std::setw(14) << "SIMD" << std::setw(10) << "Speedup" << std::setw(12) << "Visible" << std::endl;
+
+    uint32_t errors = 0;
+    for (uint32_t count : {10000u, 100000u, 1000000u})
+    {
+        std::mt19937                          rng(5);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Core::Mesh*>              meshes(count);
+        for (Core::Mesh*& m : meshes)
+        {
+            m = new Core::Mesh(cube, nullptr);
+            m->setup_volume();
+            m->set_position(Vec3(unit(rng), unit(rng), unit(rng)) * 400.0f);
+            m->set_rotation(Vec3(unit(rng), unit(rng), unit(rng)) * 180.0f);
+            m->set_scale(1.0f + unit(rng) * 0.5f);
+        }
+
+        // What every pass did before: a virtual bounding volume test per mesh
+        uint32_t     oldVisible = 0;
+        const double oldTime    = best_time(RUNS, [&]() {
+            oldVisible = 0;
+            for (Core::Mesh* m : meshes)
+                oldVisible += m->get_bounding_volume()->is_on_frustrum(frustum);
+        });
+
+        Core::CullingBounds bounds;
+        const double        updateTime = best_time(RUNS, [&]() {
+            bounds.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+                bounds.set(i, meshes[i]->get_model_matrix(), cube->get_properties().minCoords, cube->get_properties().maxCoords);
+        });
+
+        Core::VisibilityMask scalar, simd;
+        const double         scalarTime = best_time(RUNS, [&]() { Core::cull_frustum_scalar(bounds, frustum, scalar); });
+        const double         simdTime   = best_time(RUNS, [&]() { Core::cull_frustum(bounds, frustum, simd); });
+
+        // Fused multiply adds of the scalar version may flip objects exactly on a face
+        uint32_t mismatches = 0;
+        for (size_t w = 0; w < simd.words.size(); w++)
+        {
+            uint64_t diff = simd.words[w] ^ scalar.words[w];
+            for (; diff; diff &= diff - 1)
+                mismatches++;
+        }
+        if (mismatches > count / 10000)
+            errors++;
+
+        std::cout << std::setw(10) << count << std::setw(11) << oldTime << " ms" << std::setw(11) << updateTime << " ms" << std::setw(11)
+                  << scalarTime << " ms" << std::setw(11) << simdTime << " ms" << std::setw(9) << oldTime / std::max(simdTime, 1e-6) << "x"
+                  << std::setw(12) << simd.count_visible() << " (" << oldVisible << " by sphere)" << std::endl;
+
+        for (Core::Mesh* m : meshes)
+            delete m;
+    }
+    delete cube;
+
+    if (errors > 0)
+    {
+        std::cerr << "SIMD and scalar culling disagree" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -24,6 +24,10 @@ void Application::run(int argc, char* argv[]) {
 
     init(settings);
 
+    // The GUI pass is off when headless, so the tonemapped image is the output of the graph
+    if (m_renderer->get_render_graph().is_culled(Systems::DeferredRenderer::TONEMAPPIN_PASS))
+        throw std::runtime_error("Headless render graph culled the tonemapping pass");
+
     m_renderer->render(m_scene);
 
     Core::ITexture* texture1 = m_renderer->capture_texture(7);
@@ -0,0 +1,63 @@
+#include <engine/tools/loaders.h>
+#include <iomanip>
+#include <iostream>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Loader micro-benchmark. Imports every .obj file of a directory (examples meshes by default, or the first argument) a few times
+and reports throughput
+*/
+int main(int argc, char* argv[]) {
+    const std::filesystem::path MESH_PATH(argc > 1 ? argv[1] : BENCHMARK_MESHES_PATH);
+    const uint32_t              RUNS = 3;
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(MESH_PATH))
+        if (entry.is_regular_file() && entry.path().extension() == ".obj")
+            files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+    if (files.empty())
+    {
+        std::cerr << "No .obj files found in " << MESH_PATH << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double totalBytes    = 0.0;
+    double totalVertices = 0.0;
+    double totalTime     = 0.0;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const std::filesystem::path& file : files)
+    {
+        const double BYTES = static_cast<double>(std::filesystem::file_size(file));
+
+        double bestTime = std::numeric_limits<double>::max();
+        size_t vertices = 0;
+        for (uint32_t run = 0; run < RUNS; run++)
+        {
+            Core::Mesh*        mesh = new Core::Mesh();
+            Utils::ManualTimer timer;
+            timer.start();
+            Tools::Loaders::load_OBJ(mesh, file.string(), false, true);
+            timer.stop();
+            bestTime = std::min(bestTime, timer.get());
+
+            Core::Geometry* g = mesh->get_geometry();
+            vertices          = g ? g->get_properties().vertexData.size() : 0;
+            delete g;
+            delete mesh;
+        }
+
+        const double SECONDS = std::max(bestTime, 1e-3) / 1000.0;
+        std::cout << std::setw(24) << file.filename().string() << std::setw(10) << bestTime << " ms" << std::setw(10) << BYTES / SECONDS * 1e-6
+                  << " MB/s" << std::setw(12) << vertices / SECONDS * 1e-6 << " Mverts/s" << std::endl;
+
+        totalBytes += BYTES;
+        totalVertices += static_cast<double>(vertices);
+        totalTime += SECONDS;
+    }
+    std::cout << std::setw(24) << "TOTAL" << std::setw(10) << totalTime * 1000.0 << " ms" << std::setw(10) << totalBytes / totalTime * 1e-6
+              << " MB/s" << std::setw(12) << totalVertices / totalTime * 1e-6 << " Mverts/s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+#include <array>
+#include <engine/core/geometries/geometry.h>
+#include <iostream>
+#include <random>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Meshlet clustering and culling test. Clusters a dense sphere, checks the meshlets keep every triangle within the bounds, and that
+the culling kernel (mirrored by the GPU culling shader) never culls a triangle that could be seen from random cameras
+*/
+
+namespace {
+Core::Geometry* create_sphere(uint32_t rings, uint32_t sectors) {
+    std::vector<Graphics::Vertex> vertices;
+    std::vector<uint32_t>         indices;
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        float phi = math::pi<float>() * r / rings;
+        for (uint32_t s = 0; s <= sectors; s++)
+        {
+            float theta = 2.0f * math::pi<float>() * s / sectors;
+            Vec3  p     = Vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            vertices.push_back({p, p, Vec3(0.0f), Vec2(float(s) / sectors, float(r) / rings), Vec3(1.0f)});
+        }
+    }
+    // Counter clockwise seen from outside
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < sectors; s++)
+        {
+            uint32_t a = r * (sectors + 1) + s;
+            uint32_t b = a + sectors + 1;
+            indices.insert(indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+        }
+    }
+    Core::Geometry* g = new Core::Geometry();
+    g->fill(std::move(vertices), std::move(indices));
+    return g;
+}
+
+std::vector<std::array<uint32_t, 3>> sorted_triangles(const std::vector<uint32_t>& indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        // Rotated so the smallest index goes first, which keeps the winding
+        std::array<uint32_t, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+        while (t[0] > t[1] || t[0] > t[2])
+            t = {t[1], t[2], t[0]};
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// A triangle can be seen if it faces the camera and no single frustum plane leaves it outside
+bool triangle_may_be_visible(const Vec3 p[3], const Mat4& viewProj, const Vec3& cameraPosition) {
+    if (math::dot(math::cross(p[1] - p[0], p[2] - p[0]), p[0] - cameraPosition) >= 0.0f)
+        return false;
+    for (int plane = 0; plane < 6; plane++)
+    {
+        bool outside = true;
+        for (int v = 0; v < 3 && outside; v++)
+        {
+            Vec4  clip = viewProj * Vec4(p[v], 1.0f);
+            float d    = plane == 0   ? clip.w + clip.x
+                         : plane == 1 ? clip.w - clip.x
+                         : plane == 2 ? clip.w + clip.y
+                         : plane == 3 ? clip.w - clip.y
+                         : plane == 4 ? clip.z
+                                      : clip.w - clip.z;
+            outside = d < 0.0f;
+        }
+        if (outside)
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+int main() {
+    Core::Geometry* g = create_sphere(128, 256);
+    const std::vector<std::array<uint32_t, 3>> sourceTriangles = sorted_triangles(g->get_properties().vertexIndex);
+
+    if (!g->build_meshlets())
+    {
+        std::cerr << "Meshlets could not be built" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const Core::GeometricData&        props    = g->get_properties();
+    const std::vector<Core::Meshlet>& meshlets = props.meshlets;
+
+    // Clustering
+    uint32_t errors    = 0;
+    uint32_t nextIndex = 0;
+    for (const Core::Meshlet& m : meshlets)
+    {
+        std::set<uint32_t> unique(props.vertexIndex.begin() + m.firstIndex, props.vertexIndex.begin() + m.firstIndex + m.indexCount);
+        if (m.firstIndex != nextIndex || m.indexCount % 3 != 0 || m.indexCount / 3 > ENGINE_MESHLET_MAX_TRIANGLES ||
+            unique.size() != m.vertexCount || m.vertexCount > ENGINE_MESHLET_MAX_VERTICES)
+            errors++;
+        for (uint32_t v : unique)
+        {
+            if (math::length(props.vertexData[v].pos - Vec3(m.boundingSphere)) > m.boundingSphere.w * 1.0001f + 1e-5f)
+                errors++;
+        }
+        nextIndex = m.firstIndex + m.indexCount;
+    }
+    if (nextIndex != props.vertexIndex.size() || sorted_triangles(props.vertexIndex) != sourceTriangles)
+        errors++;
+    if (errors > 0)
+    {
+        std::cerr << errors << " clustering errors in " << meshlets.size() << " meshlets" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Culling
+    const uint32_t                        CAMERAS = 256;
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    size_t                                tested = 0;
+    size_t                                culled = 0;
+    for (uint32_t c = 0; c < CAMERAS; c++)
+    {
+        Mat4 model = math::translate(Mat4(1.0f), Vec3(unit(rng), unit(rng), unit(rng)));
+        model      = math::rotate(model, unit(rng) * math::pi<float>(), math::normalize(Vec3(unit(rng), unit(rng), unit(rng)) + Vec3(0.0f, 0.0f, 2.0f)));
+        model      = math::scale(model, Vec3(1.5f + unit(rng)));
+
+        const Vec3 cameraPosition = math::normalize(Vec3(unit(rng), unit(rng), unit(rng)) + Vec3(0.0f, 0.0f, 2.0f)) * (4.0f + 2.0f * unit(rng));
+        const Vec3 target         = Vec3(unit(rng), unit(rng), unit(rng));
+        Mat4       proj           = math::perspective(math::radians(50.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        proj[1][1] *= -1;
+        const Mat4 viewProj = proj * math::lookAt(cameraPosition, target, Vec3(0.0f, 1.0f, 0.0f));
+
+        for (const Core::Meshlet& m : meshlets)
+        {
+            tested++;
+            if (Core::is_meshlet_visible(m, model, viewProj, cameraPosition))
+                continue;
+            culled++;
+            for (uint32_t i = m.firstIndex; i < m.firstIndex + m.indexCount; i += 3)
+            {
+                Vec3 p[3];
+                for (int v = 0; v < 3; v++)
+                    p[v] = Vec3(model * Vec4(props.vertexData[props.vertexIndex[i + v]].pos, 1.0f));
+                if (triangle_may_be_visible(p, viewProj, cameraPosition))
+                {
+                    errors++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Non uniform scale invalidates the cones, only the frustum test may cull
+    const Mat4 stretched = math::scale(Mat4(1.0f), Vec3(1.0f, 3.0f, 1.0f));
+    Mat4       proj      = math::perspective(math::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const Mat4 viewProj  = proj * math::lookAt(Vec3(0.0f, 0.0f, 10.0f), Vec3(0.0f), Vec3(0.0f, 1.0f, 0.0f));
+    for (const Core::Meshlet& m : meshlets)
+    {
+        if (!Core::is_meshlet_visible(m, stretched, viewProj, Vec3(0.0f, 0.0f, 10.0f)))
+            errors++;
+    }
+
+    std::cout << meshlets.size() << " meshlets, " << props.vertexIndex.size() / 3 << " triangles. Culled " << culled << " of " << tested
+              << " meshlet tests (" << 100.0 * culled / std::max<size_t>(tested, 1) << "%)" << std::endl;
+    delete g;
+
+    if (errors > 0)
+    {
+        std::cerr << errors << " culling errors" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // Seen from outside, about half of a closed sphere faces away
+    if (culled < tested / 4)
+    {
+        std::cerr << "Culling is too conservative" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <engine/render/render_queue.h>
+#include <iostream>
+#include <random>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Render queue test. Fills a queue with random opaque and blended draws, many of them sharing state and distance, and checks the
+radix sort against std::stable_sort. Also checks the order the keys encode: opaque draws grouped by state and front to back,
+blended draws after them and back to front, and no draw lost when distances tie
+*/
+
+namespace {
+double elapsed_ms( std::chrono::high_resolution_clock::time_point start ) {
+    return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+}
+} // namespace
+
+int main() {
+    const uint32_t DRAWS = 200000;
+
+    std::mt19937                            rng( 5 );
+    std::uniform_int_distribution<uint32_t> state( 0, 15 );
+    std::uniform_int_distribution<uint32_t> distance( 0, 63 ); // Coarse, so ties are common
+    std::uniform_int_distribution<uint32_t> blended( 0, 9 );
+
+    struct Draw {
+        bool     blended;
+        uint32_t pipeline, material, geometry;
+        float    depth;
+    };
+    std::vector<Draw>   draws( DRAWS );
+    Render::RenderQueue queue;
+    queue.reserve( DRAWS );
+    for ( uint32_t i = 0; i < DRAWS; i++ )
+    {
+        Draw& d    = draws[i];
+        d.blended  = blended( rng ) == 0;
+        d.pipeline = state( rng );
+        d.material = state( rng );
+        d.geometry = state( rng );
+        d.depth    = 0.5f * distance( rng );
+        queue.push( d.blended ? Render::RenderQueue::make_blended_key( d.depth )
+                              : Render::RenderQueue::make_opaque_key( d.pipeline, d.material, d.geometry, d.depth ),
+                    i );
+    }
+
+    std::vector<Render::RenderQueueItem> reference = queue.get_items();
+    auto                                 start     = std::chrono::high_resolution_clock::now();
+    std::stable_sort( reference.begin(), reference.end(), []( const Render::RenderQueueItem& a, const Render::RenderQueueItem& b ) {
+        return a.key < b.key;
+    } );
+    const double referenceTime = elapsed_ms( start );
+
+    start = std::chrono::high_resolution_clock::now();
+    queue.sort();
+    const double radixTime = elapsed_ms( start );
+
+    uint32_t                                    mismatches = 0;
+    const std::vector<Render::RenderQueueItem>& items      = queue.get_items();
+    if ( items.size() != reference.size() )
+        mismatches++;
+    for ( size_t i = 0; i < std::min( items.size(), reference.size() ); i++ )
+    {
+        if ( items[i].key != reference[i].key || items[i].index != reference[i].index )
+            mismatches++;
+    }
+
+    uint32_t orderErrors = 0;
+    for ( size_t i = 1; i < items.size(); i++ )
+    {
+        const Draw& a = draws[items[i - 1].index];
+        const Draw& b = draws[items[i].index];
+        if ( a.blended != b.blended )
+        {
+            if ( a.blended ) // Blended draws go last
+                orderErrors++;
+            continue;
+        }
+        if ( a.blended )
+        {
+            if ( a.depth < b.depth || ( a.depth == b.depth && items[i - 1].index > items[i].index ) )
+                orderErrors++;
+            continue;
+        }
+        const uint32_t stateA = ( a.pipeline << 8 ) | ( a.material << 4 ) | a.geometry;
+        const uint32_t stateB = ( b.pipeline << 8 ) | ( b.material << 4 ) | b.geometry;
+        if ( stateA > stateB || ( stateA == stateB && a.depth > b.depth ) )
+            orderErrors++;
+    }
+
+    std::cout << "Sorted " << DRAWS << " draws. std::stable_sort " << referenceTime << " ms, radix sort " << radixTime << " ms" << std::endl;
+    std::cout << "Mismatches against std::stable_sort " << mismatches << ", order errors " << orderErrors << std::endl;
+    return mismatches == 0 && orderErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
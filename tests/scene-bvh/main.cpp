@@ -0,0 +1,222 @@
+#include <chrono>
+#include <engine/core/scene/scene_BVH.h>
+#include <iostream>
+#include <random>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Scene hierarchy test. Moves, removes and reinserts random boxes for a few frames and checks every query against a linear walk over
+the leaves. Also reports the time of both
+*/
+
+namespace {
+struct Box {
+    Vec3    minCoords;
+    Vec3    maxCoords;
+    int32_t proxy = Core::SceneBVH::NULL_NODE;
+};
+
+bool box_on_frustum(const Core::Frustum& f, const Vec3& minCoords, const Vec3& maxCoords) {
+    const Core::Face* faces[6] = {&f.leftFace, &f.rightFace, &f.topFace, &f.bottomFace, &f.nearFace, &f.farFace};
+    for (const Core::Face* face : faces)
+    {
+        Vec3 corner = Vec3(face->normal.x >= 0.0f ? maxCoords.x : minCoords.x,
+                           face->normal.y >= 0.0f ? maxCoords.y : minCoords.y,
+                           face->normal.z >= 0.0f ? maxCoords.z : minCoords.z);
+        if (face->get_signed_distance(corner) < 0.0f)
+            return false;
+    }
+    return true;
+}
+bool box_on_sphere(const Vec3& center, float radius, const Vec3& minCoords, const Vec3& maxCoords) {
+    Vec3 d = math::clamp(center, minCoords, maxCoords) - center;
+    return math::dot(d, d) <= radius * radius;
+}
+bool box_on_ray(const Vec3& origin, const Vec3& direction, float maxDistance, const Vec3& minCoords, const Vec3& maxCoords) {
+    float tNear = 0.0f, tFar = maxDistance;
+    for (int a = 0; a < 3; a++)
+    {
+        if (direction[a] == 0.0f)
+        {
+            if (origin[a] < minCoords[a] || origin[a] > maxCoords[a])
+                return false;
+            continue;
+        }
+        float t0 = (minCoords[a] - origin[a]) / direction[a];
+        float t1 = (maxCoords[a] - origin[a]) / direction[a];
+        tNear    = std::max(tNear, std::min(t0, t1));
+        tFar     = std::min(tFar, std::max(t0, t1));
+    }
+    return tNear <= tFar;
+}
+Core::Frustum random_frustum(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Mat4 proj = math::perspective(math::radians(40.0f + 40.0f * (unit(rng) + 1.0f)), 16.0f / 9.0f, 0.1f, 60.0f + 60.0f * unit(rng));
+    proj[1][1] *= -1;
+    Vec3 eye = Vec3(unit(rng), unit(rng), unit(rng)) * 120.0f;
+    return Core::extract_frustum(proj * math::lookAt(eye, eye + Vec3(unit(rng), unit(rng), unit(rng) + 0.01f), Vec3(0.0f, 1.0f, 0.0f)));
+}
+double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+} // namespace
+
+int main() {
+    const uint32_t OBJECTS = 20000;
+    const uint32_t FRAMES  = 16;
+    const uint32_t QUERIES = 32;
+
+    std::mt19937                          rng(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto                                  random_box = [&](Box& box) {
+        Vec3 center   = Vec3(unit(rng), unit(rng), unit(rng)) * 150.0f;
+        Vec3 extent   = Vec3(unit(rng), unit(rng), unit(rng)) * 1.5f + Vec3(1.6f);
+        box.minCoords = center - extent;
+        box.maxCoords = center + extent;
+    };
+
+    Core::SceneBVH   bvh;
+    std::vector<Box> boxes(OBJECTS);
+    for (uint32_t i = 0; i < OBJECTS; i++)
+    {
+        random_box(boxes[i]);
+        boxes[i].proxy = bvh.insert(nullptr, i, boxes[i].minCoords, boxes[i].maxCoords);
+    }
+
+    uint32_t errors     = 0;
+    size_t   reinserted = 0;
+    double   treeTime = 0.0, linearTime = 0.0;
+    for (uint32_t frame = 0; frame < FRAMES; frame++)
+    {
+        // Most objects stay, some drift, a few teleport, disappear or come back
+        for (uint32_t i = 0; i < OBJECTS; i++)
+        {
+            Box&  box  = boxes[i];
+            float roll = (unit(rng) + 1.0f) * 0.5f;
+            if (roll < 0.01f)
+            {
+                if (box.proxy != Core::SceneBVH::NULL_NODE)
+                    bvh.remove(box.proxy);
+                box.proxy = Core::SceneBVH::NULL_NODE;
+                continue;
+            }
+            if (box.proxy == Core::SceneBVH::NULL_NODE)
+            {
+                random_box(box);
+                box.proxy = bvh.insert(nullptr, i, box.minCoords, box.maxCoords);
+                continue;
+            }
+            if (roll < 0.03f)
+                random_box(box);
+            else if (roll < 0.3f)
+            {
+                Vec3 offset = Vec3(unit(rng), unit(rng), unit(rng)) * 0.2f;
+                box.minCoords += offset;
+                box.maxCoords += offset;
+            }
+            reinserted += bvh.move(box.proxy, box.minCoords, box.maxCoords);
+        }
+
+        // Queries must match the fattened leaves exactly, and never miss what the tight boxes touch
+        std::vector<uint32_t> results;
+        for (uint32_t q = 0; q < QUERIES; q++)
+        {
+            const Core::Frustum frustum = random_frustum(rng);
+            auto                start   = std::chrono::high_resolution_clock::now();
+            bvh.query_frustum(frustum, results);
+            treeTime += elapsed_ms(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < OBJECTS; i++)
+            {
+                if (boxes[i].proxy == Core::SceneBVH::NULL_NODE)
+                    continue;
+                const Core::SceneBVH::Node& leaf = bvh.get_node(boxes[i].proxy);
+                if (box_on_frustum(frustum, leaf.minCoords, leaf.maxCoords))
+                    expected.push_back(i);
+                else if (box_on_frustum(frustum, boxes[i].minCoords, boxes[i].maxCoords))
+                    errors++;
+            }
+            linearTime += elapsed_ms(start);
+            std::sort(results.begin(), results.end());
+            if (results != expected)
+                errors++;
+
+            const Vec3  center = Vec3(unit(rng), unit(rng), unit(rng)) * 150.0f;
+            const float radius = 5.0f + 20.0f * (unit(rng) + 1.0f);
+            bvh.query_sphere(center, radius, results);
+            expected.clear();
+            for (uint32_t i = 0; i < OBJECTS; i++)
+                if (boxes[i].proxy != Core::SceneBVH::NULL_NODE &&
+                    box_on_sphere(center, radius, bvh.get_node(boxes[i].proxy).minCoords, bvh.get_node(boxes[i].proxy).maxCoords))
+                    expected.push_back(i);
+            std::sort(results.begin(), results.end());
+            if (results != expected)
+                errors++;
+
+            // Some rays are axis aligned
+            const Vec3 origin    = Vec3(unit(rng), unit(rng), unit(rng)) * 150.0f;
+            Vec3       direction = Vec3(unit(rng), unit(rng), unit(rng));
+            if (q % 4 == 0)
+                direction = Vec3(0.0f, 0.0f, q % 8 == 0 ? 1.0f : -1.0f);
+            std::vector<Core::SceneBVH::RayHit> hits;
+            bvh.query_ray(origin, direction, 200.0f, hits);
+            expected.clear();
+            for (uint32_t i = 0; i < OBJECTS; i++)
+                if (boxes[i].proxy != Core::SceneBVH::NULL_NODE &&
+                    box_on_ray(origin, direction, 200.0f, bvh.get_node(boxes[i].proxy).minCoords, bvh.get_node(boxes[i].proxy).maxCoords))
+                    expected.push_back(i);
+            results.clear();
+            for (size_t h = 0; h < hits.size(); h++)
+            {
+                results.push_back(hits[h].index);
+                if (h > 0 && hits[h].distance < hits[h - 1].distance)
+                    errors++;
+            }
+            std::sort(results.begin(), results.end());
+            if (results != expected)
+                errors++;
+        }
+
+        // Batched views give the same masks as one query per view
+        Core::Frustum frustums[4];
+        for (Core::Frustum& f : frustums)
+            f = random_frustum(rng);
+        std::vector<std::pair<uint32_t, uint32_t>> masks;
+        bvh.query_frustums(frustums, 4, masks);
+        std::vector<uint32_t> expectedMasks(OBJECTS, 0);
+        for (uint32_t v = 0; v < 4; v++)
+        {
+            bvh.query_frustum(frustums[v], results);
+            for (uint32_t i : results)
+                expectedMasks[i] |= 1u << v;
+        }
+        size_t nonEmpty = 0;
+        for (uint32_t mask : expectedMasks)
+            nonEmpty += mask != 0;
+        if (masks.size() != nonEmpty)
+            errors++;
+        for (const auto& [index, mask] : masks)
+            if (expectedMasks[index] != mask)
+                errors++;
+    }
+
+    std::cout << bvh.get_count() << " objects, height " << bvh.get_height() << ". " << reinserted << " reinsertions in " << FRAMES
+              << " frames. Frustum queries: " << treeTime / (FRAMES * QUERIES) << " ms, linear " << linearTime / (FRAMES * QUERIES)
+              << " ms" << std::endl;
+
+    if (errors > 0)
+    {
+        std::cerr << errors << " query errors" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // A balanced tree stays within a small factor of log2 of the leaf count
+    if (bvh.get_height() > 4 * static_cast<uint32_t>(std::log2(OBJECTS) + 1))
+    {
+        std::cerr << "Hierarchy is unbalanced" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
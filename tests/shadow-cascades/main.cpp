@@ -0,0 +1,80 @@
+#include <engine/core/scene/light.h>
+#include <iostream>
+#include <random>
+
+USING_VULKAN_ENGINE_NAMESPACE
+
+/*
+Shadow cascades test. Fits the cascades of a directional light to random cameras and checks that every slice of the view frustum
+is inside the view of its cascade, that splits grow up to the shadow far plane, and that moving the camera less than a texel
+leaves most views untouched, so cached shadow maps are not redrawn and edges do not swim
+*/
+
+int main() {
+    const uint32_t CAMERAS    = 500;
+    const uint32_t RESOLUTION = 2048;
+    const float    NEAR       = 0.1f;
+    const float    FAR        = 300.0f;
+    const Vec3     SCENE_MIN  = Vec3(-100.0f, -2.0f, -100.0f);
+    const Vec3     SCENE_MAX  = Vec3(100.0f, 30.0f, 100.0f);
+
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    Core::DirectionalLight light(Vec3(1.0f, 1.0f, 0.0f));
+    light.set_cascade_count(ENGINE_MAX_CASCADES);
+    light.set_shadow_far(150.0f);
+
+    const Mat4 proj = math::perspective(math::radians(60.0f), 16.0f / 9.0f, NEAR, FAR);
+
+    uint32_t outsideCorners = 0, badSplits = 0, movedViews = 0, views = 0;
+    for (uint32_t i = 0; i < CAMERAS; i++)
+    {
+        light.set_direction(Vec3(unit(rng), 1.0f + 0.5f * unit(rng), unit(rng)));
+        const Vec3 position = Vec3(50.0f * unit(rng), 5.0f + 5.0f * unit(rng), 50.0f * unit(rng));
+        const Vec3 forward  = math::normalize(Vec3(unit(rng), 0.3f * unit(rng), unit(rng)));
+        const Mat4 view     = math::lookAt(position, position + forward, Vec3(0.0f, 1.0f, 0.0f));
+
+        Core::ShadowCascades cascades = light.get_shadow_cascades(view, proj, NEAR, FAR, SCENE_MIN, SCENE_MAX, RESOLUTION);
+        if (cascades.count != ENGINE_MAX_CASCADES || std::abs(cascades.splits[cascades.count - 1] - 150.0f) > 1e-3f)
+            badSplits++;
+
+        // Corners of each slice, along the rays through the corners of the view
+        const Mat4 invProj   = math::inverse(proj);
+        const Mat4 invView   = math::inverse(view);
+        float      sliceNear = NEAR;
+        for (uint32_t c = 0; c < cascades.count; c++)
+        {
+            if (cascades.splits[c] <= sliceNear)
+                badSplits++;
+            for (uint32_t corner = 0; corner < 8; corner++)
+            {
+                Vec4 ray = invProj * Vec4(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, 0.5f, 1.0f);
+                Vec3 dir = Vec3(ray) / ray.w;
+                dir /= -dir.z;
+                const Vec3 world = Vec3(invView * Vec4(dir * (corner & 4 ? cascades.splits[c] : sliceNear), 1.0f));
+                const Vec4 clip  = cascades.viewProj[c] * Vec4(world, 1.0f);
+                const float tolerance = 1e-4f * clip.w;
+                if (std::abs(clip.x) > clip.w + tolerance || std::abs(clip.y) > clip.w + tolerance || clip.z > clip.w + tolerance)
+                    outsideCorners++;
+            }
+            sliceNear = cascades.splits[c];
+        }
+
+        // Half a millimeter is far below a texel of any cascade
+        const Vec3 nudge = Vec3(0.0005f, 0.0f, 0.0f);
+        const Mat4 moved = math::lookAt(position + nudge, position + nudge + forward, Vec3(0.0f, 1.0f, 0.0f));
+        Core::ShadowCascades nudged = light.get_shadow_cascades(moved, proj, NEAR, FAR, SCENE_MIN, SCENE_MAX, RESOLUTION);
+        for (uint32_t c = 0; c < cascades.count; c++, views++)
+        {
+            if (nudged.viewProj[c] != cascades.viewProj[c])
+                movedViews++;
+        }
+    }
+
+    std::cout << "Fitted " << views << " cascades. Slice corners outside their cascade " << outsideCorners << ", bad splits " << badSplits
+              << std::endl;
+    std::cout << "Views changed by a sub-texel camera move " << movedViews << " of " << views << std::endl;
+    // Only cameras close to a texel boundary should see their views change
+    return outsideCorners == 0 && badSplits == 0 && movedViews * 10 < views ? EXIT_SUCCESS : EXIT_FAILURE;
+}